@@ -0,0 +1,118 @@
+#!/usr/bin/env python
+#
+# compare two result files of genius_bench.py and flag regressions.
+#
+#   bench_compare.py base.json new.json
+#
+# exit code is 1 when any case is slower than --time-tol, uses more memory
+# than --mem-tol, needs more newton/linear iterations than --iter-tol, or
+# is missing in the new results.
+#
+
+from __future__ import print_function
+
+import sys
+import json
+from optparse import OptionParser
+
+# counters which measure the solver work, compared with --iter-tol
+ITERATION_COUNTERS = ['newton iterations', 'linear solver iterations']
+
+
+def rel_change(base, new):
+  if base == 0:
+    return 0.0 if new == 0 else float('inf')
+  return (new - base)/float(base)
+
+
+def compare_case(name, base, new, opts, out):
+  '''@return the list of regressions of this case'''
+  regressions = []
+
+  def check(what, b, n, tol, fmt):
+    r = rel_change(b, n)
+    flag = ''
+    if r > tol:
+      flag = '  <-- REGRESSION'
+      regressions.append('%s: %s %+.1f%%' % (name, what, 100*r))
+    elif r < -tol:
+      flag = '  (improved)'
+    out.append(('  %-40s ' + fmt + ' -> ' + fmt + '  %+7.1f%%%s') % (what, b, n, 100*r, flag))
+
+  out.append(name)
+  check('wall time (s)', base['wall_time'], new['wall_time'], opts.time_tol, '%10.3f')
+  check('peak rss (MB)', base['vmhwm_kB']/1024.0, new['vmhwm_kB']/1024.0, opts.mem_tol, '%10.1f')
+
+  for c in ITERATION_COUNTERS:
+    b = base.get('counters', {}).get(c)
+    n = new.get('counters', {}).get(c)
+    if b is not None and n is not None:
+      check(c, b, n, opts.iter_tol, '%10d')
+
+  # phases, only those which take a visible part of the run
+  steps = set(base.get('steps', {}).keys()) & set(new.get('steps', {}).keys())
+  for s in sorted(steps):
+    b = base['steps'][s]['time']
+    n = new['steps'][s]['time']
+    if b >= opts.min_time:
+      check('step %s (s)' % s, b, n, opts.time_tol, '%10.3f')
+
+  # the most expensive events of the base run
+  events = base.get('events', {})
+  top = sorted(events.keys(), key=lambda e: events[e]['time'], reverse=True)[:opts.top]
+  for e in top:
+    b = events[e]['time']
+    if b < opts.min_time or e not in new.get('events', {}):
+      continue
+    n = new['events'][e]['time']
+    out.append(('  %-40s %10.3f -> %10.3f  %+7.1f%%') % (e[-40:], b, n, 100*rel_change(b, n)))
+
+  return regressions
+
+
+def main(argv=None):
+  parser = OptionParser(usage='%prog [options] base.json new.json')
+  parser.add_option('--time-tol', dest='time_tol', type='float', default=0.05, help='relative time tolerance [0.05]')
+  parser.add_option('--mem-tol', dest='mem_tol', type='float', default=0.10, help='relative memory tolerance [0.10]')
+  parser.add_option('--iter-tol', dest='iter_tol', type='float', default=0.0, help='relative iteration count tolerance [0]')
+  parser.add_option('--min-time', dest='min_time', type='float', default=0.05, help='ignore phases shorter than this (s) [0.05]')
+  parser.add_option('--top', dest='top', type='int', default=8, help='number of events to list per case [8]')
+  (opts, args) = parser.parse_args(argv)
+
+  if len(args) != 2:
+    parser.error('need base and new result files')
+
+  base = json.load(open(args[0]))
+  new  = json.load(open(args[1]))
+
+  for key in ('scale', 'np', 'threads'):
+    if base['meta'].get(key) != new['meta'].get(key):
+      print('Warning: %s differs (%s vs %s), results are not comparable' %
+            (key, base['meta'].get(key), new['meta'].get(key)))
+
+  print('base: %s %s' % (base['meta'].get('revision', ''), base['meta'].get('date', '')))
+  print('new : %s %s' % (new['meta'].get('revision', ''), new['meta'].get('date', '')))
+  print('')
+
+  regressions = []
+  out = []
+  for name in sorted(base['cases'].keys()):
+    if name not in new['cases']:
+      regressions.append('%s: missing in new results' % name)
+      continue
+    regressions.extend(compare_case(name, base['cases'][name], new['cases'][name], opts, out))
+  print('\n'.join(out))
+  print('')
+
+  if regressions:
+    print('%d regression(s):' % len(regressions))
+    for r in regressions:
+      print('  ' + r)
+    return 1
+
+  print('no regression.')
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,175 @@
+#!/usr/bin/env python
+#
+# run the genius benchmark decks with fixed settings and collect the
+# performance summary (-p_json) of each case into one json file.
+#
+#   genius_bench.py --genius build/default/src/genius.LINUX --out bench.json
+#
+# compare two result files with bench_compare.py.
+#
+
+from __future__ import print_function
+
+import os
+import re
+import sys
+import json
+import time
+import shutil
+import socket
+import tempfile
+import platform
+import subprocess
+from optparse import OptionParser
+
+bench_dir = os.path.dirname(os.path.abspath(__file__))
+
+# name, deck, description
+CASES = [
+  ('ddml1_steady', 'ddml1_steady.inp', 'DDML1 equilibrium and bias point'),
+  ('ddml2_steady', 'ddml2_steady.inp', 'DDML2 (lattice temperature) bias point'),
+  ('ebml3_steady', 'ebml3_steady.inp', 'EBML3 (electron temperature) bias point'),
+  ('ddml1_dc',     'ddml1_dc.inp',     'DDML1 drain voltage sweep'),
+  ('ddml1_tran',   'ddml1_tran.inp',   'DDML1 gate pulse transient, fixed step'),
+  ('ddm_ac',       'ddm_ac.inp',       'DDMAC small signal sweep'),
+]
+
+MESH_DECK = 'nmos_mesh.inp'
+
+
+def scale_deck(text, scale):
+  '''scale the mesh density by multiplying N.SPACES, lines marked with "# noscale" are kept'''
+  def repl(m):
+    n = max(1, int(round(int(m.group(2))*scale)))
+    return '%s%d' % (m.group(1), n)
+  lines = []
+  for line in text.split('\n'):
+    if 'noscale' not in line:
+      line = re.sub(r'(?i)(N\.SPACES\s*=\s*)(\d+)', repl, line)
+    lines.append(line)
+  return '\n'.join(lines)
+
+
+def make_deck(case_deck, scale):
+  mesh = open(os.path.join(bench_dir, 'decks', MESH_DECK)).read()
+  case = open(os.path.join(bench_dir, 'decks', case_deck)).read()
+  return scale_deck(mesh, scale) + '\n' + case + '\nEND\n'
+
+
+def git_revision():
+  try:
+    p = subprocess.Popen(['git', 'rev-parse', 'HEAD'], cwd=bench_dir,
+                         stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    out = p.communicate()[0]
+    if p.returncode == 0:
+      return out.decode().strip()
+  except OSError:
+    pass
+  return ''
+
+
+def run_case(opts, name, deck):
+  '''run one case, @return the summary written by processor 0 or None'''
+  workdir = tempfile.mkdtemp(prefix='genius_bench_%s_' % name)
+  try:
+    inp = os.path.join(workdir, name + '.inp')
+    open(inp, 'w').write(make_deck(deck, opts.scale))
+
+    summary = os.path.join(workdir, 'perf.json')
+    cmd = [os.path.abspath(opts.genius), '-i', inp, '-p_json', summary]
+    if opts.np > 1:
+      cmd = opts.mpirun.split() + ['-n', str(opts.np)] + cmd
+      summary += '.0'
+
+    env = dict(os.environ)
+    env.setdefault('GENIUS_DIR', os.path.dirname(bench_dir))
+    # fixed settings, no threading noise
+    env['OMP_NUM_THREADS'] = str(opts.threads)
+
+    log = open(os.path.join(workdir, 'genius.log'), 'w')
+    t0 = time.time()
+    ret = subprocess.call(cmd, cwd=workdir, env=env, stdout=log, stderr=subprocess.STDOUT)
+    t1 = time.time()
+    log.close()
+
+    if ret != 0 or not os.path.exists(summary):
+      print('  %s failed (exit code %d), see log:' % (name, ret))
+      print(open(os.path.join(workdir, 'genius.log')).read()[-2000:])
+      return None
+
+    result = json.load(open(summary))
+    result['process_time'] = t1 - t0
+    return result
+  finally:
+    if not opts.keep:
+      shutil.rmtree(workdir, ignore_errors=True)
+    else:
+      print('  work directory kept in %s' % workdir)
+
+
+def main(argv=None):
+  parser = OptionParser(usage='%prog --genius <executable> [options]')
+  parser.add_option('--genius', dest='genius', help='genius executable')
+  parser.add_option('--out', dest='out', default='bench.json', help='result file [bench.json]')
+  parser.add_option('--cases', dest='cases', default='', help='comma separated cases to run [all]')
+  parser.add_option('--scale', dest='scale', type='float', default=1.0, help='mesh density scale [1.0]')
+  parser.add_option('--repeat', dest='repeat', type='int', default=3, help='runs per case, the fastest is kept [3]')
+  parser.add_option('--np', dest='np', type='int', default=1, help='number of MPI processes [1]')
+  parser.add_option('--mpirun', dest='mpirun', default='mpirun', help='MPI launcher [mpirun]')
+  parser.add_option('--threads', dest='threads', type='int', default=1, help='OMP_NUM_THREADS [1]')
+  parser.add_option('--keep', dest='keep', action='store_true', default=False, help='keep work directories')
+  parser.add_option('--list', dest='list', action='store_true', default=False, help='list the cases')
+  (opts, args) = parser.parse_args(argv)
+
+  if opts.list:
+    for name, deck, desc in CASES:
+      print('%-14s %s' % (name, desc))
+    return 0
+
+  if not opts.genius or not os.path.exists(opts.genius):
+    parser.error('genius executable not found, use --genius')
+
+  selected = [c for c in CASES if not opts.cases or c[0] in opts.cases.split(',')]
+
+  results = {
+    'meta' : {
+      'host'     : socket.gethostname(),
+      'platform' : platform.platform(),
+      'date'     : time.strftime('%Y-%m-%d %H:%M:%S'),
+      'revision' : git_revision(),
+      'genius'   : os.path.abspath(opts.genius),
+      'scale'    : opts.scale,
+      'np'       : opts.np,
+      'threads'  : opts.threads,
+      'repeat'   : opts.repeat,
+    },
+    'cases' : {},
+  }
+
+  failed = 0
+  for name, deck, desc in selected:
+    print('%s: %s' % (name, desc))
+    best = None
+    times = []
+    for r in range(max(1, opts.repeat)):
+      result = run_case(opts, name, deck)
+      if result is None:
+        break
+      times.append(result['wall_time'])
+      if best is None or result['wall_time'] < best['wall_time']:
+        best = result
+    if best is None:
+      failed += 1
+      continue
+    best['wall_times'] = times
+    results['cases'][name] = best
+    print('  wall time %.3f s (best of %d), peak rss %.1f MB' % (best['wall_time'], len(times), best['vmhwm_kB']/1024.0))
+
+  json.dump(results, open(opts.out, 'w'), indent=1, sort_keys=True)
+  print('results written to %s' % opts.out)
+
+  return 1 if failed else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,664 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+/**
+ * micro benchmark of the inner kernels of the semiconductor solvers:
+ * automatic differentiation arithmetic, special functions, Scharfetter-Gummel
+ * edge fluxes, mobility and band structure models of silicon.
+ * all the kernels are evaluated on synthetic node arrays, no mesh and
+ * no solver are involved. each kernel reports evaluations per second.
+ *
+ * with -check, the fused value/derivative special functions of mathfunc.h are
+ * compared with the plain AD evaluation of the same formula instead, the exit
+ * code is 1 when the relative error exceeds the bound.
+ *
+ * usage: genius_kernel_bench [-n size] [-repeat r] [-filter substring] [-check]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+#ifndef WINDOWS
+#include <sys/time.h>
+#endif
+
+#include "genius_common.h"
+#include "adolc.h"
+#include "mathfunc.h"
+#include "jflux1.h"
+#include "jflux2.h"
+#include "jflux3.h"
+#include "PMI.h"
+
+using namespace adtl;
+
+
+extern "C"
+{
+  PMIS_Mobility* PMIS_Si_Mob_Constant (const PMIS_Environment& env);
+  PMIS_Mobility* PMIS_Si_Mob_Analytic (const PMIS_Environment& env);
+  PMIS_Mobility* PMIS_Si_Mob_Philips  (const PMIS_Environment& env);
+  PMIS_Mobility* PMIS_Si_Mob_Lucent   (const PMIS_Environment& env);
+  PMIS_Mobility* PMIS_Si_Mob_Lombardi (const PMIS_Environment& env);
+  PMIS_Mobility* PMIS_Si_Mob_HP       (const PMIS_Environment& env);
+  PMIS_Mobility* PMIS_Si_Mob_Sdevice  (const PMIS_Environment& env);
+  PMIS_Mobility* PMIS_Si_Mob_Darwish  (const PMIS_Environment& env);
+
+  PMIS_BandStructure* PMIS_Si_BandStructure_Default (const PMIS_Environment& env);
+  PMIS_BandStructure* PMIS_Si_BandStructure_Schenk  (const PMIS_Environment& env);
+  PMIS_BandStructure* PMIS_Si_BandStructure_Sdevice (const PMIS_Environment& env);
+}
+
+
+namespace
+{
+  // the unit system of genius, the same as the material benchmark
+  const double cm = 1e6;
+  const double s  = 1e12;
+  const double V  = 1.0;
+  const double C  = 1.0/1.602176462e-19;
+  const double K  = 1.0/300;
+
+  const double e  = 1.602176462e-19*C;
+  const double kb = 1.3806503e-23*C*V/K;
+
+  // keep the compiler from removing the kernels
+  volatile double sink = 0;
+
+  struct Options
+  {
+    unsigned int n;
+    unsigned int repeat;
+    std::string  filter;
+    bool         check;
+  };
+
+  double wall_time()
+  {
+#ifdef WINDOWS
+    return static_cast<double>(clock())/CLOCKS_PER_SEC;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + 1e-6*tv.tv_usec;
+#endif
+  }
+
+  // deterministic uniform random number in [a, b)
+  double uniform(double a, double b)
+  {
+    return a + (b-a)*(std::rand()/(RAND_MAX+1.0));
+  }
+
+  // log uniform random number in [a, b)
+  double log_uniform(double a, double b)
+  {
+    return std::exp(uniform(std::log(a), std::log(b)));
+  }
+
+
+  /**
+   * synthetic node and edge data, the edge i connects node i and node i+1
+   */
+  struct NodeArrays
+  {
+    std::vector<double> psi, n, p, Tl, Tn, Tp, Ep, Et, h;
+
+    explicit NodeArrays(unsigned int size)
+    {
+      std::srand(20090301);
+      for(unsigned int i=0; i<size+1; ++i)
+      {
+        psi.push_back(uniform(-1.0, 1.0)*V);
+        n.push_back(log_uniform(1e4, 1e20)*pow(cm, -3));
+        p.push_back(log_uniform(1e4, 1e20)*pow(cm, -3));
+        Tl.push_back(uniform(300, 400)/K);
+        Tn.push_back(uniform(300, 2000)/K);
+        Tp.push_back(uniform(300, 2000)/K);
+        Ep.push_back(log_uniform(1e2, 1e6)*V/cm);
+        Et.push_back(log_uniform(1e2, 1e6)*V/cm);
+        h.push_back(uniform(1e-7, 1e-4)*cm);
+      }
+    }
+  };
+
+
+  /**
+   * time the kernel functor over all the edges, report evaluations per second
+   */
+  template <typename Kernel>
+  void run(const Options &opt, const std::string &name, Kernel kernel, unsigned int evals_per_call=1)
+  {
+    if( !opt.filter.empty() && name.find(opt.filter) == std::string::npos ) return;
+
+    // warm up
+    double acc = kernel(std::min(opt.n, 1000u));
+
+    double best = 1e30;
+    for(unsigned int r=0; r<opt.repeat; ++r)
+    {
+      double t0 = wall_time();
+      acc += kernel(opt.n);
+      double t1 = wall_time();
+      best = std::min(best, t1-t0);
+    }
+    sink = sink + acc;
+
+    const double evals = static_cast<double>(opt.n)*evals_per_call;
+    std::cout << std::left << std::setw(40) << name << std::right
+              << std::setw(12) << opt.n*evals_per_call
+              << std::setw(14) << std::scientific << std::setprecision(3) << best
+              << std::setw(14) << (best > 0 ? evals/best : 0.0) << '\n' << std::flush;
+  }
+
+
+  /**
+   * a representative expression of the assembly kernels:
+   * products, quotients and exp of independent variables
+   */
+  struct ADArithmetic
+  {
+    const NodeArrays &d;
+    ADArithmetic(const NodeArrays &data) : d(data) {}
+
+    double operator() (unsigned int size) const
+    {
+      double acc = 0;
+      const unsigned int nd = AutoDScalar::numdir;
+      for(unsigned int i=0; i<size; ++i)
+      {
+        AutoDScalar V1 = d.psi[i];   V1.setADValue(0%nd, 1.0);
+        AutoDScalar V2 = d.psi[i+1]; V2.setADValue(1%nd, 1.0);
+        AutoDScalar n1 = d.n[i];     n1.setADValue(2%nd, 1.0);
+        AutoDScalar n2 = d.n[i+1];   n2.setADValue(3%nd, 1.0);
+        AutoDScalar f = (n1*exp(V1-V2) - n2)/(n1+n2) + V1*V2*n2/d.h[i];
+        acc += f.getValue() + f.getADValue(nd-1);
+      }
+      return acc;
+    }
+  };
+
+
+  /**
+   * the special functions evaluated by AD through their defining formula,
+   * as mathfunc.h did before the fused value/derivative versions.
+   * reference for -check and the ".ref" kernels
+   */
+  namespace reference
+  {
+    AutoDScalar bern ( const AutoDScalar &x )
+    {
+      AutoDScalar y;
+      if (x <= BP0_BERN)
+      { return(-x); }
+      else if (x <  BP1_BERN)
+      { return(x / (exp(x) - 1.0)); }
+      else if (x <= BP2_BERN)
+      { return(1.0 - x/2.0 * (1.0 - x/6.0 * (1.0 - x*x/60.0))); }
+      else if (x <  BP3_BERN)
+      { y = exp(-x);   return((x * y) / (1.0 - y)); }
+      else if (x <  BP4_BERN)
+      { return(x * exp(-x)); }
+      else { return 0; }
+    }
+
+    AutoDScalar fermi_half(const AutoDScalar &x)
+    {
+      if(x<-4.5)
+        return 1.0/exp(-x);
+      AutoDScalar v = adtl::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
+      AutoDScalar p = 1.329340388179*adtl::pow(v,double(-0.375));
+      if(x<0.0)
+        return 1.0/(exp(-x) + p);
+      return 1.0/(1.0/exp(x) + p);
+    }
+
+    AutoDScalar gamma_f(const AutoDScalar &x)
+    {
+      const double a=3.53553e-1,b=4.95009e-3,c=1.48386e-4;
+      const double d=4.42563e-6,pi1=1.772453851e0,pi2=9.869604401e0;
+      AutoDScalar temx;
+      if(x>1.0e1)
+      {
+        temx=sqrt(adtl::pow(7.5e-1*pi1*x,double(4.e0/3.e0))-pi2/6.e0);
+        if(x > MaximumExponent)
+          return VerySmallNumericValue;
+        else
+          return x/exp(temx);
+      }
+      else if(x>0.0)
+      {
+        temx=x*(a+x*(-b+x*(c-x*d)));
+        return 1.0/exp(temx);
+      }
+      else
+        return 1.0;
+    }
+  }
+
+
+  /**
+   * special function of the (reduced) potential difference of each edge
+   */
+  template <AutoDScalar (*AD)(const AutoDScalar &), double (*F)(double)>
+  struct Special
+  {
+    std::vector<double> arg;
+    bool ad;
+    Special(const std::vector<double> &x, bool use_ad) : arg(x), ad(use_ad) {}
+
+    double operator() (unsigned int size) const
+    {
+      double acc = 0;
+      for(unsigned int i=0; i<size; ++i)
+      {
+        if( !ad )
+        {
+          acc += F(arg[i]);
+          continue;
+        }
+        AutoDScalar x = arg[i];  x.setADValue(0, 1.0);
+        acc += AD(x).getADValue(0);
+      }
+      return acc;
+    }
+  };
+
+
+  /**
+   * batch special function over the whole array
+   */
+  struct SpecialBatch
+  {
+    std::vector<double> arg;
+    void (*batch)(unsigned int, const double *, double *, double *);
+    bool derivative;
+    SpecialBatch(const std::vector<double> &x, void (*f)(unsigned int, const double *, double *, double *), bool d)
+      : arg(x), batch(f), derivative(d) {}
+
+    double operator() (unsigned int size) const
+    {
+      static std::vector<double> y, dy;
+      y.resize(size);
+      dy.resize(size);
+      batch(size, &arg[0], &y[0], derivative ? &dy[0] : 0);
+      return y[size/2] + dy[size/2];
+    }
+  };
+
+
+  /**
+   * max relative error of value and derivative of AD function f to the reference g over [a, b]
+   */
+  double special_error(AutoDScalar (*f)(const AutoDScalar &), AutoDScalar (*g)(const AutoDScalar &), double a, double b)
+  {
+    double err = 0;
+    const unsigned int n = 100000;
+    for(unsigned int i=0; i<=n; ++i)
+    {
+      AutoDScalar x = a + (b-a)*i/n;  x.setADValue(0, 1.0);
+      AutoDScalar y = f(x);
+      AutoDScalar z = g(x);
+      if( z.getValue() != 0.0 )
+        err = std::max(err, std::abs(y.getValue()-z.getValue())/std::abs(z.getValue()));
+      if( z.getADValue(0) != 0.0 )
+        err = std::max(err, std::abs(y.getADValue(0)-z.getADValue(0))/std::abs(z.getADValue(0)));
+    }
+    return err;
+  }
+
+
+  /**
+   * check the fused special functions against the reference AD evaluation
+   * @return the number of failed functions
+   */
+  int check_special()
+  {
+    AutoDScalar::setNumDir(1);
+
+    struct { const char *name; AutoDScalar (*f)(const AutoDScalar &); AutoDScalar (*g)(const AutoDScalar &); double a, b; } funcs[] =
+    {
+      {"bern",       ::bern,       reference::bern,       -100.0, 100.0},
+      {"fermi_half", ::fermi_half, reference::fermi_half,  -20.0,  80.0},
+      {"gamma_f",    ::gamma_f,    reference::gamma_f,       0.0, 100.0},
+    };
+
+    // bern switches between different approximations of value and derivative
+    // at slightly different break points, allow their approximation error
+    const double bound[] = {1e-10, 1e-12, 1e-12};
+
+    int failed = 0;
+    for(unsigned int k=0; k<sizeof(funcs)/sizeof(funcs[0]); ++k)
+    {
+      double err = special_error(funcs[k].f, funcs[k].g, funcs[k].a, funcs[k].b);
+      bool ok = err <= bound[k];
+      if( !ok ) failed++;
+      std::cout << std::left << std::setw(40) << funcs[k].name << std::right
+                << std::setw(14) << std::scientific << std::setprecision(3) << err
+                << (ok ? "  ok" : "  FAILED") << '\n';
+    }
+    return failed;
+  }
+
+
+  struct FluxDD
+  {
+    const NodeArrays &d;
+    bool ad;
+    FluxDD(const NodeArrays &data, bool use_ad) : d(data), ad(use_ad) {}
+
+    double operator() (unsigned int size) const
+    {
+      const double Vt = kb*(300/K)/e;
+      double acc = 0;
+      for(unsigned int i=0; i<size; ++i)
+      {
+        if( !ad )
+        {
+          acc += In_dd(Vt, d.psi[i], d.psi[i+1], d.n[i], d.n[i+1], d.h[i]);
+          acc += Ip_dd(Vt, d.psi[i], d.psi[i+1], d.p[i], d.p[i+1], d.h[i]);
+          continue;
+        }
+        AutoDScalar V1 = d.psi[i];   V1.setADValue(0, 1.0);
+        AutoDScalar V2 = d.psi[i+1]; V2.setADValue(1, 1.0);
+        AutoDScalar n1 = d.n[i];     n1.setADValue(2, 1.0);
+        AutoDScalar n2 = d.n[i+1];   n2.setADValue(3, 1.0);
+        AutoDScalar p1 = d.p[i];     p1.setADValue(4, 1.0);
+        AutoDScalar p2 = d.p[i+1];   p2.setADValue(5, 1.0);
+        acc += In_dd(Vt, V1, V2, n1, n2, d.h[i]).getADValue(2);
+        acc += Ip_dd(Vt, V1, V2, p1, p2, d.h[i]).getADValue(4);
+      }
+      return acc;
+    }
+  };
+
+
+  struct FluxLT
+  {
+    const NodeArrays &d;
+    bool ad;
+    FluxLT(const NodeArrays &data, bool use_ad) : d(data), ad(use_ad) {}
+
+    double operator() (unsigned int size) const
+    {
+      double acc = 0;
+      for(unsigned int i=0; i<size; ++i)
+      {
+        const double T  = 0.5*(d.Tl[i]+d.Tl[i+1]);
+        const double dT = d.Tl[i+1]-d.Tl[i];
+        if( !ad )
+        {
+          acc += In_lt(kb, e, d.psi[i+1]-d.psi[i], d.n[i], d.n[i+1], T, dT, d.h[i]);
+          acc += Ip_lt(kb, e, d.psi[i+1]-d.psi[i], d.p[i], d.p[i+1], T, dT, d.h[i]);
+          continue;
+        }
+        AutoDScalar V1 = d.psi[i];   V1.setADValue(0, 1.0);
+        AutoDScalar V2 = d.psi[i+1]; V2.setADValue(1, 1.0);
+        AutoDScalar n1 = d.n[i];     n1.setADValue(2, 1.0);
+        AutoDScalar n2 = d.n[i+1];   n2.setADValue(3, 1.0);
+        AutoDScalar p1 = d.p[i];     p1.setADValue(4, 1.0);
+        AutoDScalar p2 = d.p[i+1];   p2.setADValue(5, 1.0);
+        AutoDScalar T1 = d.Tl[i];    T1.setADValue(6, 1.0);
+        AutoDScalar T2 = d.Tl[i+1];  T2.setADValue(7, 1.0);
+        acc += In_lt(kb, e, V2-V1, n1, n2, 0.5*(T1+T2), T2-T1, d.h[i]).getADValue(2);
+        acc += Ip_lt(kb, e, V2-V1, p1, p2, 0.5*(T1+T2), T2-T1, d.h[i]).getADValue(4);
+      }
+      return acc;
+    }
+  };
+
+
+  struct FluxEB
+  {
+    const NodeArrays &d;
+    bool ad;
+    FluxEB(const NodeArrays &data, bool use_ad) : d(data), ad(use_ad) {}
+
+    double operator() (unsigned int size) const
+    {
+      double acc = 0;
+      for(unsigned int i=0; i<size; ++i)
+      {
+        if( !ad )
+        {
+          acc += In_eb(kb, e, d.psi[i], d.psi[i+1], d.n[i], d.n[i+1], d.Tn[i], d.Tn[i+1], d.h[i]);
+          acc += Ip_eb(kb, e, d.psi[i], d.psi[i+1], d.p[i], d.p[i+1], d.Tp[i], d.Tp[i+1], d.h[i]);
+          continue;
+        }
+        AutoDScalar V1  = d.psi[i];   V1.setADValue(0, 1.0);
+        AutoDScalar V2  = d.psi[i+1]; V2.setADValue(1, 1.0);
+        AutoDScalar n1  = d.n[i];     n1.setADValue(2, 1.0);
+        AutoDScalar n2  = d.n[i+1];   n2.setADValue(3, 1.0);
+        AutoDScalar p1  = d.p[i];     p1.setADValue(4, 1.0);
+        AutoDScalar p2  = d.p[i+1];   p2.setADValue(5, 1.0);
+        AutoDScalar Tn1 = d.Tn[i];    Tn1.setADValue(6, 1.0);
+        AutoDScalar Tn2 = d.Tn[i+1];  Tn2.setADValue(7, 1.0);
+        AutoDScalar Tp1 = d.Tp[i];    Tp1.setADValue(8, 1.0);
+        AutoDScalar Tp2 = d.Tp[i+1];  Tp2.setADValue(9, 1.0);
+        acc += In_eb(kb, e, V1, V2, n1, n2, Tn1, Tn2, d.h[i]).getADValue(2);
+        acc += Ip_eb(kb, e, V1, V2, p1, p2, Tp1, Tp2, d.h[i]).getADValue(4);
+      }
+      return acc;
+    }
+  };
+
+
+  struct Mobility
+  {
+    const NodeArrays &d;
+    PMIS_Mobility *mob;
+    bool ad;
+    Mobility(const NodeArrays &data, PMIS_Mobility *m, bool use_ad) : d(data), mob(m), ad(use_ad) {}
+
+    double operator() (unsigned int size) const
+    {
+      double acc = 0;
+      for(unsigned int i=0; i<size; ++i)
+      {
+        if( !ad )
+        {
+          acc += mob->ElecMob(d.p[i], d.n[i], d.Tl[i], d.Ep[i], d.Et[i], d.Tn[i]);
+          acc += mob->HoleMob(d.p[i], d.n[i], d.Tl[i], d.Ep[i], d.Et[i], d.Tp[i]);
+          continue;
+        }
+        AutoDScalar p  = d.p[i];   p.setADValue(0, 1.0);
+        AutoDScalar n  = d.n[i];   n.setADValue(1, 1.0);
+        AutoDScalar Tl = d.Tl[i];  Tl.setADValue(2, 1.0);
+        AutoDScalar Ep = d.Ep[i];  Ep.setADValue(3, 1.0);
+        AutoDScalar Et = d.Et[i];  Et.setADValue(4, 1.0);
+        AutoDScalar Tn = d.Tn[i];  Tn.setADValue(5, 1.0);
+        AutoDScalar Tp = d.Tp[i];  Tp.setADValue(5, 1.0);
+        acc += mob->ElecMob(p, n, Tl, Ep, Et, Tn).getADValue(1);
+        acc += mob->HoleMob(p, n, Tl, Ep, Et, Tp).getADValue(0);
+      }
+      return acc;
+    }
+  };
+
+
+  struct Band
+  {
+    const NodeArrays &d;
+    PMIS_BandStructure *band;
+    bool ad;
+    Band(const NodeArrays &data, PMIS_BandStructure *b, bool use_ad) : d(data), band(b), ad(use_ad) {}
+
+    double operator() (unsigned int size) const
+    {
+      double acc = 0;
+      for(unsigned int i=0; i<size; ++i)
+      {
+        if( !ad )
+        {
+          acc += band->Eg(d.Tl[i]);
+          acc += band->EgNarrow(d.p[i], d.n[i], d.Tl[i]);
+          acc += band->nie(d.p[i], d.n[i], d.Tl[i]);
+          acc += band->Recomb(d.p[i], d.n[i], d.Tl[i]);
+          continue;
+        }
+        AutoDScalar p  = d.p[i];   p.setADValue(0, 1.0);
+        AutoDScalar n  = d.n[i];   n.setADValue(1, 1.0);
+        AutoDScalar Tl = d.Tl[i];  Tl.setADValue(2, 1.0);
+        acc += band->Eg(Tl).getADValue(2);
+        acc += band->EgNarrow(p, n, Tl).getADValue(2);
+        acc += band->nie(p, n, Tl).getADValue(1);
+        acc += band->Recomb(p, n, Tl).getADValue(0);
+      }
+      return acc;
+    }
+  };
+
+}
+
+
+
+int main(int argc, char **argv)
+{
+  Options opt;
+  opt.n = 100000;
+  opt.repeat = 5;
+  opt.check = false;
+
+  for(int i=1; i<argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if( arg == "-n" && i+1<argc )             opt.n = std::atoi(argv[++i]);
+    else if( arg == "-repeat" && i+1<argc )   opt.repeat = std::atoi(argv[++i]);
+    else if( arg == "-filter" && i+1<argc )   opt.filter = argv[++i];
+    else if( arg == "-check" )                opt.check = true;
+    else
+    {
+      std::cout << "usage: " << argv[0] << " [-n size] [-repeat r] [-filter substring] [-check]" << std::endl;
+      return 1;
+    }
+  }
+
+  if( opt.check )
+    return check_special() ? 1 : 0;
+
+  if( opt.n < 1 ) opt.n = 1;
+  if( opt.repeat < 1 ) opt.repeat = 1;
+
+  NodeArrays data(opt.n);
+
+  std::cout << std::left << std::setw(40) << "kernel" << std::right
+            << std::setw(12) << "evals"
+            << std::setw(14) << "time(s)"
+            << std::setw(14) << "evals/s" << '\n';
+
+  // AD arithmetic cost grows with the number of directions
+  const unsigned int numdirs[] = {2, 4, 6, 8, 12, 16, 24, 32, 48, ADTL_NUMBER_DIRECTIONS};
+  for(unsigned int k=0; k<sizeof(numdirs)/sizeof(numdirs[0]); ++k)
+  {
+    AutoDScalar::setNumDir(numdirs[k]);
+    char name[64];
+    std::sprintf(name, "ad.arithmetic.numdir%u", numdirs[k]);
+    run(opt, name, ADArithmetic(data));
+  }
+
+  // special functions of the reduced potential, AD with one direction
+  {
+    std::vector<double> u, eta, fh;
+    for(unsigned int i=0; i<opt.n+1; ++i)
+    {
+      u.push_back((data.psi[i+1]-data.psi[i])/(kb*(300/K)/e));
+      eta.push_back(uniform(-10.0, 20.0));
+      fh.push_back(fermi_half(eta.back()));
+    }
+
+    AutoDScalar::setNumDir(1);
+    run(opt, "special.bern.real",           Special<bern, bern>(u, false));
+    run(opt, "special.bern.ad1",            Special<bern, bern>(u, true));
+    run(opt, "special.bern.ad1.ref",        Special<reference::bern, bern>(u, true));
+    run(opt, "special.bern.batch",          SpecialBatch(u, bern_batch, true));
+    run(opt, "special.fermi_half.real",     Special<fermi_half, fermi_half>(eta, false));
+    run(opt, "special.fermi_half.ad1",      Special<fermi_half, fermi_half>(eta, true));
+    run(opt, "special.fermi_half.ad1.ref",  Special<reference::fermi_half, fermi_half>(eta, true));
+    run(opt, "special.fermi_half.batch",    SpecialBatch(eta, fermi_half_batch, true));
+    run(opt, "special.gamma_f.real",        Special<gamma_f, gamma_f>(fh, false));
+    run(opt, "special.gamma_f.ad1",         Special<gamma_f, gamma_f>(fh, true));
+    run(opt, "special.gamma_f.ad1.ref",     Special<reference::gamma_f, gamma_f>(fh, true));
+    run(opt, "special.gamma_f.batch",       SpecialBatch(fh, gamma_f_batch, true));
+  }
+
+  // edge flux, two carriers per edge
+  AutoDScalar::setNumDir(6);
+  run(opt, "jflux1.dd.real", FluxDD(data, false), 2);
+  run(opt, "jflux1.dd.ad6",  FluxDD(data, true), 2);
+  AutoDScalar::setNumDir(8);
+  run(opt, "jflux2.lt.real", FluxLT(data, false), 2);
+  run(opt, "jflux2.lt.ad8",  FluxLT(data, true), 2);
+  AutoDScalar::setNumDir(10);
+  run(opt, "jflux3.eb.real", FluxEB(data, false), 2);
+  run(opt, "jflux3.eb.ad10", FluxEB(data, true), 2);
+
+  PMIS_Environment env(100*cm, s, V, C, K);
+
+  // mobility models, electron and hole per node
+  struct { const char *name; PMIS_Mobility* (*create)(const PMIS_Environment&); } mobs[] =
+  {
+    {"Constant", PMIS_Si_Mob_Constant},
+    {"Analytic", PMIS_Si_Mob_Analytic},
+    {"Philips",  PMIS_Si_Mob_Philips},
+    {"Lucent",   PMIS_Si_Mob_Lucent},
+    {"Lombardi", PMIS_Si_Mob_Lombardi},
+    {"HP",       PMIS_Si_Mob_HP},
+    {"Sdevice",  PMIS_Si_Mob_Sdevice},
+    {"Darwish",  PMIS_Si_Mob_Darwish},
+  };
+  AutoDScalar::setNumDir(6);
+  for(unsigned int k=0; k<sizeof(mobs)/sizeof(mobs[0]); ++k)
+  {
+    PMIS_Mobility * mob = mobs[k].create(env);
+    mob->SetFakeDopingEnvironment(1e17*pow(cm,-3), 1e15*pow(cm,-3));
+    mob->SetFakeDminEnvironment(10*1e-7*cm);
+    run(opt, std::string("mob.Si.") + mobs[k].name + ".real", Mobility(data, mob, false), 2);
+    run(opt, std::string("mob.Si.") + mobs[k].name + ".ad6",  Mobility(data, mob, true), 2);
+    delete mob;
+  }
+
+  // band models: Eg, EgNarrow, nie and recombination per node
+  struct { const char *name; PMIS_BandStructure* (*create)(const PMIS_Environment&); } bands[] =
+  {
+    {"Default", PMIS_Si_BandStructure_Default},
+    {"Schenk",  PMIS_Si_BandStructure_Schenk},
+    {"Sdevice", PMIS_Si_BandStructure_Sdevice},
+  };
+  AutoDScalar::setNumDir(3);
+  for(unsigned int k=0; k<sizeof(bands)/sizeof(bands[0]); ++k)
+  {
+    PMIS_BandStructure * band = bands[k].create(env);
+    band->SetFakeDopingEnvironment(1e17*pow(cm,-3), 1e15*pow(cm,-3));
+    run(opt, std::string("band.Si.") + bands[k].name + ".real", Band(data, band, false), 4);
+    run(opt, std::string("band.Si.") + bands[k].name + ".ad3",  Band(data, band, true), 4);
+    delete band;
+  }
+
+  return 0;
+}
@@ -19,6 +19,7 @@
 
 
 
+
 #ifndef __perflog_h__
 #define __perflog_h__
 
@@ -34,7 +35,7 @@
 
 // C++ includes
 #include <string>
-#include <stack>
+#include <vector>
 #include <map>
 
 #ifdef WINDOWS
@@ -57,8 +58,8 @@
 
 
 /**
- * The \p PerfData class simply contains the performance
- * data that is recorded for individual events.
+ * The \p PerfData class simply contains the flat (exclusive time)
+ * performance data that is recorded for individual events.
  */
 
 // ------------------------------------------------------------
@@ -72,49 +73,98 @@ class PerfData
    */
   PerfData () :
     tot_time(0.),
-    count(0),
-    open(false),
-    called_recursively(0)
+    count(0)
     {}
 
-
   /**
-   * Total time spent in this event.
+   * Total time spent in this event, time spent in
+   * nested events is excluded.
    */
   double tot_time;
 
   /**
-   * Structure defining when the event
-   * was last started.
+   * The number of times this event has
+   * been executed
    */
-#ifdef WINDOWS
-  struct timeval_t tstart;
-#else
-  struct timeval tstart;
-#endif
+  unsigned int count;
+};
+
+
+
+/**
+ * The \p PerfScope class holds the data of one node in the call tree,
+ * that is one event reached through one particular chain of parent events.
+ */
+
+// ------------------------------------------------------------
+// PerfScope class definition
+class PerfScope
+{
+ public:
 
   /**
-   * The number of times this event has
-   * been executed
+   * number of log2 bins of the duration histogram. bin i holds
+   * calls which take [2^(i-1), 2^i) microseconds, the last bin
+   * holds everything longer.
+   */
+  static const unsigned int n_hist_bins = 24;
+
+  /**
+   * Constructor.  Initializes data to be empty.
+   */
+  PerfScope (unsigned int e=invalid_uint, unsigned int p=invalid_uint);
+
+  /**
+   * the event id of this scope
+   */
+  unsigned int event;
+
+  /**
+   * the parent scope
+   */
+  unsigned int parent;
+
+  /**
+   * child scopes
+   */
+  std::vector<unsigned int> children;
+
+  /**
+   * The number of times this scope has been executed
    */
   unsigned int count;
 
   /**
-   * Flag indicating if we are currently
-   * monitoring this event.  Should only
-   * be true while the event is executing.
+   * time spent in this scope, including nested scopes
    */
-  bool open;
+  double incl_time;
 
-  void   start ();
-  void   restart ();
-  double pause ();
-  double stopit ();
+  /**
+   * time spent in this scope, excluding nested scopes
+   */
+  double self_time;
 
-  int called_recursively;
+  /**
+   * the shortest/longest call (inclusive time)
+   */
+  double min_time;
+  double max_time;
 
-};
+  /**
+   * duration histogram
+   */
+  unsigned int hist[n_hist_bins];
+
+  /**
+   * record a finished call of \p t seconds
+   */
+  void record(double t);
 
+  /**
+   * @return the approximate quantile \p q of call duration, estimated from the histogram
+   */
+  double quantile(double q) const;
+};
 
 
 
@@ -125,6 +175,18 @@ class PerfData
  * This class is particulary useful for finding performance
  * bottlenecks.
  *
+ * event names are interned into integer ids once (the START_LOG/STOP_LOG
+ * macros keep the id in a function local static), and the events are
+ * recorded in a call tree, so the same event reached from different
+ * callers is reported separately. the flat exclusive time table of old is
+ * still available.
+ *
+ * besides timing, named counters (newton/KSP iterations, assembly entries
+ * ...) can be accumulated, and a snapshot of counters and memory high-water
+ * mark is taken at each solution step by mark_step(). the raw timeline can be
+ * exported as chrome trace json (chrome://tracing, perfetto) or as csv.
+ *
+ * NOTE: not thread safe, only call it from the master thread.
  */
 
 // ------------------------------------------------------------
@@ -145,7 +207,7 @@ class PerfLog
 	  const bool log_events=true);
 
   /**
-   * Destructor. Calls \p clear() and \p print_log().
+   * Destructor.
    */
   ~PerfLog();
 
@@ -155,6 +217,7 @@ class PerfLog
    * checks to see if it is currently monitoring any
    * events, and if so errors.  Be sure you are not
    * logging any events when you call this function.
+   * interned event and counter ids remain valid.
    */
   void clear();
 
@@ -168,18 +231,67 @@ class PerfLog
    */
   void enable_logging() { log_events = true; }
 
+  /**
+   * record every call into the trace buffer, at most \p max_records
+   * calls are kept, later ones are only counted as dropped.
+   */
+  void enable_trace(std::size_t max_records=1<<20)
+  { _trace_events = true; _trace_capacity = max_records; }
+
+  /**
+   * @return the id of event \p label under \p header, the event is created
+   * when not exist.
+   */
+  unsigned int event_id(const std::string &label,
+                        const std::string &header="");
+
+  /**
+   * @return the id of counter \p name, the counter is created when not exist.
+   */
+  unsigned int counter_id(const std::string &name);
+
+  /**
+   * Push the event \p id onto the stack, pausing any active event.
+   */
+  void push (unsigned int id);
+
+  /**
+   * Pop the event \p id off the stack, resuming any lower event.
+   */
+  void pop (unsigned int id);
 
   /**
    * Push the event \p label onto the stack, pausing any active event.
    */
   void push (const std::string &label,
-	     const std::string &header="");
+	     const std::string &header="")
+  { this->push(event_id(label, header)); }
 
   /**
    * Pop the event \p label off the stack, resuming any lower event.
    */
   void pop (const std::string &label,
-	    const std::string &header="");
+	    const std::string &header="")
+  { this->pop(event_id(label, header)); }
+
+  /**
+   * add \p n to counter \p id
+   */
+  void count (unsigned int id, unsigned long n=1)
+  { if (this->log_events) _counters[id] += n; }
+
+  /**
+   * @return the current value of counter \p id
+   */
+  unsigned long counter (unsigned int id) const
+  { return _counters[id]; }
+
+  /**
+   * finish a solution step: record the wall time since the last mark,
+   * the counter increments and the memory usage. \p label and \p clock
+   * (the simulation time of transient step) are kept for the report.
+   */
+  void mark_step (const std::string &label, double clock=0.0);
 
   /**
    * Start monitoring the event named \p label.
@@ -222,11 +334,41 @@ class PerfLog
    */
   std::string get_perf_info() const;
 
+  /**
+   * @returns a string containing the call tree
+   */
+  std::string get_tree_info() const;
+
+  /**
+   * @returns a string containing the counters and per step summary
+   */
+  std::string get_counter_info() const;
+
   /**
    * Print the log.
    */
   void print_log() const;
 
+  /**
+   * write the recorded calls, steps and memory usage in chrome trace
+   * event format. each processor writes its own file when running in parallel.
+   */
+  void write_chrome_trace(const std::string &filename) const;
+
+  /**
+   * write the per step timeline (time, counter increments, memory) as csv.
+   * each processor writes its own file when running in parallel.
+   */
+  void write_csv_timeline(const std::string &filename) const;
+
+  /**
+   * write a machine readable summary as json: total wall time, the flat
+   * event table, counter totals, time of steps grouped by step label and
+   * peak memory. used by the benchmark suite to compare builds.
+   * each processor writes its own file when running in parallel.
+   */
+  void write_json_summary(const std::string &filename) const;
+
   /**
    * @returns the total time spent on this event.
    */
@@ -236,6 +378,40 @@ class PerfLog
 
  private:
 
+  /**
+   * one entry of the active event stack
+   */
+  struct Frame
+  {
+    unsigned int scope;
+    double t_start;
+    double t_resume;
+  };
+
+  /**
+   * one recorded call for trace export
+   */
+  struct TraceRecord
+  {
+    unsigned int event;
+    unsigned int depth;
+    double t_start;
+    double duration;
+  };
+
+  /**
+   * the data of one solution step
+   */
+  struct StepRecord
+  {
+    std::string label;
+    double clock;
+    double t_begin;
+    double t_end;
+    std::vector<unsigned long> counters;
+    int vmrss;
+    int vmhwm;
+  };
 
   /**
    * The label for this object.
@@ -253,94 +429,113 @@ class PerfLog
   double total_time;
 
   /**
-   * The time we were constructed or last cleared.
+   * The time we were constructed or last cleared,
+   * in seconds since epoch
    */
-#ifdef WINDOWS
-  struct timeval_t tstart;
-#else
-  struct timeval tstart;
-#endif
+  double tstart;
 
   /**
-   * The actual log.
+   * @return wall time in seconds
    */
-  std::map<std::pair<std::string,
-		     std::string>,
-	   PerfData> log;
+  static double _now();
 
   /**
-   * A stack to hold the current performance log trace.
+   * names of interned events as <header, label>
    */
-  std::stack<PerfData*> log_stack;
+  std::vector<std::pair<std::string, std::string> > _event_names;
 
   /**
-   * Flag indicating if print_log() has been called.
-   * This is used to print a header with machine-specific
-   * data the first time that print_log() is called.
+   * name to id map of events
    */
-  static bool called;
+  std::map<std::pair<std::string, std::string>, unsigned int> _event_index;
 
   /**
-   * Prints a line of 'n' repeated characters 'c'
-   * to the output string stream "out".
+   * The flat log, indexed by event id.
    */
-  void _character_line(const unsigned int n,
-		       const char c,
-		       OStringStream& out) const;
-};
+  std::vector<PerfData> log;
 
+  /**
+   * the call tree, the first one is the root
+   */
+  std::vector<PerfScope> _scopes;
 
+  /**
+   * A stack to hold the current performance log trace.
+   */
+  std::vector<Frame> log_stack;
 
-// ------------------------------------------------------------
-// PerfData class member funcions
+  /**
+   * counter names, indexed by counter id
+   */
+  std::vector<std::string> _counter_names;
 
+  /**
+   * counter values, indexed by counter id
+   */
+  std::vector<unsigned long> _counters;
 
+  /**
+   * counter values at last mark_step()
+   */
+  std::vector<unsigned long> _counters_at_mark;
 
+  /**
+   * time of last mark_step()
+   */
+  double _t_mark;
 
-// ------------------------------------------------------------
-// PerfLog class inline member funcions
-inline
-void PerfLog::push (const std::string &label,
-		    const std::string &header)
-{
-  if (this->log_events)
-    {
-      // Get a reference to the event data to avoid
-      // repeated map lookups
-      PerfData *perf_data = &(log[std::make_pair(header,label)]);
+  /**
+   * steps recorded by mark_step()
+   */
+  std::vector<StepRecord> _steps;
 
-      if (!log_stack.empty())
-	total_time +=
-	  log_stack.top()->pause();
+  /**
+   * record calls into _trace
+   */
+  bool _trace_events;
 
-      perf_data->start();
-      log_stack.push(perf_data);
-    }
-}
+  /**
+   * max number of calls kept in _trace
+   */
+  std::size_t _trace_capacity;
 
+  /**
+   * the recorded calls
+   */
+  std::vector<TraceRecord> _trace;
 
+  /**
+   * the number of calls not recorded since the trace buffer is full
+   */
+  unsigned long _trace_dropped;
 
-inline
-void PerfLog::pop (const std::string &label,
-		   const std::string &header)
-{
-  if (this->log_events)
-    {
-      assert (!log_stack.empty());
+  /**
+   * Flag indicating if print_log() has been called.
+   * This is used to print a header with machine-specific
+   * data the first time that print_log() is called.
+   */
+  static bool called;
 
-#ifndef NDEBUG
-      PerfData *perf_data = &(log[std::make_pair(header,label)]);
-      assert (perf_data == log_stack.top());
-#endif
+  /**
+   * Prints a line of 'n' repeated characters 'c'
+   * to the output string stream "out".
+   */
+  void _character_line(const unsigned int n,
+		       const char c,
+		       OStringStream& out) const;
 
-      total_time += log_stack.top()->stopit();
+  /**
+   * print scope \p s and its children to \p out
+   */
+  void _print_scope(unsigned int s, unsigned int depth, unsigned int name_width, OStringStream& out) const;
+
+  /**
+   * @return the file name with processor id appended when running in parallel
+   */
+  static std::string _processor_file_name(const std::string &filename);
+};
 
-      log_stack.pop();
 
-      if (!log_stack.empty())
-	log_stack.top()->restart();
-    }
-}
 
 // Typedefs we might need
 #ifdef HAVE_LOCALE
@@ -354,14 +549,16 @@ typedef std::time_put<char, TimeIter> TimePut;
 
 #ifdef ENABLE_PERFORMANCE_LOGGING
 extern PerfLog  perflog;
-#  define START_LOG(a,b)   { perflog.push(a,b); }
-#  define STOP_LOG(a,b)    { perflog.pop(a,b); }
+#  define START_LOG(a,b)   { static const unsigned int __perf_event_id = perflog.event_id(a,b); perflog.push(__perf_event_id); }
+#  define STOP_LOG(a,b)    { static const unsigned int __perf_event_id = perflog.event_id(a,b); perflog.pop(__perf_event_id); }
+#  define PERF_COUNT(a,n)  { static const unsigned int __perf_counter_id = perflog.counter_id(a); perflog.count(__perf_counter_id, n); }
 #  define PAUSE_LOG(a,b)   { deprecated(); }
 #  define RESTART_LOG(a,b) { deprecated{}; }
 #  define PRINT_LOG()      { perflog.print_log(); }
 #else
 #  define START_LOG(a,b)   {}
 #  define STOP_LOG(a,b)    {}
+#  define PERF_COUNT(a,n)  {}
 #  define PAUSE_LOG(a,b)   {}
 #  define RESTART_LOG(a,b) {}
 #  define PRINT_LOG()      {}
@@ -83,6 +83,7 @@ extern bool consistent_bc_by_subdomain(const std::string & mat1, const std::stri
 // predefine
 class SimulationSystem;
 class SimulationRegion;
+class SparsityPattern;
 
 /**
  * The base class of Boundary Condition
@@ -540,6 +541,18 @@ public:
    */
   bool has_flag(const std::string & ) const;
 
+  /**
+   * append the state of this boundary, i.e. the real parameters and
+   * the external circuit of electrode, to buffer. used by solution checkpoint
+   */
+  void save_state(std::vector<double> & buffer) const;
+
+  /**
+   * load the state saved by save_state from buffer, starting at pos
+   * @return false when the real parameters of this boundary changed after save_state
+   */
+  bool load_state(const std::vector<double> & buffer, unsigned int & pos);
+
 
 private:
 
@@ -911,6 +924,16 @@ public:
    */
   virtual void DDM_extra_dofs(std::map<FVM_Node *, std::pair<unsigned int, unsigned int> >&) const  {}
 
+  /**
+   * build the stencil of nonlocal coupled pyhsical term, called once the dof map is ready
+   */
+  virtual void DDM_build_extra_coupling()  {}
+
+  /**
+   * declare the matrix entries of nonlocal coupled physical term to the jacobian pattern
+   */
+  virtual void DDM_extra_coupling(SparsityPattern &) const  {}
+
 
   //////////////////////////////////////////////////////////////////////////////////
   //----------------Function and Jacobian evaluate for L1 DDM---------------------//
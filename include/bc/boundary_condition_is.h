@@ -148,10 +148,69 @@ private:
     const Elem * elem;
     unsigned int side;
     Point p;
+
+    /**
+     * nodes of the side element, cached to avoid build_side() in each assembly
+     */
+    std::vector<Node *> side_nodes;
+
+    /**
+     * inverse distance weights of side nodes at p, the same as Elem::interpolation()
+     */
+    std::vector<Real> weights;
+
+    /**
+     * sum of weights
+     */
+    Real weight_sum;
+
+    /**
+     * @return the interpolated value at p by cached weights
+     */
+    template <typename T>
+    T interpolation(const std::vector<T> & value) const
+    {
+      genius_assert(value.size() == weights.size());
+      T v = 0.0;
+      for(unsigned int n=0; n<weights.size(); ++n)
+        v += weights[n]*value[n];
+      return v/weight_sum;
+    }
   };
 
   std::multimap<const Node *, NearestPoint>  _node_nearest_point_map;
 
+  /**
+   * precomputed stencil of self consistent gate tunneling for one nearest point.
+   * all the node lookup and matrix index are resolved once after dof map is built,
+   * residual and jacobian evaluation only update values
+   */
+  struct GateCoupling
+  {
+    const NearestPoint * nearest_point;
+
+    /// the fvm node at semiconductor and insulator side
+    const FVM_Node * semiconductor_node;
+    const FVM_Node * insulator_node;
+
+    /// fvm nodes of gate side element
+    std::vector<const FVM_Node *> gate_nodes;
+
+    /// distance from semiconductor node to injection point
+    Real t;
+
+    /// dofs of each gate node involved, 3 for semiconductor and 1 for metal
+    unsigned int gate_node_dofs;
+
+    /// the jacobian columns, semiconductor node (psi, n, p) followed by dofs of gate nodes
+    std::vector<PetscInt> col_index;
+
+    /// the rows tunneling current goes, semiconductor node (n, p) followed by rows of gate nodes
+    std::vector<PetscInt> row_index;
+  };
+
+  std::vector<GateCoupling> _gate_coupling;
+
   /**
    * record the target fvm node in gate region
    * NOTE these fvm_node may not on processor!
@@ -207,6 +266,16 @@ public:
    */
   virtual void DDM_extra_dofs(std::map<FVM_Node *, std::pair<unsigned int, unsigned int> >&) const;
 
+  /**
+   * build the flat table of gate tunneling coupling, only for TunnelingSelfConsistently
+   */
+  virtual void DDM_build_extra_coupling();
+
+  /**
+   * declare the gate tunneling coupling to the jacobian pattern
+   */
+  virtual void DDM_extra_coupling(SparsityPattern &) const;
+
 
   //////////////////////////////////////////////////////////////////////////////////
   //----------------Function and Jacobian evaluate for L1 DDM---------------------//
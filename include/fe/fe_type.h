@@ -93,6 +93,13 @@ public:
    */
   Order default_quadrature_order () const;
 
+  /**
+   * @returns the lowest quadrature order which integrates the mass
+   * matrix exactly on an affine element, i.e. \p 2*order.  Elements
+   * with a non-constant jacobian should use default_quadrature_order().
+   */
+  Order affine_quadrature_order () const;
+
   /**
    * @returns a quadrature rule of appropriate type and order for this \p
    * FEType.  The default quadrature rule is based on integrating the mass
@@ -118,6 +125,13 @@ Order FEType::default_quadrature_order () const
 }
 
 
+inline
+Order FEType::affine_quadrature_order () const
+{
+  return static_cast<Order>(2*static_cast<unsigned int>(order));
+}
+
+
 #endif // #ifndef __fe_type_h__
 
 
@@ -49,8 +49,10 @@ class Edge : public Elem
    * parent. Derived classes implement 'true' elements.
    */
   Edge (const unsigned int nn,
-    Elem* p) :
-    Elem(nn, Edge::n_sides(), p) {}
+    Elem* p,
+    Node** nodelinkdata=NULL,
+    Elem** elemlinkdata=NULL) :
+    Elem(nn, Edge::n_sides(), p, nodelinkdata, elemlinkdata) {}
 
   /**
    * Constructor.  Explicitly specifies the number of
@@ -58,8 +60,10 @@ class Edge : public Elem
    */
   Edge (const unsigned int nn,
     const unsigned int ns,
-    Elem* p) :
-    Elem(nn, ns, p) {}
+    Elem* p,
+    Node** nodelinkdata=NULL,
+    Elem** elemlinkdata=NULL) :
+    Elem(nn, ns, p, nodelinkdata, elemlinkdata) {}
 
   /**
    * @returns 1, the dimensionality of the object.
@@ -50,7 +50,7 @@ class Edge2 : public Edge
    * Constructor.  By default this element has no parent.
    */
   Edge2 (Elem* p=NULL) :
-    Edge(Edge2::n_nodes(), p) {}
+    Edge(Edge2::n_nodes(), p, _nodelinks_data, _elemlinks_data) {}
 
   /**
    * Constructor.  Explicitly specifies the number of
@@ -59,7 +59,7 @@ class Edge2 : public Edge
   Edge2 (const unsigned int nn,
      const unsigned int ns,
      Elem* p) :
-    Edge(nn, p) { assert (ns == 0); }
+    Edge(nn, p, _nodelinks_data, _elemlinks_data) { assert (nn <= 2); assert (ns == 0); }
 
   /**
    * @returns 1
@@ -184,6 +184,13 @@ class Edge2 : public Edge
 
 protected:
 
+  /**
+   * Storage of the node and neighbor pointers, kept in the
+   * element itself instead of two small heap arrays.
+   */
+  Node* _nodelinks_data[2];
+  Elem* _elemlinks_data[2];
+
 
 #ifdef ENABLE_AMR
 
@@ -24,6 +24,7 @@
 
 // C++ includes
 #include <algorithm>
+#include <new>
 #include <set>
 #include <vector>
 
@@ -90,12 +91,16 @@ class Elem :    public DofObject
   /**
    * Constructor.  Creates an element with \p n_nodes nodes,
    * \p n_sides sides, \p n_children possible children, and
-   * parent \p p.  The constructor allocates the memory necessary
-   * to support this data.
+   * parent \p p.  The node and neighbor pointers are kept in
+   * \p nodelinkdata and \p elemlinkdata, which the concrete element
+   * embeds in itself. When they are not given, the constructor
+   * allocates the memory necessary to support this data.
    */
   Elem (const unsigned int n_nodes=0,
         const unsigned int n_sides=0,
-        Elem* parent=NULL);
+        Elem* parent=NULL,
+        Node** nodelinkdata=NULL,
+        Elem** elemlinkdata=NULL);
 
  public:
 
@@ -1302,6 +1307,14 @@ public:
 
 #endif
 
+  /**
+   * true when \p _nodes and \p _neighbors are allocated on the heap
+   * by the constructor instead of given by the concrete element.
+   * Both arrays then share one block, the nodes first.
+   * It takes a padding byte before \p _sbd_id.
+   */
+  bool _own_links;
+
   /**
    * The subdomain to which this element belongs.
    */
@@ -1336,7 +1349,9 @@ public:
 inline
 Elem::Elem(const unsigned int nn,
            const unsigned int ns,
-           Elem* p) :
+           Elem* p,
+           Node** nodelinkdata,
+           Elem** elemlinkdata) :
   _parent(p)
 #ifdef ENABLE_AMR
   , _p_level(0)
@@ -1345,12 +1360,22 @@ Elem::Elem(const unsigned int nn,
   this->subdomain_id() = 0;
   this->processor_id() = 0;
 
+  // Either both link arrays are given by the concrete element or none
+  _own_links = (nodelinkdata == NULL);
+  assert (_own_links || ns == 0 || elemlinkdata != NULL);
+
+  // Elements without link storage of their own (i.e. the 3D cells)
+  // take the node and neighbor arrays from one heap block
+  Node** links = NULL;
+  if (_own_links && nn+ns != 0)
+    links = static_cast<Node**>(::operator new((nn+ns)*sizeof(Node*)));
+
   // Initialize the nodes data structure
   _nodes = NULL;
 
   if (nn != 0)
     {
-      _nodes = new Node*[nn];
+      _nodes = _own_links ? links : nodelinkdata;
 
       for (unsigned int n=0; n<nn; n++)
         _nodes[n] = NULL;
@@ -1361,7 +1386,7 @@ Elem::Elem(const unsigned int nn,
 
   if (ns != 0)
     {
-      _neighbors = new Elem*[ns];
+      _neighbors = _own_links ? reinterpret_cast<Elem**>(links + nn) : elemlinkdata;
 
       for (unsigned int n=0; n<ns; n++)
         _neighbors[n] = NULL;
@@ -1395,14 +1420,11 @@ Elem::Elem(const unsigned int nn,
 inline
 Elem::~Elem()
 {
-  // Delete my node storage
-  if (_nodes != NULL)
-    delete [] _nodes;
+  // Delete my node and neighbor storage, one block which
+  // starts with the nodes when there are any
+  if (_own_links)
+    ::operator delete(_nodes != NULL ? static_cast<void*>(_nodes) : static_cast<void*>(_neighbors));
   _nodes = NULL;
-
-  // Delete my neighbor storage
-  if (_neighbors != NULL)
-    delete [] _neighbors;
   _neighbors = NULL;
 
 #ifdef ENABLE_AMR
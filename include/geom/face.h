@@ -51,8 +51,10 @@ public:
    */
   Face (const unsigned int nn,
 	const unsigned int ns,
-	Elem* p) :
-    Elem(nn, ns, p) {}
+	Elem* p,
+	Node** nodelinkdata=NULL,
+	Elem** elemlinkdata=NULL) :
+    Elem(nn, ns, p, nodelinkdata, elemlinkdata) {}
 
   /**
    * @returns 2, the dimensionality of the object.
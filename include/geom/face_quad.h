@@ -60,8 +60,10 @@ public:
    * Default quadrilateral element, takes number of nodes and
    * parent. Derived classes implement 'true' elements.
    */
-  Quad (const unsigned int nn, Elem* p) :
-    Face(nn, Quad::n_sides(), p) {}
+  Quad (const unsigned int nn, Elem* p,
+	Node** nodelinkdata=NULL,
+	Elem** elemlinkdata=NULL) :
+    Face(nn, Quad::n_sides(), p, nodelinkdata, elemlinkdata) {}
 
   /**
    * Constructor.  Explicitly specifies the number of
@@ -69,8 +71,10 @@ public:
    */
   Quad (const unsigned int nn,
 	const unsigned int ns,
-	Elem* p) :
-    Face(nn, ns, p) {}
+	Elem* p,
+	Node** nodelinkdata=NULL,
+	Elem** elemlinkdata=NULL) :
+    Face(nn, ns, p, nodelinkdata, elemlinkdata) {}
 
   /**
    * @returns 4.  All quad-derivatives are guaranteed to have at
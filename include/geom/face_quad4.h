@@ -62,7 +62,7 @@ public:
    * Constructor.  By default this element has no parent.
    */
   Quad4 (Elem* p=NULL) :
-    Quad(Quad::n_nodes(), p) {}
+    Quad(Quad::n_nodes(), p, _nodelinks_data, _elemlinks_data) {}
 
   /**
    * Constructor.  Explicitly specifies the number of
@@ -71,7 +71,7 @@ public:
   Quad4 (const unsigned int nn,
          const unsigned int ns,
          Elem* p) :
-    Quad(nn, ns, p) {}
+    Quad(nn, ns, p, _nodelinks_data, _elemlinks_data) { assert (nn <= 4); assert (ns <= 4); }
 
   /**
    * @returns \p QUAD4
@@ -240,6 +240,13 @@ public:
 
 protected:
 
+  /**
+   * Storage of the node and neighbor pointers, kept in the
+   * element itself instead of two small heap arrays.
+   */
+  Node* _nodelinks_data[4];
+  Elem* _elemlinks_data[4];
+
 
 #ifdef ENABLE_AMR
 
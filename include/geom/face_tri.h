@@ -63,8 +63,10 @@ public:
    * parent. Derived classes implement 'true' elements.
    */
   Tri (const unsigned int nn,
-       Elem* p) :
-    Face(nn, Tri::n_sides(), p) {}
+       Elem* p,
+       Node** nodelinkdata=NULL,
+       Elem** elemlinkdata=NULL) :
+    Face(nn, Tri::n_sides(), p, nodelinkdata, elemlinkdata) {}
 
   /**
    * Constructor.  Explicitly specifies the number of
@@ -72,8 +74,10 @@ public:
    */
   Tri (const unsigned int nn,
        const unsigned int ns,
-       Elem* p) :
-    Face(nn, ns, p) {}
+       Elem* p,
+       Node** nodelinkdata=NULL,
+       Elem** elemlinkdata=NULL) :
+    Face(nn, ns, p, nodelinkdata, elemlinkdata) {}
 
   /**
    * @returns 3.  All tri-derivatives are guaranteed to have at
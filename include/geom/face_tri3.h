@@ -59,7 +59,7 @@ public:
    * Constructor.  By default this element has no parent.
    */
   Tri3 (Elem* p=NULL) :
-    Tri(Tri3::n_nodes(), p) {}
+    Tri(Tri3::n_nodes(), p, _nodelinks_data, _elemlinks_data) {}
 
   /**
    * Constructor.  Explicitly specifies the number of
@@ -68,7 +68,7 @@ public:
   Tri3 (const unsigned int nn,
         const unsigned int ns,
         Elem* p) :
-    Tri(nn, ns, p) {}
+    Tri(nn, ns, p, _nodelinks_data, _elemlinks_data) { assert (nn <= 3); assert (ns <= 3); }
 
   /**
    * @returns \p TRI3
@@ -240,6 +240,13 @@ public:
 
 protected:
 
+  /**
+   * Storage of the node and neighbor pointers, kept in the
+   * element itself instead of two small heap arrays.
+   */
+  Node* _nodelinks_data[3];
+  Elem* _elemlinks_data[3];
+
 
 #ifdef ENABLE_AMR
 
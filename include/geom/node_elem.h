@@ -46,7 +46,7 @@ class NodeElem : public Elem
    * Constructor.  By default this element has no parent.
    */
   NodeElem (Elem* p=NULL) :
-    Elem(NodeElem::n_nodes(), NodeElem::n_sides(), p) {}
+    Elem(NodeElem::n_nodes(), NodeElem::n_sides(), p, _nodelinks_data) {}
 
   /**
    * Constructor.  Explicitly specifies the number of
@@ -55,7 +55,7 @@ class NodeElem : public Elem
   NodeElem (const unsigned int nn,
          const unsigned int ns,
          Elem* p) :
-    Elem(nn, ns, p) { genius_assert(nn == 1); assert (ns == 0); }
+    Elem(nn, ns, p, _nodelinks_data) { genius_assert(nn == 1); assert (ns == 0); }
 
   /**
    * Default node element, takes number of nodes and
@@ -63,7 +63,7 @@ class NodeElem : public Elem
    */
   NodeElem (const unsigned int nn,
     Elem* p) :
-    Elem(nn, NodeElem::n_sides(), p) {}
+    Elem(nn, NodeElem::n_sides(), p, _nodelinks_data) { genius_assert(nn <= 1); }
 
   /**
    * @returns 0, the dimensionality of the object.
@@ -242,6 +242,11 @@ class NodeElem : public Elem
 
 protected:
 
+  /**
+   * Storage of the node pointer, a node element has no neighbor.
+   */
+  Node* _nodelinks_data[1];
+
 
 #ifdef ENABLE_AMR
 
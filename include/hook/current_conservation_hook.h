@@ -79,6 +79,11 @@ private:
   */
  std::ofstream   _out;
 
+ /**
+  * append to an existing output file, the file head is not written again
+  */
+ bool            _append;
+
  std::pair<double,double> _current_conservation_semiconductor(const SimulationRegion *);
 
  std::pair<double,double> _current_conservation_insulator(const SimulationRegion *);
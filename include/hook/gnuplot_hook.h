@@ -101,6 +101,11 @@ private:
   * if we are in mixA mode
   */
  bool            _mixA;
+
+ /**
+  * the particle event of the last written line
+  */
+ std::string     _event_label;
 };
 
 #endif
@@ -97,6 +97,11 @@ private:
   */
  std::ofstream   _out;
 
+ /**
+  * append to an existing output file, the file head is not written again
+  */
+ bool            _append;
+
 
 };
 
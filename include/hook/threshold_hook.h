@@ -82,10 +82,6 @@ private:
    */
   Point _upper_bound;
 
-  bool _is_bound_box_valid();
-
-  bool _in_bound_box(const Point &p);
-
   /**
    * the field scalar variable to be monitor and their threshold
    */
@@ -106,6 +102,12 @@ private:
    */
   void _check_E_threshold();
 
+  /**
+   * handle of max T and max E reduction in PostSolveReduction
+   */
+  unsigned int _T_reduction;
+  unsigned int _E_reduction;
+
   /**
    * record the extreme node in current solution
    */
@@ -32,6 +32,7 @@
 #include "material_define.h"
 #include "physical_unit.h"
 #include "PMI.h"
+#include "perf_log.h"
 
 #ifdef WINDOWS
   class HINSTANCE__; // Forward or never
@@ -80,6 +81,7 @@ public:
     p_point = point;
     p_node_data = node_data;
     clock = time;
+    PERF_COUNT("material calls", 1);
   }
 
   /**
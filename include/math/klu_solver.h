@@ -0,0 +1,166 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __klu_solver_h__
+#define __klu_solver_h__
+
+#include <vector>
+
+#include "genius_common.h"
+#include "genius_petsc.h"
+#include "petscmat.h"
+#include "petscpc.h"
+
+#include "klu.h"
+
+
+/**
+ * sparse direct solver based on the bundled SuiteSparse KLU.
+ *
+ * the symbolic analysis (BTF + AMD/COLAMD) is done once and kept as long as the
+ * nonzero pattern of the matrix does not change, i.e. across newton iterations
+ * and bias points of the same solver. later numerical factorizations only
+ * call klu_refactor, a full klu_factor is only done when the pivot sequence
+ * of the previous factorization becomes poor.
+ *
+ * KLU works on compressed column storage. we feed the CSR arrays of the
+ * (sequential) petsc AIJ matrix as CSC, that is we factorize A^T, and use
+ * klu_tsolve to solve the original system.
+ *
+ * only usable when running on one processor.
+ */
+class KLUSolver
+{
+public:
+
+  KLUSolver();
+
+  ~KLUSolver();
+
+  /**
+   * factorize matrix A. reuse the symbolic analysis when the
+   * nonzero pattern is the same as last call.
+   * @return true when factorization succeeded
+   */
+  bool factorize(Mat A);
+
+  /**
+   * solve A x = b with the last factorization
+   * @return true when solve succeeded
+   */
+  bool solve(Vec b, Vec x);
+
+  /**
+   * free both symbolic and numeric factorization
+   */
+  void clear();
+
+  /**
+   * attach this solver to a petsc PC as PCSHELL
+   */
+  PetscErrorCode set_pc_shell(PC pc);
+
+  /**
+   * @return the number of symbolic analysis done
+   */
+  unsigned int n_analyze() const { return _n_analyze; }
+
+  /**
+   * @return the number of full numerical factorization done
+   */
+  unsigned int n_factor() const { return _n_factor; }
+
+  /**
+   * @return the number of numerical refactorization done
+   */
+  unsigned int n_refactor() const { return _n_refactor; }
+
+private:
+
+  /**
+   * KLU control parameters and statistics
+   */
+  klu_common _common;
+
+  /**
+   * symbolic factorization
+   */
+  klu_symbolic * _symbolic;
+
+  /**
+   * numeric factorization
+   */
+  klu_numeric * _numeric;
+
+  /**
+   * matrix size
+   */
+  int _n;
+
+  /**
+   * row pointer of the matrix (column pointer of A^T)
+   */
+  std::vector<int> _Ap;
+
+  /**
+   * column index of the matrix (row index of A^T)
+   */
+  std::vector<int> _Ai;
+
+  /**
+   * matrix entries
+   */
+  std::vector<double> _Ax;
+
+  /**
+   * buffer for rhs/solution
+   */
+  std::vector<double> _b;
+
+  /**
+   * load matrix A into _Ap/_Ai/_Ax
+   * @return true when the nonzero pattern is the same as before
+   */
+  bool _load_matrix(Mat A);
+
+  /**
+   * do the symbolic analysis
+   */
+  bool _analyze();
+
+  /**
+   * full numerical factorization
+   */
+  bool _factor();
+
+  /**
+   * reciprocal pivot ratio of the last full factorization
+   */
+  double _rcond_factor;
+
+  unsigned int _n_analyze;
+  unsigned int _n_factor;
+  unsigned int _n_refactor;
+};
+
+
+#endif // #define __klu_solver_h__
@@ -93,25 +93,6 @@ inline double bern ( double x )
 
 } /* bern */
 
-inline AutoDScalar bern ( const AutoDScalar &x )
-{
-  AutoDScalar y;
-
-  if (x <= BP0_BERN)
-  { return(-x); }
-  else if (x <  BP1_BERN)
-  { return(x / (exp(x) - 1.0)); }
-  else if (x <= BP2_BERN)
-  { return(1.0 - x/2.0 * (1.0 - x/6.0 * (1.0 - x*x/60.0))); }
-  else if (x <  BP3_BERN)
-  { y = exp(-x);   return((x * y) / (1.0 - y)); }
-  else if (x <  BP4_BERN)
-  { return(x * exp(-x)); }
-  else { return 0; }
-
-} /* bern */
-
-
 /* ----------------------------------------------------------------------------
  * pd1bern:  This function returns the total derivative of the Bernoulli
  * function with respect to the argument.  To avoid under and overflows this
@@ -143,6 +124,18 @@ inline double pd1bern ( double x )
 } /* pd1bern */
 
 
+/* ----------------------------------------------------------------------------
+ * bern:  AD version, the derivative is taken from pd1bern, so only one
+ * pass over the AD directions is needed.
+ */
+inline AutoDScalar bern ( const AutoDScalar &x )
+{
+  AutoDScalar y = pd1bern(x.getValue()) * x;
+  y.setValue(bern(x.getValue()));
+  return y;
+} /* bern */
+
+
 /* ----------------------------------------------------------------------------
  * aux1:  This function returns the aux1 function.  To avoid under and over-
  * flows this function is defined by equivalent or approximate functions
@@ -307,26 +300,40 @@ inline double fermi_half(double x)
 }
 
 
-inline AutoDScalar fermi_half(const AutoDScalar &x)
+/* ----------------------------------------------------------------------------
+ * fermi_half:  value and derivative of fermi_half in one evaluation.
+ * dfdx is the exact derivative of the approximation above (not fermi_mhalf),
+ * as the newton solver expects.
+ */
+inline double fermi_half(double x, double &dfdx)
 {
-  /* use an analytic expression. The result achieves within 0.4% error in all ranges.*/
   if(x<-4.5)
   {
-    //for small arguments, fhfp and exp are almost identical.
-    return 1.0/exp(-x);
-  }
-  else if(x<0.0)
-  {
-    AutoDScalar v = adtl::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    AutoDScalar p = 1.329340388179*adtl::pow(v,double(-0.375));
-    return 1.0/(exp(-x) + p);
-  }
-  else
-  {
-    AutoDScalar v = adtl::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    AutoDScalar p = 1.329340388179*adtl::pow(v,double(-0.375));
-    return 1.0/(1.0/exp(x) + p);
+    double f = 1.0/exp(-x);
+    dfdx = f;
+    return f;
   }
+
+  // the same expression as fermi_half(double), the value is identical
+  const double g  = exp(-0.17*(x+1)*(x+1));
+  const double v  = std::pow(x,4) + 50 + 33.6*x*(1-0.68*g);
+  const double dv = 4*x*x*x + 33.6*(1-0.68*g) + 33.6*0.68*0.34*x*(x+1)*g;
+  const double p  = 1.329340388179*std::pow(v,double(-0.375));
+  const double dp = -0.375*p*dv/v;
+  const double ex = x<0.0 ? exp(-x) : 1.0/exp(x);
+  const double f  = 1.0/(ex + p);
+  dfdx = (ex - dp)*f*f;
+  return f;
+}
+
+
+inline AutoDScalar fermi_half(const AutoDScalar &x)
+{
+  double td;
+  double f = fermi_half(x.getValue(), td);
+  AutoDScalar y = td * x;
+  y.setValue(f);
+  return y;
 }
 
 
@@ -446,26 +453,105 @@ inline  double gamma_f(double x)
 }
 
 
-inline  AutoDScalar gamma_f(const AutoDScalar &x)
+/*-----------------------------------------------------------------------
+ *   value and derivative of gamma_f in one evaluation
+ */
+inline  double gamma_f(double x, double &dgdx)
 {
   const double a=3.53553e-1,b=4.95009e-3,c=1.48386e-4;
   const double d=4.42563e-6,pi1=1.772453851e0,pi2=9.869604401e0;
-  AutoDScalar temx;
   if(x>1.0e1)
   {
-    temx=sqrt(adtl::pow(7.5e-1*pi1*x,double(4.e0/3.e0))-pi2/6.e0);
     if(x > MaximumExponent)
+    {
+      dgdx = 0.0;
       return VerySmallNumericValue;
-    else
-      return x/exp(temx);
+    }
+    const double y = std::pow(7.5e-1*pi1*x,double(4.e0/3.e0));
+    const double temx = sqrt(y-pi2/6.e0);
+    const double g = x/exp(temx);
+    // d(temx)/dx = 2/3*y/(x*temx)
+    dgdx = g*(1.0 - 2.0/3.0*y/temx)/x;
+    return g;
   }
   else if(x>0.0)
   {
-    temx=x*(a+x*(-b+x*(c-x*d)));
-    return 1.0/exp(temx);
+    const double temx=x*(a+x*(-b+x*(c-x*d)));
+    const double g = 1.0/exp(temx);
+    dgdx = -g*(a+x*(-2*b+x*(3*c-4*d*x)));
+    return g;
   }
+  dgdx = 0.0;
+  return 1.0;
+}
+
+
+inline  AutoDScalar gamma_f(const AutoDScalar &x)
+{
+  double td;
+  double g = gamma_f(x.getValue(), td);
+  AutoDScalar y = td * x;
+  y.setValue(g);
+  return y;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * batch versions of the special functions above, y[i] = f(x[i]) for i<n,
+ * the optional dy receives the derivative. the scalar functions are inlined
+ * into flat loops over the arrays, values are identical to the scalar ones.
+ */
+inline void bern_batch(unsigned int n, const double * x, double * y, double * dy=0)
+{
+  for(unsigned int i=0; i<n; ++i)
+    y[i] = bern(x[i]);
+  if(dy)
+    for(unsigned int i=0; i<n; ++i)
+      dy[i] = pd1bern(x[i]);
+}
+
+inline void aux1_batch(unsigned int n, const double * x, double * y, double * dy=0)
+{
+  for(unsigned int i=0; i<n; ++i)
+    y[i] = aux1(x[i]);
+  if(dy)
+    for(unsigned int i=0; i<n; ++i)
+      dy[i] = pd1aux1(x[i]);
+}
+
+inline void aux2_batch(unsigned int n, const double * x, double * y, double * dy=0)
+{
+  for(unsigned int i=0; i<n; ++i)
+    y[i] = aux2(x[i]);
+  if(dy)
+    for(unsigned int i=0; i<n; ++i)
+      dy[i] = pd1aux2(x[i]);
+}
+
+inline void fermi_half_batch(unsigned int n, const double * x, double * y, double * dy=0)
+{
+  if(dy)
+    for(unsigned int i=0; i<n; ++i)
+      y[i] = fermi_half(x[i], dy[i]);
   else
-    return 1.0;
+    for(unsigned int i=0; i<n; ++i)
+      y[i] = fermi_half(x[i]);
+}
+
+inline void inv_fermi_half_batch(unsigned int n, const double * x, double * y)
+{
+  for(unsigned int i=0; i<n; ++i)
+    y[i] = inv_fermi_half(x[i]);
+}
+
+inline void gamma_f_batch(unsigned int n, const double * x, double * y, double * dy=0)
+{
+  if(dy)
+    for(unsigned int i=0; i<n; ++i)
+      y[i] = gamma_f(x[i], dy[i]);
+  else
+    for(unsigned int i=0; i<n; ++i)
+      y[i] = gamma_f(x[i]);
 }
 
 
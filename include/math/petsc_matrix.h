@@ -35,6 +35,7 @@
 // Local includes
 #include "genius_petsc.h"
 #include "sparse_matrix.h"
+#include "sparsity_pattern.h"
 #include "petsc_macro.h"
 
 // Forward Declarations
@@ -265,6 +266,14 @@ public:
    */
   Mat mat () { return _mat; }
 
+  /**
+   * the first assembly will be buffered into the given pattern instead of
+   * per row maps, the CSR arrays of pattern are taken over by the matrix.
+   * entries out of the pattern are still accepted. only the entries really
+   * assembled go into the petsc matrix, the pattern may be a superset.
+   */
+  void set_sparsity_pattern(SparsityPattern & pattern);
+
 
 private:
   
@@ -272,9 +281,32 @@ private:
 
   /**
    * matrix data type to store local values
+   * when the buffer pattern is given, only entries out of the pattern are stored here
    */
   std::vector< std::map<unsigned int, T> > _mat_local;
 
+  /**
+   * CSR buffer of local values from set_sparsity_pattern()
+   */
+  std::vector<int> _buf_row_ptr;
+  std::vector<int> _buf_cols;
+  std::vector<T>   _buf_values;
+
+  /**
+   * flag of the buffer entries which have been assembled
+   */
+  std::vector<unsigned char> _buf_used;
+
+  /**
+   * @return reference to the buffered value of local entry (i, j), the entry is marked as assembled
+   */
+  T & _buf_entry(unsigned int i, unsigned int j);
+
+  /**
+   * @return pointer to the buffered value of local entry (i, j), NULL if it is never assembled
+   */
+  const T * _buf_find(unsigned int i, unsigned int j) const;
+
   /**
    *  matrix nonlocal values
    */ 
@@ -27,6 +27,7 @@
 
 
 #include "petscmat.h"
+#include "petscsnes.h"
 
 #include "genius_common.h"
 #include "dense_vector.h"
@@ -35,6 +36,12 @@
 namespace PetscUtils
 {
 
+  /**
+   * add the newton and linear iterations of the last SNESSolve to the performance counters,
+   * should be called after each SNESSolve
+   */
+  extern PetscErrorCode  SNESCountIterations(SNES snes);
+
   /**
    * wrap to petsc MatZeroRows
    */
@@ -0,0 +1,169 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __sparsity_pattern_h__
+#define __sparsity_pattern_h__
+
+#include <vector>
+
+#include "genius_common.h"
+#include "genius_env.h"
+#include "genius_petsc.h"
+
+
+/**
+ * nonzero pattern of a distributed sparse matrix, built from the couplings
+ * of dof blocks instead of entry by entry.
+ *
+ * the user declares that a range of rows couples to some ranges of columns,
+ * i.e. the dofs of a node to the dofs of its stencil nodes. build() groups
+ * the declarations by row with a counting sort and merges the column ranges
+ * of each row, the result is a sorted CSR of the local rows together with the
+ * on/off processor nonzeros petsc needs for preallocation.
+ *
+ * declarations for rows owned by other processors are sent to their owner in build().
+ * several patterns can be filled by different threads and joined by append().
+ */
+class SparsityPattern
+{
+public:
+
+  /**
+   * constructor, the local rows (and the on processor columns) are
+   * [global_offset, global_offset+n_local) of the n_global rows
+   */
+  SparsityPattern(unsigned int n_global, unsigned int n_local, unsigned int global_offset);
+
+  /**
+   * start a declaration: rows [row, row+n_rows) couple to the column ranges
+   * given by add_cols() until next add_rows()
+   */
+  void add_rows(unsigned int row, unsigned int n_rows)
+  {
+    _rec_row.push_back(row);
+    _rec_n_rows.push_back(n_rows);
+    _rec_begin.push_back(_range_col.size());
+  }
+
+  /**
+   * columns [col, col+n_cols) of the current declaration
+   */
+  void add_cols(unsigned int col, unsigned int n_cols)
+  {
+    genius_assert(!_rec_row.empty());
+    _range_col.push_back(col);
+    _range_n_cols.push_back(n_cols);
+  }
+
+  /**
+   * each of the rows couples to all the cols
+   */
+  void add_coupling(const std::vector<PetscInt> &rows, const std::vector<PetscInt> &cols);
+
+  /**
+   * move the declarations of other to this pattern
+   */
+  void append(SparsityPattern &other);
+
+  /**
+   * build the CSR of local rows from the declarations, which are released afterwards.
+   * must be called by all the processors
+   */
+  void build();
+
+  /**
+   * @return true when build() is done
+   */
+  bool built() const { return !_row_ptr.empty(); }
+
+  /**
+   * @return the number of local rows
+   */
+  unsigned int n_local() const { return _n_local; }
+
+  /**
+   * @return the number of nonzeros of local rows
+   */
+  unsigned int n_nonzeros() const { return _row_ptr.empty() ? 0 : _row_ptr.back(); }
+
+  /**
+   * the row pointer of CSR, size n_local+1
+   */
+  std::vector<int> & row_ptr() { return _row_ptr; }
+
+  /**
+   * global column index of CSR, sorted in each row
+   */
+  std::vector<int> & col_index() { return _col_index; }
+
+  /**
+   * on processor nonzeros of each local row
+   */
+  const std::vector<int> & n_nz() const { return _n_nz; }
+
+  /**
+   * off processor nonzeros of each local row
+   */
+  const std::vector<int> & n_oz() const { return _n_oz; }
+
+  /**
+   * release all the memory
+   */
+  void clear();
+
+private:
+
+  unsigned int _n_global;
+
+  unsigned int _n_local;
+
+  unsigned int _global_offset;
+
+  /**
+   * declarations: first row, row number and the first column range of each
+   */
+  std::vector<unsigned int> _rec_row;
+  std::vector<unsigned int> _rec_n_rows;
+  std::vector<unsigned int> _rec_begin;
+
+  /**
+   * column ranges of all the declarations
+   */
+  std::vector<unsigned int> _range_col;
+  std::vector<unsigned int> _range_n_cols;
+
+  /**
+   * send the declarations of nonlocal rows to their owner
+   */
+  void _exchange_nonlocal();
+
+  std::vector<int> _row_ptr;
+
+  std::vector<int> _col_index;
+
+  std::vector<int> _n_nz;
+
+  std::vector<int> _n_oz;
+};
+
+
+#endif // #define __sparsity_pattern_h__
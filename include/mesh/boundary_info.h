@@ -124,6 +124,7 @@ public:
   /**
    * Add side \p side of element \p elem with boundary id \p id
    * to the boundary information data structure.
+   * \p elem must already carry its final id.
    */
   void add_side (const Elem* elem,
          const unsigned short int side,
@@ -192,8 +193,7 @@ public:
   /**
    * @return true when given elem is a boundary element
    */
-  bool is_boundary_elem(const Elem *e) const
-  { return _boundary_side_id.find(e) != _boundary_side_id.end(); }
+  bool is_boundary_elem(const Elem *e) const;
   
   
   /**
@@ -206,7 +206,7 @@ public:
    * @returns the number of element-based boundary conditions.
    */
   unsigned int n_boundary_conds () const
-  { return _boundary_side_id.size(); }
+  { return _n_boundary_sides; }
 
 
   /**
@@ -386,6 +386,12 @@ public:
    */
   void rebuild_ids();
 
+  /**
+   * re-key the node and side tables by the current node/elem ids.
+   * must be called after the mesh renumbered its nodes or elems.
+   */
+  void reindex();
+
 
   /**
    * Number used for internal use. This is the return value
@@ -403,18 +409,61 @@ public:
   const MeshBase& _mesh;
 
   /**
-   * Data structure that maps nodes in the mesh
-   * to boundary ids.
+   * flat node table indexed by Node::id(). the node pointer is
+   * kept beside its boundary id, a slot only matches the node
+   * which owns it.
+   */
+  std::vector<const Node*> _boundary_node;
+  std::vector<short int>   _boundary_node_id;
+
+  /**
+   * number of nodes with a boundary id
+   */
+  unsigned int _n_boundary_nodes;
+
+  /**
+   * flat side table. the owner elem is indexed by Elem::id(),
+   * the boundary id of its side s lives at id*max_elem_sides+s,
+   * unset sides hold invalid_id.
+   */
+  std::vector<const Elem*> _boundary_elem;
+  std::vector<short int>   _boundary_side_id;
+
+  /**
+   * the further ids of a side which already has one in
+   * \p _boundary_side_id, keyed by its index in that table
+   */
+  std::multimap<unsigned int, short int> _boundary_side_extra_id;
+
+  /**
+   * number of (elem, side, id) entries
+   */
+  unsigned int _n_boundary_sides;
+
+  /**
+   * max sides of any elem, the stride of \p _boundary_side_id
+   */
+  static const unsigned int max_elem_sides;
+
+  /**
+   * @return the slot of \p node in the node table, invalid_uint if it has none
+   */
+  unsigned int _node_slot(const Node* node) const;
+
+  /**
+   * @return the slot of \p elem in the side table, invalid_uint if it has none
+   */
+  unsigned int _elem_slot(const Elem* elem) const;
+
+  /**
+   * clear all the side ids of elem slot \p e
    */
-  std::map<const Node*, short int> _boundary_node_id;
+  void _clear_elem_slot(unsigned int e);
 
   /**
-   * Data structure that maps sides of elements
-   * to boundary ids.
+   * all the ids of side \p i of the side table, the first one leads
    */
-  std::multimap<const Elem*,
-                std::pair<unsigned short int, short int> >
-                                             _boundary_side_id;
+  void _side_ids(unsigned int i, std::vector<short int> & ids) const;
 
   /**
    * A collection of user-specified boundary ids.
@@ -77,6 +77,16 @@ public:
    */
   void setDecks(Parser::InputParser *input);
 
+  /**
+   * read batch variants from file. each line defines a variant as
+   *   name  CARD:parameter=value  CARD:parameter=value ...
+   * the substitutions are applied to every card with the same keyword.
+   * only cards run again for each variant (MODEL, METHOD, SOLVE, ...) can be substituted,
+   * the cards build the mesh and simulation system are rejected.
+   * mainloop will run the deck once for each variant in the same process.
+   */
+  int setBatchFile(const std::string &fname);
+
   /**
    * set result output file (xml format)
    */
@@ -139,6 +149,12 @@ public:
    */
   int  do_solve   ( const Parser::Card & c );
 
+  /**
+   * do a transient for each particle event of the field source. every event starts
+   * from the state before the first one, and all of them share the solver of the SOLVE card
+   */
+  int  solve_particle_ensemble ( SolverBase * solver );
+
   /**
    * process and do "EXPORT" card
    */
@@ -219,6 +235,54 @@ private:
 
   Parser::InputParser *_decks;
 
+  /**
+   * parameter substitutions of a batch variant
+   */
+  struct BatchVariant
+  {
+    std::string name;
+
+    /**
+     * card keyword, parameter name and value of each substitution
+     */
+    std::vector<std::string> cards;
+    std::vector<std::string> parameters;
+    std::vector<std::string> values;
+  };
+
+  /**
+   * all the batch variants
+   */
+  std::vector<BatchVariant> _batch_variants;
+
+  /**
+   * run the cards of deck once
+   * @param build_system  when false, cards which (re)build the mesh and simulation system are skipped
+   */
+  void run_decks(bool build_system);
+
+  /**
+   * run all the batch variants. the simulation system is built by the first variant,
+   * later variants are warm started from the nearest of a few kept finished ones,
+   * including their boundary and external circuit state.
+   */
+  int batch_loop();
+
+  /**
+   * apply substitutions of variant to the deck, original parameters are saved in backup
+   */
+  void apply_batch_variant(const BatchVariant &variant, std::vector<std::pair<unsigned int, Parser::Card> > &backup);
+
+  /**
+   * restore the deck from backup of apply_batch_variant
+   */
+  void restore_batch_variant(const std::vector<std::pair<unsigned int, Parser::Card> > &backup);
+
+  /**
+   * distance between two variants, only substitutions differ between them count
+   */
+  static double batch_variant_distance(const BatchVariant &a, const BatchVariant &b);
+
   /**
    * the main mesh structure
    */
@@ -229,6 +293,17 @@ private:
    */
   AutoPtr<SimulationSystem> _system;
 
+  /**
+   * the solver kept alive by last SOLVE card, it will be reused by
+   * the next SOLVE card with the same solver type
+   */
+  SolverBase * _suspended_solver;
+
+  /**
+   * destroy the kept solver, must be called when the mesh or simulation system changes
+   */
+  void release_suspended_solver();
+
   /**
    * define the meshgen pointer,
    * we may use it if user want to generate mesh
@@ -23,6 +23,7 @@
 #define __data_storage_h__
 
 #include <vector>
+#include <iostream>
 #include "enum_data_type.h"
 #include "vector_value.h"
 #include "tensor_value.h"
@@ -279,6 +280,18 @@ public:
   PetscScalar & scalar(const unsigned int v, const unsigned int offset)
   { return _scalar_block[v][offset]; }
 
+  /**
+   * @return the contiguous data block of scalar variable v, indexed by offset
+   */
+  PetscScalar * scalar_block(const unsigned int v)
+  { return _scalar_block[v].empty() ? 0 : &_scalar_block[v][0]; }
+
+  /**
+   * @return the contiguous data block of scalar variable v, indexed by offset
+   */
+  const PetscScalar * scalar_block(const unsigned int v) const
+  { return _scalar_block[v].empty() ? 0 : &_scalar_block[v][0]; }
+
   /**
    * data access function
    */
@@ -291,6 +304,12 @@ public:
   std::complex<PetscScalar> & complex(const unsigned int v, const unsigned int offset)
   { return _complex_block[v][offset]; }
 
+  /**
+   * @return the contiguous data block of complex variable v, indexed by offset
+   */
+  std::complex<PetscScalar> * complex_block(const unsigned int v)
+  { return _complex_block[v].empty() ? 0 : &_complex_block[v][0]; }
+
   /**
    * data access function
    */
@@ -303,6 +322,19 @@ public:
   VectorValue<PetscScalar> & vector(const unsigned int v, const unsigned int offset)
   { return _vector_block[v][offset]; }
 
+  /**
+   * @return the data block of vector variable v, indexed by offset
+   * @note VectorValue has a vtable, the components are not densely packed
+   */
+  VectorValue<PetscScalar> * vector_block(const unsigned int v)
+  { return _vector_block[v].empty() ? 0 : &_vector_block[v][0]; }
+
+  /**
+   * @return the data block of vector variable v, indexed by offset
+   */
+  const VectorValue<PetscScalar> * vector_block(const unsigned int v) const
+  { return _vector_block[v].empty() ? 0 : &_vector_block[v][0]; }
+
   /**
    * data access function
    */
@@ -328,6 +360,48 @@ public:
   template <typename T>
   const T & data(const unsigned int , const unsigned int ) const;
 
+  /**
+   * @return true when other storage has the same size and allocated variables,
+   * then data can be copied between them without invalidate any DataObject
+   */
+  bool same_layout(const DataStorage &other) const
+  {
+    return _size == other._size &&
+           _scalar_fill  == other._scalar_fill  &&
+           _complex_fill == other._complex_fill &&
+           _vector_fill  == other._vector_fill  &&
+           _tensor_fill  == other._tensor_fill;
+  }
+
+  /**
+   * write the raw data arrays to binary stream, used by checkpoint
+   */
+  void write(std::ostream &out) const
+  {
+    out.write(reinterpret_cast<const char *>(&_size), sizeof(_size));
+    _write_blocks(out, _scalar_fill, _scalar_block);
+    _write_blocks(out, _complex_fill, _complex_block);
+    _write_blocks(out, _vector_fill, _vector_block);
+    _write_blocks(out, _tensor_fill, _tensor_block);
+  }
+
+  /**
+   * read data arrays written by write(), size and variables of this storage are replaced.
+   * thus only read into a storage not referenced by any DataObject, and copy it by
+   * assignment after checking same_layout()
+   * @return false when the stream is broken
+   */
+  bool read(std::istream &in)
+  {
+    _reserve_size = 0;
+    in.read(reinterpret_cast<char *>(&_size), sizeof(_size));
+    if( !_read_blocks(in, _size, _scalar_fill, _scalar_block) ) return false;
+    if( !_read_blocks(in, _size, _complex_fill, _complex_block) ) return false;
+    if( !_read_blocks(in, _size, _vector_fill, _vector_block) ) return false;
+    if( !_read_blocks(in, _size, _tensor_fill, _tensor_block) ) return false;
+    return true;
+  }
+
   /**
    * approx memory usage
    */
@@ -386,6 +460,44 @@ private:
   std::vector<bool> _tensor_fill;
   std::vector< std::vector<TensorValue<PetscScalar> > > _tensor_block;
 
+  template <typename T>
+  static void _write_blocks(std::ostream &out, const std::vector<bool> &fill, const std::vector< std::vector<T> > &block)
+  {
+    unsigned int n = fill.size();
+    out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+    for(unsigned int i=0; i<n; ++i)
+    {
+      char flag = fill[i];
+      out.write(&flag, 1);
+      if( flag && !block[i].empty() )
+        out.write(reinterpret_cast<const char *>(&block[i][0]), block[i].size()*sizeof(T));
+    }
+  }
+
+  template <typename T>
+  static bool _read_blocks(std::istream &in, unsigned int size, std::vector<bool> &fill, std::vector< std::vector<T> > &block)
+  {
+    unsigned int n = 0;
+    in.read(reinterpret_cast<char *>(&n), sizeof(n));
+    if( !in.good() ) return false;
+    fill.resize(n);
+    block.resize(n);
+    for(unsigned int i=0; i<n; ++i)
+    {
+      char flag = 0;
+      in.read(&flag, 1);
+      fill[i] = flag;
+      if( flag )
+      {
+        block[i].resize(size);
+        if( size )
+          in.read(reinterpret_cast<char *>(&block[i][0]), size*sizeof(T));
+      }
+      if( !in.good() ) return false;
+    }
+    return true;
+  }
+
 };
 
 
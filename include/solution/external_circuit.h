@@ -25,6 +25,7 @@
 #define __external_circuit_h__
 
 #include <string>
+#include <vector>
 #include <complex>
 
 #include "genius_common.h"
@@ -292,6 +293,41 @@ public:
     _current_old = _current;
   }
 
+  /**
+   * append the state of this circuit to buffer, used by solution checkpoint
+   */
+  virtual void save_state(std::vector<Real> & buffer) const
+  {
+    buffer.push_back(_Vapp);
+    buffer.push_back(_Iapp);
+    buffer.push_back(_potential);
+    buffer.push_back(_potential_old);
+    buffer.push_back(_current);
+    buffer.push_back(_current_old);
+    buffer.push_back(_current_displacement);
+    buffer.push_back(_current_conductance);
+    buffer.push_back(_current_electron);
+    buffer.push_back(_current_hole);
+  }
+
+  /**
+   * load the state saved by save_state from buffer, starting at pos.
+   * pos is advanced to the end of the state of this circuit
+   */
+  virtual void load_state(const std::vector<Real> & buffer, unsigned int & pos)
+  {
+    _Vapp                 = buffer[pos++];
+    _Iapp                 = buffer[pos++];
+    _potential            = buffer[pos++];
+    _potential_old        = buffer[pos++];
+    _current              = buffer[pos++];
+    _current_old          = buffer[pos++];
+    _current_displacement = buffer[pos++];
+    _current_conductance  = buffer[pos++];
+    _current_electron     = buffer[pos++];
+    _current_hole         = buffer[pos++];
+  }
+
 
 protected:
   /**
@@ -193,6 +193,26 @@ public:
    */
   virtual void tran_op_init();
 
+  /**
+   * append the state of this circuit to buffer
+   */
+  virtual void save_state(std::vector<Real> & buffer) const
+  {
+    ExternalCircuit::save_state(buffer);
+    buffer.push_back(_V1);
+    buffer.push_back(_V1_last);
+  }
+
+  /**
+   * load the state saved by save_state
+   */
+  virtual void load_state(const std::vector<Real> & buffer, unsigned int & pos)
+  {
+    ExternalCircuit::load_state(buffer, pos);
+    _V1      = buffer[pos++];
+    _V1_last = buffer[pos++];
+  }
+
 private:
 
   Real _r_app;
@@ -177,6 +177,26 @@ public:
     _cap_current = _cap_current_old = 0.0;
   }
 
+  /**
+   * append the state of this circuit to buffer
+   */
+  virtual void save_state(std::vector<Real> & buffer) const
+  {
+    ExternalCircuit::save_state(buffer);
+    buffer.push_back(_cap_current);
+    buffer.push_back(_cap_current_old);
+  }
+
+  /**
+   * load the state saved by save_state
+   */
+  virtual void load_state(const std::vector<Real> & buffer, unsigned int & pos)
+  {
+    ExternalCircuit::load_state(buffer, pos);
+    _cap_current     = buffer[pos++];
+    _cap_current_old = buffer[pos++];
+  }
+
 private:
 
   Real _res;
@@ -164,6 +164,26 @@ public:
    */
   virtual void tran_op_init();
 
+  /**
+   * append the state of this circuit to buffer
+   */
+  virtual void save_state(std::vector<Real> & buffer) const
+  {
+    ExternalCircuit::save_state(buffer);
+    buffer.insert(buffer.end(), _v.begin(), _v.end());
+    buffer.insert(buffer.end(), _v_last.begin(), _v_last.end());
+  }
+
+  /**
+   * load the state saved by save_state
+   */
+  virtual void load_state(const std::vector<Real> & buffer, unsigned int & pos)
+  {
+    ExternalCircuit::load_state(buffer, pos);
+    for(unsigned int i=0; i<_v.size(); ++i)      _v[i]      = buffer[pos++];
+    for(unsigned int i=0; i<_v_last.size(); ++i) _v_last[i] = buffer[pos++];
+  }
+
 private:
 
   Real _r_app;
@@ -377,6 +377,12 @@ public:
    */
   void PDE_off_processor_node_pattern(std::vector<std::pair<unsigned int, unsigned int> > &, bool elem_based=false) const;
 
+  /**
+   * get the PDE involved nodes the same as PDE_node_pattern(), but the nodes themselves
+   * instead of the statistic. the nodes are sorted and unique.
+   */
+  void PDE_node_stencil(std::vector<const FVM_Node *> & stencil, bool elem_based=false) const;
+
 
 
   typedef std::vector< std::pair<FVM_Node *, std::pair<Real, Real> > >::const_iterator fvm_neighbor_node_iterator;
@@ -319,6 +319,29 @@ private:
    */
   Real truncated_partial_area(const Elem * elem, unsigned int ne) const;
 
+  /**
+   * mobility and impact ionization coefficients of a cell edge
+   */
+  struct DDM1_LaggedCoefficient
+  {
+    PetscScalar mun, mup;     // edge mobility
+    PetscScalar IIn, IIp;     // impact ionization rate
+    PetscScalar riin1, riip2; // impact ionization weight of node 1 (electron) and node 2 (hole)
+  };
+
+  /**
+   * coefficients of all the cell edges in element order, saved by DDM1_Function when
+   * SolverSpecify::LaggedCoefficient is set. DDM1_Jacobian takes them as constants
+   * while SolverSpecify::LaggedCoefficientFrozen is true.
+   */
+  std::vector<DDM1_LaggedCoefficient> _ddm1_lagged_coeff;
+
+  /**
+   * jacobian of the cell edge terms with frozen coefficients
+   */
+  void DDM1_Lagged_Cell_Jacobian(SparseMatrix<PetscScalar> *jac,
+                                 const std::vector<AutoDScalar> &Jn_edge, const std::vector<AutoDScalar> &Jp_edge);
+
   /**
    * elem has its circumcircle center outside the region
    */
@@ -385,11 +408,28 @@ public:
    */
   virtual void DDM1_Function(PetscScalar * x, Vec f, InsertMode &add_value_flag);
 
+  /**
+   * build function and time derivative term for L1 DDM in one node sweep
+   */
+  virtual void DDM1_Function_Time_Dependent(PetscScalar * x, Vec f, InsertMode &add_value_flag);
+
+  /**
+   * the sweep behind DDM1_Function and DDM1_Function_Time_Dependent
+   */
+  void DDM1_Function_Sweep(PetscScalar * x, Vec f, InsertMode &add_value_flag, bool time_dependent);
+
   /**
    * build function and its jacobian for L1 DDM
    */
   virtual void DDM1_Jacobian(PetscScalar * x, SparseMatrix<PetscScalar> *jac, InsertMode &add_value_flag);
 
+  /**
+   * S-G current of all the edges with hand derived partial derivatives, and the
+   * jacobian of poisson's equation on the edges. used by DDM1_Jacobian instead of
+   * evaluating the whole edge flux with AD.
+   */
+  void DDM1_Edge_Jacobian(PetscScalar * x, SparseMatrix<PetscScalar> *jac, std::vector<AutoDScalar> &Jn_edge, std::vector<AutoDScalar> &Jp_edge);
+
   /**
    * build time derivative term and its jacobian for L1 DDM
    */
@@ -105,6 +105,52 @@ public:
    */
   virtual void reinit_after_import()=0;
 
+  /**
+   * copy node and cell data of this region, i.e. a snapshot of the solution
+   */
+  void save_data(DataStorage & node_data, DataStorage & cell_data) const
+  {
+    node_data = _node_data_storage;
+    cell_data = _cell_data_storage;
+  }
+
+  /**
+   * restore node and cell data from snapshot made by save_data
+   * @return false when the variables of this region changed after the snapshot, nothing restored
+   */
+  bool restore_data(const DataStorage & node_data, const DataStorage & cell_data)
+  {
+    if( !_node_data_storage.same_layout(node_data) || !_cell_data_storage.same_layout(cell_data) )
+      return false;
+    _node_data_storage = node_data;
+    _cell_data_storage = cell_data;
+    return true;
+  }
+
+  /**
+   * @return the storage of all the node data of this region
+   */
+  DataStorage & node_data_storage()
+  { return _node_data_storage; }
+
+  /**
+   * @return the storage of all the node data of this region
+   */
+  const DataStorage & node_data_storage() const
+  { return _node_data_storage; }
+
+  /**
+   * @return the storage of all the cell data of this region
+   */
+  DataStorage & cell_data_storage()
+  { return _cell_data_storage; }
+
+  /**
+   * @return the storage of all the cell data of this region
+   */
+  const DataStorage & cell_data_storage() const
+  { return _cell_data_storage; }
+
   /**
    * get the external temperature, as region's default temperature
    */
@@ -1083,6 +1129,22 @@ public:
    */
   virtual void DDM1_Time_Dependent_Function(PetscScalar * x, Vec f, InsertMode &add_value_flag)=0;
 
+  /**
+   * @brief virtual function for evaluating level 1 DDM equation together with its time derivative term.
+   *
+   * @param x                local unknown vector
+   * @param f                petsc global function vector
+   * @param add_value_flag   flag for last operator is ADD_VALUES
+   *
+   * @note the default calls DDM1_Function and DDM1_Time_Dependent_Function, regions
+   * may override it to evaluate both in one sweep over the nodes
+   */
+  virtual void DDM1_Function_Time_Dependent(PetscScalar * x, Vec f, InsertMode &add_value_flag)
+  {
+    DDM1_Function(x, f, add_value_flag);
+    DDM1_Time_Dependent_Function(x, f, add_value_flag);
+  }
+
   /**
    * @brief virtual function for evaluating Jacobian of time derivative term of level 1 DDM equation.
    *
@@ -0,0 +1,102 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __solution_checkpoint_h__
+#define __solution_checkpoint_h__
+
+#include <vector>
+#include <iostream>
+
+#include "data_storage.h"
+
+class SimulationSystem;
+
+
+/**
+ * in-memory snapshot of the solution state of a simulation system:
+ * node and cell data of each region (solution and transient history),
+ * the real parameters of each boundary and the state of external circuits.
+ *
+ * restoring the checkpoint puts the system back to the state of save(),
+ * mesh, boundary and solver objects are not touched.
+ * each processor keeps its local part only.
+ */
+class SolutionCheckpoint
+{
+public:
+
+  SolutionCheckpoint() : _valid(false) {}
+
+  /**
+   * take a snapshot of system
+   */
+  void save(const SimulationSystem & system);
+
+  /**
+   * restore the snapshot to system
+   * @return false when the system changed its layout after save(), nothing restored
+   */
+  bool restore(SimulationSystem & system) const;
+
+  /**
+   * write the snapshot to binary stream
+   */
+  void write(std::ostream &out) const;
+
+  /**
+   * read a snapshot written by write()
+   * @return false when the stream is broken
+   */
+  bool read(std::istream &in);
+
+  /**
+   * @return true when a snapshot is held
+   */
+  bool valid() const { return _valid; }
+
+  /**
+   * free the snapshot
+   */
+  void clear();
+
+private:
+
+  bool _valid;
+
+  /**
+   * node data of each region
+   */
+  std::vector<DataStorage> _node_data;
+
+  /**
+   * cell data of each region
+   */
+  std::vector<DataStorage> _cell_data;
+
+  /**
+   * state of all the boundaries, in bc order
+   */
+  std::vector<double> _bc_state;
+};
+
+
+#endif // __solution_checkpoint_h__
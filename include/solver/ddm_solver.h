@@ -24,6 +24,9 @@
 #ifndef __ddm_solver_h__
 #define __ddm_solver_h__
 
+#include <string>
+#include <deque>
+
 #include "fvm_flex_nonlinear_solver.h"
 
 /**
@@ -73,6 +76,23 @@ public:
    */
   virtual int solve_iv_trace();
 
+  /**
+   * write the full transient state: node/cell data, boundary and circuit state,
+   * solution history vectors and time step controller, to checkpoint file.
+   * each processor writes its own file
+   * @return true when all the processors succeeded
+   */
+  bool write_transient_checkpoint(const std::string &fname, int autostep_retry, int diverged_retry,
+                                  const std::deque<double> &time_step_success);
+
+  /**
+   * restore the transient state from checkpoint file, the solver should be
+   * created in the same way as the one which wrote the checkpoint
+   * @return true when all the processors succeeded
+   */
+  bool read_transient_checkpoint(const std::string &fname, int &autostep_retry, int &diverged_retry,
+                                 std::deque<double> &time_step_success);
+
   /**
    * do nonlinear solve with pseudo time step
    */
@@ -93,6 +113,21 @@ public:
    */
   virtual int destroy_solver();
   
+  /**
+   * the dof map, jacobian and snes/ksp/pc can be kept between SOLVE cards
+   */
+  virtual bool can_suspend() const { return true; }
+
+  /**
+   * keep the nonlinear data for the next SOLVE card
+   */
+  virtual int suspend_solver();
+
+  /**
+   * reuse the nonlinear data of last SOLVE card, apply the current METHOD settings
+   */
+  virtual int resume_solver();
+
   /**
    * do snes solve!
    */
@@ -142,6 +177,11 @@ public:
    */
   virtual void set_extra_matrix_nonzero_pattern();
 
+  /**
+   * add the nonlocal coupling of bc to the jacobian pattern
+   */
+  virtual void build_sparsity_pattern(SparsityPattern & pattern) const;
+
   /**
    * force carrier density to be positive during projection
    */
@@ -180,8 +220,21 @@ public:
    */
   virtual void petsc_ksp_convergence_test(PetscInt its, PetscReal rnorm, KSPConvergedReason* reason);
 
+  /**
+   * decide if the next jacobian uses frozen mobility / impact ionization coefficients,
+   * called by the snes convergence test with the 2-norm of solution and newton update,
+   * see SolverSpecify::LaggedCoefficient
+   */
+  void update_lagged_coefficient(PetscInt its, PetscReal xnorm, PetscReal pnorm);
+
 protected:
 
+  /**
+   * set snes/ksp tolerances and read petsc command line options,
+   * called by create_solver() and resume_solver()
+   */
+  void set_solver_tolerances();
+
   /**
    * the global privious solution vector at n step
    */
@@ -72,6 +72,21 @@ public:
    */
   virtual double profile(double x, double y, double z)=0;
 
+  /**
+   * compute the profile of n points in one call. the coordinates are given as
+   * separate x, y and z arrays, the result is written to d.
+   * the default implementation calls profile(x,y,z) for each point in serial,
+   * derived class can override it with a vectorizable or threaded loop when
+   * its profile evaluation is known to be thread safe.
+   */
+  virtual void profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *d);
+
+  /**
+   * the bounding box out of which the profile is zero (or negligible)
+   * @return false if the profile has no finite bounding box
+   */
+  virtual bool bound_box(Point &, Point &) const { return false; }
+
 protected:
   /**
    * impurity ion type N-ion or P-ion
@@ -106,6 +121,16 @@ public:
    */
   double profile(double x,double y,double z);
 
+  /**
+   * compute doping concentration of n points
+   */
+  void profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *d);
+
+  /**
+   * the bounding box of doping region
+   */
+  bool bound_box(Point &, Point &) const;
+
 private:
   /**
    * the peak value of doping concentration
@@ -173,6 +198,11 @@ public:
    */
   double profile(double x,double y,double z);
 
+  /**
+   * the bounding box of doping region
+   */
+  bool bound_box(Point &, Point &) const;
+
 
 private:
 
@@ -262,6 +292,19 @@ public:
    */
   double profile(double x, double y, double z);
 
+  /**
+   * compute doping concentration of n points.
+   * each direction is evaluated for all the points in its own loop
+   * without branch, which can be vectorized by compiler
+   */
+  void profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *d);
+
+  /**
+   * the bounding box of doping region, extended by 7 characteristic lengths.
+   * out of it the profile is less than 1e-21 of peak value.
+   */
+  bool bound_box(Point &, Point &) const;
+
 private:
   /**
    * the peak value of doping concentration
@@ -328,6 +371,11 @@ private:
    */
   bool   _ZERFC;
 
+  /**
+   * the distribution factor along one direction
+   */
+  static double _factor(double x, double xmin, double xmax, double xchar, bool xerfc);
+
 };
 
 
@@ -353,6 +401,17 @@ public:
    */
   double profile(double x, double y, double z);
 
+  /**
+   * compute doping concentration of n points, the mask plane and
+   * normalize factor are evaluated only once
+   */
+  void profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *d);
+
+  /**
+   * the bounding box of the doping lines swept from mask polygon
+   */
+  bool bound_box(Point &, Point &) const;
+
 private:
 
   /**
@@ -393,15 +452,30 @@ private:
 
   PolygonUSample _mask_mesh;
 
+  /**
+   * doping bounding box
+   */
+  Point _doping_min;
+
+  /**
+   * doping bounding box
+   */
+  Point _doping_max;
+
 
-  std::vector<double> prof_func_r(const std::vector<double> &rs) const;
+  double prof_func_r(double r) const;
 
 
-  std::vector<double> prof_func_l(const std::vector<double> &dists) const;
+  double prof_func_l(double dist) const;
 
 
   double prof_func_lnorm() const;
 
+  /**
+   * compute doping concentration at p with given mask plane and normalize factor
+   */
+  double _profile(const Point &p, const Point &plane_point, const Point &plane_norm, double A) const;
+
 
 };
 
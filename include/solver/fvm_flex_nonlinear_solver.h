@@ -36,6 +36,7 @@
 #include "petscsnes.h"
 
 
+class KLUSolver;
 
 
 /**
@@ -152,6 +153,19 @@ public:
    */
   void clear_nonlinear_data();
 
+  /**
+   * keep vectors, scatter, jacobian matrix with its nonzero pattern,
+   * snes/ksp/pc and KLU factorization for the next SOLVE card.
+   * only the petsc options set by this solver are cleared
+   */
+  void suspend_nonlinear_data();
+
+  /**
+   * apply the (maybe changed) solver and preconditioner types
+   * to the kept snes/ksp/pc
+   */
+  void resume_nonlinear_data();
+
 
   /**
    * Sets the type of nonlinear solver to use.
@@ -295,6 +309,23 @@ protected:
    */
   VecScatter     scatter;
 
+  /**
+   * scatter global vector v to local vector lx. the scatter is skipped when lx already
+   * holds v and v is not modified since then, i.e. the jacobian evaluation following the
+   * residual evaluation at the same x. every scatter into lx should go through here.
+   */
+  void scatter_local_solution(Vec v);
+
+  /**
+   * the vector lx was scattered from, and its state at that time
+   */
+  Vec            lx_source;
+#if PETSC_VERSION_GE(3,5,0)
+  PetscObjectState lx_source_state;
+#else
+  PetscInt       lx_source_state;
+#endif
+
   /**
    * petsc nonlinear solver contex
    */
@@ -324,6 +355,12 @@ protected:
    */
   PC             pc;
 
+  /**
+   * KLU direct solver, used as PCSHELL when linear solver is KLU.
+   * it keeps symbolic analysis alive between newton iterations and bias points
+   */
+  KLUSolver *    klu;
+
   /**
    * array for ksp residual history
    */
@@ -25,6 +25,7 @@
 
 #include "solver_base.h"
 
+class SparsityPattern;
 
 
 /**
@@ -77,6 +78,13 @@ public:
    */
   void build_dof_map();
 
+  /**
+   * virtual function indicates if PDE involves all neighbor elements.
+   * when it is true, the matrix bandwidth will include all the nodes belongs to neighbor elements, i.e. DDM solver
+   * when it is false, only neighbor nodes (link local node by edge) are appeared in matrix bandwidth, i.e. poisson solver.
+   */
+  virtual bool all_neighbor_elements_involved(const SimulationRegion * ) const  { return false; }
+
   /**
    * @return the (exact) nodal dofs of each simulation region
    */
@@ -97,6 +105,13 @@ public:
    */
   virtual void set_extra_matrix_nonzero_pattern()  { return; }
 
+  /**
+   * declare the jacobian entries of node and bc dofs to pattern, which is a superset of
+   * the entries assembled: each node couples to its FVM stencil, the bc dofs to the
+   * stencil of boundary nodes. must be called after build_dof_map()
+   */
+  virtual void build_sparsity_pattern(SparsityPattern & pattern) const;
+
 protected:
 
   /**
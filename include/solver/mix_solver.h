@@ -54,6 +54,11 @@ public:
    */
   virtual int destroy_solver();
 
+  /**
+   * the circuit is linked to the device for each SOLVE card, do not keep the solver
+   */
+  virtual bool can_suspend() const { return false; }
+
 
   /**
    * do pre-process before each solve action
@@ -95,14 +95,14 @@ private:
  enum Profile_Data_Axes {AXES_X, AXES_Y, AXES_Z, AXES_XY, AXES_XZ, AXES_YZ, AXES_XYZ};
 
  /**
-  * @return the first mole fraction of given node
+  * @return the first mole fraction of given node from mole profile file
   */
- double mole_x(const std::string & region, const Node * node);
+ double mole_x_data(const Node * node);
 
  /**
-  * @return the second mole fraction of given node
+  * @return the second mole fraction of given node from mole profile file
   */
- double mole_y(const std::string & region, const Node * node);
+ double mole_y_data(const Node * node);
 
  /**
   * the pointer vector to DopingFunction
@@ -47,6 +47,15 @@ public:
    */
   virtual double profile(double x, double y, double z)=0;
 
+  /**
+   * compute mole fraction at n points in one call, the result is stored in m
+   */
+  virtual void profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *m)
+  {
+    for(unsigned int i=0; i<n; ++i)
+      m[i] = profile(x[i], y[i], z[i]);
+  }
+
   /**
    * @return region name as const reference
    */
@@ -151,6 +160,24 @@ public:
   
   }
 
+  /**
+   * compute mole fraction at n points, grading direction is resolved only once
+   */
+  void profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *m)
+  {
+    const double *c = 0;
+    switch(_dir)
+    {
+      case X_Direction: c = x; break;
+      case Y_Direction: c = y; break;
+      case Z_Direction: c = z; break;
+      default: genius_error();
+    }
+
+    for(unsigned int i=0; i<n; ++i)
+      m[i] = (c[i] >= _base_plane && c[i] <= _end_plane) ? _mole_begin + (c[i]-_base_plane)*_mole_slope : 0.0;
+  }
+
   /**
    * @return \p true if this is first mole fraction for signle compound material
    */
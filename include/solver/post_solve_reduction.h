@@ -0,0 +1,171 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __post_solve_reduction_h__
+#define __post_solve_reduction_h__
+
+#include <string>
+#include <vector>
+
+#include "genius_common.h"
+#include "enum_data_location.h"
+#include "point.h"
+#include "vector_value.h"
+
+class SimulationSystem;
+class SimulationRegion;
+
+
+/**
+ * reductions of region variables shared by the post solve hooks.
+ *
+ * a hook registers its reductions (max/min with location, sum, volume integral)
+ * once, and the solver evaluates all of them in one sweep over the node and cell
+ * data of each region before the hooks' post_solve() is called. all the reductions
+ * of a region read the same node (cell) in the same pass, so the region data is
+ * traversed once no matter how many monitors are attached.
+ */
+class PostSolveReduction
+{
+public:
+
+  enum Operation
+  {
+    MAX,      // max value and the node/elem id where reached
+    MIN,      // min value and the node/elem id where reached
+    SUM,      // sum of value
+    INTEGRAL  // sum of value times control volume (elem volume)
+  };
+
+  PostSolveReduction() {}
+
+  /**
+   * register a reduction of region variable over on processor nodes (POINT_CENTER)
+   * or cells (CELL_CENTER) of the region, or of all the regions when region is empty.
+   * vector variable is reduced by its magnitude.
+   * when lower < upper in any direction, only the nodes (elem centroids) in box [lower, upper] are counted
+   * @return the handle of the reduction
+   */
+  unsigned int add(Operation op, const std::string & variable, DataLocation location,
+                   const std::string & region="", const Point & lower=Point(), const Point & upper=Point());
+
+  /**
+   * @return the number of reductions
+   */
+  unsigned int n_reductions() const { return _reductions.size(); }
+
+  /**
+   * remove all the reductions, the node and cell lists of the regions are kept
+   */
+  void clear() { _reductions.clear(); }
+
+  /**
+   * evaluate all the reductions, must be executed in parallel
+   */
+  void evaluate(const SimulationSystem & system);
+
+  /**
+   * @return true when any node/cell is counted by the reduction in last evaluate()
+   */
+  bool valid(unsigned int h) const { return _reductions[h].count > 0; }
+
+  /**
+   * @return the value of reduction in last evaluate()
+   */
+  Real value(unsigned int h) const { return _reductions[h].value; }
+
+  /**
+   * @return the node/elem id where MAX/MIN reduction reached, invalid_uint for others
+   */
+  unsigned int location(unsigned int h) const { return _reductions[h].id; }
+
+private:
+
+  struct Reduction
+  {
+    Operation     op;
+    std::string   variable;
+    DataLocation  data_location;
+    std::string   region;
+    bool          box;
+    Point         lower;
+    Point         upper;
+
+    Real          value;
+    unsigned int  id;
+    unsigned int  count;
+  };
+
+  std::vector<Reduction> _reductions;
+
+  /**
+   * on processor nodes (cells) of a region: data offset, control volume, id and position
+   */
+  struct Entities
+  {
+    const SimulationRegion * region;
+    unsigned int n_total;
+    std::vector<unsigned int> offset;
+    std::vector<Real> volume;
+    std::vector<unsigned int> id;
+    std::vector<Point> position;
+  };
+
+  /**
+   * nodes and cells of each region, rebuilt when the regions change
+   */
+  std::vector<Entities> _nodes;
+  std::vector<Entities> _cells;
+
+  void _build_entities(const SimulationSystem & system);
+
+  /**
+   * partial result of the reductions on one processor or thread
+   */
+  struct Partial
+  {
+    std::vector<Real> value;
+    std::vector<unsigned int> id;
+    std::vector<unsigned int> count;
+
+    void init(const std::vector<Reduction> & reductions);
+    void merge(const std::vector<Reduction> & reductions, const Partial & other);
+  };
+
+  /**
+   * the data of one reduction in a region
+   */
+  struct Source
+  {
+    unsigned int reduction;
+    const PetscScalar * scalar;
+    const VectorValue<PetscScalar> * vector;
+  };
+
+  /**
+   * sweep entities [begin, end), update the partial result of sources
+   */
+  void _sweep(const Entities & entities, unsigned int begin, unsigned int end,
+              const std::vector<Source> & sources, Partial & partial) const;
+};
+
+#endif
@@ -30,6 +30,7 @@
 #include "boundary_condition_collector.h"
 #include "solver_specify.h"
 #include "hook_list.h"
+#include "post_solve_reduction.h"
 #include "log.h"
 #include "perf_log.h"
 
@@ -87,6 +88,24 @@ public:
    */
   virtual int destroy_solver();
 
+  /**
+   * @return true when the solver data can be kept between SOLVE cards
+   * by suspend_solver() and resume_solver()
+   */
+  virtual bool can_suspend() const { return false; }
+
+  /**
+   * close the hooks of this SOLVE card, but keep the solver data
+   * for the next SOLVE card of the same solver type
+   */
+  virtual int suspend_solver();
+
+  /**
+   * prepare a suspended solver for a new SOLVE card,
+   * it takes the place of create_solver()
+   */
+  virtual int resume_solver();
+
   /**
    * @return reference to system
    */
@@ -145,6 +164,18 @@ public:
   HookList * hook_list()
   { return & _hooks; }
 
+  /**
+   * reductions shared by the hooks, evaluated before post_solve of the hooks
+   */
+  PostSolveReduction & reduction()
+  { return _reduction; }
+
+  /**
+   * reductions shared by the hooks, evaluated before post_solve of the hooks
+   */
+  const PostSolveReduction & reduction() const
+  { return _reduction; }
+
   /**
    * set the root node of solution dom
    */
@@ -167,6 +198,11 @@ protected:
    */
   HookList           _hooks;
 
+  /**
+   * the reductions registered by hooks
+   */
+  PostSolveReduction _reduction;
+
   /**
    * create a solution dom element, and add to the dom document
    */
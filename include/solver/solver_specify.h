@@ -63,6 +63,11 @@ namespace SolverSpecify
    */
   extern std::string      out_prefix;
 
+  /**
+   * label of the particle event solved by an ensemble transient, empty otherwise
+   */
+  extern std::string      event_label;
+
   /**
    * the append model for output file
    */
@@ -89,6 +94,28 @@ namespace SolverSpecify
    */
   extern int     NSLagJacobian;
 
+  /**
+   * freeze the mobility and impact ionization coefficients in the DDML1 jacobian,
+   * full derivatives are restored when the newton update drops below LaggedCoefficientTol
+   */
+  extern bool    LaggedCoefficient;
+
+  /**
+   * relative newton update |dx|/|x| below which the frozen coefficients are released
+   */
+  extern double  LaggedCoefficientTol;
+
+  /**
+   * set by the nonlinear solver, true while the jacobian uses frozen coefficients
+   */
+  extern bool    LaggedCoefficientFrozen;
+
+  /**
+   * keep the solver (dof map, jacobian pattern, snes/ksp/pc) alive between
+   * SOLVE cards of the same solver type
+   */
+  extern bool    ReuseSolver;
+
   /**
    * linear solver scheme: LU, BCGS, GMRES ...
    */
@@ -398,6 +425,21 @@ namespace SolverSpecify
    */
   extern bool      tran_histroy;
 
+  /**
+   * file of transient checkpoint, empty for no checkpoint
+   */
+  extern std::string      checkpoint_file;
+
+  /**
+   * wall clock interval (in second) between transient checkpoints, 0 for only on signal
+   */
+  extern double    checkpoint_interval;
+
+  /**
+   * continue the transient from this checkpoint file, empty for a new transient
+   */
+  extern std::string      restart_file;
+
   /**
    * current time
    */
@@ -33,6 +33,7 @@
 //#include "petscmat.h"
 #include "petscksp.h"
 
+class Elem;
 
 /**
  * The linear solver contex.
@@ -88,10 +89,10 @@ public:
 
 
   /**
-   * @return node's dof for each region. only 1 dof here
+   * @return node's dof for each region. the 3 displacement components
    */
   virtual unsigned int node_dofs(const SimulationRegion * region) const
-  { assert(region!=NULL); return 1; }
+  { assert(region!=NULL); return 3; }
 
   /**
    * @return the dofs of each boundary condition
@@ -105,8 +106,11 @@ public:
   virtual unsigned int bc_node_dofs(const BoundaryCondition * bc) const
   { assert(bc!=NULL); return 0; }
 
+  /**
+   * the element stiff matrix couples all the nodes of an element
+   */
   virtual bool all_neighbor_elements_involved(const SimulationRegion *) const
-  { return false; }
+  { return true; }
 
  private:
 
@@ -115,6 +119,62 @@ public:
   */
  Parser::InputParser & _decks;
 
+ /**
+  * geometry data of a straight-sided linear simplex element.
+  * the shape function gradients are constant over such element,
+  * and the integral of each shape function is a weighted sum of
+  * the reference table, so no FE reinit is needed.
+  */
+ struct AffineElem
+ {
+   const Elem * elem;
+   unsigned int n_nodes;
+   /// physical gradient of each shape function
+   Real dphi[4][3];
+   /// integral of each shape function over the element
+   Real phi_JxW[4];
+   /// index of each node in _node_offset
+   unsigned int node[4];
+ };
+
+ /**
+  * linear simplex elements, assembled from cached affine data.
+  * sorted by color, elements of one color share no node
+  */
+ std::vector<AffineElem> _affine_elems;
+
+ /**
+  * the affine elements of color c are [_affine_color_begin[c], _affine_color_begin[c+1])
+  */
+ std::vector<unsigned int> _affine_color_begin;
+
+ /**
+  * the other elements, assembled by FEBase::reinit
+  */
+ std::vector<const Elem *> _general_elems;
+
+ /**
+  * index in _node_offset of the nodes of each general element, one after another
+  */
+ std::vector<unsigned int> _general_elem_nodes;
+
+ /**
+  * global offset of the fvm nodes used by the local elements
+  */
+ std::vector<PetscInt> _node_offset;
+
+ /**
+  * the load vector of the local elements, 3 entries per node of _node_offset.
+  * filled by build_matrix() and added to b by build_rhs()
+  */
+ std::vector<PetscScalar> _node_load;
+
+ /**
+  * fill _affine_elems and _general_elems with the on processor elements,
+  * the cache is kept until destroy_solver() since the mesh does not change in between
+  */
+ void _build_elem_cache();
+
 };
 
 
@@ -66,6 +66,18 @@ public:
    */
   bool applied_to_system() const { return _applied_to_system; }
 
+  /**
+   * force the next update() to rebuild OptG and PatG,
+   * should be called when node data was changed outside field source
+   */
+  void invalidate_generation() { _generation_valid = false; }
+
+  /**
+   * drop the generation profiles of all the sources, they are indexed by node data of the old mesh.
+   * the next update() will call update_source() again
+   */
+  void clear_mesh_data();
+
   /**
    * @return the limited time step
    */
@@ -83,6 +95,22 @@ public:
   LightLenses  * light_lenses() const
   { return _light_lenses; }
 
+  /**
+   * @return the number of particle events, the largest one of all the particle sources
+   */
+  unsigned int n_particle_events() const;
+
+  /**
+   * @return the label of particle event e
+   */
+  std::string particle_event_label(unsigned int e) const;
+
+  /**
+   * let particle sources deposit the energy of event e and update the sources.
+   * sources with a single event keep it
+   */
+  void select_particle_event(unsigned int e);
+
   /**
    * @return true when we have light source
    */
@@ -156,6 +184,16 @@ private:
    */
   bool _applied_to_system;
 
+  /**
+   * OptG and PatG are up to date with _generation_scale
+   */
+  bool _generation_valid;
+
+  /**
+   * time scale of each particle and light source applied by last update()
+   */
+  std::vector<double> _generation_scale;
+
   /**
    * all the particle sources
    */
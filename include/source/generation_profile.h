@@ -0,0 +1,88 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __generation_profile_h__
+#define __generation_profile_h__
+
+#include <vector>
+
+class SimulationSystem;
+class FVM_Node;
+
+
+/**
+ * spatial carrier generation profile of a field source.
+ *
+ * the profile is kept as one dense array per semiconductor region, indexed by
+ * the offset of the node data in the region's node DataStorage. thus applying
+ * the source at a time step is a single multiply-add sweep over the OptG/PatG
+ * data block, the time dependence is only a scale factor.
+ *
+ * only on processor nodes of semiconductor regions hold a profile value,
+ * entries of other nodes are never applied.
+ */
+class GenerationProfile
+{
+public:
+
+  GenerationProfile(SimulationSystem &system)
+    : _system(system), _dummy(0.0)
+  {}
+
+  /**
+   * @return writable profile value of fvm_node
+   */
+  double & operator[] (const FVM_Node *fvm_node);
+
+  /**
+   * @return profile value of fvm_node
+   */
+  double operator[] (const FVM_Node *fvm_node) const;
+
+  /**
+   * remove all the profile values
+   */
+  void clear();
+
+  /**
+   * add scale*profile to the scalar node variable v of each semiconductor region,
+   * v is the variable index in node DataStorage, i.e. FVM_Semiconductor_NodeData::_OptG_
+   */
+  void apply(unsigned int v, double scale) const;
+
+private:
+
+  SimulationSystem & _system;
+
+  /**
+   * profile of each region, empty for regions without generation
+   */
+  std::vector< std::vector<double> > _profile;
+
+  /**
+   * write target for nodes not hold a profile value
+   */
+  double _dummy;
+};
+
+
+#endif // __generation_profile_h__
@@ -32,6 +32,7 @@
 #include "vector_value.h"
 #include "tensor_value.h"
 #include "waveform.h"
+#include "generation_profile.h"
 
 namespace Parser{
   class InputParser;
@@ -48,7 +49,7 @@ public:
    * constructor
    */
   Light_Source(SimulationSystem & system)
-  : _system(system), _waveform(0), _global_waveform(0)
+  : _system(system), _waveform(0), _global_waveform(0), _fvm_node_particle_deposit(system)
   {}
 
   /**
@@ -66,11 +67,21 @@ public:
    */
   virtual void carrier_generation(double t);
 
+  /**
+   * @return the time scale of optical generation averaged over the time step at t
+   */
+  double carrier_generation_step(double t);
+
   /**
    * virtual function to update OptG
    */
   virtual void update_source() {}
 
+  /**
+   * drop the data which depend on the mesh, the mesh is about to change
+   */
+  virtual void clear_mesh_data() { _fvm_node_particle_deposit.clear(); }
+
   /**
    * virtual function for limit the time step
    */
@@ -109,7 +120,7 @@ protected:
   /**
    * light energy deposit for on processor FVM node
    */
-  std::map<const FVM_Node *, double> _fvm_node_particle_deposit;
+  GenerationProfile _fvm_node_particle_deposit;
 
 };
 
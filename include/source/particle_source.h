@@ -24,9 +24,11 @@
 #ifndef __particle_source_h__
 #define __particle_source_h__
 
+#include "genius_env.h"
 #include "auto_ptr.h"
 #include "point.h"
 #include "interpolation_base.h"
+#include "generation_profile.h"
 
 namespace Parser{
   class InputParser;
@@ -35,6 +37,7 @@ namespace Parser{
 class SimulationSystem;
 class SimulationRegion;
 class FVM_Node;
+class NearestNodeLocator;
 
 /**
  * set the carrier generation of Particle
@@ -45,7 +48,7 @@ public:
   /**
    *  constructor, do nothing
    */
-  Particle_Source(SimulationSystem &system) : _system(system) {}
+  Particle_Source(SimulationSystem &system) : _system(system), _fvm_node_particle_deposit(system) {}
 
   /**
    * destructor
@@ -57,11 +60,36 @@ public:
    */
   virtual void carrier_generation(double t);
 
+  /**
+   * @return the time scale of particle generation averaged over the time step at t
+   */
+  double carrier_generation_step(double t) const;
+
   /**
    * calculate the PatG for each mesh node
    */
   virtual void update_source()=0;
 
+  /**
+   * drop the data which depend on the mesh, the mesh is about to change
+   */
+  virtual void clear_mesh_data() { _fvm_node_particle_deposit.clear(); }
+
+  /**
+   * @return the number of independent particle events, i.e. strikes of an ensemble transient
+   */
+  virtual unsigned int n_events() const { return 1; }
+
+  /**
+   * @return the label of event e
+   */
+  virtual std::string event_label(unsigned int e) const { return std::string(); }
+
+  /**
+   * let following update_source() only deposit the energy of event e
+   */
+  virtual void select_event(unsigned int e) {}
+
   /**
    * virtual function for limit the time step
    */
@@ -104,7 +132,7 @@ protected:
  /**
   * particle energy deposit for on processor FVM node
   */
- std::map<const FVM_Node *, double> _fvm_node_particle_deposit;
+ GenerationProfile _fvm_node_particle_deposit;
 
 };
 
@@ -209,13 +237,33 @@ public:
   /**
    * destructor
    */
-  ~Particle_Source_Track() {}
+  ~Particle_Source_Track();
 
   /**
    * assign PatG to mesh node
    */
   virtual void update_source();
 
+  /**
+   * @return the number of events in the track file
+   */
+  virtual unsigned int n_events() const { return _event_labels.size(); }
+
+  /**
+   * @return the label of event e
+   */
+  virtual std::string event_label(unsigned int e) const { return _event_labels[e]; }
+
+  /**
+   * select event e
+   */
+  virtual void select_event(unsigned int e) { genius_assert(e < n_events()); _event = e; }
+
+  /**
+   * drop the node locator together with the deposit, it holds nodes of the old mesh
+   */
+  virtual void clear_mesh_data();
+
 private:
 
   int _version;
@@ -232,6 +280,26 @@ private:
 
   std::vector<track_t> _tracks;
 
+  /**
+   * tracks of event e are _tracks[ _event_begin[e], _event_begin[e+1] )
+   */
+  std::vector<unsigned int> _event_begin;
+
+  /**
+   * label of each event
+   */
+  std::vector<std::string> _event_labels;
+
+  /**
+   * current event
+   */
+  unsigned int _event;
+
+  /**
+   * node locator, shared by all the events on the same mesh
+   */
+  AutoPtr<NearestNodeLocator> _nn_locator;
+
   void _read_particle_profile_track_evt(const std::string &, Real );
 #ifdef HAVE_HDF5
   void _read_particle_profile_track_hdf5(const std::string &, const std::string & path, Real );
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "octree.h"
+#include "linear_octree.h"
 
 class SimulationSystem;
 class MeshBase;
@@ -54,6 +55,13 @@ class DoseRate
      */
     void energy_deposite(const Point &p1, const Point &p2, double e);
 
+    /**
+     * calculate energy deposite of a batch of tracks (p1[n], p2[n]) with energy e[n].
+     * the tracks are distributed to threads when OpenMP is enabled, each thread
+     * has its own energy accumulator
+     */
+    void energy_deposite(const std::vector<Point> &p1, const std::vector<Point> &p2, const std::vector<double> &e);
+
     /**
      * parallel sync
      */
@@ -163,6 +171,42 @@ class DoseRate
      * geometry octree
      */
     OcTree * _octree;
+
+    /**
+     * flat copy of the octree leaves for point location and track traversal
+     */
+    LinearOcTree _linear_octree;
+
+    /**
+     * leaf data, energy, weighted density and volume in the leaf order of _linear_octree.
+     * _leaf_energy holds the deposited energy, it is stored back to the leaf data
+     * before the octree is refined or exported
+     */
+    std::vector<OcTreeDataDoseRate *> _leaf_data;
+    std::vector<double> _leaf_energy;
+    std::vector<double> _leaf_density;
+    std::vector<double> _leaf_volume;
+
+    /**
+     * energy accumulator of each thread except master
+     */
+    std::vector< std::vector<double> > _thread_energy;
+
+    /**
+     * build the leaf arrays after octree changed
+     */
+    void _build_leaves();
+
+    /**
+     * write _leaf_energy to the leaf data
+     */
+    void _store_leaf_energy();
+
+    /**
+     * add the energy of track (p1, p2) to energy array
+     */
+    void _deposite(const Point &p1, const Point &p2, double e, double * energy,
+                   std::vector<std::pair<unsigned int, Real> > & hits) const;
 };
 
 #endif
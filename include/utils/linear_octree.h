@@ -0,0 +1,142 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#ifndef __linear_octree_h__
+#define __linear_octree_h__
+
+#include <vector>
+#include <utility>
+
+#include "genius_common.h"
+#include "point.h"
+
+class OcTree;
+
+
+/**
+ * flat (linear) copy of the leaves of an OcTree.
+ *
+ * the root box is mapped to an integer grid of 2^max_level cells in each direction,
+ * and a leaf is identified by the Morton code of its low corner on this grid.
+ * leaves are stored in Morton order in contiguous arrays, so point location is a
+ * binary search on the codes. a segment is traversed leaf by leaf with a 3D-DDA:
+ * the exit face of current leaf gives the grid cell just outside it, which is then
+ * located by its code. no tree iterators and no epsilon stepping are involved.
+ *
+ * the leaf geometry is fixed after build(), rebuild when the OcTree is refined.
+ */
+class LinearOcTree
+{
+public:
+
+  /**
+   * max depth of the octree, 21 bits per direction fit in 64 bit Morton code
+   */
+  static const unsigned int max_level = 21;
+
+  LinearOcTree() {}
+
+  /**
+   * build from the leaves of octree
+   */
+  void build(const OcTree & octree);
+
+  /**
+   * clear all the leaves
+   */
+  void clear();
+
+  /**
+   * @return the number of leaves
+   */
+  unsigned int n_leaves() const { return _code.size(); }
+
+  /**
+   * @return the index of leaf n in the leaf iterating order of OcTree
+   */
+  unsigned int tree_leaf(unsigned int n) const { return _tree_leaf[n]; }
+
+  /**
+   * @return the volume of leaf n
+   */
+  Real volume(unsigned int n) const;
+
+  /**
+   * @return the index of the leaf which has point p, invalid_uint if p is outside the root
+   */
+  unsigned int locate(const Point & p) const;
+
+  /**
+   * the leaves crossed by segment (p1, p2) and the length of segment in each leaf
+   * are appended to result. segment outside the root box is ignored
+   */
+  void intersect(const Point & p1, const Point & p2, std::vector<std::pair<unsigned int, Real> > & result) const;
+
+private:
+
+  typedef unsigned long long code_type;
+
+  /**
+   * low corner and edge length of the root box
+   */
+  Point _low;
+  Real  _size[3];
+
+  /**
+   * grid cells per unit length in each direction
+   */
+  Real  _scale[3];
+
+  /**
+   * Morton code of the leaf low corner, sorted
+   */
+  std::vector<code_type> _code;
+
+  /**
+   * level of each leaf, the leaf has 2^(max_level-level) grid cells in each direction
+   */
+  std::vector<unsigned char> _level;
+
+  /**
+   * leaf index in OcTree leaf iterating order
+   */
+  std::vector<unsigned int> _tree_leaf;
+
+  /**
+   * @return the leaf which contains grid cell (i, j, k)
+   */
+  unsigned int _find(const unsigned int * ijk) const;
+
+  /**
+   * interleave the bits of grid cell index
+   */
+  static code_type _encode(const unsigned int * ijk);
+
+  /**
+   * inverse of _encode
+   */
+  static void _decode(code_type code, unsigned int * ijk);
+};
+
+
+#endif
@@ -0,0 +1,99 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __mmap_file_h__
+#define __mmap_file_h__
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+
+/**
+ * read only view of a whole file for the mesh/field importers.
+ *
+ * the file is memory mapped when the platform supports it, then the importer
+ * parses the page cache directly without copying it into istream buffers.
+ * on other platforms, or when mmap fails, the file is read into memory once.
+ */
+class MMapFile
+{
+public:
+
+  MMapFile();
+
+  ~MMapFile();
+
+  /**
+   * open the file
+   * @return true when succeeded
+   */
+  bool open(const std::string & filename);
+
+  /**
+   * unmap/free the file
+   */
+  void close();
+
+  /**
+   * @return true when file is open
+   */
+  bool is_open() const
+  { return _data != 0; }
+
+  /**
+   * @return the first char of the file
+   */
+  const char * begin() const
+  { return _data; }
+
+  /**
+   * @return past the last char of the file
+   */
+  const char * end() const
+  { return _data + _size; }
+
+  /**
+   * @return the file size in bytes
+   */
+  size_t size() const
+  { return _size; }
+
+private:
+
+  const char * _data;
+
+  size_t _size;
+
+  /**
+   * true when _data is mapped, otherwise it points to _buffer
+   */
+  bool _mapped;
+
+  std::vector<char> _buffer;
+
+  // no copy
+  MMapFile(const MMapFile &);
+  MMapFile & operator= (const MMapFile &);
+};
+
+#endif // #define __mmap_file_h__
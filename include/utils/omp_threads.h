@@ -0,0 +1,59 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __omp_threads_h__
+#define __omp_threads_h__
+
+#include <cstddef>
+
+#include "config.h"
+
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+
+namespace OmpThreads
+{
+
+  /**
+   * loops with less work than this run on one thread,
+   * the cost of starting the thread team is not paid back.
+   * the unit is a loop item of a few hundred flops, i.e. one fvm node
+   */
+  const std::size_t min_loop_work = 10000;
+
+  /**
+   * @return the number of threads for a loop of n items, each costs
+   * about item_cost units of min_loop_work. 1 without OpenMP
+   */
+  inline int loop_threads(std::size_t n, std::size_t item_cost=1)
+  {
+#ifdef HAVE_OPENMP
+    if( n*item_cost > min_loop_work ) return omp_get_max_threads();
+#endif
+    return 1;
+  }
+
+}
+
+#endif // #ifndef __omp_threads_h__
@@ -0,0 +1,208 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __scratch_vector_h__
+#define __scratch_vector_h__
+
+#include <vector>
+
+#include "config.h"
+#include "genius_common.h"
+#include "perf_log.h"
+
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+
+/**
+ * a std::vector leased from a per-thread pool of scratch buffers.
+ *
+ * the assemble kernels need a number of small temporary vectors for each cell
+ * (AD vertex values, column index ...). declaring them as ScratchVector instead of
+ * std::vector reuses the buffers of previous cells and newton iterations, so once
+ * every buffer has grown to the largest cell, the kernel does no heap allocation.
+ *
+ * the vector is empty when leased and returned to the pool on destruction. it
+ * converts to std::vector<T> & and can be passed to functions taking std::vector.
+ * the number of times the pool has to allocate, on any thread, is recorded in the
+ * perf log as "scratch allocations", it should stop growing after the first iteration.
+ *
+ * the pool is meant for small per cell scratch. buffers larger than max_pool_bytes
+ * are freed on release instead of kept, and each thread keeps at most max_pool_size
+ * free buffers, so region sized arrays should be plain std::vector.
+ */
+template <typename T>
+class ScratchVector
+{
+public:
+
+  typedef typename std::vector<T>::size_type       size_type;
+  typedef typename std::vector<T>::reference       reference;
+  typedef typename std::vector<T>::const_reference const_reference;
+  typedef typename std::vector<T>::iterator        iterator;
+  typedef typename std::vector<T>::const_iterator  const_iterator;
+
+  /**
+   * lease an empty vector
+   */
+  ScratchVector() : _v(_acquire()), _capacity(_v->capacity())
+  {}
+
+  /**
+   * lease a vector of \p n copies of \p value
+   */
+  explicit ScratchVector(size_type n, const T &value = T()) : _v(_acquire()), _capacity(_v->capacity())
+  { _v->assign(n, value); }
+
+  /**
+   * return the vector to the pool
+   */
+  ~ScratchVector()
+  {
+    if( _v->capacity() != _capacity ) _count_allocation();
+    _release(_v);
+  }
+
+  operator std::vector<T> & ()             { return *_v; }
+  operator const std::vector<T> & () const { return *_v; }
+
+  size_type size() const     { return _v->size(); }
+  bool empty() const         { return _v->empty(); }
+  void clear()               { _v->clear(); }
+  void reserve(size_type n)  { _v->reserve(n); }
+  void resize(size_type n, const T &value = T()) { _v->resize(n, value); }
+  void assign(size_type n, const T &value) { _v->assign(n, value); }
+  void push_back(const T &value) { _v->push_back(value); }
+
+  reference       operator [] (size_type i)       { return (*_v)[i]; }
+  const_reference operator [] (size_type i) const { return (*_v)[i]; }
+  reference       back()        { return _v->back(); }
+  const_reference back() const  { return _v->back(); }
+
+  iterator       begin()       { return _v->begin(); }
+  const_iterator begin() const { return _v->begin(); }
+  iterator       end()         { return _v->end(); }
+  const_iterator end() const   { return _v->end(); }
+
+private:
+
+  /**
+   * max number of threads supported
+   */
+  static const int max_threads = 64;
+
+  /**
+   * max free buffers kept by each thread
+   */
+  static const unsigned int max_pool_size = 64;
+
+  /**
+   * max size of a buffer kept in the pool, in bytes
+   */
+  static const size_t max_pool_bytes = 1<<16;
+
+  /**
+   * free vectors of one thread
+   */
+  struct Pool
+  {
+    std::vector< std::vector<T> * > free;
+    ~Pool()
+    {
+      for(unsigned int n=0; n<free.size(); ++n)
+        delete free[n];
+    }
+  };
+
+  static Pool & _pool()
+  {
+    static Pool pools[max_threads];
+#ifdef HAVE_OPENMP
+    const int tid = omp_get_thread_num();
+    genius_assert(tid < max_threads);
+    return pools[tid];
+#else
+    return pools[0];
+#endif
+  }
+
+  static std::vector<T> * _acquire()
+  {
+    Pool & pool = _pool();
+    if( pool.free.empty() )
+    {
+      _count_allocation();
+      return new std::vector<T>;
+    }
+    std::vector<T> * v = pool.free.back();
+    pool.free.pop_back();
+    v->clear();
+    return v;
+  }
+
+  static void _release(std::vector<T> * v)
+  {
+    Pool & pool = _pool();
+    if( pool.free.size() >= max_pool_size || v->capacity()*sizeof(T) > max_pool_bytes )
+    {
+      delete v;
+      return;
+    }
+    pool.free.push_back(v);
+  }
+
+  static void _count_allocation()
+  {
+#ifdef HAVE_OPENMP
+    // the perf log is not thread safe, other threads leave their count
+    // to the next allocation of master thread
+    static unsigned int pending = 0;
+    unsigned int n = 0;
+    #pragma omp critical (scratch_vector_count)
+    {
+      pending++;
+      if( omp_get_thread_num() == 0 ) { n = pending; pending = 0; }
+    }
+    if( n ) PERF_COUNT("scratch allocations", n);
+#else
+    PERF_COUNT("scratch allocations", 1);
+#endif
+  }
+
+  // not copyable
+  ScratchVector(const ScratchVector &);
+  ScratchVector & operator = (const ScratchVector &);
+
+  /**
+   * the leased vector
+   */
+  std::vector<T> * _v;
+
+  /**
+   * capacity when leased, to detect reallocation
+   */
+  size_type _capacity;
+};
+
+
+#endif // #ifndef __scratch_vector_h__
@@ -94,6 +94,13 @@ public:
    */
   virtual std::pair<const Elem*, unsigned int> operator() (const Point& p, Point & project_point, Real dist=1e30) const = 0;
 
+  /**
+   * Locates the surface elements nearest to a batch of points, the default version calls
+   * operator() for each point.
+   */
+  virtual void locate (const std::vector<Point> & points, std::vector<std::pair<const Elem*, unsigned int> > & elems,
+                       std::vector<Point> & project_points, Real dist=1e30) const;
+
   /**
    * @returns \p true when this object is properly initialized
    * and ready for use, \p false otherwise.
@@ -0,0 +1,137 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#ifndef __surface_locator_bvh_h__
+#define __surface_locator_bvh_h__
+
+#include <vector>
+
+#include "surface_locator_base.h"
+#include "point.h"
+
+// Forward Declarations
+class MeshBase;
+class Elem;
+
+
+/**
+ * surface element locator based on bounding volume hierarchy (BVH).
+ * the axis aligned bounding boxes of surface elements are organized in a binary tree
+ * built by median split along the longest axis. the query is a branch and bound
+ * traversal, subtrees whose box is farther than the best distance found so far are skipped.
+ * the result is the exact nearest surface element, and the search cost is about log(n).
+ */
+
+// ------------------------------------------------------------
+// SurfaceLocatorBVH class definition
+class SurfaceLocatorBVH : public SurfaceLocatorBase
+{
+public:
+
+  /**
+   * Constructor.
+   */
+  SurfaceLocatorBVH (const MeshBase& mesh, const unsigned int subdomain);
+
+  /**
+   * Constructor.
+   */
+  SurfaceLocatorBVH (const MeshBase& mesh, const short int boundary);
+
+  /**
+   * Destructor.
+   */
+  ~SurfaceLocatorBVH ();
+
+  /**
+   * Clears the \p SurfaceLocator.
+   */
+  void clear();
+
+  /**
+   * Initializes the surface locator, so that the \p operator() methods can
+   * be used.
+   */
+  void init();
+
+  /**
+   * Locates the element which is nearest to given point p within distance dist
+   */
+  std::pair<const Elem*, unsigned int> operator() (const Point& p, Point & project_point, const Real dist=1e30) const ;
+
+  /**
+   * Locates the surface elements nearest to a batch of points.
+   * the queries are independent and run in parallel when OpenMP is enabled
+   */
+  void locate (const std::vector<Point> & points, std::vector<std::pair<const Elem*, unsigned int> > & elems,
+               std::vector<Point> & project_points, Real dist=1e30) const;
+
+private:
+
+  /**
+   * node of the hierarchy. for leaf, the surface elements are
+   * _leaf_elems[begin, end), otherwise left child is this+1 and right child is at index right
+   */
+  struct BVHNode
+  {
+    Point  min, max;
+    unsigned int begin, end;
+    unsigned int right;
+    bool leaf;
+  };
+
+  /**
+   * max surface elements in a leaf
+   */
+  static const unsigned int _leaf_size = 4;
+
+  /**
+   * flat array of tree nodes, root at 0
+   */
+  std::vector<BVHNode> _bvh_nodes;
+
+  /**
+   * surface element in the leaf order
+   */
+  std::vector<const Elem *> _leaf_elems;
+
+  /**
+   * the volume element and side index of each surface element in _leaf_elems
+   */
+  std::vector<std::pair<const Elem *, unsigned int> > _leaf_volume_elems;
+
+  /**
+   * build the subtree of elements [begin, end), return the index of subtree root
+   */
+  unsigned int _build(unsigned int begin, unsigned int end, std::vector<unsigned int> & order,
+                      const std::vector<Point> & elem_min, const std::vector<Point> & elem_max,
+                      const std::vector<Point> & elem_center);
+
+  /**
+   * squared distance from point p to box [min, max]
+   */
+  static Real _dist_sq(const Point &p, const Point &min, const Point &max);
+};
+
+
+#endif
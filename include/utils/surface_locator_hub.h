@@ -49,7 +49,7 @@ public:
   /**
    * Constructor.
    */
-  SurfaceLocatorHub (const MeshBase& mesh, const SurfaceLocatorType t=SurfaceLocator_SPHERE);
+  SurfaceLocatorHub (const MeshBase& mesh, const SurfaceLocatorType t=SurfaceLocator_BVH);
 
   /**
    * Destructor.
@@ -74,6 +74,12 @@ public:
    */
   std::pair<const Elem*, unsigned int> operator() (const Point& p, const short int boundary, Point & project_point, const Real dist=1e30);
 
+  /**
+   * Locates the surface elements with specified subdomain which are nearest to a batch of points
+   */
+  void locate (const std::vector<Point> & points, const unsigned int subdomain,
+               std::vector<std::pair<const Elem*, unsigned int> > & elems, std::vector<Point> & project_points, const Real dist=1e30);
+
 private:
 
   /**
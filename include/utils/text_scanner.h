@@ -0,0 +1,207 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __text_scanner_h__
+#define __text_scanner_h__
+
+#include <string>
+#include <cstring>
+
+
+/**
+ * a light weight, locale free scanner over a char range, i.e. a MMapFile.
+ *
+ * numbers are parsed without going through istream and its locale/facet
+ * machinery, which dominates the import time of large text meshes.
+ * real numbers accept the fortran 'D' exponent.
+ * the scanner can also read native binary values, for the binary
+ * sections of some formats.
+ */
+class TextScanner
+{
+public:
+
+  TextScanner(const char * begin, const char * end)
+    : _p(begin), _end(end)
+  {}
+
+  /**
+   * @return current position
+   */
+  const char * pos() const
+  { return _p; }
+
+  /**
+   * set current position
+   */
+  void set_pos(const char * p)
+  { _p = p; }
+
+  /**
+   * @return past the last char
+   */
+  const char * end() const
+  { return _end; }
+
+  /**
+   * @return true when only white space remains
+   */
+  bool eof()
+  {
+    skip_space();
+    return _p >= _end;
+  }
+
+  /**
+   * skip white space, include line ends
+   */
+  void skip_space()
+  {
+    while( _p < _end && is_space(*_p) ) ++_p;
+  }
+
+  /**
+   * move to the begin of next line
+   */
+  void skip_line()
+  {
+    const char * p = static_cast<const char *>(std::memchr(_p, '\n', _end - _p));
+    _p = p ? p + 1 : _end;
+  }
+
+  /**
+   * get next white space separated token
+   * @return false when no token left
+   */
+  bool token(const char * & b, const char * & e)
+  {
+    skip_space();
+    if( _p >= _end ) return false;
+    b = _p;
+    while( _p < _end && !is_space(*_p) ) ++_p;
+    e = _p;
+    return true;
+  }
+
+  /**
+   * get next token as string
+   */
+  bool get(std::string & s)
+  {
+    const char * b, * e;
+    if( !token(b, e) ) return false;
+    s.assign(b, e);
+    return true;
+  }
+
+  /**
+   * get next token as integer
+   */
+  bool get(long & v);
+
+  bool get(int & v)
+  {
+    long l;
+    if( !get(l) ) return false;
+    v = static_cast<int>(l);
+    return true;
+  }
+
+  bool get(unsigned int & v)
+  {
+    long l;
+    if( !get(l) || l < 0 ) return false;
+    v = static_cast<unsigned int>(l);
+    return true;
+  }
+
+  /**
+   * get next token as real number
+   */
+  bool get(double & v);
+
+  /**
+   * @return true and skip the next token if it starts with s
+   */
+  bool match(const char * s)
+  {
+    skip_space();
+    size_t n = std::strlen(s);
+    if( static_cast<size_t>(_end - _p) < n || std::strncmp(_p, s, n) ) return false;
+    while( _p < _end && !is_space(*_p) ) ++_p;
+    return true;
+  }
+
+  /**
+   * find the next line begins with s, from current position
+   * @return the begin of that line, or end() when not found
+   */
+  const char * find_line(const char * s) const;
+
+  /**
+   * read a native binary value
+   */
+  template <typename T>
+  bool read_binary(T & v)
+  {
+    if( static_cast<size_t>(_end - _p) < sizeof(T) ) return false;
+    std::memcpy(&v, _p, sizeof(T));
+    _p += sizeof(T);
+    return true;
+  }
+
+  /**
+   * read an array of native binary values
+   */
+  template <typename T>
+  bool read_binary_array(T * v, size_t n)
+  {
+    if( static_cast<size_t>(_end - _p) < n*sizeof(T) ) return false;
+    std::memcpy(v, _p, n*sizeof(T));
+    _p += n*sizeof(T);
+    return true;
+  }
+
+  /**
+   * parse real number in [b, e) without locale
+   * @return false when [b, e) is not a number
+   */
+  static bool parse_real(const char * b, const char * e, double & v);
+
+  /**
+   * parse integer number in [b, e)
+   * @return false when [b, e) is not a number
+   */
+  static bool parse_integer(const char * b, const char * e, long & v);
+
+  static bool is_space(char c)
+  { return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f'; }
+
+private:
+
+  const char * _p;
+
+  const char * _end;
+};
+
+
+#endif // #define __text_scanner_h__
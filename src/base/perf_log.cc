@@ -24,10 +24,16 @@
 #include <iomanip>
 #include <ctime>
 #include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cassert>
 
 // Local includes
 #include "perf_log.h"
 #include "genius_env.h"
+#include "memory_log.h"
 
 #ifdef ENABLE_PERFORMANCE_LOGGING
 
@@ -65,53 +71,126 @@ inline int gettimeofday(struct timeval_t *tp, void *tzp)
 
 
 
-void PerfData::start ()
-{
-  this->count++;
-  this->called_recursively++;
-  gettimeofday (&(this->tstart), NULL);
-}
-
-
+// ------------------------------------------------------------
+// local helper functions
+
+namespace {
+
+  /**
+   * "header::label", or "label" for event without header
+   */
+  std::string event_full_name(const std::pair<std::string, std::string> &name)
+  {
+    if (name.first.empty()) return name.second;
+    return name.first + "::" + name.second;
+  }
+
+  /**
+   * quote a string for json output
+   */
+  std::string json_string(const std::string &s)
+  {
+    std::string r("\"");
+    for (unsigned int i=0; i<s.size(); ++i)
+    {
+      const char c = s[i];
+      if (c == '"' || c == '\\') { r += '\\'; r += c; }
+      else if (static_cast<unsigned char>(c) < 0x20) r += ' ';
+      else r += c;
+    }
+    r += '"';
+    return r;
+  }
+
+  /**
+   * quote a string for csv output
+   */
+  std::string csv_string(const std::string &s)
+  {
+    std::string r("\"");
+    for (unsigned int i=0; i<s.size(); ++i)
+    {
+      if (s[i] == '"') r += '"';
+      r += s[i];
+    }
+    r += '"';
+    return r;
+  }
+
+  /**
+   * sort scopes by inclusive time, longest first
+   */
+  struct ScopeTimeGreater
+  {
+    ScopeTimeGreater(const std::vector<PerfScope> &s) : scopes(s) {}
+    bool operator() (unsigned int a, unsigned int b) const
+    { return scopes[a].incl_time > scopes[b].incl_time; }
+    const std::vector<PerfScope> & scopes;
+  };
 
-void PerfData::restart ()
-{
-  gettimeofday (&(this->tstart), NULL);
 }
 
 
 
+// ------------------------------------------------------------
+// PerfScope class member funcions
 
+const unsigned int PerfScope::n_hist_bins;
 
-double PerfData::pause ()
-{
-  // save the start times, reuse the structure we have rather than create
-  // a new one.
-  const double
-      tstart_tv_sec  = this->tstart.tv_sec,
-  tstart_tv_usec = this->tstart.tv_usec;
 
-  gettimeofday (&(this->tstart), NULL);
+PerfScope::PerfScope (unsigned int e, unsigned int p) :
+  event(e),
+  parent(p),
+  count(0),
+  incl_time(0.),
+  self_time(0.),
+  min_time(0.),
+  max_time(0.)
+{
+  for (unsigned int i=0; i<n_hist_bins; ++i)
+    hist[i] = 0;
+}
 
-  const double elapsed_time = (static_cast<double>(this->tstart.tv_sec  - tstart_tv_sec) +
-      static_cast<double>(this->tstart.tv_usec - tstart_tv_usec)*1.e-6);
 
-  this->tot_time += elapsed_time;
 
-  return elapsed_time;
+void PerfScope::record (double t)
+{
+  if (count == 0 || t < min_time) min_time = t;
+  if (t > max_time) max_time = t;
+  count++;
+  incl_time += t;
+
+  // bin i holds [2^(i-1), 2^i) microseconds
+  int e = 0;
+  const double us = t*1.e6;
+  if (us >= 1.0)
+    std::frexp(us, &e);
+  hist[std::min(static_cast<unsigned int>(e), n_hist_bins-1)]++;
 }
 
 
-double PerfData::stopit ()
-{
-  // stopit is just like pause except decriments the
-  // recursive call counter
 
-  this->called_recursively--;
-  return this->pause();
+double PerfScope::quantile (double q) const
+{
+  if (count == 0) return 0.;
+
+  const double target = q*count;
+  unsigned int acc = 0;
+  for (unsigned int i=0; i<n_hist_bins; ++i)
+  {
+    acc += hist[i];
+    if (acc >= target)
+    {
+      // upper edge of the bin, clipped by the recorded extremes
+      const double t = std::ldexp(1.0, static_cast<int>(i))*1.e-6;
+      return std::max(min_time, std::min(max_time, t));
+    }
+  }
+  return max_time;
 }
 
 
+
 // ------------------------------------------------------------
 // PerfLog class member funcions
 
@@ -122,10 +201,14 @@ PerfLog::PerfLog(const std::string& ln,
                  const bool le) :
   label_name(ln),
   log_events(le),
-  total_time(0.)
+  total_time(0.),
+  _trace_events(false),
+  _trace_capacity(0),
+  _trace_dropped(0)
 {
-  if (log_events)
-    this->clear();
+  // the root of call tree
+  _scopes.push_back(PerfScope());
+  tstart = _t_mark = _now();
 }
 
 
@@ -137,35 +220,197 @@ PerfLog::~PerfLog()
 
 
 
+double PerfLog::_now()
+{
+#ifdef WINDOWS
+  struct timeval_t t;
+#else
+  struct timeval t;
+#endif
+  gettimeofday (&t, NULL);
+  return static_cast<double>(t.tv_sec) + static_cast<double>(t.tv_usec)*1.e-6;
+}
 
 
 
 void PerfLog::clear()
 {
-  if (log_events)
+  //  check that all events are closed
+  if (!log_stack.empty())
     {
-      //  check that all events are closed
-      for (std::map<std::pair<std::string,std::string>, PerfData>::iterator
-             pos = log.begin(); pos != log.end(); ++pos)
-        if (pos->second.open)
-          {
-            std::cout
-              << "ERROR clearning performance log for class "
-              << label_name << std::endl
-              << "event " << pos->first.second << " is still being monitored!"
-              << std::endl;
+      const std::pair<std::string, std::string> & name = _event_names[_scopes[log_stack.back().scope].event];
+      std::cout
+        << "ERROR clearning performance log for class "
+        << label_name << std::endl
+        << "event " << name.second << " is still being monitored!"
+        << std::endl;
+
+      genius_error();
+    }
 
-            genius_error();
-          }
+  // keep the interned ids, they are cached by START_LOG/STOP_LOG
+  std::fill(log.begin(), log.end(), PerfData());
+  std::fill(_counters.begin(), _counters.end(), 0);
+  std::fill(_counters_at_mark.begin(), _counters_at_mark.end(), 0);
 
+  _scopes.clear();
+  _scopes.push_back(PerfScope());
 
-      gettimeofday (&tstart, NULL);
+  _steps.clear();
+  _trace.clear();
+  _trace_dropped = 0;
+
+  total_time = 0.;
+  tstart = _t_mark = _now();
+}
+
+
+
+unsigned int PerfLog::event_id(const std::string &label,
+                               const std::string &header)
+{
+  const std::pair<std::string, std::string> name(header, label);
+
+  std::map<std::pair<std::string, std::string>, unsigned int>::const_iterator it = _event_index.find(name);
+  if (it != _event_index.end())
+    return it->second;
+
+  const unsigned int id = _event_names.size();
+  _event_names.push_back(name);
+  _event_index.insert(std::make_pair(name, id));
+  log.push_back(PerfData());
+  return id;
+}
+
+
+
+unsigned int PerfLog::counter_id(const std::string &name)
+{
+  for (unsigned int i=0; i<_counter_names.size(); ++i)
+    if (_counter_names[i] == name)
+      return i;
+
+  _counter_names.push_back(name);
+  _counters.push_back(0);
+  return _counter_names.size()-1;
+}
 
-      log.clear();
 
-      while (!log_stack.empty())
-        log_stack.pop();
+
+void PerfLog::push (unsigned int id)
+{
+  if (!this->log_events) return;
+
+  const double now = _now();
+
+  // pause the active event
+  unsigned int parent = 0;
+  if (!log_stack.empty())
+    {
+      const Frame & top = log_stack.back();
+      const double t = now - top.t_resume;
+      _scopes[top.scope].self_time += t;
+      log[_scopes[top.scope].event].tot_time += t;
+      total_time += t;
+      parent = top.scope;
+    }
+
+  // find the scope of this event under its parent, a scope usually has only a few children
+  unsigned int scope = invalid_uint;
+  {
+    const std::vector<unsigned int> & children = _scopes[parent].children;
+    for (unsigned int c=0; c<children.size(); ++c)
+      if (_scopes[children[c]].event == id)
+        { scope = children[c]; break; }
+  }
+  if (scope == invalid_uint)
+    {
+      scope = _scopes.size();
+      _scopes.push_back(PerfScope(id, parent));
+      _scopes[parent].children.push_back(scope);
     }
+
+  log[id].count++;
+
+  Frame frame;
+  frame.scope    = scope;
+  frame.t_start  = now;
+  frame.t_resume = now;
+  log_stack.push_back(frame);
+}
+
+
+
+void PerfLog::pop (unsigned int id)
+{
+  if (!this->log_events) return;
+
+  assert (!log_stack.empty());
+
+  const double now = _now();
+
+  const Frame & top = log_stack.back();
+  PerfScope & scope = _scopes[top.scope];
+  assert (scope.event == id);
+
+  const double t = now - top.t_resume;
+  scope.self_time += t;
+  log[id].tot_time += t;
+  total_time += t;
+
+  const double duration = now - top.t_start;
+  scope.record(duration);
+
+  if (_trace_events)
+    {
+      if (_trace.size() < _trace_capacity)
+        {
+          TraceRecord record;
+          record.event    = id;
+          record.depth    = log_stack.size()-1;
+          record.t_start  = top.t_start - tstart;
+          record.duration = duration;
+          _trace.push_back(record);
+        }
+      else
+        _trace_dropped++;
+    }
+
+  log_stack.pop_back();
+
+  // resume the lower event
+  if (!log_stack.empty())
+    log_stack.back().t_resume = now;
+}
+
+
+
+void PerfLog::mark_step (const std::string &label, double clock)
+{
+  if (!this->log_events) return;
+
+  const double now = _now();
+
+  MMU * mmu = MMU::instance();
+  mmu->measure();
+
+  StepRecord step;
+  step.label   = label;
+  step.clock   = clock;
+  step.t_begin = _t_mark - tstart;
+  step.t_end   = now - tstart;
+  step.vmrss   = mmu->vmrss();
+  step.vmhwm   = mmu->vmhwm();
+
+  _counters_at_mark.resize(_counters.size(), 0);
+  step.counters.resize(_counters.size());
+  for (unsigned int i=0; i<_counters.size(); ++i)
+    step.counters[i] = _counters[i] - _counters_at_mark[i];
+
+  _steps.push_back(step);
+
+  _counters_at_mark = _counters;
+  _t_mark = now;
 }
 
 
@@ -281,20 +526,9 @@ std::string PerfLog::get_perf_info() const
 {
   OStringStream out;
 
-  if (log_events && !log.empty())
+  if (log_events && _scopes.size() > 1)
     {
-      // Stop timing for this event.
-#ifdef WINDOWS
-      struct timeval_t tstop;
-#else
-      struct timeval tstop;
-#endif
-
-
-      gettimeofday (&tstop, NULL);
-
-      const double elapsed_time = (static_cast<double>(tstop.tv_sec  - tstart.tv_sec) +
-                                   static_cast<double>(tstop.tv_usec - tstart.tv_usec)*1.e-6);
+      const double elapsed_time = _now() - tstart;
 
       // Figure out the formatting required based on the event names
       // Unsigned ints for each of the column widths
@@ -304,12 +538,12 @@ std::string PerfLog::get_perf_info() const
       const unsigned int avg_time_col_width   = 12;
       const unsigned int pct_active_col_width = 13;
 
-      // Iterator to be used to loop over the map of timed events
-      std::map<std::pair<std::string,std::string>, PerfData>::const_iterator pos;
+      // Iterator to be used to loop over the timed events, sorted by name
+      std::map<std::pair<std::string,std::string>, unsigned int>::const_iterator pos;
 
       // Reset the event column width based on the longest event name plus
       // a possible 2-character indentation, plus a space.
-      for (pos = log.begin(); pos != log.end(); ++pos)
+      for (pos = _event_index.begin(); pos != _event_index.end(); ++pos)
         if (pos->first.second.size()+3 > event_col_width)
           event_col_width = pos->first.second.size()+3;
 
@@ -383,9 +617,9 @@ std::string PerfLog::get_perf_info() const
 
       std::string last_header("");
 
-      for (pos = log.begin(); pos != log.end(); ++pos)
+      for (pos = _event_index.begin(); pos != _event_index.end(); ++pos)
         {
-          const PerfData& perf_data = pos->second;
+          const PerfData& perf_data = log[pos->second];
 
           // Only print the event if the count is non-zero.
           if (perf_data.count != 0)
@@ -496,7 +730,7 @@ std::string PerfLog::get_log() const
     {
       // Only print the log
       // if it isn't empty
-      if (!log.empty())
+      if (_scopes.size() > 1)
         {
           // Possibly print machine info,
           // but only do this once
@@ -506,6 +740,8 @@ std::string PerfLog::get_log() const
               out << get_info_header();
             }
           out << get_perf_info();
+          out << get_tree_info();
+          out << get_counter_info();
         }
     }
 
@@ -555,6 +791,365 @@ void PerfLog::restart_event(const std::string &,
 
 
 
+std::string PerfLog::get_tree_info() const
+{
+  OStringStream out;
+
+  if (log_events && _scopes.size() > 1)
+    {
+      const unsigned int ncalls_col_width = 10;
+      const unsigned int time_col_width   = 12;
+
+      // Reset the scope column width based on the longest event name
+      // with 2-character indentation for each level, plus a space.
+      unsigned int scope_col_width = 30;
+      for (unsigned int s=1; s<_scopes.size(); ++s)
+        {
+          unsigned int depth = 0;
+          for (unsigned int p=_scopes[s].parent; p!=0; p=_scopes[p].parent)
+            depth++;
+          const unsigned int width = 2*depth + event_full_name(_event_names[_scopes[s].event]).size() + 1;
+          if (width > scope_col_width)
+            scope_col_width = width;
+        }
+
+      const unsigned int total_col_width = scope_col_width + ncalls_col_width + 6*time_col_width + 1;
+
+      out << ' ';
+      this->_character_line(total_col_width, '-', out);
+      out << '\n';
+
+      out << "| ";
+      OSSStringleft(out, total_col_width-1, label_name + " Call Tree (time in second, median/p90 from log2 histogram)");
+      out << "|\n";
+
+      out << ' ';
+      this->_character_line(total_col_width, '-', out);
+      out << '\n';
+
+      out << "| ";
+      OSSStringleft(out,scope_col_width,"Scope");
+      OSSStringleft(out,ncalls_col_width,"nCalls");
+      OSSStringleft(out,time_col_width,"Inclusive");
+      OSSStringleft(out,time_col_width,"Self");
+      OSSStringleft(out,time_col_width,"Min");
+      OSSStringleft(out,time_col_width,"Median");
+      OSSStringleft(out,time_col_width,"P90");
+      OSSStringleft(out,time_col_width,"Max");
+      out << "|\n|";
+      this->_character_line(total_col_width, '-', out);
+      out << "|\n";
+
+      std::vector<unsigned int> children(_scopes[0].children);
+      std::sort(children.begin(), children.end(), ScopeTimeGreater(_scopes));
+      for (unsigned int c=0; c<children.size(); ++c)
+        this->_print_scope(children[c], 0, scope_col_width, out);
+
+      out << ' ';
+      this->_character_line(total_col_width, '-', out);
+      out << '\n';
+    }
+
+  return out.str();
+}
+
+
+
+void PerfLog::_print_scope(unsigned int s, unsigned int depth, unsigned int name_width, OStringStream& out) const
+{
+  const PerfScope & scope = _scopes[s];
+
+  // skip the scope which never finished
+  if (scope.count == 0) return;
+
+  out << "| ";
+  this->_character_line(2*depth, ' ', out);
+  OSSStringleft(out, name_width-2*depth, event_full_name(_event_names[scope.event]));
+  OSSInt(out, 10, scope.count);
+  out.setf(std::ios::fixed);
+  OSSRealleft(out, 12, 4, scope.incl_time);
+  OSSRealleft(out, 12, 4, scope.self_time);
+  OSSRealleft(out, 12, 6, scope.min_time);
+  OSSRealleft(out, 12, 6, scope.quantile(0.5));
+  OSSRealleft(out, 12, 6, scope.quantile(0.9));
+  OSSRealleft(out, 12, 6, scope.max_time);
+  out << "|\n";
+
+  std::vector<unsigned int> children(scope.children);
+  std::sort(children.begin(), children.end(), ScopeTimeGreater(_scopes));
+  for (unsigned int c=0; c<children.size(); ++c)
+    this->_print_scope(children[c], depth+1, name_width, out);
+}
+
+
+
+std::string PerfLog::get_counter_info() const
+{
+  OStringStream out;
+
+  if (log_events && (!_counter_names.empty() || !_steps.empty()))
+    {
+      unsigned int name_col_width = 30;
+      const unsigned int value_col_width = 16;
+
+      for (unsigned int i=0; i<_counter_names.size(); ++i)
+        if (_counter_names[i].size()+1 > name_col_width)
+          name_col_width = _counter_names[i].size()+1;
+
+      const unsigned int total_col_width = name_col_width + 2*value_col_width + 1;
+
+      out << ' ';
+      this->_character_line(total_col_width, '-', out);
+      out << '\n';
+
+      out << "| ";
+      OSSStringleft(out, total_col_width-1, label_name + " Counters");
+      out << "|\n";
+
+      out << ' ';
+      this->_character_line(total_col_width, '-', out);
+      out << '\n';
+
+      out << "| ";
+      OSSStringleft(out,name_col_width,"Counter");
+      OSSStringleft(out,value_col_width,"Total");
+      OSSStringleft(out,value_col_width,"Avg per Step");
+      out << "|\n|";
+      this->_character_line(total_col_width, '-', out);
+      out << "|\n";
+
+      for (unsigned int i=0; i<_counter_names.size(); ++i)
+        {
+          out << "| ";
+          OSSStringleft(out,name_col_width,_counter_names[i]);
+          OSSInt(out,value_col_width,_counters[i]);
+          out.setf(std::ios::fixed);
+          OSSRealleft(out,value_col_width,2,_steps.empty() ? 0.0 : static_cast<double>(_counters[i])/_steps.size());
+          out << "|\n";
+        }
+
+      if (!_steps.empty())
+        {
+          double min_step = 0., max_step = 0., sum_step = 0.;
+          int    max_hwm  = 0;
+          for (unsigned int i=0; i<_steps.size(); ++i)
+            {
+              const double t = _steps[i].t_end - _steps[i].t_begin;
+              if (i == 0 || t < min_step) min_step = t;
+              if (t > max_step) max_step = t;
+              sum_step += t;
+              if (_steps[i].vmhwm > max_hwm) max_hwm = _steps[i].vmhwm;
+            }
+
+          OStringStream temp;
+          temp.setf(std::ios::fixed);
+          temp << "| Steps: " << _steps.size()
+               << ", step time min/avg/max=" << std::setprecision(4) << min_step
+               << "/" << sum_step/_steps.size()
+               << "/" << max_step
+               << ", memory high-water=" << max_hwm/1024 << " MB";
+
+          out << '|';
+          this->_character_line(total_col_width, ' ', out);
+          out << "|\n";
+          out << temp.str();
+          if (temp.str().size() < total_col_width+2)
+            {
+              OSSStringright(out, total_col_width-temp.str().size()+2, "|");
+            }
+          out << '\n';
+        }
+
+      out << ' ';
+      this->_character_line(total_col_width, '-', out);
+      out << '\n';
+    }
+
+  return out.str();
+}
+
+
+
+void PerfLog::write_chrome_trace(const std::string &filename) const
+{
+  if (!log_events) return;
+
+  std::ofstream fout(_processor_file_name(filename).c_str());
+  if (!fout.good())
+    {
+      std::cerr << "Warning: can't open performance trace file " << filename << std::endl;
+      return;
+    }
+
+  const unsigned int pid = Genius::processor_id();
+
+  fout << std::fixed << std::setprecision(3);
+  fout << "{\"traceEvents\":[\n";
+  fout << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+       << ",\"args\":{\"name\":" << json_string(label_name) << "}},\n";
+  fout << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":0"
+       << ",\"args\":{\"name\":\"events\"}},\n";
+  fout << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":1"
+       << ",\"args\":{\"name\":\"steps\"}}";
+
+  // recorded calls, in microseconds
+  for (unsigned int i=0; i<_trace.size(); ++i)
+    {
+      const TraceRecord & record = _trace[i];
+      const std::pair<std::string, std::string> & name = _event_names[record.event];
+      fout << ",\n{\"name\":" << json_string(event_full_name(name))
+           << ",\"cat\":" << json_string(name.first.empty() ? std::string("genius") : name.first)
+           << ",\"ph\":\"X\",\"ts\":" << record.t_start*1e6
+           << ",\"dur\":" << record.duration*1e6
+           << ",\"pid\":" << pid << ",\"tid\":0}";
+    }
+
+  // solution steps with memory usage and counter increments
+  for (unsigned int i=0; i<_steps.size(); ++i)
+    {
+      const StepRecord & step = _steps[i];
+      fout << ",\n{\"name\":" << json_string(step.label.empty() ? std::string("step") : step.label)
+           << ",\"cat\":\"step\",\"ph\":\"X\",\"ts\":" << step.t_begin*1e6
+           << ",\"dur\":" << (step.t_end - step.t_begin)*1e6
+           << ",\"pid\":" << pid << ",\"tid\":1"
+           << ",\"args\":{\"step\":" << i << ",\"clock\":" << std::scientific << step.clock << std::fixed << "}}";
+
+      fout << ",\n{\"name\":\"memory (MB)\",\"ph\":\"C\",\"ts\":" << step.t_end*1e6
+           << ",\"pid\":" << pid
+           << ",\"args\":{\"rss\":" << step.vmrss/1024.0 << ",\"high-water\":" << step.vmhwm/1024.0 << "}}";
+
+      if (!step.counters.empty())
+        {
+          fout << ",\n{\"name\":\"counters per step\",\"ph\":\"C\",\"ts\":" << step.t_end*1e6
+               << ",\"pid\":" << pid << ",\"args\":{";
+          for (unsigned int c=0; c<step.counters.size(); ++c)
+            fout << (c ? "," : "") << json_string(_counter_names[c]) << ":" << step.counters[c];
+          fout << "}}";
+        }
+    }
+
+  fout << "\n],\n";
+  fout << "\"displayTimeUnit\":\"ms\",\n";
+  fout << "\"otherData\":{\"dropped_events\":" << _trace_dropped << "}\n";
+  fout << "}\n";
+}
+
+
+
+void PerfLog::write_csv_timeline(const std::string &filename) const
+{
+  if (!log_events) return;
+
+  std::ofstream fout(_processor_file_name(filename).c_str());
+  if (!fout.good())
+    {
+      std::cerr << "Warning: can't open performance timeline file " << filename << std::endl;
+      return;
+    }
+
+  fout << "step,label,clock,t_begin,t_end,elapsed,vmrss_kB,vmhwm_kB";
+  for (unsigned int c=0; c<_counter_names.size(); ++c)
+    fout << ',' << csv_string(_counter_names[c]);
+  fout << '\n';
+
+  for (unsigned int i=0; i<_steps.size(); ++i)
+    {
+      const StepRecord & step = _steps[i];
+      fout << i << ',' << csv_string(step.label) << ','
+           << std::scientific << std::setprecision(6) << step.clock << ','
+           << std::fixed << std::setprecision(6)
+           << step.t_begin << ',' << step.t_end << ',' << step.t_end - step.t_begin << ','
+           << step.vmrss << ',' << step.vmhwm;
+      // counters created after this step have zero increment
+      for (unsigned int c=0; c<_counter_names.size(); ++c)
+        fout << ',' << (c < step.counters.size() ? step.counters[c] : 0UL);
+      fout << '\n';
+    }
+}
+
+
+
+void PerfLog::write_json_summary(const std::string &filename) const
+{
+  if (!log_events) return;
+
+  std::ofstream fout(_processor_file_name(filename).c_str());
+  if (!fout.good())
+    {
+      std::cerr << "Warning: can't open performance summary file " << filename << std::endl;
+      return;
+    }
+
+  MMU * mmu = MMU::instance();
+  mmu->measure();
+
+  fout << std::fixed << std::setprecision(6);
+  fout << "{\n";
+  fout << "\"label\":" << json_string(label_name) << ",\n";
+  fout << "\"processor_id\":" << Genius::processor_id() << ",\n";
+  fout << "\"n_processors\":" << Genius::n_processors() << ",\n";
+  fout << "\"wall_time\":" << _now() - tstart << ",\n";
+  fout << "\"vmpeak_kB\":" << mmu->vmpeak() << ",\n";
+  fout << "\"vmhwm_kB\":" << mmu->vmhwm() << ",\n";
+
+  // flat exclusive time of each event
+  fout << "\"events\":{";
+  bool first = true;
+  for (unsigned int e=0; e<log.size(); ++e)
+    {
+      if (!log[e].count) continue;
+      fout << (first ? "\n" : ",\n") << json_string(event_full_name(_event_names[e]))
+           << ":{\"calls\":" << log[e].count << ",\"time\":" << log[e].tot_time << "}";
+      first = false;
+    }
+  fout << "\n},\n";
+
+  fout << "\"counters\":{";
+  for (unsigned int c=0; c<_counter_names.size(); ++c)
+    fout << (c ? ",\n" : "\n") << json_string(_counter_names[c]) << ":" << _counters[c];
+  fout << "\n},\n";
+
+  // steps grouped by label, keep the order of first appearance
+  std::vector<std::string> labels;
+  std::map<std::string, std::pair<unsigned int, double> > step_time;
+  for (unsigned int i=0; i<_steps.size(); ++i)
+    {
+      const StepRecord & step = _steps[i];
+      if (step_time.find(step.label) == step_time.end())
+        {
+          labels.push_back(step.label);
+          step_time[step.label] = std::make_pair(0u, 0.0);
+        }
+      std::pair<unsigned int, double> & t = step_time[step.label];
+      t.first++;
+      t.second += step.t_end - step.t_begin;
+    }
+
+  fout << "\"steps\":{";
+  for (unsigned int i=0; i<labels.size(); ++i)
+    {
+      const std::pair<unsigned int, double> & t = step_time[labels[i]];
+      fout << (i ? ",\n" : "\n") << json_string(labels[i].empty() ? std::string("step") : labels[i])
+           << ":{\"count\":" << t.first << ",\"time\":" << t.second << "}";
+    }
+  fout << "\n}\n";
+  fout << "}\n";
+}
+
+
+
+std::string PerfLog::_processor_file_name(const std::string &filename)
+{
+  if (Genius::n_processors() == 1)
+    return filename;
+
+  std::stringstream ss;
+  ss << filename << '.' << Genius::processor_id();
+  return ss.str();
+}
+
+
+
 void PerfLog::_character_line(const unsigned int n,
                               const char c,
                               OStringStream& out) const
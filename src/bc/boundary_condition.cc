@@ -554,6 +554,49 @@ bool BoundaryCondition::has_flag(const std::string & name) const
 }
 
 
+void BoundaryCondition::save_state(std::vector<double> & buffer) const
+{
+  buffer.push_back(_real_parameters.size());
+  std::map<std::string, double>::const_iterator it = _real_parameters.begin();
+  for(; it != _real_parameters.end(); ++it)
+    buffer.push_back(it->second);
+
+  buffer.push_back(_real_array_parameters.size());
+  std::map<std::string, std::vector<double> >::const_iterator ait = _real_array_parameters.begin();
+  for(; ait != _real_array_parameters.end(); ++ait)
+  {
+    buffer.push_back(ait->second.size());
+    buffer.insert(buffer.end(), ait->second.begin(), ait->second.end());
+  }
+
+  if(_ext_circuit)
+    _ext_circuit->save_state(buffer);
+}
+
+
+bool BoundaryCondition::load_state(const std::vector<double> & buffer, unsigned int & pos)
+{
+  if( static_cast<unsigned int>(buffer[pos++]) != _real_parameters.size() ) return false;
+  std::map<std::string, double>::iterator it = _real_parameters.begin();
+  for(; it != _real_parameters.end(); ++it)
+    it->second = buffer[pos++];
+
+  if( static_cast<unsigned int>(buffer[pos++]) != _real_array_parameters.size() ) return false;
+  std::map<std::string, std::vector<double> >::iterator ait = _real_array_parameters.begin();
+  for(; ait != _real_array_parameters.end(); ++ait)
+  {
+    ait->second.resize(static_cast<unsigned int>(buffer[pos++]));
+    for(unsigned int i=0; i<ait->second.size(); ++i)
+      ait->second[i] = buffer[pos++];
+  }
+
+  if(_ext_circuit)
+    _ext_circuit->load_state(buffer, pos);
+
+  return true;
+}
+
+
 //---------------------------------------------------------------------------------
 // constructors for each derived class
 //---------------------------------------------------------------------------------
@@ -83,6 +83,9 @@ void InsulatorSemiconductorInterfaceBC::_find_nearest_points_in_gate_region()
     //if( distance < 1e-6*nm || distance > 30*nm ) continue; // skip adjacent and far away regions
 
 
+    // collect the on processor nodes near the region
+    std::vector<unsigned int> query_nodes;
+    std::vector<Point> query_points;
     for(unsigned int n=0; n<nodes.size(); ++n)
     {
       // skip node not on processor
@@ -92,8 +95,20 @@ void InsulatorSemiconductorInterfaceBC::_find_nearest_points_in_gate_region()
       // point is far from boundingbox of region, skip it
       if( MeshTools::minimal_distance(region_bounding_box, p) >  30*nm ) continue;
 
-      Point project_point;
-      std::pair<const Elem*, unsigned int> surface_elem_pair = surface_locator(p, r, project_point, 30*nm);
+      query_nodes.push_back(n);
+      query_points.push_back(p);
+    }
+    if( query_points.empty() ) continue;
+
+    // search all the nodes at once
+    std::vector<std::pair<const Elem*, unsigned int> > surface_elem_pairs;
+    std::vector<Point> project_points;
+    surface_locator.locate(query_points, r, surface_elem_pairs, project_points, 30*nm);
+
+    for(unsigned int q=0; q<query_nodes.size(); ++q)
+    {
+      const unsigned int n = query_nodes[q];
+      const std::pair<const Elem*, unsigned int> & surface_elem_pair = surface_elem_pairs[q];
       if( surface_elem_pair.first == NULL ) continue;
 
       // ok, which bc the nearset point on?
@@ -111,7 +126,21 @@ void InsulatorSemiconductorInterfaceBC::_find_nearest_points_in_gate_region()
         loc.bc = const_cast<BoundaryCondition *>(bc);
         loc.elem = surface_elem_pair.first;
         loc.side = surface_elem_pair.second;
-        loc.p = project_point;
+        loc.p = project_points[q];
+
+        // cache side nodes and interpolation weights
+        {
+          AutoPtr<Elem> side_elem = loc.elem->build_side(loc.side, false);
+          loc.weight_sum = 0.0;
+          for(unsigned int v=0; v<side_elem->n_nodes(); ++v)
+          {
+            Real w = 1.0/((loc.p - side_elem->point(v)).size_sq()+1e-6);
+            loc.side_nodes.push_back(side_elem->get_node(v));
+            loc.weights.push_back(w);
+            loc.weight_sum += w;
+          }
+        }
+
         _node_nearest_point_map.insert(std::make_pair(nodes[n], loc));
 
         Elem * loc_elem = const_cast<Elem *>(loc.elem);
@@ -24,6 +24,12 @@
 #include <ctime>
 #include <iomanip>
 
+#include "config.h"
+#ifdef WINDOWS
+#else
+#include <unistd.h>
+#endif
+
 #include "solver_base.h"
 #include "current_conservation_hook.h"
 #include "parallel.h"
@@ -37,8 +43,18 @@ CurrentConservationHook::CurrentConservationHook(SolverBase & solver, const std:
 {
   _p_solver = & solver;
 
+  _append = false;
   if ( !Genius::processor_id() )
-    _out.open(_probe_file.c_str());
+  {
+#ifdef WINDOWS
+    bool file_exist = ( _access( (char *) _probe_file.c_str(),  04 ) == 0 );
+#else
+    bool file_exist = ( access( _probe_file.c_str(),  R_OK ) == 0 );
+#endif
+
+    _append = file_exist && SolverSpecify::out_append;
+    _out.open(_probe_file.c_str(), _append ? std::ios::app : std::ios::trunc);
+  }
 
 }
 
@@ -58,7 +74,7 @@ CurrentConservationHook::~CurrentConservationHook()
  */
 void CurrentConservationHook::on_init()
 {
-  if ( !Genius::processor_id() )
+  if ( !Genius::processor_id() && !_append )
   {
     time_t          _time;
     time(&_time);
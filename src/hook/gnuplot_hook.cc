@@ -135,6 +135,14 @@ void GnuplotHook::post_solve()
         SolverSpecify::Type==SolverSpecify::TRACE         ||
         SolverSpecify::Type==SolverSpecify::TRANSIENT )
     {
+      // each event of an ensemble transient is a data block
+      if (SolverSpecify::Type == SolverSpecify::TRANSIENT && SolverSpecify::event_label != _event_label)
+      {
+        if(!_event_label.empty()) _out << std::endl << std::endl;
+        _out << "# Event: " << SolverSpecify::event_label << std::endl;
+        _event_label = SolverSpecify::event_label;
+      }
+
       // if transient simulation, we need to record time
       if (SolverSpecify::Type == SolverSpecify::TRANSIENT)
       {
@@ -398,6 +398,8 @@ bool ParticleCaptureDataHook::build_tracks_block(std::istream * in, unsigned int
   unsigned int track_begin = Genius::processor_id()*track_part;
   unsigned int track_end   = std::min((Genius::processor_id()+1)*track_part, n_track);
 
+  std::vector<Point> p1, p2;
+  std::vector<double> e;
   for(unsigned int n=track_begin; n<track_end; n++)
   {
     double x1 = track_data[7*n+0];
@@ -408,8 +410,11 @@ bool ParticleCaptureDataHook::build_tracks_block(std::istream * in, unsigned int
     double z2 = track_data[7*n+5];
     double energy = track_data[7*n+6];
 
-    dose_rate->energy_deposite(Point(x1,y1,z1), Point(x2,y2,z2), _weight*energy);
+    p1.push_back(Point(x1,y1,z1));
+    p2.push_back(Point(x2,y2,z2));
+    e.push_back(_weight*energy);
   }
+  dose_rate->energy_deposite(p1, p2, e);
 
   return true;
 
@@ -650,13 +650,18 @@ void ParticleCaptureG4Hook::process_particle_dose_octree()
   unsigned int bin_size = tracks.size()/Genius::n_processors();
   unsigned int begin = bin_size*Genius::processor_id();
   unsigned int end   = std::min(begin+bin_size, tracks.size());
+  std::vector<Point> p1, p2;
+  std::vector<double> e;
   for(unsigned int t=begin; t<end; ++t)
   {
     const track_t & track = tracks[t];
     genius_assert(track.energy > 0.0 && (track.end - track.start).size() > 0.0);
 
-    dose_rate->energy_deposite(track.start, track.end, track.energy);
+    p1.push_back(track.start);
+    p2.push_back(track.end);
+    e.push_back(track.energy);
   }
+  dose_rate->energy_deposite(p1, p2, e);
 
 }
 
@@ -24,6 +24,12 @@
 #include <ctime>
 #include <iomanip>
 
+#include "config.h"
+#ifdef WINDOWS
+#else
+#include <unistd.h>
+#endif
+
 #include "solver_base.h"
 #include "spice_ckt.h"
 #include "probe_hook.h"
@@ -62,8 +68,18 @@ ProbeHook::ProbeHook(SolverBase & solver, const std::string & name, void * param
   if(!_region.empty() && !system.has_region(_region)) _region.clear();
   if(!_material.empty() && !system.has_region_with_material(_material)) _material.clear();
 
+  _append = false;
   if ( !Genius::processor_id() )
-    _out.open(_probe_file.c_str());
+  {
+#ifdef WINDOWS
+    bool file_exist = ( _access( (char *) _probe_file.c_str(),  04 ) == 0 );
+#else
+    bool file_exist = ( access( _probe_file.c_str(),  R_OK ) == 0 );
+#endif
+
+    _append = file_exist && SolverSpecify::out_append;
+    _out.open(_probe_file.c_str(), _append ? std::ios::app : std::ios::trunc);
+  }
 
 }
 
@@ -183,7 +199,7 @@ void ProbeHook::on_init()
   for(int i=0; i<n_var; i++)
     Parallel::broadcast(var_name[i], _min_loc);
 
-  if ( !Genius::processor_id() )
+  if ( !Genius::processor_id() && !_append )
   {
     time_t          _time;
     time(&_time);
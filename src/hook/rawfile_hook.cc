@@ -25,6 +25,12 @@
 #include <cstdlib>
 #include <iomanip>
 
+#include "config.h"
+#ifdef WINDOWS
+#else
+#include <unistd.h>
+#endif
+
 #include "solver_base.h"
 #include "rawfile_hook.h"
 #include "spice_ckt.h"
@@ -36,7 +42,19 @@ RawFileHook::RawFileHook(SolverBase & solver, const std::string & name, void * f
     : Hook(solver, name), _input_file((const char *)file), _raw_file(SolverSpecify::out_prefix + ".raw"), _mixA(false), _n_values(0)
 {
   if ( !Genius::processor_id() )
-    _out.open(_raw_file.c_str());
+  {
+#ifdef WINDOWS
+    bool file_exist = ( _access( (char *) _raw_file.c_str(),  04 ) == 0 );
+#else
+    bool file_exist = ( access( _raw_file.c_str(),  R_OK ) == 0 );
+#endif
+
+    // each run writes a complete plot on close, append the plot to the existing raw file
+    if(file_exist && SolverSpecify::out_append)
+      _out.open(_raw_file.c_str(), std::ios::app);
+    else
+      _out.open(_raw_file.c_str(), std::ios::trunc);
+  }
 
   SolverSpecify::SolverType solver_type = this->get_solver().solver_type();
 
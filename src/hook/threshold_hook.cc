@@ -22,6 +22,12 @@
 #include <cstdlib>
 #include <iomanip>
 
+#include "config.h"
+#ifdef WINDOWS
+#else
+#include <unistd.h>
+#endif
+
 #include "mesh_base.h"
 #include "solver_base.h"
 #include "threshold_hook.h"
@@ -39,7 +45,8 @@
  * constructor, open the file for writing
  */
 ThresholdHook::ThresholdHook ( SolverBase & solver, const std::string & name, void * param)
-    : Hook ( solver, name ), _violate_threshold(false), _stop_when_violate_threshold(false)
+    : Hook ( solver, name ), _T_reduction(invalid_uint), _E_reduction(invalid_uint),
+      _violate_threshold(false), _stop_when_violate_threshold(false)
 {
   _threshold_prefix = "threshold";
   const SimulationSystem & system = get_solver().get_system();
@@ -122,47 +129,65 @@ ThresholdHook::ThresholdHook ( SolverBase & solver, const std::string & name, vo
     }
   }
 
+  // max T and E are evaluated by the shared post solve reduction
+  if(_scalar_variable_threshold_map.find(TEMPERATURE) !=  _scalar_variable_threshold_map.end())
+    _T_reduction = _solver.reduction().add(PostSolveReduction::MAX, "temperature", POINT_CENTER, _region, _lower_bound, _upper_bound);
+
+  if(_vector_variable_threshold_map.find(E_FIELD) !=  _vector_variable_threshold_map.end())
+    _E_reduction = _solver.reduction().add(PostSolveReduction::MAX, "efield", CELL_CENTER, _region, _lower_bound, _upper_bound);
+
   if ( Genius::is_first_processor() )
   {
     std::string file = _threshold_prefix + ".dat";
-    _out.open(file.c_str(), std::ios::trunc);
+#ifdef WINDOWS
+    bool file_exist = ( _access( (char *) file.c_str(),  04 ) == 0 );
+#else
+    bool file_exist = ( access( file.c_str(),  R_OK ) == 0 );
+#endif
 
-    // write file head
-    _out << "# Title: ThresholdHook File Created by Genius TCAD Simulation" << std::endl;
+    // continue the existing file, the file head is already there
+    const bool append = file_exist && SolverSpecify::out_append;
+    _out.open(file.c_str(), append ? std::ios::app : std::ios::trunc);
 
-    unsigned int n_var = 0;
-    if ( SolverSpecify::Type == SolverSpecify::TRANSIENT )
+    if( !append )
     {
-      _out << '#' <<'\t' << ++n_var <<'\t' << "Time" << " [s]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "TimeStep" << " [s]"<< std::endl;
-    }
+      // write file head
+      _out << "# Title: ThresholdHook File Created by Genius TCAD Simulation" << std::endl;
 
-    //_out << '#' <<'\t' << ++n_var <<'\t' << "x" << " [um]"<< std::endl;
-    //_out << '#' <<'\t' << ++n_var <<'\t' << "y" << " [um]"<< std::endl;
-    //_out << '#' <<'\t' << ++n_var <<'\t' << "z" << " [um]"<< std::endl;
+      unsigned int n_var = 0;
+      if ( SolverSpecify::Type == SolverSpecify::TRANSIENT )
+      {
+        _out << '#' <<'\t' << ++n_var <<'\t' << "Time" << " [s]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "TimeStep" << " [s]"<< std::endl;
+      }
 
-    if(_scalar_variable_threshold_map.find(TEMPERATURE) !=  _scalar_variable_threshold_map.end())
-    {
-      _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_node_id"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_node_x[um]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_node_y[um]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_node_z[um]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "temperature[K]"<< std::endl;
-
-      // other parameters
-      _out << '#' <<'\t' << ++n_var <<'\t' << "elec_density[cm-3]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "hole_density[cm-3]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "recombination[cm-3/s]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "recombination_dir[cm-3/s]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "recombination_srh[cm-3/s]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "recombination_auger[cm-3/s]"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "impact_ionization[cm-3/s]"<< std::endl;
-    }
+      //_out << '#' <<'\t' << ++n_var <<'\t' << "x" << " [um]"<< std::endl;
+      //_out << '#' <<'\t' << ++n_var <<'\t' << "y" << " [um]"<< std::endl;
+      //_out << '#' <<'\t' << ++n_var <<'\t' << "z" << " [um]"<< std::endl;
 
-    if(_vector_variable_threshold_map.find(E_FIELD) !=  _vector_variable_threshold_map.end())
-    {
-      _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_cell_id"<< std::endl;
-      _out << '#' <<'\t' << ++n_var <<'\t' << "efield[V/cm]"<< std::endl;
+      if(_scalar_variable_threshold_map.find(TEMPERATURE) !=  _scalar_variable_threshold_map.end())
+      {
+        _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_node_id"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_node_x[um]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_node_y[um]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_node_z[um]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "temperature[K]"<< std::endl;
+
+        // other parameters
+        _out << '#' <<'\t' << ++n_var <<'\t' << "elec_density[cm-3]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "hole_density[cm-3]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "recombination[cm-3/s]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "recombination_dir[cm-3/s]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "recombination_srh[cm-3/s]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "recombination_auger[cm-3/s]"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "impact_ionization[cm-3/s]"<< std::endl;
+      }
+
+      if(_vector_variable_threshold_map.find(E_FIELD) !=  _vector_variable_threshold_map.end())
+      {
+        _out << '#' <<'\t' << ++n_var <<'\t' << "extreme_cell_id"<< std::endl;
+        _out << '#' <<'\t' << ++n_var <<'\t' << "efield[V/cm]"<< std::endl;
+      }
     }
 
 
@@ -251,44 +276,12 @@ void ThresholdHook::_check_T_threshold()
 
   const Real T_threshold = _scalar_variable_threshold_map[TEMPERATURE];
 
-  bool box = _is_bound_box_valid();
-
-  Real T_magnitude = 0;
-  unsigned int node = invalid_uint;
-
-  for( unsigned int n=0; n<system.n_regions(); ++n )
-  {
-    const SimulationRegion * region = system.region(n);
-    if( !_region.empty() && region->name() != _region ) continue;
-
-    SimulationRegion::const_local_node_iterator it = region->on_local_nodes_begin();
-    SimulationRegion::const_local_node_iterator it_end = region->on_local_nodes_end();
-    for(; it!=it_end; ++it)
-    {
-      const FVM_Node * fvm_node = *it;
-
-      if(box && !_in_bound_box(*(fvm_node->root_node()))) continue;
-      const Real T = fvm_node->node_data()->T();
-
-      if( T > T_magnitude )
-      {
-        T_magnitude = T;
-        node = fvm_node->root_node()->id();
-      }
-    }
-  }
-
-  std::map<Real, unsigned int> order;
-  if(node != invalid_uint)
-    order.insert(std::make_pair(T_magnitude, node));
+  const PostSolveReduction & reduction = get_solver().reduction();
 
-  Parallel::allgather(order);
-
-  if(!order.empty())
+  if(reduction.valid(_T_reduction))
   {
-
-    T_magnitude = order.rbegin()->first;
-    _extreme_node = order.rbegin()->second;
+    const Real T_magnitude = reduction.value(_T_reduction);
+    _extreme_node = reduction.location(_T_reduction);
 
     AutoPtr<Node> node_ptr = mesh.node_clone(_extreme_node);
 
@@ -373,42 +366,12 @@ void ThresholdHook::_check_E_threshold()
 
   const Real E_threshold = _vector_variable_threshold_map[E_FIELD];
 
-  bool box = _is_bound_box_valid();
-
-  Real E_magnitude = 0;
-  unsigned int cell = invalid_uint;
-
-  for( unsigned int n=0; n<system.n_regions(); ++n )
-  {
-    const SimulationRegion * region = system.region(n);
-    if( !_region.empty() && region->name() != _region ) continue;
-
-    for(unsigned int e=0; e<region->n_cell(); ++e)
-    {
-      const Elem * elem = region->get_region_elem(e);
-
-      if(box && !_in_bound_box(elem->centroid())) continue;
-
-      const FVM_CellData * elem_data = region->get_region_elem_data(e);
-      const Real E = elem_data->E().size();
-      if( E > E_magnitude )
-      {
-        E_magnitude = E;
-        cell = elem->id();
-      }
-    }
-  }
+  const PostSolveReduction & reduction = get_solver().reduction();
 
-  std::map<Real, unsigned int> order;
-  if(cell != invalid_uint)
-    order.insert(std::make_pair(E_magnitude, cell));
-
-  Parallel::allgather(order);
-
-  if(!order.empty())
+  if(reduction.valid(_E_reduction))
   {
-    E_magnitude = order.rbegin()->first;
-    _extreme_cell = order.rbegin()->second;
+    const Real E_magnitude = reduction.value(_E_reduction);
+    _extreme_cell = reduction.location(_E_reduction);
 
     AutoPtr<Elem> elem = mesh.elem_clone(_extreme_cell);
 
@@ -451,19 +414,6 @@ void ThresholdHook::_check_E_threshold()
 
 
 
-bool ThresholdHook::_is_bound_box_valid()
-{
-  return _lower_bound.x()<_upper_bound.x() || _lower_bound.y()<_upper_bound.y() || _lower_bound.z()<_upper_bound.z();
-}
-
-bool ThresholdHook::_in_bound_box(const Point &p)
-{
-  return p.x() >= _lower_bound.x() && p.x() <= _upper_bound.x() &&
-         p.y() >= _lower_bound.y() && p.y() <= _upper_bound.y() &&
-         p.z() >= _lower_bound.z() && p.z() <= _upper_bound.z();
-}
-
-
 #ifdef DLLHOOK
 
 // dll interface
@@ -23,6 +23,12 @@
 #include <cstdlib>
 #include <iomanip>
 
+#include "config.h"
+#ifdef WINDOWS
+#else
+#include <unistd.h>
+#endif
+
 #include "solver_base.h"
 #include "tunneling_hook.h"
 
@@ -39,42 +45,54 @@ TunnelingHook::TunnelingHook ( SolverBase & solver, const std::string & name, vo
 {
   if ( !Genius::processor_id() )
   {
-    _out.open((_output_prefix+".tunneling_current.dat").c_str());
+    const std::string file = _output_prefix+".tunneling_current.dat";
+#ifdef WINDOWS
+    bool file_exist = ( _access( (char *) file.c_str(),  04 ) == 0 );
+#else
+    bool file_exist = ( access( file.c_str(),  R_OK ) == 0 );
+#endif
 
-    // write file head
-    _out << "# Title: Gnuplot File Created by Genius TCAD Simulation" << std::endl << std::endl;
+    // continue the existing file, the file head is already there
+    const bool append = file_exist && SolverSpecify::out_append;
+    _out.open(file.c_str(), append ? std::ios::app : std::ios::trunc);
 
-    _out << "# Plotname: tunneling current" << std::endl;
-    // write variables
-    _out << "# Variables: " << std::endl;
+    if( !append )
+    {
+      // write file head
+      _out << "# Title: Gnuplot File Created by Genius TCAD Simulation" << std::endl << std::endl;
 
-    unsigned int n_var = 0;
+      _out << "# Plotname: tunneling current" << std::endl;
+      // write variables
+      _out << "# Variables: " << std::endl;
 
-    if(SolverSpecify::TimeDependent)
-      _out << '#' <<'\t' << ++n_var <<'\t' << "Time"      << " [s]"<< std::endl;
+      unsigned int n_var = 0;
 
-    const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
-    for(unsigned int n=0; n<bcs->n_bcs(); n++)
-    {
-      const BoundaryCondition * bc = bcs->get_bc(n);
-      if( bc->is_electrode() )
-      {
-        std::string bc_label = bc->label();
-        if(!bc->electrode_label().empty())
-          bc_label = bc->electrode_label();
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_Vapp"      << " [V]"<< std::endl;
-      }
+      if(SolverSpecify::TimeDependent)
+        _out << '#' <<'\t' << ++n_var <<'\t' << "Time"      << " [s]"<< std::endl;
 
-      if ( bc->bc_type() == IF_Insulator_Semiconductor )
+      const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
+      for(unsigned int n=0; n<bcs->n_bcs(); n++)
       {
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc->label() + "_J_CBET"      << " [A*cm^-2]"<< std::endl;
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc->label() + "_J_VBHT"      << " [A*cm^-2]"<< std::endl;
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc->label() + "_J_VBET"      << " [A*cm^-2]"<< std::endl;
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc->label() + "_J"           << " [A*cm^-2]"<< std::endl;
+        const BoundaryCondition * bc = bcs->get_bc(n);
+        if( bc->is_electrode() )
+        {
+          std::string bc_label = bc->label();
+          if(!bc->electrode_label().empty())
+            bc_label = bc->electrode_label();
+          _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_Vapp"      << " [V]"<< std::endl;
+        }
+
+        if ( bc->bc_type() == IF_Insulator_Semiconductor )
+        {
+          _out << '#' <<'\t' << ++n_var <<'\t' << bc->label() + "_J_CBET"      << " [A*cm^-2]"<< std::endl;
+          _out << '#' <<'\t' << ++n_var <<'\t' << bc->label() + "_J_VBHT"      << " [A*cm^-2]"<< std::endl;
+          _out << '#' <<'\t' << ++n_var <<'\t' << bc->label() + "_J_VBET"      << " [A*cm^-2]"<< std::endl;
+          _out << '#' <<'\t' << ++n_var <<'\t' << bc->label() + "_J"           << " [A*cm^-2]"<< std::endl;
+        }
       }
-    }
 
-    _out << std::endl;
+      _out << std::endl;
+    }
   }
 
 }
@@ -159,7 +159,17 @@ int main(int argc, char ** args)
   // performace log flag
   PetscBool     log_flg;
   PetscOptionsHasName(PETSC_NULL,"-p", &log_flg);
-  if(!log_flg)
+
+  // export performace trace (chrome trace json), per step timeline (csv) and summary (json)
+  PetscBool     trace_flg, timeline_flg, summary_flg;
+  char perf_trace_file[1024], perf_timeline_file[1024], perf_summary_file[1024];
+  PetscOptionsGetString(PETSC_NULL, "-p_trace", perf_trace_file, 1023, &trace_flg);
+  PetscOptionsGetString(PETSC_NULL, "-p_timeline", perf_timeline_file, 1023, &timeline_flg);
+  PetscOptionsGetString(PETSC_NULL, "-p_json", perf_summary_file, 1023, &summary_flg);
+  if(trace_flg)
+    perflog.enable_trace();
+
+  if(!log_flg && !trace_flg && !timeline_flg && !summary_flg)
     perflog.disable_logging();
 
   // get the name of user input file by PETSC routine
@@ -282,6 +292,14 @@ int main(int argc, char ** args)
     fsol << Genius::input_file() << ".sol";
     solve_ctrl->setSolutionFile(fsol.str().c_str());
   }
+  // run parameter variants of the deck in this process
+  {
+    PetscBool     batch_flg;
+    char batch_file[1024];
+    PetscOptionsGetString(PETSC_NULL, "-batch", batch_file, 1023, &batch_flg);
+    if(batch_flg)
+      solve_ctrl->setBatchFile(batch_file);
+  }
   solve_ctrl->mainloop();
   
   // record memory usage
@@ -325,6 +343,13 @@ int main(int argc, char ** args)
     MESSAGE<<perf_info; RECORD();
   }
 
+  if(trace_flg)
+    perflog.write_chrome_trace(perf_trace_file);
+  if(timeline_flg)
+    perflog.write_csv_timeline(perf_timeline_file);
+  if(summary_flg)
+    perflog.write_json_summary(perf_summary_file);
+
   //finish log system
   if (Genius::processor_id() == 0)
   {
@@ -0,0 +1,278 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include "config.h"
+
+#ifdef HAVE_PETSC
+
+#include "klu_solver.h"
+#include "genius_env.h"
+#include "log.h"
+#include "perf_log.h"
+
+
+//--------------------------------------------------------------------
+// Functions with C linkage to pass to PETSc as PCSHELL routines.
+extern "C"
+{
+  //---------------------------------------------------------------
+  // called by PETSc when the operator of PC changes
+  static PetscErrorCode __genius_klu_pc_setup(PC pc)
+  {
+    void * ctx;
+    PCShellGetContext(pc, (void **)&ctx);
+    KLUSolver * klu = (KLUSolver *)ctx;
+
+    Mat A, P;
+#if PETSC_VERSION_GE(3,5,0)
+    PCGetOperators(pc, &A, &P);
+#else
+    MatStructure flag;
+    PCGetOperators(pc, &A, &P, &flag);
+#endif
+
+    if( !klu->factorize(P) ) return 1;
+    return 0;
+  }
+
+  //---------------------------------------------------------------
+  // called by PETSc to apply the PC, here a full direct solve
+  static PetscErrorCode __genius_klu_pc_apply(PC pc, Vec b, Vec x)
+  {
+    void * ctx;
+    PCShellGetContext(pc, (void **)&ctx);
+    KLUSolver * klu = (KLUSolver *)ctx;
+
+    if( !klu->solve(b, x) ) return 1;
+    return 0;
+  }
+}
+
+
+
+KLUSolver::KLUSolver()
+  : _symbolic(0), _numeric(0), _n(0), _rcond_factor(0.0),
+    _n_analyze(0), _n_factor(0), _n_refactor(0)
+{
+  klu_defaults(&_common);
+  // BTF pre-ordering followed by AMD on each diagonal block
+  _common.btf = 1;
+  _common.ordering = 0;
+  // do not halt on singular matrix, let newton solver handle it
+  _common.halt_if_singular = 0;
+}
+
+
+KLUSolver::~KLUSolver()
+{
+  clear();
+}
+
+
+void KLUSolver::clear()
+{
+  if(_numeric)  klu_free_numeric(&_numeric, &_common);
+  if(_symbolic) klu_free_symbolic(&_symbolic, &_common);
+  _numeric = 0;
+  _symbolic = 0;
+
+  _n = 0;
+  _Ap.clear();
+  _Ai.clear();
+  _Ax.clear();
+  _b.clear();
+}
+
+
+PetscErrorCode KLUSolver::set_pc_shell(PC pc)
+{
+  PetscErrorCode ierr;
+  ierr = PCSetType(pc, (char*) PCSHELL); if(ierr) return ierr;
+  ierr = PCShellSetContext(pc, this); if(ierr) return ierr;
+  ierr = PCShellSetSetUp(pc, __genius_klu_pc_setup); if(ierr) return ierr;
+  ierr = PCShellSetApply(pc, __genius_klu_pc_apply); if(ierr) return ierr;
+  ierr = PCShellSetName(pc, "KLU"); if(ierr) return ierr;
+  return 0;
+}
+
+
+bool KLUSolver::_load_matrix(Mat A)
+{
+  PetscInt nrow, ncol;
+  MatGetSize(A, &nrow, &ncol);
+  genius_assert(nrow == ncol);
+
+  bool same_pattern = (_n == nrow);
+  _n = nrow;
+
+  std::vector<int> Ap;
+  Ap.reserve(_n+1);
+  Ap.push_back(0);
+
+  unsigned int nz = 0;
+  for(PetscInt row=0; row<nrow; row++)
+  {
+    PetscInt row_ncol;
+    const PetscInt * row_cols_pointer;
+    const PetscScalar * row_vals_pointer;
+
+    MatGetRow(A, row, &row_ncol, &row_cols_pointer, &row_vals_pointer);
+
+    if( nz + row_ncol > _Ai.size() )
+    {
+      _Ai.resize(nz + row_ncol);
+      _Ax.resize(nz + row_ncol);
+      same_pattern = false;
+    }
+
+    for(PetscInt c=0; c<row_ncol; ++c, ++nz)
+    {
+      if( same_pattern && _Ai[nz] != row_cols_pointer[c] ) same_pattern = false;
+      _Ai[nz] = row_cols_pointer[c];
+      _Ax[nz] = static_cast<double>(row_vals_pointer[c]);
+    }
+
+    MatRestoreRow(A, row, &row_ncol, &row_cols_pointer, &row_vals_pointer);
+
+    Ap.push_back(nz);
+  }
+
+  _Ai.resize(nz);
+  _Ax.resize(nz);
+
+  if( same_pattern && Ap != _Ap ) same_pattern = false;
+  _Ap.swap(Ap);
+
+  return same_pattern;
+}
+
+
+bool KLUSolver::_analyze()
+{
+  if(_numeric)  klu_free_numeric(&_numeric, &_common);
+  if(_symbolic) klu_free_symbolic(&_symbolic, &_common);
+
+  _common.ordering = 0;
+  _symbolic = klu_analyze(_n, &_Ap[0], &_Ai[0], &_common);
+  if( !_symbolic )
+  {
+    // AMD failed, try COLAMD
+    _common.ordering = 1;
+    _symbolic = klu_analyze(_n, &_Ap[0], &_Ai[0], &_common);
+  }
+  _n_analyze++;
+  return _symbolic != 0;
+}
+
+
+bool KLUSolver::_factor()
+{
+  if(_numeric)  klu_free_numeric(&_numeric, &_common);
+
+  _numeric = klu_factor(&_Ap[0], &_Ai[0], &_Ax[0], _symbolic, &_common);
+  _n_factor++;
+
+  if( !_numeric || _common.status != KLU_OK ) return false;
+
+  klu_rcond(_symbolic, _numeric, &_common);
+  _rcond_factor = _common.rcond;
+
+  return true;
+}
+
+
+bool KLUSolver::factorize(Mat A)
+{
+  START_LOG("factorize()", "KLUSolver");
+
+  bool same_pattern = _load_matrix(A);
+
+  bool ok = true;
+  if( !same_pattern || !_symbolic )
+  {
+    ok = _analyze() && _factor();
+  }
+  else if( !_numeric )
+  {
+    ok = _factor();
+  }
+  else
+  {
+    // numerical refactorization with the pivot sequence of last klu_factor
+    int refactor_ok = klu_refactor(&_Ap[0], &_Ai[0], &_Ax[0], _symbolic, _numeric, &_common);
+    _n_refactor++;
+
+    // the old pivot sequence may be bad for the new matrix, do a full factorization
+    // when the reciprocal pivot ratio drops too much
+    if( refactor_ok && _common.status == KLU_OK )
+    {
+      klu_rcond(_symbolic, _numeric, &_common);
+      if( _common.rcond < 1e-3*_rcond_factor )
+        ok = _factor();
+    }
+    else
+      ok = _factor();
+  }
+
+  if( !ok )
+  {
+    MESSAGE<< "Warning:  KLU factorization failed with status " << _common.status << "." << std::endl;
+    RECORD();
+  }
+
+  STOP_LOG("factorize()", "KLUSolver");
+
+  return ok;
+}
+
+
+
+bool KLUSolver::solve(Vec b, Vec x)
+{
+  if( !_numeric ) return false;
+
+  START_LOG("solve()", "KLUSolver");
+
+  _b.resize(_n);
+
+  PetscScalar * bb;
+  VecGetArray(b, &bb);
+  for(int i=0; i<_n; ++i)
+    _b[i] = static_cast<double>(bb[i]);
+  VecRestoreArray(b, &bb);
+
+  // we factorized A^T, solve (A^T)^T x = b
+  int ok = klu_tsolve(_symbolic, _numeric, _n, 1, &_b[0], &_common);
+
+  PetscScalar * xx;
+  VecGetArray(x, &xx);
+  for(int i=0; i<_n; ++i)
+    xx[i] = _b[i];
+  VecRestoreArray(x, &xx);
+
+  STOP_LOG("solve()", "KLUSolver");
+
+  return ok && _common.status == KLU_OK;
+}
+
+
+#endif
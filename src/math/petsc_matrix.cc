@@ -27,6 +27,7 @@
 // Local includes
 #include "petsc_matrix.h"
 #include "parallel.h"
+#include "perf_log.h"
 
 
 
@@ -87,7 +88,7 @@ void PetscMatrix<T>::set (const unsigned int i, const unsigned int j, const T va
   if(_mat_buf_mode)
   {
     if( SparseMatrix<T>::row_on_processor(i) )
-      _mat_local[i-SparseMatrix<T>::_global_offset][j] = value;
+      _buf_entry(i-SparseMatrix<T>::_global_offset, j) = value;
     else 
       _mat_nonlocal[std::make_pair(i,j)] = value;
   }
@@ -113,7 +114,7 @@ void PetscMatrix<T>::add (const unsigned int i, const unsigned int j, const T va
   if(_mat_buf_mode)
   {
     if( SparseMatrix<T>::row_on_processor(i) )
-      _mat_local[i-SparseMatrix<T>::_global_offset][j] += value;
+      _buf_entry(i-SparseMatrix<T>::_global_offset, j) += value;
     else 
       _mat_nonlocal[std::make_pair(i,j)] += value;
   }
@@ -140,7 +141,7 @@ void PetscMatrix<T>::add_row (unsigned int row, const std::vector<unsigned int>
     if( SparseMatrix<T>::row_on_processor(row) )
     {
       for(unsigned int j=0; j<cols.size(); j++)
-         _mat_local[row-SparseMatrix<T>::_global_offset][cols[j]] += dm[j];
+         _buf_entry(row-SparseMatrix<T>::_global_offset, cols[j]) += dm[j];
     }
     else
     {
@@ -171,7 +172,7 @@ void PetscMatrix<T>::add_row (unsigned int row, unsigned int n, const unsigned i
     if( SparseMatrix<T>::row_on_processor(row) )
     {
       for(unsigned int j=0; j<n; j++)
-         _mat_local[row-SparseMatrix<T>::_global_offset][cols[j]] += dm[j];
+         _buf_entry(row-SparseMatrix<T>::_global_offset, cols[j]) += dm[j];
     }
     else
     {
@@ -203,7 +204,7 @@ void PetscMatrix<T>::add_row (unsigned int row, int n, const int * cols, const T
     if( SparseMatrix<T>::row_on_processor(row) )
     {
       for(int j=0; j<n; j++)
-         _mat_local[row-SparseMatrix<T>::_global_offset][cols[j]] += dm[j];
+         _buf_entry(row-SparseMatrix<T>::_global_offset, cols[j]) += dm[j];
     }
     else
     {
@@ -242,7 +243,7 @@ void PetscMatrix<T>::add_matrix(const std::vector<unsigned int>& rows,
       if( SparseMatrix<T>::row_on_processor(rows[i]) )
       {
         for(unsigned int j=0; j<n; j++)
-          _mat_local[rows[i]-SparseMatrix<T>::_global_offset][cols[j]] += dm[i*n+j];
+          _buf_entry(rows[i]-SparseMatrix<T>::_global_offset, cols[j]) += dm[i*n+j];
       }
       else
         for(unsigned int j=0; j<n; j++)
@@ -279,7 +280,7 @@ void PetscMatrix<T>::add_matrix (unsigned int m, unsigned int * rows,
       if( SparseMatrix<T>::row_on_processor(rows[i]) )
       {
         for(unsigned int j=0; j<n; j++)
-          _mat_local[rows[i]-SparseMatrix<T>::_global_offset][cols[j]] += dm[i*n+j];
+          _buf_entry(rows[i]-SparseMatrix<T>::_global_offset, cols[j]) += dm[i*n+j];
       }
       else
         for(unsigned int j=0; j<n; j++)
@@ -336,6 +337,9 @@ void PetscMatrix<T>::init ()
 template <typename T>
 void PetscMatrix<T>::close (bool final)
 {
+  // counted once per assembly, not per entry
+  if(final) PERF_COUNT("matrix assemblies", 1);
+
   if(_mat_buf_mode)
   {
     unsigned int nonlocal_entries = _mat_nonlocal.size();
@@ -366,7 +370,7 @@ void PetscMatrix<T>::close (bool final)
 
         unsigned int col = cols[n];
         T value = values[n];
-        _mat_local[row-SparseMatrix<T>::_global_offset][col] += value;
+        _buf_entry(row-SparseMatrix<T>::_global_offset, col) += value;
       }
     }
     
@@ -380,8 +384,17 @@ void PetscMatrix<T>::close (bool final)
     ierr = MatAssemblyBegin (_mat, MAT_FINAL_ASSEMBLY);
     ierr = MatAssemblyEnd   (_mat, MAT_FINAL_ASSEMBLY);
   }
-  
-  
+
+#ifdef ENABLE_PERFORMANCE_LOGGING
+  // entries are read from the assembled matrix, not counted in add/set
+  if(final)
+  {
+    MatInfo info;
+    MatGetInfo(_mat, MAT_LOCAL, &info);
+    PERF_COUNT("matrix entries assembled", static_cast<unsigned long>(info.nz_used));
+  }
+#endif
+
 }
 
 
@@ -400,6 +413,8 @@ void PetscMatrix<T>::zero ()
     
     for(typename std::map< std::pair<unsigned int, unsigned int>, T >::iterator it= _mat_nonlocal.begin();it!=_mat_nonlocal.end(); it++)
       it->second = 0.0;  
+
+    std::fill(_buf_values.begin(), _buf_values.end(), T(0.0));
   }
   else
   {
@@ -418,6 +433,11 @@ void PetscMatrix<T>::clear ()
 {
   _mat_local.clear();
   _mat_nonlocal.clear();
+
+  std::vector<int>().swap(_buf_row_ptr);
+  std::vector<int>().swap(_buf_cols);
+  std::vector<T>().swap(_buf_values);
+  std::vector<unsigned char>().swap(_buf_used);
   
   int ierr=0;
 
@@ -436,10 +456,10 @@ void PetscMatrix<T>::get_row (unsigned int row, int n, const int * cols, T* dm)
 {
   if(_mat_buf_mode)
   {
-    const std::map<unsigned int, T> & buf = _mat_local[row-SparseMatrix<T>::_global_offset];
     for(int i=0; i<n; i++)
     {
-      dm[i] = buf.find(cols[i])->second;
+      const T * value = _buf_find(row-SparseMatrix<T>::_global_offset, cols[i]);
+      dm[i] = value ? *value : T(0.0);
     }
   }
   else
@@ -456,11 +476,9 @@ T PetscMatrix<T>::operator () (const unsigned int i, const unsigned int j) const
   
   if(_mat_buf_mode)
   {
-    const std::map<unsigned int, T> & buf = _mat_local[i-SparseMatrix<T>::_global_offset];
+    const T * value = _buf_find(i-SparseMatrix<T>::_global_offset, j);
   
-    typename std::map<unsigned int, T>::const_iterator ent =  buf.find(j);
-  
-    if(ent != buf.end() ) return ent->second;
+    if( value ) return *value;
 
     // Otherwise the entry is not in the sparse matrix,
     // i.e. it is 0.
@@ -532,6 +550,12 @@ void PetscMatrix<T>::add_row_to_row(const std::vector<int> &src_rows,
       genius_assert(SparseMatrix<T>::row_on_processor(src_row));
     
       unsigned int local_src_row = src_row - SparseMatrix<T>::_global_offset;
+      if( !_buf_row_ptr.empty() )
+      {
+        for(int k=_buf_row_ptr[local_src_row]; k<_buf_row_ptr[local_src_row+1]; ++k)
+          if( _buf_used[k] ) add(dst_row, _buf_cols[k], _buf_values[k]);
+      }
+
       const std::map<unsigned int, T> & cols = _mat_local[local_src_row];
       for(typename std::map<unsigned int, T>::const_iterator it=cols.begin(); it!=cols.end(); it++)
       {
@@ -617,8 +641,10 @@ void PetscMatrix<T>::clear_row(int row, const T diag )
     
     for(typename std::map<unsigned int, T>::iterator it=cols.begin(); it!=cols.end(); it++)
       it->second = 0.0;
+    if( !_buf_row_ptr.empty() )
+      std::fill(_buf_values.begin()+_buf_row_ptr[local_row], _buf_values.begin()+_buf_row_ptr[local_row+1], T(0.0));
     
-    cols[row] = diag;
+    _buf_entry(local_row, row) = diag;
     return;
   }
     
@@ -644,8 +670,10 @@ void PetscMatrix<T>::clear_row(const std::vector<int> &rows, const T diag)
     
       for(typename std::map<unsigned int, T>::iterator it=cols.begin(); it!=cols.end(); it++)
         it->second = 0.0;
+      if( !_buf_row_ptr.empty() )
+        std::fill(_buf_values.begin()+_buf_row_ptr[local_row], _buf_values.begin()+_buf_row_ptr[local_row+1], T(0.0));
     
-      cols[rows[n]] = diag;
+      _buf_entry(local_row, rows[n]) = diag;
     }
     return;
   }
@@ -741,6 +769,15 @@ void PetscMatrix<T>::flush_buf()
       if( SparseMatrix<T>::col_on_processor(col) ) nz++;
       else noz++;
     }
+    if( !_buf_row_ptr.empty() )
+    {
+      for(int k=_buf_row_ptr[n]; k<_buf_row_ptr[n+1]; ++k)
+      {
+        if( !_buf_used[k] ) continue;
+        if( SparseMatrix<T>::col_on_processor(_buf_cols[k]) ) nz++;
+        else noz++;
+      }
+    }
     n_nz[n] = nz;
     n_oz[n] = noz;
   }
@@ -775,19 +812,32 @@ void PetscMatrix<T>::flush_buf()
   ierr = MatSetFromOptions(_mat); genius_assert(!ierr);
   
   // set value
+  std::vector<unsigned int> cols;
+  std::vector<T> col_values;
   for(size_t n=0; n<_mat_local.size(); ++n)
   {
     unsigned int row = n+SparseMatrix<T>::_global_offset; 
     
+    cols.clear();
+    col_values.clear();
+    if( !_buf_row_ptr.empty() )
+    {
+      for(int k=_buf_row_ptr[n]; k<_buf_row_ptr[n+1]; ++k)
+        if( _buf_used[k] )
+        {
+          cols.push_back(_buf_cols[k]);
+          col_values.push_back(_buf_values[k]);
+        }
+    }
+
     const std::map<unsigned int, T> & col_map = _mat_local[n];
-    std::vector<unsigned int> cols;
-    std::vector<T> col_values; 
     for(typename std::map<unsigned int, T>::const_iterator it=col_map.begin(); it!=col_map.end(); it++)
     {
       cols.push_back(it->first);
       col_values.push_back(it->second);
     }
     
+    if( cols.empty() ) continue;
     ierr = MatSetValues(_mat, 1, (int*) &row, cols.size(), (int*) &cols[0], &col_values[0], ADD_VALUES);
     genius_assert(!ierr);
   }
@@ -798,9 +848,71 @@ void PetscMatrix<T>::flush_buf()
   
   
   _mat_local.clear();
+  std::vector<int>().swap(_buf_row_ptr);
+  std::vector<int>().swap(_buf_cols);
+  std::vector<T>().swap(_buf_values);
+  std::vector<unsigned char>().swap(_buf_used);
   _mat_buf_mode = false;
 }
 
+
+
+template <typename T>
+void PetscMatrix<T>::set_sparsity_pattern(SparsityPattern & pattern)
+{
+  genius_assert(_mat_buf_mode);
+  genius_assert(pattern.built());
+  genius_assert(pattern.n_local() == SparseMatrix<T>::_m_local);
+
+  _buf_row_ptr.swap(pattern.row_ptr());
+  _buf_cols.swap(pattern.col_index());
+  _buf_values.assign(_buf_cols.size(), T(0.0));
+  _buf_used.assign(_buf_cols.size(), 0);
+}
+
+
+
+template <typename T>
+T & PetscMatrix<T>::_buf_entry(unsigned int i, unsigned int j)
+{
+  if( !_buf_cols.empty() )
+  {
+    const int * begin = &_buf_cols[0] + _buf_row_ptr[i];
+    const int * end   = &_buf_cols[0] + _buf_row_ptr[i+1];
+    const int * p = std::lower_bound(begin, end, static_cast<int>(j));
+    if( p != end && *p == static_cast<int>(j) )
+    {
+      const int k = p - &_buf_cols[0];
+      _buf_used[k] = 1;
+      return _buf_values[k];
+    }
+  }
+
+  // not in the pattern
+  return _mat_local[i][j];
+}
+
+
+
+template <typename T>
+const T * PetscMatrix<T>::_buf_find(unsigned int i, unsigned int j) const
+{
+  if( !_buf_cols.empty() )
+  {
+    const int * begin = &_buf_cols[0] + _buf_row_ptr[i];
+    const int * end   = &_buf_cols[0] + _buf_row_ptr[i+1];
+    const int * p = std::lower_bound(begin, end, static_cast<int>(j));
+    if( p != end && *p == static_cast<int>(j) )
+    {
+      const int k = p - &_buf_cols[0];
+      return _buf_used[k] ? &_buf_values[k] : NULL;
+    }
+  }
+
+  typename std::map<unsigned int, T>::const_iterator it = _mat_local[i].find(j);
+  return it != _mat_local[i].end() ? &it->second : NULL;
+}
+
 //------------------------------------------------------------------
 // Explicit instantiations
 template class PetscMatrix<PetscScalar>;
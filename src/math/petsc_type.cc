@@ -93,6 +93,7 @@ namespace SolverSpecify
       LinearSolverName_to_LinearSolverType["mumps"       ]  = MUMPS;
       LinearSolverName_to_LinearSolverType["superlu_dist"]  = SuperLU_DIST;
       LinearSolverName_to_LinearSolverType["gss"         ]  = GSS;
+      LinearSolverName_to_LinearSolverType["klu"         ]  = KLU;
     }
 
   }
@@ -173,7 +174,8 @@ namespace SolverSpecify
       case PASTIX       :
       case MUMPS        :
       case SuperLU_DIST :
-      case GSS          : return DIRECT;
+      case GSS          :
+      case KLU          : return DIRECT;
     }
 
     return HYBRID;
@@ -26,10 +26,26 @@
 
 #include "genius_petsc.h"
 #include "petsc_utils.h"
+#include "perf_log.h"
 
 
 namespace PetscUtils
 {
+
+  /**
+   * add the newton and linear iterations of the last SNESSolve to the performance counters
+   */
+  PetscErrorCode SNESCountIterations(SNES snes)
+  {
+    PetscErrorCode ierr;
+    PetscInt its, lits;
+    ierr = SNESGetIterationNumber(snes, &its); if(ierr) return ierr;
+    ierr = SNESGetLinearSolveIterations(snes, &lits); if(ierr) return ierr;
+    PERF_COUNT("newton iterations", its);
+    PERF_COUNT("linear solver iterations", lits);
+    return 0;
+  }
+
   /**
    * wrap to petsc MatZeroRows
    */
@@ -0,0 +1,279 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <algorithm>
+
+#include "omp_threads.h"
+
+#include "sparsity_pattern.h"
+#include "parallel.h"
+#include "perf_log.h"
+
+
+namespace
+{
+  typedef std::pair<unsigned int, unsigned int> Range;
+
+  /**
+   * collect the column ranges of all the declarations of a row, sort and merge them.
+   * @return the number of columns
+   */
+  unsigned int merge_row_ranges(const unsigned int * rec, unsigned int n_rec,
+                                const std::vector<unsigned int> &rec_begin,
+                                const std::vector<unsigned int> &range_col,
+                                const std::vector<unsigned int> &range_n_cols,
+                                std::vector<Range> &ranges)
+  {
+    ranges.clear();
+    for(unsigned int n=0; n<n_rec; ++n)
+      for(unsigned int k=rec_begin[rec[n]]; k<rec_begin[rec[n]+1]; ++k)
+        if( range_n_cols[k] ) ranges.push_back(Range(range_col[k], range_col[k]+range_n_cols[k]));
+
+    if( ranges.empty() ) return 0;
+
+    std::sort(ranges.begin(), ranges.end());
+
+    // merge overlapped or adjacent ranges in place
+    unsigned int m = 0;
+    for(unsigned int k=1; k<ranges.size(); ++k)
+    {
+      if( ranges[k].first <= ranges[m].second )
+        ranges[m].second = std::max(ranges[m].second, ranges[k].second);
+      else
+        ranges[++m] = ranges[k];
+    }
+    ranges.resize(m+1);
+
+    unsigned int n_cols = 0;
+    for(unsigned int k=0; k<ranges.size(); ++k)
+      n_cols += ranges[k].second - ranges[k].first;
+    return n_cols;
+  }
+}
+
+
+
+SparsityPattern::SparsityPattern(unsigned int n_global, unsigned int n_local, unsigned int global_offset)
+  : _n_global(n_global), _n_local(n_local), _global_offset(global_offset)
+{}
+
+
+
+void SparsityPattern::add_coupling(const std::vector<PetscInt> &rows, const std::vector<PetscInt> &cols)
+{
+  for(unsigned int i=0; i<rows.size(); ++i)
+  {
+    add_rows(rows[i], 1);
+
+    // consecutive columns as one range
+    unsigned int k = 0;
+    while( k<cols.size() )
+    {
+      unsigned int n = 1;
+      while( k+n<cols.size() && cols[k+n] == cols[k]+static_cast<PetscInt>(n) ) n++;
+      add_cols(cols[k], n);
+      k += n;
+    }
+  }
+}
+
+
+
+void SparsityPattern::append(SparsityPattern &other)
+{
+  const unsigned int shift = _range_col.size();
+  for(unsigned int r=0; r<other._rec_row.size(); ++r)
+  {
+    _rec_row.push_back(other._rec_row[r]);
+    _rec_n_rows.push_back(other._rec_n_rows[r]);
+    _rec_begin.push_back(other._rec_begin[r] + shift);
+  }
+  _range_col.insert(_range_col.end(), other._range_col.begin(), other._range_col.end());
+  _range_n_cols.insert(_range_n_cols.end(), other._range_n_cols.begin(), other._range_n_cols.end());
+
+  other.clear();
+}
+
+
+
+void SparsityPattern::_exchange_nonlocal()
+{
+  const unsigned int row_begin = _global_offset;
+  const unsigned int row_end   = _global_offset + _n_local;
+
+  // pack the declarations not entirely on this processor as
+  // row, n_rows, n_ranges, (col, n_cols)...
+  std::vector<unsigned int> buffer;
+  for(unsigned int r=0; r<_rec_row.size(); ++r)
+  {
+    if( _rec_row[r] >= row_begin && _rec_row[r]+_rec_n_rows[r] <= row_end ) continue;
+
+    const unsigned int range_end = r+1<_rec_row.size() ? _rec_begin[r+1] : _range_col.size();
+    buffer.push_back(_rec_row[r]);
+    buffer.push_back(_rec_n_rows[r]);
+    buffer.push_back(range_end - _rec_begin[r]);
+    for(unsigned int k=_rec_begin[r]; k<range_end; ++k)
+    {
+      buffer.push_back(_range_col[k]);
+      buffer.push_back(_range_n_cols[k]);
+    }
+  }
+
+  unsigned int nonlocal_entries = buffer.size();
+  Parallel::sum(nonlocal_entries);
+  if( !nonlocal_entries ) return;
+
+  Parallel::allgather(buffer);
+
+  // keep the ones overlap the local rows, the rows out of range are clipped in build()
+  unsigned int p = 0;
+  while( p<buffer.size() )
+  {
+    const unsigned int row = buffer[p], n_rows = buffer[p+1], n_ranges = buffer[p+2];
+    p += 3;
+    if( row < row_end && row+n_rows > row_begin )
+    {
+      add_rows(row, n_rows);
+      for(unsigned int k=0; k<n_ranges; ++k)
+        add_cols(buffer[p+2*k], buffer[p+2*k+1]);
+    }
+    p += 2*n_ranges;
+  }
+}
+
+
+
+void SparsityPattern::build()
+{
+  START_LOG("build()", "SparsityPattern");
+
+  _exchange_nonlocal();
+
+  const unsigned int row_begin = _global_offset;
+  const unsigned int row_end   = _global_offset + _n_local;
+  const unsigned int n_rec = _rec_row.size();
+  _rec_begin.push_back(_range_col.size());
+
+  // counting sort of the declarations by local row
+  std::vector<unsigned int> rec_ptr(_n_local+1, 0);
+  for(unsigned int r=0; r<n_rec; ++r)
+  {
+    const unsigned int begin = std::max(_rec_row[r], row_begin);
+    const unsigned int end   = std::min(_rec_row[r]+_rec_n_rows[r], row_end);
+    for(unsigned int row=begin; row<end; ++row)
+      rec_ptr[row-row_begin+1]++;
+  }
+  for(unsigned int i=0; i<_n_local; ++i)
+    rec_ptr[i+1] += rec_ptr[i];
+
+  std::vector<unsigned int> row_rec(rec_ptr.back()+1);
+  {
+    std::vector<unsigned int> pos(rec_ptr.begin(), rec_ptr.end()-1);
+    for(unsigned int r=0; r<n_rec; ++r)
+    {
+      const unsigned int begin = std::max(_rec_row[r], row_begin);
+      const unsigned int end   = std::min(_rec_row[r]+_rec_n_rows[r], row_end);
+      for(unsigned int row=begin; row<end; ++row)
+        row_rec[pos[row-row_begin]++] = r;
+    }
+  }
+
+  _row_ptr.assign(_n_local+1, 0);
+  _n_nz.assign(_n_local, 0);
+  _n_oz.assign(_n_local, 0);
+
+  // rows are independent, first count then fill the columns of each row
+  const int n_rows = static_cast<int>(_n_local);
+#ifdef HAVE_OPENMP
+  const int n_threads = OmpThreads::loop_threads(n_rows);
+  #pragma omp parallel num_threads(n_threads)
+#endif
+  {
+    std::vector<Range> ranges;
+
+#ifdef HAVE_OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for(int i=0; i<n_rows; ++i)
+    {
+      const unsigned int n_cols = merge_row_ranges(&row_rec[rec_ptr[i]], rec_ptr[i+1]-rec_ptr[i],
+                                                   _rec_begin, _range_col, _range_n_cols, ranges);
+      unsigned int nz = 0;
+      for(unsigned int k=0; k<ranges.size(); ++k)
+      {
+        genius_assert(ranges[k].second <= _n_global);
+        const unsigned int begin = std::max(ranges[k].first, row_begin);
+        const unsigned int end   = std::min(ranges[k].second, row_end);
+        if( begin < end ) nz += end - begin;
+      }
+      _n_nz[i] = nz;
+      _n_oz[i] = n_cols - nz;
+      _row_ptr[i+1] = n_cols;
+    }
+
+#ifdef HAVE_OPENMP
+    #pragma omp single
+#endif
+    {
+      for(unsigned int i=0; i<_n_local; ++i)
+        _row_ptr[i+1] += _row_ptr[i];
+      _col_index.resize(_row_ptr.back());
+    }
+
+#ifdef HAVE_OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for(int i=0; i<n_rows; ++i)
+    {
+      merge_row_ranges(&row_rec[rec_ptr[i]], rec_ptr[i+1]-rec_ptr[i],
+                       _rec_begin, _range_col, _range_n_cols, ranges);
+      int * col = _col_index.empty() ? 0 : &_col_index[_row_ptr[i]];
+      for(unsigned int k=0; k<ranges.size(); ++k)
+        for(unsigned int c=ranges[k].first; c<ranges[k].second; ++c)
+          *col++ = c;
+    }
+  }
+
+  // declarations are no longer needed
+  std::vector<unsigned int>().swap(_rec_row);
+  std::vector<unsigned int>().swap(_rec_n_rows);
+  std::vector<unsigned int>().swap(_rec_begin);
+  std::vector<unsigned int>().swap(_range_col);
+  std::vector<unsigned int>().swap(_range_n_cols);
+
+  STOP_LOG("build()", "SparsityPattern");
+}
+
+
+
+void SparsityPattern::clear()
+{
+  std::vector<unsigned int>().swap(_rec_row);
+  std::vector<unsigned int>().swap(_rec_n_rows);
+  std::vector<unsigned int>().swap(_rec_begin);
+  std::vector<unsigned int>().swap(_range_col);
+  std::vector<unsigned int>().swap(_range_n_cols);
+
+  std::vector<int>().swap(_row_ptr);
+  std::vector<int>().swap(_col_index);
+  std::vector<int>().swap(_n_nz);
+  std::vector<int>().swap(_n_oz);
+}
@@ -20,7 +20,7 @@
 
 
 // C++ includes
-
+#include <algorithm>
 
 // Local includes
 #include "elem.h"
@@ -41,13 +41,16 @@
 //------------------------------------------------------
 // BoundaryInfo static member initializations
 const short int BoundaryInfo::invalid_id = -1234;
+const unsigned int BoundaryInfo::max_elem_sides = 6;
 
 
 
 //------------------------------------------------------
 // BoundaryInfo functions
 BoundaryInfo::BoundaryInfo(const MeshBase& m) :
-    _mesh (m)
+    _mesh (m),
+    _n_boundary_nodes (0),
+    _n_boundary_sides (0)
 {}
 
 
@@ -61,8 +64,13 @@ BoundaryInfo::~BoundaryInfo()
 
 void BoundaryInfo::clear()
 {
+  _boundary_node.clear();
   _boundary_node_id.clear();
+  _n_boundary_nodes = 0;
+  _boundary_elem.clear();
   _boundary_side_id.clear();
+  _boundary_side_extra_id.clear();
+  _n_boundary_sides = 0;
   _boundary_ids.clear();
   _boundary_labels_to_ids.clear();
   _boundary_ids_to_labels.clear();
@@ -73,6 +81,62 @@ void BoundaryInfo::clear()
 
 
 
+unsigned int BoundaryInfo::_node_slot(const Node* node) const
+{
+  const unsigned int id = node->id();
+
+  if (id < _boundary_node.size() && _boundary_node[id] == node)
+    return id;
+
+  return invalid_uint;
+}
+
+
+
+unsigned int BoundaryInfo::_elem_slot(const Elem* elem) const
+{
+  const unsigned int id = elem->id();
+
+  if (id < _boundary_elem.size() && _boundary_elem[id] == elem)
+    return id;
+
+  return invalid_uint;
+}
+
+
+
+void BoundaryInfo::_clear_elem_slot(unsigned int e)
+{
+  for (unsigned int s=0; s<max_elem_sides; ++s)
+  {
+    const unsigned int i = e*max_elem_sides + s;
+    if (_boundary_side_id[i] != invalid_id)
+    {
+      _boundary_side_id[i] = invalid_id;
+      _n_boundary_sides -= 1 + _boundary_side_extra_id.erase(i);
+    }
+  }
+
+  _boundary_elem[e] = NULL;
+}
+
+
+
+void BoundaryInfo::_side_ids(unsigned int i, std::vector<short int> & ids) const
+{
+  ids.clear();
+
+  if (_boundary_side_id[i] == invalid_id) return;
+  ids.push_back(_boundary_side_id[i]);
+
+  typedef std::multimap<unsigned int, short int>::const_iterator It;
+  std::pair<It, It> bound = _boundary_side_extra_id.equal_range(i);
+  for (; bound.first != bound.second; ++bound.first)
+    ids.push_back(bound.first->second);
+}
+
+
+
 void BoundaryInfo::sync(BoundaryMesh& boundary_mesh)
 {
   boundary_mesh.clear();
@@ -148,32 +212,20 @@ void BoundaryInfo::sync(BoundaryMesh& boundary_mesh)
         // Get the top-level parent for this element
         const Elem* top_parent = elem->top_parent();
 
-        // A convenient typedef
-        typedef
-        std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator
-        Iter;
-
         // Find the right id number for that side
-        std::pair<Iter, Iter> pos = _boundary_side_id.equal_range(top_parent);
+        const short int bd_id = this->boundary_id(top_parent, s, false);
 
-        while (pos.first != pos.second)
+        if (bd_id != invalid_id) // already flagged with a boundary condition
         {
-          if (pos.first->second.first == s) // already flagged with a boundary condition
-          {
-            side->subdomain_id() =
-              id_map[pos.first->second.second];
+          side->subdomain_id() =
+            id_map[bd_id];
 
-            side->processor_id() =
-              side->subdomain_id();
-            break;
-          }
-
-          ++pos.first;
+          side->processor_id() =
+            side->subdomain_id();
         }
-
         // either the element wasn't found or side s
         // doesn't have a boundary condition
-        if (pos.first == pos.second)
+        else
         {
           side->subdomain_id() = id_map[invalid_id];
         }
@@ -225,7 +277,21 @@ void BoundaryInfo::add_node(const Node* node, const short int id)
     genius_error();
   }
 
-  _boundary_node_id[node] = id;
+  const unsigned int n = node->id();
+  assert (n != DofObject::invalid_id);
+
+  if (n >= _boundary_node.size())
+  {
+    const unsigned int n_slots = std::max(n+1, _mesh.max_node_id());
+    _boundary_node.resize(n_slots, NULL);
+    _boundary_node_id.resize(n_slots, invalid_id);
+  }
+
+  if (_boundary_node[n] == NULL)
+    ++_n_boundary_nodes;
+
+  _boundary_node[n] = node;
+  _boundary_node_id[n] = id;
   _boundary_ids.insert(id);
 }
 
@@ -259,35 +325,43 @@ void BoundaryInfo::add_side(const Elem* elem,
     genius_error();
   }
 
-  // if the elem/side pair has already been set, skip it
+  const unsigned int e = elem->id();
+  assert (e != DofObject::invalid_id);
+  assert (side < max_elem_sides);
+
+  if (e >= _boundary_elem.size())
   {
-    typedef std::multimap<const Elem*, std::pair<unsigned short int, short int> >::iterator It;
-    std::pair<It, It> bound = _boundary_side_id.equal_range(elem);
-    while(bound.first!=bound.second)
-    {
-      if(bound.first->second.first==side && bound.first->second.second==id) return;
-      ++bound.first;
-    }
+    const unsigned int n_slots = std::max(e+1, _mesh.max_elem_id());
+    _boundary_elem.resize(n_slots, NULL);
+    _boundary_side_id.resize(n_slots*max_elem_sides, invalid_id);
   }
 
-  std::pair<unsigned short int, short int> p(side,id);
-  std::pair<const Elem*, std::pair<unsigned short int, short int> >  kv (elem, p);
-
-  _boundary_side_id.insert(kv);
-  _boundary_ids.insert(id);
+  // the slot may still hold the sides of an elem this one replaces
+  if (_boundary_elem[e] != elem)
+  {
+    _clear_elem_slot(e);
+    _boundary_elem[e] = elem;
+  }
 
-  // Possilby add the nodes of the side,
-  // no matter they are already there.
-  /*
+  // if the elem/side pair has already been set, skip it
+  const unsigned int i = e*max_elem_sides + side;
+  if (_boundary_side_id[i] == invalid_id)
+    _boundary_side_id[i] = id;
+  else
   {
-    assert (side < elem->n_sides());
+    if (_boundary_side_id[i] == id) return;
+
+    typedef std::multimap<unsigned int, short int>::const_iterator It;
+    std::pair<It, It> bound = _boundary_side_extra_id.equal_range(i);
+    for (; bound.first != bound.second; ++bound.first)
+      if (bound.first->second == id) return;
 
-    AutoPtr<Elem> side_elem(elem->build_side(side));
+    // more ids of the same side go to the overflow list
+    _boundary_side_extra_id.insert(std::make_pair(i, id));
+  }
 
-    for (unsigned int n=0; n<side_elem->n_nodes(); n++)
-      //if (this->boundary_id(side_elem->get_node(n)) == invalid_id)
-      this->add_node(side_elem->get_node(n), id);
-  }*/
+  ++_n_boundary_sides;
+  _boundary_ids.insert(id);
 }
 
 void BoundaryInfo::boundary_side_nodes_with_id ( std::map<short int, std::set<const Node *> > & boundary_side_nodes_id_map) const
@@ -296,25 +370,31 @@ void BoundaryInfo::boundary_side_nodes_with_id ( std::map<short int, std::set<co
 
   boundary_side_nodes_id_map.clear();
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+  std::vector<short int> bd_ids;
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    const Elem* elem = (*pos).first;
-    unsigned short int side = (*pos).second.first;
-    short int bd_id = (*pos).second.second;
-
-    std::vector<const Elem*> family;
-    elem->active_family_tree_by_side(family, side);
+    const Elem* elem = _boundary_elem[e];
+    if (elem == NULL) continue;
 
-    for(unsigned int f=0; f<family.size(); ++f)
+    for (unsigned short int side=0; side<max_elem_sides; ++side)
     {
-      const Elem* family_elem = family[f];
-      AutoPtr<Elem> side_elem = family_elem->build_side(side);
+      _side_ids(e*max_elem_sides + side, bd_ids);
+      if (bd_ids.empty()) continue;
 
-      for (unsigned int n=0; n<side_elem->n_nodes(); ++n)
+      std::vector<const Elem*> family;
+      elem->active_family_tree_by_side(family, side);
+
+      for(unsigned int f=0; f<family.size(); ++f)
       {
-        const Node * node = side_elem->get_node(n);
-        boundary_side_nodes_id_map[bd_id].insert(node);
+        const Elem* family_elem = family[f];
+        AutoPtr<Elem> side_elem = family_elem->build_side(side);
+
+        for (unsigned int n=0; n<side_elem->n_nodes(); ++n)
+        {
+          const Node * node = side_elem->get_node(n);
+          for (unsigned int k=0; k<bd_ids.size(); ++k)
+            boundary_side_nodes_id_map[bd_ids[k]].insert(node);
+        }
       }
     }
   }
@@ -324,51 +404,62 @@ void BoundaryInfo::boundary_side_nodes_with_id ( std::map<short int, std::set<co
 
 void BoundaryInfo::build_node_ids_from_priority_order(const std::map<short int, unsigned int> & order)
 {
+  _boundary_node.clear();
   _boundary_node_id.clear();
+  _n_boundary_nodes = 0;
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+  std::vector<short int> bd_ids;
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    const Elem* elem = (*pos).first;
-    unsigned short int side = (*pos).second.first;
-    short int bd_id = (*pos).second.second;
+    const Elem* elem = _boundary_elem[e];
+    if (elem == NULL) continue;
 
-    std::vector<const Elem*> family;
-    elem->active_family_tree_by_side(family, side);
-
-    for(unsigned int f=0; f<family.size(); ++f)
+    for (unsigned short int side=0; side<max_elem_sides; ++side)
     {
-      const Elem* family_elem = family[f];
-      AutoPtr<Elem> side_elem = family_elem->build_side(side);
+      _side_ids(e*max_elem_sides + side, bd_ids);
+      if (bd_ids.empty()) continue;
+
+      std::vector<const Elem*> family;
+      elem->active_family_tree_by_side(family, side);
 
-      for (unsigned int n=0; n<side_elem->n_nodes(); ++n)
+      for (unsigned int k=0; k<bd_ids.size(); ++k)
       {
+        short int bd_id = bd_ids[k];
 
-        const Node * node = side_elem->get_node(n);
+        for(unsigned int f=0; f<family.size(); ++f)
+        {
+          const Elem* family_elem = family[f];
+          AutoPtr<Elem> side_elem = family_elem->build_side(side);
 
-        std::map<const Node*, short int>::iterator it = _boundary_node_id.find(node);
+          for (unsigned int n=0; n<side_elem->n_nodes(); ++n)
+          {
 
-        // the node is already exist
-        if( it != _boundary_node_id.end()  )
-        {
-          // the bd id of existing node
-          short int node_bd_id = (*it).second;
-
-          //if current bd_id has a higher priority order, replace existing bd_id
-          unsigned int o1 = (*order.find(bd_id)).second;
-          unsigned int o2 = (*order.find(node_bd_id)).second;
-          if(  o1 > o2  )
-            _boundary_node_id[node] = bd_id;
-
-          // or two node has the same priority order, set bd_id to little one
-          if( o1 == o2 && get_label_by_id(bd_id) < get_label_by_id(node_bd_id))
-            _boundary_node_id[node] = bd_id;
-        }
-        // not exist yet? insert it
-        else
-          _boundary_node_id[node] = bd_id;
+            const Node * node = side_elem->get_node(n);
+
+            unsigned int slot = _node_slot(node);
+
+            // the node is already exist
+            if( slot != invalid_uint )
+            {
+              // the bd id of existing node
+              short int node_bd_id = _boundary_node_id[slot];
 
+              //if current bd_id has a higher priority order, replace existing bd_id
+              unsigned int o1 = (*order.find(bd_id)).second;
+              unsigned int o2 = (*order.find(node_bd_id)).second;
+              if(  o1 > o2  )
+                _boundary_node_id[slot] = bd_id;
+
+              // or two node has the same priority order, set bd_id to little one
+              if( o1 == o2 && get_label_by_id(bd_id) < get_label_by_id(node_bd_id))
+                _boundary_node_id[slot] = bd_id;
+            }
+            // not exist yet? insert it
+            else
+              this->add_node(node, bd_id);
+
+          }
+        }
       }
     }
   }
@@ -381,7 +472,13 @@ void BoundaryInfo::remove (const Node* node)
   assert (node != NULL);
 
   // Erase everything associated with node
-  _boundary_node_id.erase (node);
+  unsigned int slot = _node_slot(node);
+  if (slot != invalid_uint)
+  {
+    _boundary_node[slot] = NULL;
+    _boundary_node_id[slot] = invalid_id;
+    --_n_boundary_nodes;
+  }
 
   // for efficency reason, we don't do it here.
   // please call rebuild_ids() after all the remove operator
@@ -397,7 +494,9 @@ void BoundaryInfo::remove (const Elem* elem)
   assert (elem != NULL);
 
   // Erase everything associated with elem
-  _boundary_side_id.erase (elem);
+  unsigned int slot = _elem_slot(elem);
+  if (slot != invalid_uint)
+    _clear_elem_slot(slot);
 
 
   // for efficency reason, we don't do it here.
@@ -413,23 +512,25 @@ void BoundaryInfo::remove (const Elem* elem, unsigned short int side)
 {
   assert (elem != NULL);
 
-  // Erase element with the given side
-  typedef std::multimap<const Elem*, std::pair<unsigned short int, short int> >::iterator It;
-  std::pair<It,It> pos = _boundary_side_id.equal_range(elem);
-
-  std::vector<It> its;
+  unsigned int slot = _elem_slot(elem);
+  if (slot == invalid_uint || side >= max_elem_sides) return;
 
-  //record all the element should be erased.
-  while (pos.first != pos.second)
+  // Erase element with the given side, all of its ids
+  const unsigned int i = slot*max_elem_sides + side;
+  if (_boundary_side_id[i] != invalid_id)
   {
-    if( (*pos.first).second.first == side )
-      its.push_back(pos.first);
-    ++pos.first;
+    _boundary_side_id[i] = invalid_id;
+    _n_boundary_sides -= 1 + _boundary_side_extra_id.erase(i);
   }
 
-  // erase here
-  for(size_t n=0; n<its.size(); n++)
-    _boundary_side_id.erase (its[n]);
+  // release the slot when no side of elem is left
+  bool has_side = false;
+  for (unsigned int s=0; s<max_elem_sides; ++s)
+    if (_boundary_side_id[slot*max_elem_sides + s] != invalid_id)
+      has_side = true;
+
+  if (!has_side)
+    _boundary_elem[slot] = NULL;
 
 
   // for efficency reason, we don't do it here.
@@ -445,13 +546,58 @@ void BoundaryInfo::rebuild_ids()
 {
   _boundary_ids.clear();
 
-  std::map<const Node*, short int>::iterator node_it = _boundary_node_id.begin();
-  for(; node_it != _boundary_node_id.end(); ++node_it)
-    _boundary_ids.insert((*node_it).second);
+  for (unsigned int n=0; n<_boundary_node.size(); ++n)
+    if (_boundary_node[n] != NULL)
+      _boundary_ids.insert(_boundary_node_id[n]);
+
+  for (unsigned int n=0; n<_boundary_side_id.size(); ++n)
+    if (_boundary_side_id[n] != invalid_id)
+      _boundary_ids.insert(_boundary_side_id[n]);
+
+  std::multimap<unsigned int, short int>::const_iterator it = _boundary_side_extra_id.begin();
+  for (; it != _boundary_side_extra_id.end(); ++it)
+    _boundary_ids.insert(it->second);
+}
+
+
+
+void BoundaryInfo::reindex()
+{
+  // the nodes and elems keep their pointers, only the ids changed
+  std::vector<const Node*> boundary_node;
+  std::vector<short int>   boundary_node_id;
+  boundary_node.swap(_boundary_node);
+  boundary_node_id.swap(_boundary_node_id);
+  _n_boundary_nodes = 0;
+
+  for (unsigned int n=0; n<boundary_node.size(); ++n)
+    if (boundary_node[n] != NULL)
+      this->add_node(boundary_node[n], boundary_node_id[n]);
+
+  std::vector<const Elem*> boundary_elem;
+  std::vector<short int>   boundary_side_id;
+  std::multimap<unsigned int, short int> boundary_side_extra_id;
+  boundary_elem.swap(_boundary_elem);
+  boundary_side_id.swap(_boundary_side_id);
+  boundary_side_extra_id.swap(_boundary_side_extra_id);
+  _n_boundary_sides = 0;
+
+  typedef std::multimap<unsigned int, short int>::const_iterator It;
+  for (unsigned int e=0; e<boundary_elem.size(); ++e)
+  {
+    if (boundary_elem[e] == NULL) continue;
+    for (unsigned short int s=0; s<max_elem_sides; ++s)
+    {
+      const unsigned int i = e*max_elem_sides + s;
+      if (boundary_side_id[i] == invalid_id) continue;
+
+      this->add_side(boundary_elem[e], s, boundary_side_id[i]);
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::iterator elem_it = _boundary_side_id.begin();
-  for(; elem_it != _boundary_side_id.end(); ++elem_it)
-    _boundary_ids.insert((*elem_it).second.second);
+      std::pair<It, It> bound = boundary_side_extra_id.equal_range(i);
+      for (; bound.first != bound.second; ++bound.first)
+        this->add_side(boundary_elem[e], s, bound.first->second);
+    }
+  }
 }
 
 
@@ -459,14 +605,13 @@ void BoundaryInfo::rebuild_ids()
 
 short int BoundaryInfo::boundary_id(const Node* node) const
 {
-  std::map<const Node*, short int>::const_iterator
-  n = _boundary_node_id.find(node);
+  unsigned int slot = _node_slot(node);
 
   // node not in the data structure
-  if (n == _boundary_node_id.end())
+  if (slot == invalid_uint)
     return invalid_id;
 
-  return n->second;
+  return _boundary_node_id[slot];
 }
 
 
@@ -483,68 +628,29 @@ short int BoundaryInfo::boundary_id(const Elem* const elem,  const unsigned shor
   if ( to_top_parent && elem->level() != 0)
     searched_elem = elem->top_parent ();
 
-  std::pair<std::multimap<const Elem*,
-  std::pair<unsigned short int, short int> >::const_iterator,
-  std::multimap<const Elem*,
-  std::pair<unsigned short int, short int> >::const_iterator >
-  e = _boundary_side_id.equal_range(searched_elem);
+  unsigned int slot = _elem_slot(searched_elem);
 
   // elem not in the data structure
-  if (e.first == e.second)
+  if (slot == invalid_uint || side >= max_elem_sides)
     return invalid_id;
 
+  // invalid_id if elem is there but not the requested side
+  return _boundary_side_id[slot*max_elem_sides + side];
+}
 
-  // elem is there, maybe multiple occurances
-  while (e.first != e.second)
-  {
-    // if this is true we found the requested side
-    // of the element and want to return the id
-
-    if (e.first->second.first == side)
-      return e.first->second.second;
 
-    ++e.first;
-  }
 
-  // if we get here, we found elem in the data structure but not
-  // the requested side, so return the default value
-  return invalid_id;
+bool BoundaryInfo::is_boundary_elem(const Elem *e) const
+{
+  return _elem_slot(e) != invalid_uint;
 }
 
 bool BoundaryInfo::is_boundary_elem_side(const Elem * elem, unsigned int side) const
 {
   assert (elem != NULL);
 
-
-  const Elem*  searched_elem = elem;
-
-  // Only level-0 elements store BCs.  If this is not a level-0
-  // element get its level-0 parent and infer the BCs when to_top_parent is true.
-  if ( elem->level() != 0)
-    searched_elem = elem->top_parent ();
-
-  std::pair<std::multimap<const Elem*,
-  std::pair<unsigned short int, short int> >::const_iterator,
-  std::multimap<const Elem*,
-  std::pair<unsigned short int, short int> >::const_iterator >
-      e = _boundary_side_id.equal_range(searched_elem);
-
-  // elem not in the data structure
-  if (e.first == e.second)
-    return false;
-
-
-  // elem is there, maybe multiple occurances
-  while (e.first != e.second)
-  {
-    // if this is true we found the requested side of the element 
-    if (e.first->second.first == side)
-      return true;
-
-    ++e.first;
-  }
-
-  return false;
+  // Only level-0 elements store BCs, boundary_id() looks up the top parent
+  return this->boundary_id(elem, side) != invalid_id;
 }
 
 
@@ -554,22 +660,19 @@ unsigned int BoundaryInfo::side_with_boundary_id(const Elem* const elem, short i
   if (elem->level() != 0)
     searched_elem = elem->top_parent();
 
-  typedef  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator CIter;
-  std::pair<CIter,CIter> e = _boundary_side_id.equal_range(searched_elem);
+  unsigned int slot = _elem_slot(searched_elem);
 
   // elem not in the data structure
-  if (e.first == e.second)
+  if (slot == invalid_uint)
     return invalid_uint;
 
-  // elem is there, maybe multiple occurances
-  while (e.first != e.second)
+  // the lowest side with the requested boundary_id
+  std::vector<short int> bd_ids;
+  for (unsigned int s=0; s<max_elem_sides; ++s)
   {
-    // if this is true we found the requested boundary_id
-    // of the element and want to return the side
-    if (e.first->second.second == boundary_id)
-      return e.first->second.first;
-
-    ++e.first;
+    _side_ids(slot*max_elem_sides + s, bd_ids);
+    if (std::find(bd_ids.begin(), bd_ids.end(), boundary_id) != bd_ids.end())
+      return s;
   }
 
   // if we get here, we found elem in the data structure but not
@@ -583,16 +686,15 @@ void BoundaryInfo::build_node_list (std::vector<unsigned int>& nl,
                                     std::vector<short int>&    il) const
 {
   // Reserve the size, then use push_back
-  nl.reserve (_boundary_node_id.size());
-  il.reserve (_boundary_node_id.size());
-
-  std::map<const Node*, short int>::const_iterator pos
-  = _boundary_node_id.begin();
+  nl.reserve (_n_boundary_nodes);
+  il.reserve (_n_boundary_nodes);
 
-  for (; pos != _boundary_node_id.end(); ++pos)
+  for (unsigned int n=0; n<_boundary_node.size(); ++n)
   {
-    nl.push_back (pos->first->id());
-    il.push_back (pos->second);
+    if (_boundary_node[n] == NULL) continue;
+
+    nl.push_back (_boundary_node[n]->id());
+    il.push_back (_boundary_node_id[n]);
   }
 }
 
@@ -602,15 +704,13 @@ void BoundaryInfo::build_on_processor_node_list (std::vector<unsigned int>& nl,
   nl.clear();
   il.clear();
 
-  std::map<const Node*, short int>::const_iterator pos
-  = _boundary_node_id.begin();
-
-  for (; pos != _boundary_node_id.end(); ++pos)
+  for (unsigned int n=0; n<_boundary_node.size(); ++n)
   {
-    if(pos->first->processor_id() != Genius::processor_id()) continue;
+    const Node * node = _boundary_node[n];
+    if(node == NULL || node->processor_id() != Genius::processor_id()) continue;
 
-    nl.push_back (pos->first->id());
-    il.push_back (pos->second);
+    nl.push_back (node->id());
+    il.push_back (_boundary_node_id[n]);
   }
 }
 
@@ -619,18 +719,28 @@ void BoundaryInfo::build_side_list (std::vector<unsigned int>&       el,
                                     std::vector<unsigned short int>& sl,
                                     std::vector<short int>&          il) const
 {
-  el.resize (_boundary_side_id.size());
-  sl.resize (_boundary_side_id.size());
-  il.resize (_boundary_side_id.size());
-
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos = _boundary_side_id.begin();
+  el.resize (_n_boundary_sides);
+  sl.resize (_n_boundary_sides);
+  il.resize (_n_boundary_sides);
 
-  for (unsigned int n=0; pos != _boundary_side_id.end(); ++pos, ++n)
+  unsigned int n=0;
+  std::vector<short int> bd_ids;
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    el[n] = pos->first->id();
-    sl[n] = pos->second.first;
-    il[n] = pos->second.second;
+    if (_boundary_elem[e] == NULL) continue;
+
+    for (unsigned short int s=0; s<max_elem_sides; ++s)
+    {
+      _side_ids(e*max_elem_sides + s, bd_ids);
+      for (unsigned int k=0; k<bd_ids.size(); ++k, ++n)
+      {
+        el[n] = _boundary_elem[e]->id();
+        sl[n] = s;
+        il[n] = bd_ids[k];
+      }
+    }
   }
+  assert (n == _n_boundary_sides);
 }
 
 
@@ -643,32 +753,39 @@ void BoundaryInfo::build_active_side_list (std::vector<unsigned int>&       el,
   sl.clear();
   il.clear();
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+  std::vector<short int> bd_ids;
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    const Elem * elem = pos->first;
-    if (elem->active() )
-    {
-      el.push_back (pos->first->id());
-      sl.push_back (pos->second.first);
-      il.push_back (pos->second.second);
-    }
-    // this element has child
-    else
+    const Elem * elem = _boundary_elem[e];
+    if (elem == NULL) continue;
+
+    for (unsigned short int side=0; side<max_elem_sides; ++side)
     {
-      unsigned short int side = pos->second.first;
-      std::vector<const Elem*> family;
+      _side_ids(e*max_elem_sides + side, bd_ids);
+      for (unsigned int k=0; k<bd_ids.size(); ++k)
+      {
+        if (elem->active() )
+        {
+          el.push_back (elem->id());
+          sl.push_back (side);
+          il.push_back (bd_ids[k]);
+        }
+        // this element has child
+        else
+        {
+          std::vector<const Elem*> family;
 
-      elem->active_family_tree_by_side(family, side);
+          elem->active_family_tree_by_side(family, side);
 
-      for(unsigned int n=0; n<family.size(); ++n)
-      {
-        el.push_back (family[n]->id());
-        sl.push_back (side);
-        il.push_back (pos->second.second);
-      }
+          for(unsigned int n=0; n<family.size(); ++n)
+          {
+            el.push_back (family[n]->id());
+            sl.push_back (side);
+            il.push_back (bd_ids[k]);
+          }
 
+        }
+      }
     }
   }
 
@@ -683,15 +800,22 @@ void BoundaryInfo::build_on_processor_side_list (std::vector<unsigned int>&
   sl.clear();
   il.clear();
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos = _boundary_side_id.begin();
-
-  for (unsigned int n=0; pos != _boundary_side_id.end(); ++pos, ++n)
+  std::vector<short int> bd_ids;
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    if(pos->first->processor_id() != Genius::processor_id()) continue;
+    const Elem * elem = _boundary_elem[e];
+    if(elem == NULL || elem->processor_id() != Genius::processor_id()) continue;
 
-    el.push_back(pos->first->id());
-    sl.push_back(pos->second.first);
-    il.push_back(pos->second.second);
+    for (unsigned short int s=0; s<max_elem_sides; ++s)
+    {
+      _side_ids(e*max_elem_sides + s, bd_ids);
+      for (unsigned int k=0; k<bd_ids.size(); ++k)
+      {
+        el.push_back(elem->id());
+        sl.push_back(s);
+        il.push_back(bd_ids[k]);
+      }
+    }
   }
 
 }
@@ -701,18 +825,13 @@ void BoundaryInfo::build_on_processor_side_list (std::vector<unsigned int>&
 void BoundaryInfo::nodes_with_boundary_id (std::vector<unsigned int>& nl, short int boundary_id) const
 {
   nl.clear();
-  // use set to reorder the nodes by their id
-  std::set<unsigned int> bd_node_set;
 
-  std::map<const Node*, short int>::const_iterator pos = _boundary_node_id.begin();
-  for (; pos != _boundary_node_id.end(); ++pos)
+  // the node table is indexed by node id, nodes come out sorted
+  for (unsigned int n=0; n<_boundary_node.size(); ++n)
   {
-    if( pos->second==boundary_id )
-      bd_node_set.insert(pos->first->id());
+    if( _boundary_node[n] && _boundary_node_id[n]==boundary_id )
+      nl.push_back(_boundary_node[n]->id());
   }
-
-  for(std::set<unsigned int>::iterator it=bd_node_set.begin(); it!=bd_node_set.end(); ++it)
-      nl.push_back(*it);
 }
 
 
@@ -720,18 +839,13 @@ void BoundaryInfo::nodes_with_boundary_id (std::vector<unsigned int>& nl, short
 void BoundaryInfo::nodes_with_boundary_id (std::vector<const Node *>& nl, short int boundary_id) const
 {
   nl.clear();
-  // use map to reorder the nodes by their id
-  std::map<unsigned int, const Node *> bd_node_map;
 
-  std::map<const Node*, short int>::const_iterator pos = _boundary_node_id.begin();
-  for (; pos != _boundary_node_id.end(); ++pos)
+  // the node table is indexed by node id, nodes come out sorted
+  for (unsigned int n=0; n<_boundary_node.size(); ++n)
   {
-    if( pos->second==boundary_id )
-      bd_node_map[pos->first->id()] = pos->first;
+    if( _boundary_node[n] && _boundary_node_id[n]==boundary_id )
+      nl.push_back(_boundary_node[n]);
   }
-
-  for(std::map<unsigned int, const Node *>::iterator it=bd_node_map.begin(); it!=bd_node_map.end(); ++it)
-    nl.push_back((*it).second);
 }
 
 
@@ -739,10 +853,10 @@ void BoundaryInfo::nodes_with_boundary_id ( std::map<short int, std::vector<cons
 {
   node_boundary_id_map.clear();
 
-  std::map<const Node*, short int>::const_iterator pos = _boundary_node_id.begin();
-  for (; pos != _boundary_node_id.end(); ++pos)
+  for (unsigned int n=0; n<_boundary_node.size(); ++n)
   {
-    node_boundary_id_map[pos->second].push_back(pos->first);
+    if( _boundary_node[n] )
+      node_boundary_id_map[_boundary_node_id[n]].push_back(_boundary_node[n]);
   }
 }
 
@@ -752,29 +866,32 @@ void BoundaryInfo::node_in_regions ( std::map<const Node *, std::set<unsigned in
   {
     node_region_map.clear();
 
-    std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-    for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+    for (unsigned int e=0; e<_boundary_elem.size(); ++e)
     {
-      const Elem* elem = (*pos).first;
-      unsigned short int side = (*pos).second.first;
-      short int bd_id = (*pos).second.second;
+      const Elem* elem = _boundary_elem[e];
+      if (elem == NULL) continue;
 
-      std::vector<const Elem*> family;
-      elem->active_family_tree_by_side(family, side);
-
-      for(unsigned int f=0; f<family.size(); ++f)
+      for (unsigned short int side=0; side<max_elem_sides; ++side)
       {
-        const Elem* family_elem = family[f];
-        AutoPtr<Elem> side_elem = family_elem->build_side(side);
+        if (_boundary_side_id[e*max_elem_sides + side] == invalid_id) continue;
 
-        for (unsigned int n=0; n<side_elem->n_nodes(); ++n)
+        std::vector<const Elem*> family;
+        elem->active_family_tree_by_side(family, side);
+
+        for(unsigned int f=0; f<family.size(); ++f)
         {
-          const Node * node = side_elem->get_node(n);
-          node_region_map[node].insert(elem->subdomain_id());
+          const Elem* family_elem = family[f];
+          AutoPtr<Elem> side_elem = family_elem->build_side(side);
+
+          for (unsigned int n=0; n<side_elem->n_nodes(); ++n)
+          {
+            const Node * node = side_elem->get_node(n);
+            node_region_map[node].insert(elem->subdomain_id());
+          }
         }
       }
     }
-    assert(node_region_map.size() == _boundary_node_id.size());
+    assert(node_region_map.size() == _n_boundary_nodes);
   }
 
 
@@ -784,37 +901,36 @@ void BoundaryInfo::active_elem_with_boundary_id (std::vector<const Elem *>& el,
   el.clear();
   sl.clear();
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end();
-       ++pos)
+  std::vector<short int> bd_ids;
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    const Elem * elem = pos->first;
-    if (elem->active() )
+    const Elem * elem = _boundary_elem[e];
+    if (elem == NULL) continue;
+
+    for (unsigned short int side=0; side<max_elem_sides; ++side)
     {
-      if( pos->second.second == boundary_id )
+      _side_ids(e*max_elem_sides + side, bd_ids);
+      if( std::find(bd_ids.begin(), bd_ids.end(), boundary_id) == bd_ids.end() ) continue;
+
+      if (elem->active() )
       {
-        el.push_back (pos->first);
-        sl.push_back (pos->second.first);
+        el.push_back (elem);
+        sl.push_back (side);
       }
-    }
-    // this element has child
-    else
-    {
-      unsigned short int side = pos->second.first;
-      std::vector<const Elem*> family;
+      // this element has child
+      else
+      {
+        std::vector<const Elem*> family;
 
-      elem->active_family_tree_by_side(family, side);
+        elem->active_family_tree_by_side(family, side);
 
-      for(unsigned int n=0; n<family.size(); ++n)
-      {
-        if( pos->second.second == boundary_id )
+        for(unsigned int n=0; n<family.size(); ++n)
         {
           el.push_back (family[n]);
           sl.push_back (side);
         }
-      }
 
+      }
     }
   }
 
@@ -825,25 +941,33 @@ void BoundaryInfo::active_elem_with_boundary_id (
 {
   boundary_elem_side_map.clear();
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+  std::vector<short int> bd_ids;
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    const Elem * elem = pos->first;
-    if (elem->active() )
-    {
-      boundary_elem_side_map[pos->second.second].push_back(std::make_pair(pos->first, pos->second.first));
-    }
-    // this element has child
-    else
+    const Elem * elem = _boundary_elem[e];
+    if (elem == NULL) continue;
+
+    for (unsigned short int side=0; side<max_elem_sides; ++side)
     {
-      unsigned short int side = pos->second.first;
-      std::vector<const Elem*> family;
+      _side_ids(e*max_elem_sides + side, bd_ids);
+      for (unsigned int k=0; k<bd_ids.size(); ++k)
+      {
+        if (elem->active() )
+        {
+          boundary_elem_side_map[bd_ids[k]].push_back(std::make_pair(elem, side));
+        }
+        // this element has child
+        else
+        {
+          std::vector<const Elem*> family;
 
-      elem->active_family_tree_by_side(family, side);
+          elem->active_family_tree_by_side(family, side);
 
-      for(unsigned int n=0; n<family.size(); ++n)
-      {
-        boundary_elem_side_map[pos->second.second].push_back(std::make_pair(pos->first, pos->second.first));
+          for(unsigned int n=0; n<family.size(); ++n)
+          {
+            boundary_elem_side_map[bd_ids[k]].push_back(std::make_pair(elem, side));
+          }
+        }
       }
     }
   }
@@ -861,25 +985,31 @@ void BoundaryInfo::get_subdomains_bd_on( std::map<short int,  std::pair<unsigned
   for(; bit != _boundary_ids.end(); ++bit)
     boundary_sub_ids.insert( std::make_pair(*bit,std::set< unsigned int >()) );
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+  std::vector<short int> bd_ids;
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    short int boundary_id = pos->second.second;
+    const Elem * elem = _boundary_elem[e];
+    if(elem == NULL || !elem->on_processor()) continue;
 
-    const Elem * elem = pos->first;
-    if(!elem->on_processor()) continue;
+    for (unsigned short int side=0; side<max_elem_sides; ++side)
+    {
+      _side_ids(e*max_elem_sides + side, bd_ids);
+      for (unsigned int k=0; k<bd_ids.size(); ++k)
+      {
+        short int boundary_id = bd_ids[k];
 
-    boundary_sub_ids[boundary_id].insert( elem->subdomain_id() );
+        boundary_sub_ids[boundary_id].insert( elem->subdomain_id() );
 
-    // get the side
-    unsigned short int side = pos->second.first;
-    const Elem * neighbor_elem = elem->neighbor(side);
-    if( neighbor_elem == NULL )
-      boundary_sub_ids[boundary_id].insert( invalid_uint );
-    else
-    {
-      assert(neighbor_elem->on_local());
-      boundary_sub_ids[boundary_id].insert( neighbor_elem->subdomain_id() );
+        // get the side
+        const Elem * neighbor_elem = elem->neighbor(side);
+        if( neighbor_elem == NULL )
+          boundary_sub_ids[boundary_id].insert( invalid_uint );
+        else
+        {
+          assert(neighbor_elem->on_local());
+          boundary_sub_ids[boundary_id].insert( neighbor_elem->subdomain_id() );
+        }
+      }
     }
   }
 
@@ -918,17 +1048,20 @@ void BoundaryInfo::get_boundary_ids_by_subdomain (unsigned int subdomain, std::s
   {
     bd_ids.clear();
 
-    std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-
-    for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+    std::vector<short int> side_ids;
+    for (unsigned int e=0; e<_boundary_elem.size(); ++e)
     {
-
-      const Elem * elem = pos->first;
+      const Elem * elem = _boundary_elem[e];
+      if( elem == NULL ) continue;
 
       if( elem->subdomain_id() != subdomain) continue;
 
       // only process element at this subdomain
-      bd_ids.insert(pos->second.second);
+      for (unsigned int s=0; s<max_elem_sides; ++s)
+      {
+        _side_ids(e*max_elem_sides + s, side_ids);
+        bd_ids.insert(side_ids.begin(), side_ids.end());
+      }
     }
 
     Parallel::allgather(bd_ids);
@@ -941,18 +1074,23 @@ void BoundaryInfo::get_subdomain_neighbors( unsigned int subdomain, std::vector<
 {
   std::set<unsigned int> neighbor_subdomains_set;
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    const Elem * elem = pos->first;
+    const Elem * elem = _boundary_elem[e];
+    if( elem == NULL ) continue;
     if( !elem->on_processor() ) continue;
 
     if( elem->subdomain_id() != subdomain) continue;
 
     // only process element at this subdomain
-    const Elem * neighbor_elem = elem->neighbor(pos->second.first);
-    if( neighbor_elem )
-      neighbor_subdomains_set.insert(neighbor_elem->subdomain_id());
+    for (unsigned int s=0; s<max_elem_sides; ++s)
+    {
+      if( _boundary_side_id[e*max_elem_sides + s] == invalid_id ) continue;
+
+      const Elem * neighbor_elem = elem->neighbor(s);
+      if( neighbor_elem )
+        neighbor_subdomains_set.insert(neighbor_elem->subdomain_id());
+    }
   }
 
   Parallel::allgather(neighbor_subdomains_set);
@@ -971,17 +1109,24 @@ void BoundaryInfo::get_subdomain_neighbors( unsigned int subdomain, std::vector<
 std::set<short int> BoundaryInfo::get_ids_on_region_interface(unsigned int sub1, unsigned int sub2) const
 {
   std::set<short int> bds;
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+  std::vector<short int> bd_ids;
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-    const Elem * elem = pos->first;
+    const Elem * elem = _boundary_elem[e];
+    if( elem == NULL ) continue;
     if( !elem->on_processor() ) continue;
     if( elem->subdomain_id() != sub1) continue; // only consider elem on subdomain 1
 
+    for (unsigned int s=0; s<max_elem_sides; ++s)
+    {
+      _side_ids(e*max_elem_sides + s, bd_ids);
+      if( bd_ids.empty() ) continue;
+
       // if my neighbor on subdomain 2, record it
-    const Elem * neighbor_elem = elem->neighbor(pos->second.first);
-    if(!neighbor_elem) continue;
-    if( neighbor_elem->subdomain_id() == sub2) bds.insert(pos->second.second);
+      const Elem * neighbor_elem = elem->neighbor(s);
+      if(!neighbor_elem) continue;
+      if( neighbor_elem->subdomain_id() == sub2) bds.insert(bd_ids.begin(), bd_ids.end());
+    }
   }
   Parallel::allgather(bds);
   return bds;
@@ -1011,16 +1156,17 @@ void BoundaryInfo::find_neighbors()
   // A map from side keys to corresponding elements & side numbers
   map_type side_to_elem_map;
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::iterator el = _boundary_side_id.begin();
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::iterator el_end = _boundary_side_id.end();
-  for (; el != el_end; ++el)
+  for (unsigned int e=0; e<_boundary_elem.size(); ++e)
   {
-  next_side:
+    if (_boundary_elem[e] == NULL) continue;
 
-    Elem * element    = const_cast<Elem *>(el->first);
-    unsigned int side = el->second.first;
-    if (element->neighbor(side) == NULL)
+    Elem * element    = const_cast<Elem *>(_boundary_elem[e]);
+
+    for (unsigned int side=0; side<max_elem_sides; ++side)
     {
+      if (_boundary_side_id[e*max_elem_sides + side] == invalid_id) continue;
+      if (element->neighbor(side) != NULL) continue;
+
       // Get the key for the side of this element
       const unsigned int key = element->key(side);
 
@@ -1028,6 +1174,8 @@ void BoundaryInfo::find_neighbors()
       std::pair <map_type::iterator, map_type::iterator>
       bounds = side_to_elem_map.equal_range(key);
 
+      bool found = false;
+
       // May be multiple keys, check all the possible
       // elements which _might_ be neighbors.
       if (bounds.first != bounds.second)
@@ -1047,20 +1195,22 @@ void BoundaryInfo::find_neighbors()
           //assert (my_side.get() != NULL);
           //assert (their_side.get() != NULL);
 
-          // If found a match wbounds.firsth my side
+          // If found a match with my side
           if( *my_side == *their_side )
           {
             element->set_neighbor (side, neighbor);
             neighbor->set_neighbor(ns, element);
             side_to_elem_map.erase (bounds.first);
-            // get out of this nested crap
-            goto next_side;
+            found = true;
+            break;
           }
 
           ++bounds.first;
         }
       }
 
+      if (found) continue;
+
       // didn't find a match...
       // Build the map entry for this element
       key_val_pair kvp;
@@ -1081,47 +1231,42 @@ void BoundaryInfo::find_neighbors()
 void BoundaryInfo::print_info() const
 {
   // Print out the nodal BCs
-  if (!_boundary_node_id.empty())
+  if (_n_boundary_nodes)
   {
     std::cout << "Nodal Boundary conditions:" << std::endl
     << "--------------------------" << std::endl
     << "  (Node No., ID)               " << std::endl;
 
-    //       std::for_each(_boundary_node_id.begin(),
-    //          _boundary_node_id.end(),
-    //          PrintNodeInfo());
-
-    std::map<const Node*, short int>::const_iterator it        = _boundary_node_id.begin();
-    const std::map<const Node*, short int>::const_iterator end = _boundary_node_id.end();
-
-    for (; it != end; ++it)
-      std::cout << "  (" << (*it).first->id()
-      << ", "  << (*it).second
-      << ")"  << std::endl;
+    for (unsigned int n=0; n<_boundary_node.size(); ++n)
+      if (_boundary_node[n] != NULL)
+        std::cout << "  (" << _boundary_node[n]->id()
+        << ", "  << _boundary_node_id[n]
+        << ")"  << std::endl;
   }
 
   // Print out the element BCs
-  if (!_boundary_side_id.empty())
+  if (_n_boundary_sides)
   {
     std::cout << std::endl
     << "Side Boundary conditions:" << std::endl
     << "-------------------------" << std::endl
     << "  (Elem No., Side No., ID)      " << std::endl;
 
-    //       std::for_each(_boundary_side_id.begin(),
-    //          _boundary_side_id.end(),
-    //              PrintSideInfo());
-
-    std::multimap<const Elem*,
-    std::pair<unsigned short int, short int> >::const_iterator it = _boundary_side_id.begin();
-    const std::multimap<const Elem*,
-    std::pair<unsigned short int, short int> >::const_iterator end = _boundary_side_id.end();
+    std::vector<short int> bd_ids;
+    for (unsigned int e=0; e<_boundary_elem.size(); ++e)
+    {
+      if (_boundary_elem[e] == NULL) continue;
 
-    for (; it != end; ++it)
-      std::cout << "  (" << (*it).first->id()
-      << ", "  << (*it).second.first
-      << ", "  << (*it).second.second
-      << ")"   << std::endl;
+      for (unsigned int s=0; s<max_elem_sides; ++s)
+      {
+        _side_ids(e*max_elem_sides + s, bd_ids);
+        for (unsigned int k=0; k<bd_ids.size(); ++k)
+          std::cout << "  (" << _boundary_elem[e]->id()
+          << ", "  << s
+          << ", "  << bd_ids[k]
+          << ")"   << std::endl;
+      }
+    }
   }
 
 
@@ -380,7 +380,7 @@ void MeshBase::clear_point_locator ()
 SurfaceLocatorHub & MeshBase::surface_locator () const
 {
   if (_surface_locator.get() == NULL)
-    _surface_locator.reset (new SurfaceLocatorHub(*this, SurfaceLocator_SPHERE));
+    _surface_locator.reset (new SurfaceLocatorHub(*this, SurfaceLocator_BVH));
 
   return *_surface_locator;
 }
@@ -412,6 +412,9 @@ bool SerialMesh::reorder_elems(std::string &err)
     std::sort( _nodes.begin(), _nodes.end(), less );
   }
 
+  // boundary info is indexed by node/elem id
+  this->boundary_info->reindex();
+
   return true;
 }
 
@@ -484,6 +487,9 @@ bool SerialMesh::reorder_nodes(std::string &err)
   DofObject::Less less;
   std::sort( _nodes.begin(), _nodes.end(), less );
 
+  // boundary info is indexed by node id
+  this->boundary_info->reindex();
+
   return true;
 
 }
@@ -696,6 +702,10 @@ void SerialMesh::renumber_nodes_and_elements ()
     _elements.erase (out, end);
   }
 
+  // boundary info is indexed by node/elem id, re-key it before
+  // the unused nodes below are removed from it
+  this->boundary_info->reindex();
+
   // Any nodes in the vector >= _nodes[next_free_node]
   // are not connected to any elements and may be deleted
   // if desired.
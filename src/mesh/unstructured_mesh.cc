@@ -526,13 +526,18 @@ void UnstructuredMesh::all_first_order ()
      */
     assert (lo_elem->n_sides() == so_elem->n_sides());
 
+    std::vector<short int> boundary_ids(so_elem->n_sides());
     for (unsigned int s=0; s<so_elem->n_sides(); s++)
-    {
-      const short int boundary_id =
-        this->boundary_info->boundary_id (so_elem, s);
+      boundary_ids[s] = this->boundary_info->boundary_id (so_elem, s);
+
+    // boundary info is indexed by elem id, lo_elem takes the id
+    // of so_elem before its sides are added
+    lo_elem->set_id(so_elem->id());
 
-      if (boundary_id != this->boundary_info->invalid_id)
-        this->boundary_info->add_side (lo_elem, s, boundary_id);
+    for (unsigned int s=0; s<so_elem->n_sides(); s++)
+    {
+      if (boundary_ids[s] != this->boundary_info->invalid_id)
+        this->boundary_info->add_side (lo_elem, s, boundary_ids[s]);
     }
 
     /*
@@ -540,7 +545,6 @@ void UnstructuredMesh::all_first_order ()
      * Inserting it into the mesh will replace and delete
      * the second-order element.
      */
-    lo_elem->set_id(so_elem->id());
     this->insert_elem(lo_elem);
   }
 
@@ -650,13 +654,20 @@ bool UnstructuredMesh::convert_to_fvm_mesh (std::string &error)
 
     if( this->boundary_info->is_boundary_elem(fem_elem) )
     {
+      // only search fem_elem itself in the boundary_info structure,
+      // send false to function boundary_id() avoid search the top parent of fem_elem in the boundary_info structure!
+      std::vector<short int> boundary_ids(fem_elem->n_sides());
+      for (unsigned int s=0; s<fem_elem->n_sides(); s++)
+        boundary_ids[s] = this->boundary_info->boundary_id (fem_elem, s, false);
+
+      // boundary info is indexed by elem id, fvm_elem takes the id
+      // of fem_elem before its sides are added
+      fvm_elem->set_id(fem_elem->id());
+
       for (unsigned int s=0; s<fem_elem->n_sides(); s++)
       {
-        // only search fem_elem itself in the boundary_info structure,
-        // send false to function boundary_id() avoid search the top parent of fem_elem in the boundary_info structure!
-        const short int boundary_id = this->boundary_info->boundary_id (fem_elem, s, false);
-        if (boundary_id != BoundaryInfo::invalid_id)
-          this->boundary_info->add_side ( fvm_elem, s, boundary_id );
+        if (boundary_ids[s] != BoundaryInfo::invalid_id)
+          this->boundary_info->add_side ( fvm_elem, s, boundary_ids[s] );
       }
     }
 
@@ -799,13 +810,20 @@ bool UnstructuredMesh::convert_to_cylindrical_fvm_mesh (std::string &error)
 
     if( this->boundary_info->is_boundary_elem(fem_elem) )
     {
+      // only search fem_elem itself in the boundary_info structure,
+      // send false to function boundary_id() avoid search the top parent of fem_elem in the boundary_info structure!
+      std::vector<short int> boundary_ids(fem_elem->n_sides());
+      for (unsigned int s=0; s<fem_elem->n_sides(); s++)
+        boundary_ids[s] = this->boundary_info->boundary_id (fem_elem, s, false);
+
+      // boundary info is indexed by elem id, fvm_elem takes the id
+      // of fem_elem before its sides are added
+      fvm_elem->set_id(fem_elem->id());
+
       for (unsigned int s=0; s<fem_elem->n_sides(); s++)
       {
-        // only search fem_elem itself in the boundary_info structure,
-        // send false to function boundary_id() avoid search the top parent of fem_elem in the boundary_info structure!
-        const short int boundary_id = this->boundary_info->boundary_id (fem_elem, s, false);
-        if (boundary_id != BoundaryInfo::invalid_id)
-          this->boundary_info->add_side ( fvm_elem, s, boundary_id );
+        if (boundary_ids[s] != BoundaryInfo::invalid_id)
+          this->boundary_info->add_side ( fvm_elem, s, boundary_ids[s] );
       }
     }
 
@@ -29,6 +29,7 @@ void QConical::init_2D(const ElemType _type,
   switch (_type)
     {
     case TRI3:
+    case TRI3_FVM:
     case TRI6:
       {
 	this->conical_product_tri(p);
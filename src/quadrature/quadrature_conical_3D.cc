@@ -29,6 +29,7 @@ void QConical::init_3D(const ElemType _type,
   switch (_type)
     {
     case TET4:
+    case TET4_FVM:
     case TET10:
       {
 	this->conical_product_tet(p);
@@ -37,6 +38,7 @@ void QConical::init_3D(const ElemType _type,
       } // end case TET4, TET10
 
     case PYRAMID5:
+    case PYRAMID5_FVM:
       {
 	this->conical_product_pyramid(p);
 	return;
@@ -27,7 +27,7 @@
 void QGauss::init_2D(const ElemType _type,
                      unsigned int p)
 {
-#if LIBMESH_DIM > 1
+#if DIM > 1
   
   //-----------------------------------------------------------------------
   // 2D quadrature rules
@@ -38,6 +38,7 @@ void QGauss::init_2D(const ElemType _type,
       //---------------------------------------------
       // Quadrilateral quadrature rules
     case QUAD4:
+    case QUAD4_FVM:
     case QUAD8:
     case QUAD9:
       {
@@ -66,6 +67,7 @@ void QGauss::init_2D(const ElemType _type,
       //---------------------------------------------
       // Triangle quadrature rules
     case TRI3:
+    case TRI3_FVM:
     case TRI6:
       {
 	switch(_order + 2*p)
@@ -1289,11 +1291,11 @@ void QGauss::init_2D(const ElemType _type,
     default:
       {
 	std::cerr << "Element type not supported!:" << _type << std::endl;
-	libmesh_error();
+	genius_error();
       }
     }
 
-  libmesh_error();
+  genius_error();
 
   return;
 
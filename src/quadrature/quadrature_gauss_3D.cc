@@ -22,12 +22,11 @@
 // Local includes
 #include "quadrature_gauss.h"
 #include "quadrature_conical.h"
-#include "quadrature_gm.h"
 
 void QGauss::init_3D(const ElemType _type,
                      unsigned int p)
 {
-#if LIBMESH_DIM == 3
+#if DIM == 3
   
   //-----------------------------------------------------------------------
   // 3D quadrature rules
@@ -36,6 +35,7 @@ void QGauss::init_3D(const ElemType _type,
       //---------------------------------------------
       // Hex quadrature rules
     case HEX8:
+    case HEX8_FVM:
     case HEX20:
     case HEX27:
       {
@@ -54,6 +54,7 @@ void QGauss::init_3D(const ElemType _type,
       //---------------------------------------------
       // Tetrahedral quadrature rules
     case TET4:
+    case TET4_FVM:
     case TET10:
       {
 	switch(_order + 2*p)
@@ -452,45 +453,24 @@ void QGauss::init_3D(const ElemType _type,
 	      // Note: if !allow_rules_with_negative_weights, fall through to next case.
 	    }
 
-	    // Fall back on Grundmann-Moller or Conical Product rules at high orders.
+	    // Fall back on Conical Product rules at high orders.
+	    // (the Grundmann-Moller rules of libMesh are not shipped with genius)
 	  default:
 	    {
-	      if ((allow_rules_with_negative_weights) && (_order + 2*p < 34))
-		{
-		  // The Grundmann-Moller rules are defined to arbitrary order and
-		  // can have significantly fewer evaluation points than concial product
-		  // rules.  If you allow rules with negative weights, the GM rules
-		  // will be more efficient for degree up to 33 (for degree 34 and
-		  // higher, CP is more efficient!) but may be more susceptible
-		  // to round-off error.  Safest is to disallow rules with negative
-		  // weights, but this decision should be made on a case-by-case basis.
-		  QGrundmann_Moller gm_rule(3, _order);
-		  gm_rule.init(_type, p);
-
-		  // Swap points and weights with the about-to-be destroyed rule.
-		  _points.swap (gm_rule.get_points() );
-		  _weights.swap(gm_rule.get_weights());
-
-		  return;
-		}
-
-	      else
-		{
-		  // The following quadrature rules are generated as
-		  // conical products.  These tend to be non-optimal
-		  // (use too many points, cluster points in certain
-		  // regions of the domain) but they are quite easy to
-		  // automatically generate using a 1D Gauss rule on
-		  // [0,1] and two 1D Jacobi-Gauss rules on [0,1].
-		  QConical conical_rule(3, _order);
-		  conical_rule.init(_type, p);
+	      // The following quadrature rules are generated as
+	      // conical products.  These tend to be non-optimal
+	      // (use too many points, cluster points in certain
+	      // regions of the domain) but they are quite easy to
+	      // automatically generate using a 1D Gauss rule on
+	      // [0,1] and two 1D Jacobi-Gauss rules on [0,1].
+	      QConical conical_rule(3, _order);
+	      conical_rule.init(_type, p);
+
+	      // Swap points and weights with the about-to-be destroyed rule.
+	      _points.swap (conical_rule.get_points() );
+	      _weights.swap(conical_rule.get_weights());
 
-		  // Swap points and weights with the about-to-be destroyed rule.
-		  _points.swap (conical_rule.get_points() );
-		  _weights.swap(conical_rule.get_weights());
-		  
-		  return;
-		}
+	      return;
 	    }
 	  }
       } // end case TET4,TET10
@@ -500,6 +480,7 @@ void QGauss::init_3D(const ElemType _type,
       //---------------------------------------------
       // Prism quadrature rules
     case PRISM6:
+    case PRISM6_FVM:
     case PRISM15:
     case PRISM18:
       {
@@ -524,6 +505,7 @@ void QGauss::init_3D(const ElemType _type,
       //---------------------------------------------
       // Pyramid
     case PYRAMID5:
+    case PYRAMID5_FVM:
       {
 	// We compute the Pyramid rule as a conical product of a
 	// Jacobi rule with alpha==2 on the interval [0,1] two 1D
@@ -548,11 +530,11 @@ void QGauss::init_3D(const ElemType _type,
     default:
       {
 	std::cerr << "ERROR: Unsupported type: " << _type << std::endl;
-	libmesh_error();
+	genius_error();
       }
     }
 
-  libmesh_error();
+  genius_error();
 
   return;
   
@@ -21,6 +21,12 @@
 
 //  $Id: control.cc,v 1.54 2008/07/09 12:56:23 gdiso Exp $
 
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cstdlib>
+#include <cmath>
+
 #include "genius_common.h"
 
 #ifdef WINDOWS
@@ -52,6 +58,7 @@
 #include "boundary_info.h"
 #include "electrical_source.h"
 #include "field_source.h"
+#include "solution_checkpoint.h"
 #include "enum_solution.h"
 #include "spice_ckt.h"
 
@@ -137,7 +144,7 @@ using PhysicalUnit::rad;
 
 //------------------------------------------------------------------------------
 SolverControl::SolverControl()
-    : _decks(NULL), _mesh(NULL), _system(NULL)
+    : _decks(NULL), _mesh(NULL), _system(NULL), _suspended_solver(NULL)
 {
   _dom_solution = mxmlNewXML("1.0");
   mxmlNewElement(_dom_solution, "genius-solutions");
@@ -145,6 +152,7 @@ SolverControl::SolverControl()
 
 SolverControl::~SolverControl()
 {
+  release_suspended_solver();
   mxmlDelete(_dom_solution);
   _dom_solution=NULL;
 }
@@ -176,11 +184,97 @@ void SolverControl::setDecks(Parser::InputParser *input)
   _decks = input;
 }
 
+/*------------------------------------------------------------------
+ * cards run again for each batch variant. the others build the mesh and
+ * simulation system, which is done once by the first variant
+ */
+static bool is_batch_variable_card(const std::string &card)
+{
+  return card == "MODEL" || card == "METHOD" || card == "HOOK" || card == "SOLVE" ||
+         card == "EXPORT" || card == "NODESET" || card == "REGIONSET" || card == "BOUNDARYSET" ||
+         card == "PMI" || card == "TID" || card == "SOURCEAPPLY" || card == "ATTACH";
+}
+
+
+int SolverControl::setBatchFile(const std::string &fname)
+{
+  // read batch file on processor 0 and broadcast
+  std::string content;
+  if (Genius::processor_id() == 0)
+  {
+    std::ifstream in(fname.c_str());
+    if( !in.good() )
+    {
+      MESSAGE<<"ERROR: I can't read batch file " << fname << "." << std::endl; RECORD();
+      genius_error();
+    }
+    std::stringstream ss;
+    ss << in.rdbuf();
+    content = ss.str();
+  }
+  Parallel::broadcast(content);
+
+  _batch_variants.clear();
+
+  std::stringstream lines(content);
+  std::string line;
+  unsigned int line_number = 0;
+  while( std::getline(lines, line) )
+  {
+    line_number++;
+
+    // skip comments
+    std::string::size_type comment = line.find('#');
+    if( comment != std::string::npos ) line.erase(comment);
+
+    std::stringstream tokens(line);
+    BatchVariant variant;
+    if( !(tokens >> variant.name) ) continue;
+
+    std::string sub;
+    while( tokens >> sub )
+    {
+      // CARD:parameter=value
+      std::string::size_type colon = sub.find(':');
+      std::string::size_type equal = sub.find('=');
+      if( colon == std::string::npos || equal == std::string::npos || equal < colon )
+      {
+        MESSAGE<<"ERROR at " << fname << ":" << line_number << " batch substitution " << sub
+               << " should be CARD:parameter=value." << std::endl; RECORD();
+        genius_error();
+      }
+
+      std::string card = sub.substr(0, colon);
+      std::string parameter = sub.substr(colon+1, equal-colon-1);
+      for(unsigned int c=0; c<card.size(); ++c) card[c] = toupper(card[c]);
+      for(unsigned int c=0; c<parameter.size(); ++c) parameter[c] = tolower(parameter[c]);
+
+      if( !is_batch_variable_card(card) )
+      {
+        MESSAGE<<"ERROR at " << fname << ":" << line_number << " batch substitution " << sub
+               << ": " << card << " card builds the simulation system, which is shared by all the variants." << std::endl; RECORD();
+        genius_error();
+      }
+
+      variant.cards.push_back(card);
+      variant.parameters.push_back(parameter);
+      variant.values.push_back(sub.substr(equal+1));
+    }
+    _batch_variants.push_back(variant);
+  }
+
+  MESSAGE<<"Batch file " << fname << " defines " << _batch_variants.size() << " variant(s).\n"; RECORD();
+
+  return 0;
+}
+
+
 int SolverControl::reset_simulation_system()
 {
   if (_decks == NULL)
     return 0;
 
+  release_suspended_solver();
   _mesh = AutoPtr<Mesh>(new Mesh(3));
   _system = AutoPtr<SimulationSystem>(new SimulationSystem(mesh(), decks()));
   return 0;
@@ -195,6 +289,10 @@ int SolverControl::mainloop()
   if (_mesh.get() == NULL || _system.get() == NULL)
     reset_simulation_system();
 
+  // run each batch variant in this process
+  if ( !_batch_variants.empty() )
+    return batch_loop();
+
   // first, we should see if mesh generation card exist
   if ( decks().is_card_exist("MESH") )
   {
@@ -209,11 +307,29 @@ int SolverControl::mainloop()
   // if not, user should use IMPORT command to get an (previous) system into memory.
 
   // we can begin the main loop here
+  run_decks(true);
+
+  return 0;
+}
+
+
+//------------------------------------------------------------------------------
+void SolverControl::run_decks(bool build_system)
+{
   for( decks().begin(); !decks().end(); decks().next() )
   {
 
     Parser::Card c = decks().get_current_card();
 
+    // these cards change the mesh or the equations of the simulation system,
+    // the solver kept by last SOLVE card is no longer valid
+    if( c.key() == "MODEL" || c.key() == "PMI" || c.key() == "TID" ||
+        c.key() == "REGIONSET" || c.key() == "BOUNDARYSET" ||
+        ( build_system && ( c.key() == "IMPORT" || c.key() == "EXTEND" || c.key() == "ROTATE" ||
+                            c.key() == "REFINE.CONFORM" || c.key() == "REFINE.HIERARCHICAL" ||
+                            c.key() == "REFINE.UNIFORM" ) ) )
+      release_suspended_solver();
+
     if(c.key() == "MODEL")
       this->set_model ( c );
 
@@ -229,19 +345,19 @@ int SolverControl::mainloop()
     if(c.key() == "EXPORT")
       this->do_export( c );
 
-    if(c.key() == "IMPORT")
+    if(c.key() == "IMPORT" && build_system)
       this->do_import( c );
 
     if(c.key() == "NODESET")
       this->set_initial_node_voltage( c );
 
-    if(c.key() == "REFINE.CONFORM")
+    if(c.key() == "REFINE.CONFORM" && build_system)
       this->do_refine_conform( c );
 
-    if(c.key() == "REFINE.HIERARCHICAL")
+    if(c.key() == "REFINE.HIERARCHICAL" && build_system)
       this->do_refine_hierarchical( c );
 
-    if(c.key() == "REFINE.UNIFORM")
+    if(c.key() == "REFINE.UNIFORM" && build_system)
       this->do_refine_uniform( c );
 
     if(c.key() == "REGIONSET")
@@ -262,16 +378,236 @@ int SolverControl::mainloop()
     if(c.key() == "ATTACH")
       this->set_electrode_source ( c );
 
-    if(c.key() == "EXTEND")
+    if(c.key() == "EXTEND" && build_system)
       this->extend_to_3d( c );
 
-    if(c.key() == "ROTATE")
+    if(c.key() == "ROTATE" && build_system)
       this->rotate_to_3d( c );
 
-    if(c.key() == "PLOTMESH")
+    if(c.key() == "PLOTMESH" && build_system)
       this->plot_mesh( c );
   }
 
+  release_suspended_solver();
+}
+
+
+void SolverControl::release_suspended_solver()
+{
+  if( !_suspended_solver ) return;
+
+  _suspended_solver->destroy_solver();
+  delete _suspended_solver;
+  _suspended_solver = NULL;
+}
+
+
+/*------------------------------------------------------------------
+ * set the value of parameter from string, keep the type of parameter
+ */
+static bool set_parameter_value(Parser::Parameter &p, const std::string &value)
+{
+  // array parameter can not be substituted
+  if( p.array_size() > 1 ) return false;
+
+  std::string lower_value(value);
+  for(unsigned int c=0; c<lower_value.size(); ++c) lower_value[c] = tolower(lower_value[c]);
+
+  char * end;
+  switch( p.type() )
+  {
+    case Parser::BOOL    :
+    {
+      if( lower_value == "true"  || lower_value == "on"  || lower_value == "1" ) { p.set_bool(true);  return true; }
+      if( lower_value == "false" || lower_value == "off" || lower_value == "0" ) { p.set_bool(false); return true; }
+      return false;
+    }
+    case Parser::INTEGER :
+    {
+      long v = strtol(value.c_str(), &end, 10);
+      if( *end ) return false;
+      p.set_int(static_cast<int>(v));
+      return true;
+    }
+    case Parser::REAL    :
+    {
+      double v = strtod(value.c_str(), &end);
+      if( *end ) return false;
+      p.set_real(v);
+      return true;
+    }
+    case Parser::STRING  : p.set_string(value); return true;
+    case Parser::ENUM    : return p.set_enum(lower_value) == 0;
+    default: return false;
+  }
+}
+
+
+void SolverControl::apply_batch_variant(const BatchVariant &variant, std::vector<std::pair<unsigned int, Parser::Card> > &backup)
+{
+  backup.clear();
+
+  std::vector<unsigned int> n_applied(variant.cards.size(), 0);
+
+  unsigned int card_index = 0;
+  for( decks().begin(); !decks().end(); decks().next(), ++card_index )
+  {
+    Parser::Card & c = decks().get_current_card();
+
+    bool changed = false;
+    for(unsigned int n=0; n<variant.cards.size(); ++n)
+    {
+      if( c.key() != variant.cards[n] ) continue;
+
+      for(unsigned int i=0; i<c.parameter_size(); ++i)
+      {
+        Parser::Parameter p = c.get_parameter(i);
+        if( p.name() != variant.parameters[n] ) continue;
+
+        if( !changed )
+          backup.push_back(std::make_pair(card_index, c));
+
+        if( !set_parameter_value(p, variant.values[n]) )
+        {
+          MESSAGE<<"ERROR at " << c.get_fileline() << " batch variant " << variant.name << ": invalid value "
+                 << variant.values[n] << " for parameter " << variant.parameters[n] << "." << std::endl; RECORD();
+          genius_error();
+        }
+        c.set_parameter(p, i);
+        changed = true;
+        n_applied[n]++;
+      }
+    }
+
+    if( changed )
+      c.rebuild_parameter_map();
+  }
+
+  for(unsigned int n=0; n<variant.cards.size(); ++n)
+    if( !n_applied[n] )
+    {
+      MESSAGE<<"Warning: batch variant " << variant.name << ": no parameter " << variant.parameters[n]
+             << " in " << variant.cards[n] << " card, substitution ignored." << std::endl; RECORD();
+    }
+}
+
+
+void SolverControl::restore_batch_variant(const std::vector<std::pair<unsigned int, Parser::Card> > &backup)
+{
+  unsigned int card_index = 0;
+  unsigned int b = 0;
+  for( decks().begin(); !decks().end(); decks().next(), ++card_index )
+  {
+    if( b < backup.size() && backup[b].first == card_index )
+      decks().get_current_card() = backup[b++].second;
+  }
+}
+
+
+double SolverControl::batch_variant_distance(const BatchVariant &a, const BatchVariant &b)
+{
+  double distance = 0.0;
+
+  // substitutions only in a, or with different value in b
+  for(unsigned int n=0; n<a.cards.size(); ++n)
+  {
+    double d = 1.0;
+    for(unsigned int m=0; m<b.cards.size(); ++m)
+    {
+      if( a.cards[n] != b.cards[m] || a.parameters[n] != b.parameters[m] ) continue;
+
+      // relative difference for numerical value
+      char * end_a, * end_b;
+      double va = strtod(a.values[n].c_str(), &end_a);
+      double vb = strtod(b.values[m].c_str(), &end_b);
+      if( !*end_a && !*end_b )
+        d = std::abs(va - vb)/std::max(std::max(std::abs(va), std::abs(vb)), 1e-30);
+      else
+        d = (a.values[n] == b.values[m]) ? 0.0 : 1.0;
+      break;
+    }
+    distance += d;
+  }
+
+  // substitutions only in b
+  for(unsigned int m=0; m<b.cards.size(); ++m)
+  {
+    bool find = false;
+    for(unsigned int n=0; n<a.cards.size(); ++n)
+      if( a.cards[n] == b.cards[m] && a.parameters[n] == b.parameters[m] ) { find = true; break; }
+    if( !find ) distance += 1.0;
+  }
+
+  return distance;
+}
+
+
+int SolverControl::batch_loop()
+{
+  // solution state of finished variants, only the ones nearest to the last variant are kept
+  const unsigned int max_snapshots = 4;
+  std::map<unsigned int, SolutionCheckpoint> snapshots;
+
+  for(unsigned int v=0; v<_batch_variants.size(); ++v)
+  {
+    const BatchVariant & variant = _batch_variants[v];
+
+    MESSAGE<<"\n--------------------------------------------------------------------------------\n"
+           <<"Batch variant " << v+1 << "/" << _batch_variants.size() << ": " << variant.name << "\n"
+           <<"--------------------------------------------------------------------------------\n\n"; RECORD();
+
+    std::vector<std::pair<unsigned int, Parser::Card> > backup;
+    apply_batch_variant(variant, backup);
+
+    if( v == 0 )
+    {
+      // the first variant builds mesh and simulation system, which are kept for all the others
+      if ( decks().is_card_exist("MESH") )
+      {
+        this->do_mesh();
+        this->do_process();
+      }
+      run_decks(true);
+    }
+    else
+    {
+      // warm start from the nearest kept variant, node data, boundary and external circuit state are restored
+      std::map<unsigned int, SolutionCheckpoint>::const_iterator nearest = snapshots.begin();
+      double min_distance = batch_variant_distance(variant, _batch_variants[nearest->first]);
+      std::map<unsigned int, SolutionCheckpoint>::const_iterator it = snapshots.begin();
+      for(++it; it!=snapshots.end(); ++it)
+      {
+        double distance = batch_variant_distance(variant, _batch_variants[it->first]);
+        if( distance < min_distance ) { min_distance = distance; nearest = it; }
+      }
+
+      if( nearest->second.restore(system()) )
+      {
+        MESSAGE<<"Warm start from batch variant " << _batch_variants[nearest->first].name << ".\n\n"; RECORD();
+      }
+
+      run_decks(false);
+    }
+
+    restore_batch_variant(backup);
+
+    snapshots[v].save(system());
+
+    // drop the snapshot farthest from this variant, the next variants are most likely close to it
+    if( snapshots.size() > max_snapshots )
+    {
+      std::map<unsigned int, SolutionCheckpoint>::iterator farthest = snapshots.begin();
+      double max_distance = -1.0;
+      for(std::map<unsigned int, SolutionCheckpoint>::iterator it=snapshots.begin(); it!=snapshots.end(); ++it)
+      {
+        if( it->first == v ) continue;
+        double distance = batch_variant_distance(variant, _batch_variants[it->first]);
+        if( distance > max_distance ) { max_distance = distance; farthest = it; }
+      }
+      snapshots.erase(farthest);
+    }
+  }
+
   return 0;
 }
 
@@ -421,6 +757,11 @@ int SolverControl::set_method ( const Parser::Card & c )
   SolverSpecify::NSLagPCLU                  = c.get_int("pclu.lag", 5);
   // set jacobian lag
   SolverSpecify::NSLagJacobian              = c.get_int("jacobian.lag", 1);
+  // freeze mobility and impact ionization coefficients in the jacobian
+  SolverSpecify::LaggedCoefficient          = c.get_bool("lagged.coeff", false);
+  SolverSpecify::LaggedCoefficientTol       = c.get_real("lagged.coeff.tol", 1e-3);
+  // keep the solver between SOLVE cards
+  SolverSpecify::ReuseSolver                = c.get_bool("reuse.solver", true);
 
   // set Newton damping type
   if(c.is_parameter_exist("damping"))
@@ -1088,6 +1429,10 @@ int SolverControl::do_solve( const Parser::Card & c )
         if(c.is_parameter_exist("tran.histroy"))
           SolverSpecify::tran_histroy   = c.get_bool("tran.histroy", false);
 
+        SolverSpecify::checkpoint_file     = c.get_string("checkpoint.file", "");
+        SolverSpecify::checkpoint_interval = c.get_real("checkpoint.interval", 0.0);
+        SolverSpecify::restart_file        = c.get_string("restart.file", "");
+
         break;
       }
 
@@ -1097,10 +1442,28 @@ int SolverControl::do_solve( const Parser::Card & c )
 
   SolverSpecify::out_prefix = c.get_string("out.prefix", "result");
   SolverSpecify::out_append = c.get_bool("out.append", false);
+  // a restarted transient continues the output files of the interrupted run
+  if( SolverSpecify::Type==SolverSpecify::TRANSIENT && !SolverSpecify::restart_file.empty() )
+    SolverSpecify::out_append = true;
 
   SolverBase * solver = NULL;
 
+  // the solver kept by last SOLVE card can be used again when it has the same type
+  bool reuse = false;
+  if( _suspended_solver )
+  {
+    if( SolverSpecify::ReuseSolver && _suspended_solver->solver_type() == SolverSpecify::Solver )
+    {
+      solver = _suspended_solver;
+      _suspended_solver = NULL;
+      reuse = true;
+    }
+    else
+      release_suspended_solver();
+  }
+
   // call each solver here
+  if( !solver )
   switch (SolverSpecify::Solver)
   {
 #ifdef TCAD_SOLVERS
@@ -1268,9 +1631,22 @@ int SolverControl::do_solve( const Parser::Card & c )
       solver->add_hook(control_hook);
     }
 
-    solver->create_solver();
-    solver->solve();
-    solver->destroy_solver(); // hooks are deleted here
+    if( reuse )
+      solver->resume_solver();
+    else
+      solver->create_solver();
+    if( SolverSpecify::Type == SolverSpecify::TRANSIENT && SolverSpecify::PatG &&
+        system().get_field_source()->n_particle_events() > 1 )
+      solve_particle_ensemble(solver);
+    else
+      solver->solve();
+
+    // keep the solver for next SOLVE card when possible
+    bool suspend = SolverSpecify::ReuseSolver && solver->can_suspend();
+    if( suspend )
+      solver->suspend_solver(); // hooks are deleted here
+    else
+      solver->destroy_solver(); // hooks are deleted here
 
     {
       // if there is a solution in the group, add it to the solution document
@@ -1280,7 +1656,10 @@ int SolverControl::do_solve( const Parser::Card & c )
       }
     }
 
-    delete solver;
+    if( suspend )
+      _suspended_solver = solver;
+    else
+      delete solver;
 
   }
 
@@ -1290,6 +1669,49 @@ int SolverControl::do_solve( const Parser::Card & c )
 
 
 
+int SolverControl::solve_particle_ensemble( SolverBase * solver )
+{
+  FieldSource * field_source = system().get_field_source();
+  const unsigned int n_events = field_source->n_particle_events();
+
+  // the operating point all the events start from
+  SolutionCheckpoint checkpoint;
+  checkpoint.save(system());
+  const bool tran_histroy = SolverSpecify::tran_histroy;
+
+  if( system().get_circuit() )
+  {
+    MESSAGE<<"Warning: SPICE circuit state is not reset between particle events." << std::endl; RECORD();
+  }
+
+  int ierr = 0;
+  for(unsigned int e=0; e<n_events; ++e)
+  {
+    if( e>0 && !checkpoint.restore(system()) )
+    {
+      MESSAGE<<"ERROR: Simulation system changed during particle ensemble, stop at event " << e << "." << std::endl; RECORD();
+      ierr = 1;
+      break;
+    }
+    SolverSpecify::tran_histroy = tran_histroy;
+
+    SolverSpecify::event_label = field_source->particle_event_label(e);
+    MESSAGE<<"Particle ensemble: event " << SolverSpecify::event_label << " (" << e+1 << " of " << n_events << ")\n\n"; RECORD();
+
+    field_source->select_particle_event(e);
+    if( solver->solve() ) ierr = 1;
+  }
+
+  SolverSpecify::event_label.clear();
+
+  // later SOLVE cards see the first event
+  field_source->select_particle_event(0);
+
+  return ierr;
+}
+
+
+
 int  SolverControl::set_electrode_source  ( const Parser::Card & c )
 {
 
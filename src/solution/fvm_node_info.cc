@@ -646,6 +646,55 @@ void FVM_Node::PDE_off_processor_node_pattern(std::vector<std::pair<unsigned int
 
 
 
+void FVM_Node::PDE_node_stencil(std::vector<const FVM_Node *> & stencil, bool elem_based) const
+{
+  stencil.clear();
+
+  // this node and its ghost nodes in other regions
+  std::vector<const FVM_Node *> centers(1, this);
+  if( _ghost_nodes!=NULL )
+    for(fvm_ghost_node_iterator  git = ghost_node_begin(); git!=ghost_node_end(); ++git)
+      if( (*git).first ) centers.push_back( (*git).first );
+
+  for(unsigned int c=0; c<centers.size(); ++c)
+  {
+    const FVM_Node * center = centers[c];
+    stencil.push_back(center);
+
+    //only consider neighbor nodes, link this node by an edge
+    if( elem_based==false )
+    {
+      for(fvm_neighbor_node_iterator it= center->neighbor_node_begin(); it!= center->neighbor_node_end(); ++it)
+        stencil.push_back( (*it).first );
+      continue;
+    }
+
+    // consider all the nodes belongs to neighbor elements and their side neighbors
+    for(fvm_element_iterator element_it = center->elem_begin(); element_it != center->elem_end(); ++element_it)
+    {
+      const Elem * e = (*element_it).first;
+      for(unsigned int v=0; v<e->n_vertices(); v++)
+        stencil.push_back( e->get_fvm_node(v) );
+
+      for(unsigned int n=0; n<e->n_sides(); ++n)
+      {
+        const Elem * neighbor = e->neighbor(n);
+        if( !neighbor ) continue;
+        for(unsigned int v=0; v<neighbor->n_vertices(); v++)
+          stencil.push_back( neighbor->get_fvm_node(v) );
+      }
+    }
+  }
+
+  std::sort(stencil.begin(), stencil.end());
+  stencil.erase(std::unique(stencil.begin(), stencil.end()), stencil.end());
+  // remote element may have no fvm node
+  if( !stencil.empty() && stencil.front()==NULL )
+    stencil.erase(stencil.begin());
+}
+
+
+
 PetscScalar FVM_Node::variable(SolutionVariable var) const
 {
   genius_assert( _node_data );
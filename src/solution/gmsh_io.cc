@@ -22,8 +22,14 @@
 // C++ includes
 #include <fstream>
 #include <set>
+#include <algorithm>
 #include <cstring> // std::memcpy, std::strncmp
 
+#include "config.h"
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
 // Local includes
 //#include "genius_config.h"
 #include "gmsh_io.h"
@@ -33,6 +39,9 @@
 #include "mesh_communication.h"
 #include "simulation_region.h"
 #include "parallel.h"
+#include "mmap_file.h"
+#include "text_scanner.h"
+#include "perf_log.h"
 
 using PhysicalUnit::mm;
 
@@ -316,6 +325,446 @@ namespace
     }
   }
 
+
+
+  /**
+   * element read from file, node tags are stored in a shared array
+   */
+  struct GmshElement
+  {
+    unsigned int type;
+    int          physical;
+    size_t       offset;
+  };
+
+
+  /**
+   * all the nodes and elements read from file
+   */
+  struct GmshData
+  {
+    std::vector<long>         node_tags;
+    std::vector<Real>         node_coords;
+    std::vector<GmshElement>  elements;
+    std::vector<long>         element_nodes;
+
+    /**
+     * physical tag of each (dim, entity tag), gmsh 4 only
+     */
+    std::map<std::pair<int, int>, int> entity_physical;
+  };
+
+
+  /**
+   * translate node tag in file to node index in mesh. tags are dense in most files,
+   * then a vector is used instead of a map.
+   */
+  class NodeTagMap
+  {
+  public:
+    void build(const std::vector<long> & tags)
+    {
+      long max_tag = 0;
+      for(size_t i=0; i<tags.size(); ++i)
+        max_tag = std::max(max_tag, tags[i]);
+
+      _dense = (max_tag < static_cast<long>(4*tags.size() + 1024));
+      if( _dense )
+      {
+        _index.assign(max_tag+1, invalid_uint);
+        for(size_t i=0; i<tags.size(); ++i)
+          _index[tags[i]] = i;
+      }
+      else
+      {
+        for(size_t i=0; i<tags.size(); ++i)
+          _map[tags[i]] = i;
+      }
+    }
+
+    unsigned int operator() (long tag) const
+    {
+      unsigned int index = invalid_uint;
+      if( _dense )
+      {
+        if( tag >= 0 && tag < static_cast<long>(_index.size()) ) index = _index[tag];
+      }
+      else
+      {
+        std::map<long, unsigned int>::const_iterator it = _map.find(tag);
+        if( it != _map.end() ) index = it->second;
+      }
+
+      if( index == invalid_uint )
+      {
+        std::cerr << "Error: node " << tag << " used by element is not defined in msh file\n";
+        genius_error();
+      }
+      return index;
+    }
+
+  private:
+    bool _dense;
+    std::vector<unsigned int>     _index;
+    std::map<long, unsigned int>  _map;
+  };
+
+
+  /**
+   * number of nodes of gmsh element type
+   */
+  unsigned int gmsh_element_nodes(unsigned int type)
+  {
+    std::map<unsigned int, elementDefinition>::const_iterator it = eletypes_imp.find(type);
+    if( it == eletypes_imp.end() )
+    {
+      std::cerr << "Error: unsupported gmsh element type " << type << "\n";
+      genius_error();
+    }
+    return it->second.nnodes;
+  }
+
+
+  void read_error(const char * section)
+  {
+    std::cerr << "Error: bad " << section << " section in msh file\n";
+    genius_error();
+  }
+
+
+  /**
+   * split [b, e) into n chunks at line ends
+   */
+  void split_lines(const char * b, const char * e, unsigned int n, std::vector<const char *> & bounds)
+  {
+    bounds.clear();
+    bounds.push_back(b);
+    for(unsigned int i=1; i<n; ++i)
+    {
+      const char * p = std::max(bounds.back(), b + (e-b)/n*i);
+      p = static_cast<const char *>(std::memchr(p, '\n', e-p));
+      p = p ? p+1 : e;
+      bounds.push_back(p);
+    }
+    bounds.push_back(e);
+  }
+
+
+  unsigned int n_parse_threads(size_t bytes)
+  {
+#ifdef HAVE_OPENMP
+    // not worth for small block
+    if( bytes > (1<<22) ) return omp_get_max_threads();
+#endif
+    return 1;
+  }
+
+
+  /**
+   * "tag x y z" lines of gmsh 1/2 ascii node block, parsed in chunks by threads
+   */
+  void read_nodes_ascii(TextScanner & in, unsigned int n_nodes, GmshData & data)
+  {
+    const char * end = in.find_line("$E");
+
+    std::vector<const char *> bounds;
+    split_lines(in.pos(), end, n_parse_threads(end - in.pos()), bounds);
+    const int n_chunks = bounds.size() - 1;
+
+    std::vector< std::vector<long> > tags(n_chunks);
+    std::vector< std::vector<Real> > coords(n_chunks);
+    std::vector<int> fail(n_chunks, 0);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+    for(int c=0; c<n_chunks; ++c)
+    {
+      TextScanner chunk(bounds[c], bounds[c+1]);
+      tags[c].reserve(n_nodes/n_chunks + 1);
+      coords[c].reserve(3*(n_nodes/n_chunks + 1));
+      long tag;
+      double x, y, z;
+      while( !chunk.eof() )
+      {
+        if( !(chunk.get(tag) && chunk.get(x) && chunk.get(y) && chunk.get(z)) ) { fail[c] = 1; break; }
+        tags[c].push_back(tag);
+        coords[c].push_back(x); coords[c].push_back(y); coords[c].push_back(z);
+      }
+    }
+
+    data.node_tags.reserve(n_nodes);
+    data.node_coords.reserve(3*n_nodes);
+    for(int c=0; c<n_chunks; ++c)
+    {
+      if( fail[c] ) read_error("$Nodes");
+      data.node_tags.insert(data.node_tags.end(), tags[c].begin(), tags[c].end());
+      data.node_coords.insert(data.node_coords.end(), coords[c].begin(), coords[c].end());
+    }
+    if( data.node_tags.size() != n_nodes ) read_error("$Nodes");
+
+    in.set_pos(end);
+  }
+
+
+  /**
+   * gmsh 1/2 ascii element block, parsed in chunks by threads
+   * version 1 : "id type physical elementary nnodes nodes..."
+   * version 2 : "id type ntags tags... nodes..."
+   */
+  void read_elements_ascii(TextScanner & in, unsigned int n_elems, Real version, GmshData & data)
+  {
+    const char * end = in.find_line("$E");
+
+    std::vector<const char *> bounds;
+    split_lines(in.pos(), end, n_parse_threads(end - in.pos()), bounds);
+    const int n_chunks = bounds.size() - 1;
+
+    std::vector< std::vector<GmshElement> > elems(n_chunks);
+    std::vector< std::vector<long> > nodes(n_chunks);
+    std::vector<int> fail(n_chunks, 0);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+    for(int c=0; c<n_chunks; ++c)
+    {
+      TextScanner chunk(bounds[c], bounds[c+1]);
+      elems[c].reserve(n_elems/n_chunks + 1);
+      while( !chunk.eof() )
+      {
+        long id, tag;
+        unsigned int type, ntags, nnodes;
+        GmshElement elem;
+        elem.physical = 1;
+        if( !(chunk.get(id) && chunk.get(type)) ) { fail[c] = 1; break; }
+        if( version <= 1.0 )
+        {
+          long elementary;
+          if( !(chunk.get(tag) && chunk.get(elementary) && chunk.get(nnodes)) ) { fail[c] = 1; break; }
+          elem.physical = tag;
+        }
+        else
+        {
+          if( !chunk.get(ntags) ) { fail[c] = 1; break; }
+          for(unsigned int j=0; j<ntags; ++j)
+          {
+            if( !chunk.get(tag) ) { fail[c] = 1; break; }
+            if( j == 0 ) elem.physical = tag;
+          }
+        }
+        elem.type = type;
+        elem.offset = nodes[c].size();
+        nnodes = gmsh_element_nodes(type);
+        for(unsigned int i=0; i<nnodes; ++i)
+        {
+          long nod;
+          if( !chunk.get(nod) ) { fail[c] = 1; break; }
+          nodes[c].push_back(nod);
+        }
+        if( fail[c] ) break;
+        elems[c].push_back(elem);
+      }
+    }
+
+    data.elements.reserve(n_elems);
+    for(int c=0; c<n_chunks; ++c)
+    {
+      if( fail[c] ) read_error("$Elements");
+      size_t offset = data.element_nodes.size();
+      for(size_t i=0; i<elems[c].size(); ++i)
+      {
+        elems[c][i].offset += offset;
+        data.elements.push_back(elems[c][i]);
+      }
+      data.element_nodes.insert(data.element_nodes.end(), nodes[c].begin(), nodes[c].end());
+    }
+    if( data.elements.size() != n_elems ) read_error("$Elements");
+
+    in.set_pos(end);
+  }
+
+
+  /**
+   * gmsh 2 binary node block, int tag followed by 3 double
+   */
+  void read_nodes_binary_v2(TextScanner & in, unsigned int n_nodes, GmshData & data)
+  {
+    data.node_tags.reserve(n_nodes);
+    data.node_coords.reserve(3*n_nodes);
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      int tag;
+      double x[3];
+      if( !(in.read_binary(tag) && in.read_binary(x)) ) read_error("$Nodes");
+      data.node_tags.push_back(tag);
+      data.node_coords.push_back(x[0]); data.node_coords.push_back(x[1]); data.node_coords.push_back(x[2]);
+    }
+  }
+
+
+  /**
+   * gmsh 2 binary element block, groups of elements with the same type
+   */
+  void read_elements_binary_v2(TextScanner & in, unsigned int n_elems, GmshData & data)
+  {
+    data.elements.reserve(n_elems);
+    while( data.elements.size() < n_elems )
+    {
+      int header[3]; // type, number of elements, number of tags
+      if( !in.read_binary(header) ) read_error("$Elements");
+      const unsigned int nnodes = gmsh_element_nodes(header[0]);
+      std::vector<int> buffer(1 + header[2] + nnodes);
+      for(int e=0; e<header[1]; ++e)
+      {
+        if( !in.read_binary_array(&buffer[0], buffer.size()) ) read_error("$Elements");
+        GmshElement elem;
+        elem.type = header[0];
+        elem.physical = header[2] > 0 ? buffer[1] : 1;
+        elem.offset = data.element_nodes.size();
+        data.element_nodes.insert(data.element_nodes.end(), buffer.begin() + 1 + header[2], buffer.end());
+        data.elements.push_back(elem);
+      }
+    }
+  }
+
+
+  /**
+   * read gmsh 4 value, int or size_t in binary file
+   */
+  template <typename T>
+  long read_value_v4(TextScanner & in, bool binary)
+  {
+    if( binary )
+    {
+      T v;
+      if( !in.read_binary(v) ) read_error("gmsh 4");
+      return static_cast<long>(v);
+    }
+    long v;
+    if( !in.get(v) ) read_error("gmsh 4");
+    return v;
+  }
+
+  double read_real_v4(TextScanner & in, bool binary)
+  {
+    double v;
+    if( !(binary ? in.read_binary(v) : in.get(v)) ) read_error("gmsh 4");
+    return v;
+  }
+
+
+  /**
+   * gmsh 4.1 $Entities, we only need the physical tags
+   */
+  void read_entities_v4(TextScanner & in, bool binary, GmshData & data)
+  {
+    long n_entities[4];
+    for(int d=0; d<4; ++d)
+      n_entities[d] = read_value_v4<size_t>(in, binary);
+
+    for(int d=0; d<4; ++d)
+      for(long n=0; n<n_entities[d]; ++n)
+      {
+        int tag = read_value_v4<int>(in, binary);
+        // point has coordinate, others have bounding box
+        for(int i=0; i<(d == 0 ? 3 : 6); ++i)
+          read_real_v4(in, binary);
+
+        long n_physical = read_value_v4<size_t>(in, binary);
+        for(long i=0; i<n_physical; ++i)
+        {
+          int physical = read_value_v4<int>(in, binary);
+          if( i == 0 ) data.entity_physical[std::make_pair(d, tag)] = physical;
+        }
+
+        if( d > 0 )
+        {
+          long n_bounding = read_value_v4<size_t>(in, binary);
+          for(long i=0; i<n_bounding; ++i)
+            read_value_v4<int>(in, binary);
+        }
+      }
+  }
+
+
+  /**
+   * gmsh 4.1 $Nodes, blocks of node tags followed by coordinates
+   */
+  void read_nodes_v4(TextScanner & in, bool binary, GmshData & data)
+  {
+    long n_blocks = read_value_v4<size_t>(in, binary);
+    long n_nodes  = read_value_v4<size_t>(in, binary);
+    read_value_v4<size_t>(in, binary); // min tag
+    read_value_v4<size_t>(in, binary); // max tag
+
+    data.node_tags.reserve(n_nodes);
+    data.node_coords.reserve(3*n_nodes);
+
+    for(long b=0; b<n_blocks; ++b)
+    {
+      int dim = read_value_v4<int>(in, binary);
+      read_value_v4<int>(in, binary); // entity tag
+      int parametric = read_value_v4<int>(in, binary);
+      long n = read_value_v4<size_t>(in, binary);
+
+      for(long i=0; i<n; ++i)
+        data.node_tags.push_back(read_value_v4<size_t>(in, binary));
+
+      for(long i=0; i<n; ++i)
+      {
+        for(int j=0; j<3; ++j)
+          data.node_coords.push_back(read_real_v4(in, binary));
+        // parametric coordinates on the entity, not used
+        if( parametric )
+          for(int j=0; j<dim; ++j)
+            read_real_v4(in, binary);
+      }
+    }
+
+    if( static_cast<long>(data.node_tags.size()) != n_nodes ) read_error("$Nodes");
+  }
+
+
+  /**
+   * gmsh 4.1 $Elements, blocks of elements with the same entity and type
+   */
+  void read_elements_v4(TextScanner & in, bool binary, GmshData & data)
+  {
+    long n_blocks = read_value_v4<size_t>(in, binary);
+    long n_elems  = read_value_v4<size_t>(in, binary);
+    read_value_v4<size_t>(in, binary); // min tag
+    read_value_v4<size_t>(in, binary); // max tag
+
+    data.elements.reserve(n_elems);
+
+    for(long b=0; b<n_blocks; ++b)
+    {
+      int dim  = read_value_v4<int>(in, binary);
+      int tag  = read_value_v4<int>(in, binary);
+      int type = read_value_v4<int>(in, binary);
+      long n   = read_value_v4<size_t>(in, binary);
+
+      GmshElement elem;
+      elem.type = type;
+      elem.physical = 1;
+      std::map<std::pair<int, int>, int>::const_iterator it = data.entity_physical.find(std::make_pair(dim, tag));
+      if( it != data.entity_physical.end() ) elem.physical = it->second;
+
+      const unsigned int nnodes = gmsh_element_nodes(type);
+      for(long e=0; e<n; ++e)
+      {
+        read_value_v4<size_t>(in, binary); // element tag
+        elem.offset = data.element_nodes.size();
+        for(unsigned int i=0; i<nnodes; ++i)
+          data.element_nodes.push_back(read_value_v4<size_t>(in, binary));
+        data.elements.push_back(elem);
+      }
+    }
+
+    if( static_cast<long>(data.elements.size()) != n_elems ) read_error("$Elements");
+  }
+
 } // end anonymous namespace
 
 
@@ -394,12 +843,13 @@ void GmshIO::read_mesh(const std::string& name)
   // broadcast later
   genius_assert(Genius::processor_id() == 0);
 
-  std::ifstream in (name.c_str());
-  if(!in.good())
+  MMapFile file;
+  if(!file.open(name))
   {
     std::cerr << "Open GMSH file " << name << " failed." << "\n";
     genius_error();
   }
+  TextScanner in(file.begin(), file.end());
 
   // initialize the map with element types
   init_eletypes();
@@ -411,292 +861,293 @@ void GmshIO::read_mesh(const std::string& name)
   const unsigned int dim = 3;
 
   // some variables
-  const int  bufLen = 256;
-  char       buf[bufLen+1];
   int        format=0, size=0;
   Real       version = 1.0;
 
-  // map to hold the node numbers for translation
-  // note the the nodes can be non-consecutive
-  std::map<unsigned int, unsigned int> nodetrans;
+  // nodes and elements of the file, the mesh is built after the whole file is parsed
+  GmshData data;
 
   std::map<int, unsigned int> elem_physical_map;
   std::map<int, unsigned int> boundary_physical_map;
 
+  START_LOG("read_mesh()", "GmshIO");
+
+  std::string buf;
+  while (in.get(buf))
   {
-    while (!in.eof())
+    if (buf == "$MeshFormat")
     {
-      in >> buf;
-
-      if (!std::strncmp(buf,"$MeshFormat",11))
+      if( !(in.get(version) && in.get(format) && in.get(size)) ) read_error("$MeshFormat");
+      if ((version != 2.0) && (version != 2.1) && (version != 2.2) && (version != 4.1))
       {
-        in >> version >> format >> size;
-        if ((version != 2.0) && (version != 2.1) && (version != 2.2))
-        {
-          // Some notes on gmsh mesh versions:
-          //
-          // Mesh version 2.0 goes back as far as I know.  It's not explicitly
-          // mentioned here: http://www.geuz.org/gmsh/doc/VERSIONS.txt
-          //
-          // As of gmsh-2.4.0:
-          // bumped mesh version format to 2.1 (small change in the $PhysicalNames
-          // section, where the group dimension is now required);
-          // [Since we don't even parse the PhysicalNames section at the time
-          //  of this writing, I don't think this change affects us.]
-          std::cerr << "Error: Wrong msh file version " << version << "\n";
-          genius_error();
-        }
-        if(format)
+        // Some notes on gmsh mesh versions:
+        //
+        // Mesh version 2.0 goes back as far as I know.  It's not explicitly
+        // mentioned here: http://www.geuz.org/gmsh/doc/VERSIONS.txt
+        //
+        // As of gmsh-2.4.0:
+        // bumped mesh version format to 2.1 (small change in the $PhysicalNames
+        // section, where the group dimension is now required);
+        // [Since we don't even parse the PhysicalNames section at the time
+        //  of this writing, I don't think this change affects us.]
+        //
+        // gmsh 4.0 format is replaced by 4.1 soon, only 4.1 is supported.
+        std::cerr << "Error: Wrong msh file version " << version << "\n";
+        genius_error();
+      }
+      if(format)
+      {
+        // binary file, an integer 1 follows to check the byte order
+        int one = 0;
+        in.skip_line();
+        if( size != 8 || !in.read_binary(one) || one != 1 )
         {
-          std::cerr << "Error: Unknown data format for mesh\n";
+          std::cerr << "Error: Unknown data format or byte order for mesh\n";
           genius_error();
         }
       }
+    }
+
+    else if (buf == "$Entities")
+    {
+      if(format) in.skip_line();
+      read_entities_v4(in, format!=0, data);
+    }
 
-      // read the node block
-      else if (!std::strncmp(buf,"$NOD",4) ||
-               !std::strncmp(buf,"$NOE",4) ||
-               !std::strncmp(buf,"$Nodes",6)
-              )
+    // read the node block
+    else if (buf == "$NOD" || buf == "$NOE" || buf == "$Nodes")
+    {
+      if( version >= 4.0 )
+      {
+        if(format) in.skip_line();
+        read_nodes_v4(in, format!=0, data);
+      }
+      else
       {
         unsigned int numNodes = 0;
-        in >> numNodes;
-        mesh.reserve_nodes (numNodes);
-
-        // read in the nodal coordinates and form points.
-        Real x, y, z;
-        unsigned int id;
-
-        // add the nodal coordinates to the mesh
-        for (unsigned int i=0; i<numNodes; ++i)
+        if( !in.get(numNodes) ) read_error("$Nodes");
+        if(format)
         {
-          in >> id >> x >> y >> z;
-          mesh.add_point (Point(x, y, z)*mm, i);
-          nodetrans[id] = i;
+          in.skip_line();
+          read_nodes_binary_v2(in, numNodes, data);
         }
-        // read the $ENDNOD delimiter
-        in >> buf;
-        
+        else
+          read_nodes_ascii(in, numNodes, data);
       }
+    }
 
-      /**
-       * Read the element block
-       *
-       * If the element dimension is smaller than the mesh dimension, this is a
-       * boundary element and will be added to mesh.boundary_info.
-       *
-       * Because the elements might not yet exist, the sides are put on hold
-       * until the elements are created, and inserted once reading elements is
-       * finished
-       */
-      else if (!std::strncmp(buf,"$ELM",4) ||
-               !std::strncmp(buf,"$Elements",9)
-              )
+    // read the element block
+    else if (buf == "$ELM" || buf == "$Elements")
+    {
+      if( version >= 4.0 )
+      {
+        if(format) in.skip_line();
+        read_elements_v4(in, format!=0, data);
+      }
+      else
       {
         unsigned int numElem = 0;
-        std::vector< boundaryElementInfo > boundary_elem;
-
-        // read how many elements are there, and reserve space in the mesh
-        in >> numElem;
-        mesh.reserve_elem (numElem);
-
-        // read the elements
-        unsigned int elem_id_counter = 0;
-        for (unsigned int iel=0; iel<numElem; ++iel)
+        if( !in.get(numElem) ) read_error("$Elements");
+        if(format)
         {
-          unsigned int id, type, physical=0, elementary=0,
-          /* partition = 1,*/ nnodes, ntags;
-          // note - partition was assigned but never used - BSK
-          if(version <= 1.0)
-          {
-            in >> id >> type >> physical >> elementary >> nnodes;
-          }
-          else
-          {
-            in >> id >> type >> ntags;
-            elementary = physical = /* partition = */ 1;
-            for(unsigned int j = 0; j < ntags; j++)
-            {
-              int tag;
-              in >> tag;
-              if(j == 0)
-                physical = tag;
-              else if(j == 1)
-                elementary = tag;
-              // else if(j == 2)
-              //  partition = tag;
-              // ignore any other tags for now
-            }
-          }
-
-
-          // consult the import element table which element to build
-          const elementDefinition& eletype = eletypes_imp[type];
-          nnodes = eletype.nnodes;
+          in.skip_line();
+          read_elements_binary_v2(in, numElem, data);
+        }
+        else
+          read_elements_ascii(in, numElem, version, data);
+      }
+    }
 
-          // only elements that match the mesh dimension are added
-          // if the element dimension is one less than dim, the nodes and
-          // sides are added to the mesh.boundary_info
-          if (eletype.dim == dim)
-          {
-            // add the elements to the mesh
-            Elem* elem = Elem::build(eletype.type).release();
-            elem->set_id(elem_id_counter);
-            mesh.add_elem(elem);
+    // skip other sections
+    else if (buf[0] == '$' && buf.compare(0, 4, "$End") && buf.compare(0, 4, "$END"))
+    {
+      in.set_pos(in.find_line("$End"));
+      in.skip_line();
+    }
+  }
 
-            // different to iel, lower dimensional elems aren't added
-            elem_id_counter++;
+  STOP_LOG("read_mesh()", "GmshIO");
 
-            // check number of nodes. We cannot do that for version 2.0
-            if (version <= 1.0)
-            {
-              if (elem->n_nodes() != nnodes)
-              {
-                std::cerr << "Number of nodes for element " << id
-                << " of type " << eletypes_imp[type].type
-                << " (Gmsh type " << type
-                << ") does not match Libmesh definition. "
-                << "I expected " << elem->n_nodes()
-                << " nodes, but got " << nnodes << "\n";
-                genius_error();
-              }
-            }
+  // add the nodal coordinates to the mesh
+  {
+    const unsigned int numNodes = data.node_tags.size();
+    mesh.reserve_nodes (numNodes);
+    for (unsigned int i=0; i<numNodes; ++i)
+    {
+      const Real * x = &data.node_coords[3*i];
+      mesh.add_point (Point(x[0], x[1], x[2])*mm, i);
+    }
+  }
 
-            // add node pointers to the elements
-            int nod = 0;
-            // if there is a node translation table, use it
-            if (eletype.nodes.size() > 0)
-              for (unsigned int i=0; i<nnodes; i++)
-              {
-                in >> nod;
-                elem->set_node(eletype.nodes[i]) = mesh.node_ptr(nodetrans[nod]);
-              }
-            else
-            {
-              for (unsigned int i=0; i<nnodes; i++)
-              {
-                in >> nod;
-                elem->set_node(i) = mesh.node_ptr(nodetrans[nod]);
-              }
-            }
+  // map to hold the node numbers for translation
+  // note the the nodes can be non-consecutive
+  NodeTagMap nodetrans;
+  nodetrans.build(data.node_tags);
+  std::vector<long>().swap(data.node_tags);
+  std::vector<Real>().swap(data.node_coords);
 
-            // Finally, set the subdomain ID to physical
-            if(elem_physical_map.find(physical) == elem_physical_map.end())
-              elem_physical_map[physical]=elem_physical_map.size();
-            elem->subdomain_id() = elem_physical_map[physical];
-          } // if element.dim == dim
-          // if this is a boundary
-          else if (eletype.dim == dim-1)
-          {
-            /**
-             * add the boundary element nodes to the set of nodes
-             */
-
-            boundaryElementInfo binfo;
-            std::set<unsigned int>::iterator iter = binfo.nodes.begin();
-            int nod = 0;
-            for (unsigned int i=0; i<nnodes; i++)
-            {
-              in >> nod;
-              mesh.boundary_info->add_node(nodetrans[nod], physical);
-              binfo.nodes.insert(iter, nodetrans[nod]);
-            }
-            if(boundary_physical_map.find(physical) == boundary_physical_map.end())
-              boundary_physical_map[physical]=boundary_physical_map.size();
-            binfo.id = boundary_physical_map[physical];
-            boundary_elem.push_back(binfo);
-          }
-          /**
-           * If the element yet another dimension, just read in the nodes
-           * and throw them away
-           */
-          else
-          {
-            static bool seen_high_dim_element = false;
-            if (!seen_high_dim_element)
-            {
-              std::cerr << "Warning: can't load an element of dimension "
-              << eletype.dim << " into a mesh of dimension "
-              << dim << std::endl;
-              seen_high_dim_element = true;
-            }
-            int nod = 0;
-            for (unsigned int i=0; i<nnodes; i++)
-              in >> nod;
-          }
-        }//element loop
+  /**
+   * build the elements
+   *
+   * If the element dimension is smaller than the mesh dimension, this is a
+   * boundary element and will be added to mesh.boundary_info.
+   *
+   * Because the elements might not yet exist, the sides are put on hold
+   * until the elements are created, and inserted once reading elements is
+   * finished
+   */
+  if (!data.elements.empty())
+  {
+    std::vector< boundaryElementInfo > boundary_elem;
 
+    // reserve space in the mesh for the elements of mesh dimension
+    unsigned int numElem = 0;
+    for (size_t iel=0; iel<data.elements.size(); ++iel)
+      if (eletypes_imp[data.elements[iel].type].dim == dim) numElem++;
+    mesh.reserve_elem (numElem);
 
-        // read the $ENDELM delimiter
-        in >> buf;
+    unsigned int elem_id_counter = 0;
+    for (size_t iel=0; iel<data.elements.size(); ++iel)
+    {
+      const GmshElement & gmsh_elem = data.elements[iel];
+      const long * elem_nodes = &data.element_nodes[gmsh_elem.offset];
+      int physical = gmsh_elem.physical;
+
+      // consult the import element table which element to build
+      const elementDefinition& eletype = eletypes_imp[gmsh_elem.type];
+      unsigned int nnodes = eletype.nnodes;
+
+      // only elements that match the mesh dimension are added
+      // if the element dimension is one less than dim, the nodes and
+      // sides are added to the mesh.boundary_info
+      if (eletype.dim == dim)
+      {
+        // add the elements to the mesh
+        Elem* elem = Elem::build(eletype.type).release();
+        elem->set_id(elem_id_counter);
+        mesh.add_elem(elem);
+
+        // different to iel, lower dimensional elems aren't added
+        elem_id_counter++;
+
+        // add node pointers to the elements
+        // if there is a node translation table, use it
+        if (eletype.nodes.size() > 0)
+          for (unsigned int i=0; i<nnodes; i++)
+            elem->set_node(eletype.nodes[i]) = mesh.node_ptr(nodetrans(elem_nodes[i]));
+        else
+        {
+          for (unsigned int i=0; i<nnodes; i++)
+            elem->set_node(i) = mesh.node_ptr(nodetrans(elem_nodes[i]));
+        }
 
-        
+        // Finally, set the subdomain ID to physical
+        if(elem_physical_map.find(physical) == elem_physical_map.end())
+          elem_physical_map[physical]=elem_physical_map.size();
+        elem->subdomain_id() = elem_physical_map[physical];
+      } // if element.dim == dim
+      // if this is a boundary
+      else if (eletype.dim == dim-1)
+      {
         /**
-         * If any lower dimensional elements have been found in the file,
-         * try to add them to the mesh.boundary_info as sides and nodes with
-         * the respecitve id's (called "physical" in Gmsh).
+         * add the boundary element nodes to the set of nodes
          */
-        if (boundary_elem.size() > 0)
+
+        boundaryElementInfo binfo;
+        std::set<unsigned int>::iterator iter = binfo.nodes.begin();
+        for (unsigned int i=0; i<nnodes; i++)
         {
-          // create a index of the boundary nodes to easily locate which
-          // element might have that boundary
-          std::map<unsigned int, std::vector<unsigned int> > node_index;
-          for (unsigned int i=0; i<boundary_elem.size(); i++)
-          {
-            boundaryElementInfo binfo = boundary_elem[i];
-            std::set<unsigned int>::iterator iter = binfo.nodes.begin();
-            for (;iter!= binfo.nodes.end(); iter++)
-              node_index[*iter].push_back(i);
-          }
+          unsigned int nod = nodetrans(elem_nodes[i]);
+          mesh.boundary_info->add_node(nod, physical);
+          binfo.nodes.insert(iter, nod);
+        }
+        if(boundary_physical_map.find(physical) == boundary_physical_map.end())
+          boundary_physical_map[physical]=boundary_physical_map.size();
+        binfo.id = boundary_physical_map[physical];
+        boundary_elem.push_back(binfo);
+      }
+      /**
+       * If the element yet another dimension, just throw it away
+       */
+      else if (eletype.dim > dim)
+      {
+        static bool seen_high_dim_element = false;
+        if (!seen_high_dim_element)
+        {
+          std::cerr << "Warning: can't load an element of dimension "
+          << eletype.dim << " into a mesh of dimension "
+          << dim << std::endl;
+          seen_high_dim_element = true;
+        }
+      }
+    }//element loop
+
+    std::vector<GmshElement>().swap(data.elements);
+    std::vector<long>().swap(data.element_nodes);
+
+    /**
+     * If any lower dimensional elements have been found in the file,
+     * try to add them to the mesh.boundary_info as sides and nodes with
+     * the respecitve id's (called "physical" in Gmsh).
+     */
+    if (boundary_elem.size() > 0)
+    {
+      // create a index of the boundary nodes to easily locate which
+      // element might have that boundary
+      std::map<unsigned int, std::vector<unsigned int> > node_index;
+      for (unsigned int i=0; i<boundary_elem.size(); i++)
+      {
+        boundaryElementInfo binfo = boundary_elem[i];
+        std::set<unsigned int>::iterator iter = binfo.nodes.begin();
+        for (;iter!= binfo.nodes.end(); iter++)
+          node_index[*iter].push_back(i);
+      }
 
-          MeshBase::const_element_iterator       it  = mesh.active_elements_begin();
-          const MeshBase::const_element_iterator end = mesh.active_elements_end();
+      MeshBase::const_element_iterator       it  = mesh.active_elements_begin();
+      const MeshBase::const_element_iterator end = mesh.active_elements_end();
 
-          // iterate over all elements and see which boundary element has
-          // the same set of nodes as on of the boundary elements previously read
-          for ( ; it != end; ++it)
+      // iterate over all elements and see which boundary element has
+      // the same set of nodes as on of the boundary elements previously read
+      for ( ; it != end; ++it)
+      {
+        const Elem* elem = *it;
+        for (unsigned int s=0; s<elem->n_sides(); s++)
+          if (elem->neighbor(s) == NULL)
           {
-            const Elem* elem = *it;
-            for (unsigned int s=0; s<elem->n_sides(); s++)
-              if (elem->neighbor(s) == NULL)
+            AutoPtr<Elem> side (elem->build_side(s));
+            std::set<unsigned int> side_nodes;
+            std::set<unsigned int>::iterator iter = side_nodes.begin();
+
+            // make a set with all nodes from this side
+            // this allows for easy comparison
+            for (unsigned int ns=0; ns<side->n_nodes(); ns++)
+              side_nodes.insert(iter, side->node(ns));
+
+            // See whether one of the side node occurs in the list
+            // of tagged nodes. If we would loop over all side
+            // nodes, we would just get multiple hits, so taking
+            // node 0 is enough to do the job
+            unsigned int sn = side->node(0);
+            if (node_index.count(sn) > 0)
+            {
+              // Loop over all tagged ("physical") "sides" which
+              // contain the node sn (typically just 1 to
+              // three). For each of these the set of nodes is
+              // compared to the current element's side nodes
+              for (unsigned int n=0; n<node_index[sn].size(); n++)
               {
-                AutoPtr<Elem> side (elem->build_side(s));
-                std::set<unsigned int> side_nodes;
-                std::set<unsigned int>::iterator iter = side_nodes.begin();
-
-                // make a set with all nodes from this side
-                // this allows for easy comparison
-                for (unsigned int ns=0; ns<side->n_nodes(); ns++)
-                  side_nodes.insert(iter, side->node(ns));
-
-                // See whether one of the side node occurs in the list
-                // of tagged nodes. If we would loop over all side
-                // nodes, we would just get multiple hits, so taking
-                // node 0 is enough to do the job
-                unsigned int sn = side->node(0);
-                if (node_index.count(sn) > 0)
+                unsigned int bidx = node_index[sn][n];
+                if (boundary_elem[bidx].nodes == side_nodes)
                 {
-                  // Loop over all tagged ("physical") "sides" which
-                  // contain the node sn (typically just 1 to
-                  // three). For each of these the set of nodes is
-                  // compared to the current element's side nodes
-                  for (unsigned int n=0; n<node_index[sn].size(); n++)
-                  {
-                    unsigned int bidx = node_index[sn][n];
-                    if (boundary_elem[bidx].nodes == side_nodes)
-                    {
-                      mesh.boundary_info->add_side(elem, s, boundary_elem[bidx].id);
-                    }
-                  }
+                  mesh.boundary_info->add_side(elem, s, boundary_elem[bidx].id);
                 }
-              } // if elem->neighbor(s) == NULL
-          } // element loop
-        } // if boundary_elem.size() > 0
-      } // if $ELM
-
-    } // while !in.eof()
+              }
+            }
+          } // if elem->neighbor(s) == NULL
+      } // element loop
+    } // if boundary_elem.size() > 0
+  } // if elements
 
-  }
 
   // set mesh subdomain info
 
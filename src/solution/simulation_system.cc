@@ -312,6 +312,10 @@ void SimulationSystem::clear(bool clear_mesh)
 
   _electrical_source->clear_bc_source_map();
 
+  // generation profiles refer to node data of the old regions
+  if(_field_source)
+    _field_source->clear_mesh_data();
+
   //since we cleared all the solution data, previous solve histroy is meaningless
   _solver_active_history.clear();
 }
@@ -0,0 +1,131 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include "solution_checkpoint.h"
+#include "simulation_system.h"
+#include "simulation_region.h"
+#include "boundary_condition_collector.h"
+#include "field_source.h"
+#include "parallel.h"
+
+
+void SolutionCheckpoint::save(const SimulationSystem & system)
+{
+  _node_data.resize(system.n_regions());
+  _cell_data.resize(system.n_regions());
+  for(unsigned int r=0; r<system.n_regions(); ++r)
+    system.region(r)->save_data(_node_data[r], _cell_data[r]);
+
+  _bc_state.clear();
+  const BoundaryConditionCollector * bcs = system.get_bcs();
+  for(unsigned int b=0; b<bcs->n_bcs(); ++b)
+    bcs->get_bc(b)->save_state(_bc_state);
+
+  _valid = true;
+}
+
+
+bool SolutionCheckpoint::restore(SimulationSystem & system) const
+{
+  if( !_valid ) return false;
+
+  // check all the layouts before any change is done
+  int ok = (_node_data.size() == system.n_regions());
+  for(unsigned int r=0; ok && r<system.n_regions(); ++r)
+  {
+    SimulationRegion * region = system.region(r);
+    if( !region->node_data_storage().same_layout(_node_data[r]) ) ok = 0;
+  }
+  Parallel::min(ok);
+  if( !ok ) return false;
+
+  for(unsigned int r=0; r<system.n_regions(); ++r)
+    if( !system.region(r)->restore_data(_node_data[r], _cell_data[r]) ) ok = 0;
+
+  BoundaryConditionCollector * bcs = system.get_bcs();
+  unsigned int pos = 0;
+  for(unsigned int b=0; ok && b<bcs->n_bcs(); ++b)
+    if( !bcs->get_bc(b)->load_state(_bc_state, pos) ) ok = 0;
+
+  // OptG/PatG are part of node data
+  if( system.get_field_source() )
+    system.get_field_source()->invalidate_generation();
+
+  Parallel::min(ok);
+  return ok;
+}
+
+
+void SolutionCheckpoint::write(std::ostream &out) const
+{
+  unsigned int n_regions = _node_data.size();
+  out.write(reinterpret_cast<const char *>(&n_regions), sizeof(n_regions));
+  for(unsigned int r=0; r<n_regions; ++r)
+  {
+    _node_data[r].write(out);
+    _cell_data[r].write(out);
+  }
+
+  unsigned int n_bc_state = _bc_state.size();
+  out.write(reinterpret_cast<const char *>(&n_bc_state), sizeof(n_bc_state));
+  if( n_bc_state )
+    out.write(reinterpret_cast<const char *>(&_bc_state[0]), n_bc_state*sizeof(double));
+}
+
+
+bool SolutionCheckpoint::read(std::istream &in)
+{
+  clear();
+
+  unsigned int n_regions = 0;
+  in.read(reinterpret_cast<char *>(&n_regions), sizeof(n_regions));
+  if( !in.good() ) return false;
+
+  // layout is checked against the system by restore()
+  _node_data.resize(n_regions);
+  _cell_data.resize(n_regions);
+  for(unsigned int r=0; r<n_regions; ++r)
+  {
+    if( !_node_data[r].read(in) ) return false;
+    if( !_cell_data[r].read(in) ) return false;
+  }
+
+  unsigned int n_bc_state = 0;
+  in.read(reinterpret_cast<char *>(&n_bc_state), sizeof(n_bc_state));
+  if( !in.good() ) return false;
+  _bc_state.resize(n_bc_state);
+  if( n_bc_state )
+    in.read(reinterpret_cast<char *>(&_bc_state[0]), n_bc_state*sizeof(double));
+  if( !in.good() ) return false;
+
+  _valid = true;
+  return true;
+}
+
+
+void SolutionCheckpoint::clear()
+{
+  _node_data.clear();
+  _cell_data.clear();
+  _bc_state.clear();
+  _valid = false;
+}
@@ -152,8 +152,7 @@ int DDM1Solver::solve()
 int DDM1Solver::post_solve_process()
 {
 
-  VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+  scatter_local_solution(x);
 
   PetscScalar *lxx;
   VecGetArray(lx, &lxx);
@@ -206,8 +205,7 @@ int DDM1Solver::post_solve_process()
  */
 void DDM1Solver::flush_system(Vec v)
 {
-  VecScatterBegin(scatter, v, lx, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, v, lx, INSERT_VALUES, SCATTER_FORWARD);
+  scatter_local_solution(v);
 
   PetscScalar *lxx;
   VecGetArray(lx, &lxx);
@@ -847,9 +845,9 @@ void DDM1Solver::build_petsc_sens_residual(Vec x, Vec r)
 
   START_LOG("DDM1Solver_Residual()", "DDM1Solver");
 
-  // scatte global solution vector x to local vector lx
-  VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+  // scatte global solution vector x to local vector lx,
+  // the jacobian evaluation reuses lx of the residual evaluation at the same x
+  scatter_local_solution(x);
 
   PetscScalar *lxx;
   // get PetscScalar array contains solution from local solution vector lx
@@ -861,26 +859,17 @@ void DDM1Solver::build_petsc_sens_residual(Vec x, Vec r)
   // flag for indicate ADD_VALUES operator.
   InsertMode add_value_flag = NOT_SET_VALUES;
 
-  // evaluate governing equations of DDML1 in all the regions
+  // evaluate governing equations of DDML1 in all the regions,
+  // together with time derivative if necessary
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
-    region->DDM1_Function(lxx, r, add_value_flag);
+    if(SolverSpecify::TimeDependent == true)
+      region->DDM1_Function_Time_Dependent(lxx, r, add_value_flag);
+    else
+      region->DDM1_Function(lxx, r, add_value_flag);
   }
 
-#if defined(HAVE_FENV_H) && defined(DEBUG)
-  genius_assert( !fetestexcept(FE_INVALID) );
-#endif
-
-  // evaluate time derivative if necessary
-  if(SolverSpecify::TimeDependent == true)
-    for(unsigned int n=0; n<_system.n_regions(); n++)
-    {
-      SimulationRegion * region = _system.region(n);
-      region->DDM1_Time_Dependent_Function(lxx, r, add_value_flag);
-    }
-
-
   // evaluate pseudo time step if necessary
   if(SolverSpecify::Type == SolverSpecify::OP && SolverSpecify::PseudoTimeMethod == true)
     for(unsigned int n=0; n<_system.n_regions(); n++)
@@ -947,9 +936,9 @@ void DDM1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
 
   START_LOG("DDM1Solver_Jacobian()", "DDM1Solver");
 
-  // scatte global solution vector x to local vector lx
-  VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+  // scatte global solution vector x to local vector lx,
+  // the jacobian evaluation reuses lx of the residual evaluation at the same x
+  scatter_local_solution(x);
 
   PetscScalar *lxx;
   // get PetscScalar array contains solution from local solution vector lx
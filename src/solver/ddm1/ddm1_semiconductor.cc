@@ -26,6 +26,7 @@
 #include "semiconductor_region.h"
 #include "solver_specify.h"
 #include "log.h"
+#include "scratch_vector.h"
 
 #include "jflux1.h"
 
@@ -87,10 +88,42 @@ void SemiconductorSimulationRegion::DDM1_Fill_Value(Vec x, Vec L)
 }
 
 
+namespace
+{
+  /**
+   * BDF1/BDF2 discretization of -dc/dt*volume for carrier density c,
+   * c_n and c_last are the values of the last two time steps, r = dt_last/(dt_last+dt)
+   */
+  inline PetscScalar ddm1_time_term(PetscScalar c, PetscScalar c_n, PetscScalar c_last, PetscScalar r, PetscScalar volume)
+  {
+    //second order
+    if(SolverSpecify::TS_type==SolverSpecify::BDF2 && SolverSpecify::BDF2_LowerOrder==false)
+      return -((2-r)/(1-r)*c - 1.0/(r*(1-r))*c_n + (1-r)/r*c_last)
+             / (SolverSpecify::dt_last+SolverSpecify::dt) * volume;
+
+    //first order
+    return -(c - c_n)/SolverSpecify::dt*volume;
+  }
+}
+
+
+void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, InsertMode &add_value_flag)
+{
+  DDM1_Function_Sweep(x, f, add_value_flag, false);
+}
+
+
+void SemiconductorSimulationRegion::DDM1_Function_Time_Dependent(PetscScalar * x, Vec f, InsertMode &add_value_flag)
+{
+  DDM1_Function_Sweep(x, f, add_value_flag, true);
+}
+
+
 /*---------------------------------------------------------------------
- * build function and its jacobian for DDML1 solver
+ * build function and its jacobian for DDML1 solver.
+ * with time_dependent, the time derivative term is added in the same node sweep
  */
-void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, InsertMode &add_value_flag)
+void SemiconductorSimulationRegion::DDM1_Function_Sweep(PetscScalar * x, Vec f, InsertMode &add_value_flag, bool time_dependent)
 {
 
   // note, we will use ADD_VALUES to set values of vec f
@@ -248,6 +281,13 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
   // then, search all the element in this region and process "cell" related terms
   // note, they are all local element, thus must be processed
 
+  // save the mobility and impact ionization coefficients of each cell edge for the lagged jacobian
+  const bool save_coeff = SolverSpecify::LaggedCoefficient;
+  if( save_coeff )
+  {
+    _ddm1_lagged_coeff.clear();
+    _ddm1_lagged_coeff.reserve(6*this->n_cell());
+  }
 
   const_element_iterator it = elements_begin();
   const_element_iterator it_end = elements_end();
@@ -531,6 +571,16 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
         Jn_edge_cell.push_back(Jn);
         Jp_edge_cell.push_back(Jp);
 
+        if( save_coeff )
+        {
+          DDM1_LaggedCoefficient coeff;
+          coeff.mun = mun;
+          coeff.mup = mup;
+          coeff.IIn = coeff.IIp = 0.0;
+          coeff.riin1 = coeff.riip2 = 0.5;
+          _ddm1_lagged_coeff.push_back(coeff);
+        }
+
 
         // ignore thoese ghost nodes (ghost nodes is local but with different processor_id())
         if( fvm_n1->on_processor() )
@@ -633,6 +683,15 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
           GIIn = IIn * fabs(Jn)/e;
           GIIp = IIp * fabs(Jp)/e;
 
+          if( save_coeff )
+          {
+            DDM1_LaggedCoefficient & coeff = _ddm1_lagged_coeff.back();
+            coeff.IIn   = IIn;
+            coeff.IIp   = IIp;
+            coeff.riin1 = riin1;
+            coeff.riip2 = riip2;
+          }
+
           if( fvm_n1->on_processor() )
           {
             // continuity equation
@@ -674,6 +733,9 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
 
+  // ratio of the last two time steps, only meaningful in transient
+  const PetscScalar r = time_dependent ? SolverSpecify::dt_last/(SolverSpecify::dt_last + SolverSpecify::dt) : 0.0;
+
   // process node related terms
   // including \rho of poisson's equation and recombination term of continuation equation
   const_processor_node_iterator node_it = on_processor_nodes_begin();
@@ -703,12 +765,20 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
     // consider carrier generation
     PetscScalar Field_G = node_data->Field_G()*fvm_node->volume();
 
+    // time derivative term
+    PetscScalar Tn = 0, Tp = 0;
+    if(time_dependent)
+    {
+      Tn = ddm1_time_term(n, node_data->n(), node_data->n_last(), r, fvm_node->volume());
+      Tp = ddm1_time_term(p, node_data->p(), node_data->p_last(), r, fvm_node->volume());
+    }
+
     isource.push_back(global_offset+0);                                // save index in the buffer
     isource.push_back(global_offset+1);
     isource.push_back(global_offset+2);
     source.push_back( rho );                                                       // save value in the buffer
-    source.push_back( R + Field_G + node_data->EIn());
-    source.push_back( R + Field_G + node_data->HIn());
+    source.push_back( R + Field_G + node_data->EIn() + Tn);
+    source.push_back( R + Field_G + node_data->HIn() + Tp);
 
 
     if (get_advanced_model()->Trap)
@@ -766,6 +836,198 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
 
 
 
+namespace
+{
+  /**
+   * @return true when the command line flag is given
+   */
+  bool ddm1_flux_flag(const char * name)
+  {
+    PetscBool flg = PETSC_FALSE;
+    PetscOptionsHasName(PETSC_NULL, name, &flg);
+    return flg;
+  }
+
+  /**
+   * max relative difference between the hand derived and AD edge flux.
+   * derivatives are compared relative to the largest derivative of the same flux
+   */
+  PetscScalar ddm1_flux_diff(const AutoDScalar &a, const AutoDScalar &b)
+  {
+    PetscScalar diff = 0.0;
+
+    PetscScalar scale = std::abs(a.getValue()) + std::abs(b.getValue());
+    if( scale > 0.0 )
+      diff = std::abs(a.getValue() - b.getValue())/scale;
+
+    scale = 0.0;
+    for(unsigned int k=0; k<6; ++k)
+      scale = std::max(scale, std::abs(b.getADValue(k)));
+    if( scale > 0.0 )
+      for(unsigned int k=0; k<6; ++k)
+        diff = std::max(diff, std::abs(a.getADValue(k) - b.getADValue(k))/scale);
+
+    return diff;
+  }
+}
+
+
+/*---------------------------------------------------------------------
+ * S-G current of each edge for DDML1 jacobian with hand derived partial derivatives.
+ * Ec and Ev only depend on the variables of their own node, they are evaluated by AD
+ * once per node. the flux and its derivatives to (Ec2-Ec1, n1, n2) are then computed
+ * in closed form on flat arrays of all the edges, and combined by chain rule.
+ * when jac is not null, the jacobian of poisson's equation on the edges is added as well.
+ */
+void SemiconductorSimulationRegion::DDM1_Edge_Jacobian(PetscScalar * x, SparseMatrix<PetscScalar> *jac,
+                                                      std::vector<AutoDScalar> &Jn_edge, std::vector<AutoDScalar> &Jp_edge)
+{
+  START_LOG("DDM1_Edge_Jacobian()", "Semiconductor");
+
+  const PetscScalar T   = T_external();
+  const PetscScalar Vt  = kb*T/e;
+
+  // Ec/e, Ev/e of each node (see the NOTE in DDM1_Jacobian) and their derivatives to V, n and p,
+  // indexed by the offset of node data
+  const unsigned int n_node_data = _node_data_storage.size();
+  std::vector<PetscScalar> Ec(4*n_node_data);
+  std::vector<PetscScalar> Ev(4*n_node_data);
+  {
+    adtl::AutoDScalar::numdir = 3;
+    mt->set_ad_num(adtl::AutoDScalar::numdir);
+
+    const_local_node_iterator node_it = on_local_nodes_begin();
+    const_local_node_iterator node_it_end = on_local_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+    {
+      const FVM_Node * fvm_node = *node_it;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+      const unsigned int local_offset = fvm_node->local_offset();
+
+      mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);
+
+      AutoDScalar V  =  x[local_offset+0];   V.setADValue(0, 1.0);
+      AutoDScalar n  =  x[local_offset+1];   n.setADValue(1, 1.0);
+      AutoDScalar p  =  x[local_offset+2];   p.setADValue(2, 1.0);
+
+      AutoDScalar Ecn =  -(e*V + node_data->affinity() - node_data->dEcStrain() + mt->band->EgNarrowToEc(p, n, T) + kb*T*log(node_data->Nc()));
+      AutoDScalar Evn =  -(e*V + node_data->affinity() - node_data->dEvStrain() - mt->band->EgNarrowToEv(p, n, T) - kb*T*log(node_data->Nv()) + mt->band->Eg(T));
+      if(get_advanced_model()->Fermi)
+      {
+        Ecn = Ecn - kb*T*log(gamma_f(fabs(n)/node_data->Nc()));
+        Evn = Evn + kb*T*log(gamma_f(fabs(p)/node_data->Nv()));
+      }
+
+      const unsigned int offset = 4*node_data->offset();
+      Ec[offset] = Ecn.getValue()/e;
+      Ev[offset] = Evn.getValue()/e;
+      for(unsigned int k=0; k<3; ++k)
+      {
+        Ec[offset+k+1] = Ecn.getADValue(k)/e;
+        Ev[offset+k+1] = Evn.getADValue(k)/e;
+      }
+    }
+  }
+
+  // gather the edge data into flat arrays
+  const unsigned int n_edges = n_edge();
+  std::vector<unsigned int> edge_offset(2*n_edges);
+  std::vector<PetscScalar> h(n_edges), dVc(n_edges), dVv(n_edges);
+  std::vector<PetscScalar> n1(n_edges), n2(n_edges), p1(n_edges), p2(n_edges);
+  {
+    const_edge_iterator it = edges_begin();
+    const_edge_iterator it_end = edges_end();
+    for(unsigned int i=0; it!=it_end; ++it, ++i)
+    {
+      const FVM_Node * fvm_n1 = (*it).first;
+      const FVM_Node * fvm_n2 = (*it).second;
+      const FVM_NodeData * n1_data =  fvm_n1->node_data();
+      const FVM_NodeData * n2_data =  fvm_n2->node_data();
+      const unsigned int n1_local_offset = fvm_n1->local_offset();
+      const unsigned int n2_local_offset = fvm_n2->local_offset();
+      const unsigned int o1 = 4*n1_data->offset();
+      const unsigned int o2 = 4*n2_data->offset();
+
+      edge_offset[2*i+0] = o1;
+      edge_offset[2*i+1] = o2;
+      h[i]   = fvm_n1->distance(fvm_n2);
+      dVc[i] = Ec[o2] - Ec[o1];
+      dVv[i] = Ev[o2] - Ev[o1];
+      n1[i]  = x[n1_local_offset+1];
+      p1[i]  = x[n1_local_offset+2];
+      n2[i]  = x[n2_local_offset+1];
+      p2[i]  = x[n2_local_offset+2];
+
+      if( !jac ) continue;
+
+      // poisson's equation, eps*S*(V2 - V1)/length
+      const PetscScalar eps = 0.5*(n1_data->eps() + n2_data->eps());
+      const PetscScalar d_phi = eps*fvm_n1->cv_surface_area(fvm_n2)/h[i];
+
+      const PetscInt row1 = fvm_n1->global_offset();
+      const PetscInt row2 = fvm_n2->global_offset();
+
+      // ignore those ghost nodes
+      if( fvm_n1->on_processor() )
+      {
+        jac->add( row1,  row1,  -d_phi );
+        jac->add( row1,  row2,   d_phi );
+      }
+
+      if( fvm_n2->on_processor() )
+      {
+        jac->add( row2,  row1,   d_phi );
+        jac->add( row2,  row2,  -d_phi );
+      }
+    }
+  }
+
+  // S-G current and its partial derivatives, Ip_dd(p1, p2) is In_dd(p2, p1)
+  std::vector<PetscScalar> Jn(n_edges), dJn_dV(n_edges), dJn_dn1(n_edges), dJn_dn2(n_edges);
+  std::vector<PetscScalar> Jp(n_edges), dJp_dV(n_edges), dJp_dp1(n_edges), dJp_dp2(n_edges);
+  if( n_edges )
+  {
+    In_dd_block(n_edges, Vt, &dVc[0], &n1[0], &n2[0], &h[0], &Jn[0], &dJn_dV[0], &dJn_dn1[0], &dJn_dn2[0]);
+    In_dd_block(n_edges, Vt, &dVv[0], &p2[0], &p1[0], &h[0], &Jp[0], &dJp_dV[0], &dJp_dp2[0], &dJp_dp1[0]);
+  }
+
+  // chain rule to the 6 independent variables (V1, n1, p1, V2, n2, p2) of the edge
+  adtl::AutoDScalar::numdir = 6;
+  mt->set_ad_num(adtl::AutoDScalar::numdir);
+
+  Jn_edge.clear();
+  Jp_edge.clear();
+  Jn_edge.reserve(n_edges);
+  Jp_edge.reserve(n_edges);
+  for(unsigned int i=0; i<n_edges; ++i)
+  {
+    const PetscScalar * gc1 = &Ec[edge_offset[2*i+0]+1];
+    const PetscScalar * gc2 = &Ec[edge_offset[2*i+1]+1];
+    const PetscScalar * gv1 = &Ev[edge_offset[2*i+0]+1];
+    const PetscScalar * gv2 = &Ev[edge_offset[2*i+1]+1];
+
+    PetscScalar dn[6], dp[6];
+    for(unsigned int k=0; k<3; ++k)
+    {
+      dn[k]   = -dJn_dV[i]*gc1[k];
+      dn[k+3] =  dJn_dV[i]*gc2[k];
+      dp[k]   = -dJp_dV[i]*gv1[k];
+      dp[k+3] =  dJp_dV[i]*gv2[k];
+    }
+    dn[1] += dJn_dn1[i];
+    dn[4] += dJn_dn2[i];
+    dp[2] += dJp_dp1[i];
+    dp[5] += dJp_dp2[i];
+
+    Jn_edge.push_back( AutoDScalar(Jn[i], dn, 6) );
+    Jp_edge.push_back( AutoDScalar(Jp[i], dp, 6) );
+  }
+
+  STOP_LOG("DDM1_Edge_Jacobian()", "Semiconductor");
+}
+
+
+
 /*---------------------------------------------------------------------
  * build function and its jacobian for DDML1 solver
  * AD is fully used here
@@ -778,9 +1040,17 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
   const PetscScalar Vt  = kb*T/e;
   bool  highfield_mob   = highfield_mobility() && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM;
 
-  // precompute S-G current on each edge
+  // precompute S-G current on each edge.
+  // the hand derived flux is used unless -ddm_ad_flux is given, -ddm_check_flux evaluates
+  // both and reports the max relative difference
+  static const bool ad_flux    = ddm1_flux_flag("-ddm_ad_flux");
+  static const bool check_flux = ddm1_flux_flag("-ddm_check_flux");
+
   std::vector<AutoDScalar> Jn_edge_buffer;
   std::vector<AutoDScalar> Jp_edge_buffer;
+  if( !ad_flux && !check_flux )
+    DDM1_Edge_Jacobian(x, jac, Jn_edge_buffer, Jp_edge_buffer);
+  else
   {
     Jn_edge_buffer.reserve(n_edge());
     Jp_edge_buffer.reserve(n_edge());
@@ -879,6 +1149,21 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
       }
 
     }
+
+    if( check_flux )
+    {
+      std::vector<AutoDScalar> Jn_check;
+      std::vector<AutoDScalar> Jp_check;
+      DDM1_Edge_Jacobian(x, 0, Jn_check, Jp_check);
+
+      PetscScalar diff = 0.0;
+      for(unsigned int i=0; i<Jn_edge_buffer.size(); ++i)
+      {
+        diff = std::max(diff, ddm1_flux_diff(Jn_check[i], Jn_edge_buffer[i]));
+        diff = std::max(diff, ddm1_flux_diff(Jp_check[i], Jp_edge_buffer[i]));
+      }
+      MESSAGE<<"  Region " << name() << ": max relative difference of hand derived S-G flux to AD is " << diff << std::endl; RECORD();
+    }
   }
 
   // search all the element in this region.
@@ -886,6 +1171,15 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
 
   const_element_iterator it = elements_begin();
   const_element_iterator it_end = elements_end();
+
+  // with frozen mobility and impact ionization coefficients, the cell terms only
+  // depend on the edge current and are assembled edge by edge
+  if( SolverSpecify::LaggedCoefficientFrozen && !_ddm1_lagged_coeff.empty() )
+  {
+    DDM1_Lagged_Cell_Jacobian(jac, Jn_edge_buffer, Jp_edge_buffer);
+    it = it_end;
+  }
+
   for(; it!=it_end; ++it)
   {
     const Elem * elem = *it;
@@ -902,7 +1196,7 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
     mt->set_ad_num(adtl::AutoDScalar::numdir);
 
     // indicate the column position of the variables in the matrix
-    std::vector<PetscInt> cell_col;
+    ScratchVector<PetscInt> cell_col;
     cell_col.reserve(4*elem->n_nodes());
     for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
     {
@@ -933,9 +1227,9 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
       // which are the vector of electric field and current density.
       // here use type AutoDScalar, we should make sure the order of independent variable keeps the
       // same all the time
-      std::vector<AutoDScalar> psi_vertex;
-      std::vector<AutoDScalar> phin_vertex;
-      std::vector<AutoDScalar> phip_vertex;
+      ScratchVector<AutoDScalar> psi_vertex;
+      ScratchVector<AutoDScalar> phin_vertex;
+      ScratchVector<AutoDScalar> phip_vertex;
 
       for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
       {
@@ -986,14 +1280,14 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
       if(get_advanced_model()->ESurface && insulator_interface_elem)
       {
         // get all the sides on insulator interface
-        std::vector<unsigned int> sides;
-        std::vector<SimulationRegion *> regions;
+        ScratchVector<unsigned int> sides;
+        ScratchVector<SimulationRegion *> regions;
         elem_on_insulator_interface(elem, sides, regions);
         genius_assert(!sides.empty());
         const Elem * elem_insul=elem->neighbor(sides[0]);
         SimulationRegion * region_insul=regions[0];
 
-        std::vector<AutoDScalar> psi_vertex_neighbor;
+        ScratchVector<AutoDScalar> psi_vertex_neighbor;
         for(unsigned int nd=0; nd<elem_insul->n_nodes(); ++nd)
         {
           const FVM_Node * fvm_node_neighbor = elem_insul->get_fvm_node(nd);
@@ -1412,6 +1706,111 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, SparseMatrix<
 
 
 
+void SemiconductorSimulationRegion::DDM1_Lagged_Cell_Jacobian(SparseMatrix<PetscScalar> *jac,
+                                                              const std::vector<AutoDScalar> &Jn_edge_buffer,
+                                                              const std::vector<AutoDScalar> &Jp_edge_buffer)
+{
+  // the mobility and impact ionization rate are taken from the last DDM1_Function, without
+  // derivatives. the band band tunneling rate only depends on the cell E field, so it
+  // has no jacobian entry here.
+  bool  impact_ionization = get_advanced_model()->ImpactIonization && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM;
+
+  //the indepedent variable number, the same 6 variables as the edge current
+  adtl::AutoDScalar::numdir = 6;
+
+  //synchronize with material database
+  mt->set_ad_num(adtl::AutoDScalar::numdir);
+
+  unsigned int cell_edge = 0;
+
+  const_element_iterator it = elements_begin();
+  const_element_iterator it_end = elements_end();
+  for(; it!=it_end; ++it)
+  {
+    const Elem * elem = *it;
+    bool truncation =  SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationAlways ||
+        (SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationBoundary && is_elem_touch_boundary(elem)) ;
+
+    for(unsigned int ne=0; ne<elem->n_edges(); ++ne, ++cell_edge )
+    {
+      genius_assert( cell_edge < _ddm1_lagged_coeff.size() );
+      const DDM1_LaggedCoefficient & coeff = _ddm1_lagged_coeff[cell_edge];
+
+      std::pair<unsigned int, unsigned int> edge_nodes;
+      elem->nodes_on_edge(ne, edge_nodes);
+
+      const unsigned int edge_index = this->elem_edge_index(elem, ne);
+
+      const FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);   // fvm_node of node1
+      const FVM_Node * fvm_n2 = elem->get_fvm_node(edge_nodes.second);  // fvm_node of node2
+
+      double truncated_partial_area =  elem->partial_area_with_edge(ne);
+      double truncated_partial_volume =  elem->partial_volume_with_edge(ne);
+      if(truncation)
+      {
+        truncated_partial_area =  this->truncated_partial_area(elem, ne);
+        truncated_partial_volume =  elem->partial_volume_with_edge_truncated(ne);
+      }
+
+      bool inverse = fvm_n1->root_node()->id() > fvm_n2->root_node()->id();
+
+      // the column position of the variables, in the order of the edge current
+      const FVM_Node * first  = inverse ? fvm_n2 : fvm_n1;
+      const FVM_Node * second = inverse ? fvm_n1 : fvm_n2;
+      PetscInt col[6];
+      for(int i=0; i<3; ++i) col[i]   = first->global_offset()+i;
+      for(int i=0; i<3; ++i) col[i+3] = second->global_offset()+i;
+
+      const unsigned int n1_global_offset = fvm_n1->global_offset();
+      const unsigned int n2_global_offset = fvm_n2->global_offset();
+
+      AutoDScalar Jn = (inverse ? -1.0 : 1.0)*coeff.mun*Jn_edge_buffer[edge_index];
+      AutoDScalar Jp = (inverse ? -1.0 : 1.0)*coeff.mup*Jp_edge_buffer[edge_index];
+
+      // ignore thoese ghost nodes (ghost nodes is local but with different processor_id())
+      if( fvm_n1->on_processor() )
+      {
+        AutoDScalar f_Jn  =  Jn*truncated_partial_area ;
+        AutoDScalar f_Jp  = -Jp*truncated_partial_area;
+        jac->add_row(  n1_global_offset+1,  6,  col,  f_Jn.getADValue() );
+        jac->add_row(  n1_global_offset+2,  6,  col,  f_Jp.getADValue() );
+      }
+
+      if( fvm_n2->on_processor() )
+      {
+        AutoDScalar f_Jn  = -Jn*truncated_partial_area ;
+        AutoDScalar f_Jp  =  Jp*truncated_partial_area;
+        jac->add_row(  n2_global_offset+1,  6,  col,  f_Jn.getADValue() );
+        jac->add_row(  n2_global_offset+2,  6,  col,  f_Jp.getADValue() );
+      }
+
+      if( impact_ionization )
+      {
+        AutoDScalar GIIn = coeff.IIn * fabs(Jn)/e;
+        AutoDScalar GIIp = coeff.IIp * fabs(Jp)/e;
+
+        if( fvm_n1->on_processor() )
+        {
+          AutoDScalar continuity = (coeff.riin1*GIIn+(1.0-coeff.riip2)*GIIp)*truncated_partial_volume ;
+          jac->add_row(  n1_global_offset+1,  6,  col,  continuity.getADValue() );
+          jac->add_row(  n1_global_offset+2,  6,  col,  continuity.getADValue() );
+        }
+
+        if( fvm_n2->on_processor() )
+        {
+          AutoDScalar continuity = ((1.0-coeff.riin1)*GIIn+coeff.riip2*GIIp)*truncated_partial_volume ;
+          jac->add_row(  n2_global_offset+1,  6,  col,  continuity.getADValue() );
+          jac->add_row(  n2_global_offset+2,  6,  col,  continuity.getADValue() );
+        }
+      }
+    }
+  }
+
+  genius_assert( cell_edge == _ddm1_lagged_coeff.size() );
+}
+
+
+
 void SemiconductorSimulationRegion::DDM1_Time_Dependent_Function(PetscScalar * x, Vec f, InsertMode &add_value_flag)
 {
   // note, we will use ADD_VALUES to set values of vec f
@@ -1446,24 +1845,8 @@ void SemiconductorSimulationRegion::DDM1_Time_Dependent_Function(PetscScalar * x
     iy.push_back(fvm_node->global_offset()+1);                                // save index in the buffer
     iy.push_back(fvm_node->global_offset()+2);
 
-    //second order
-    if(SolverSpecify::TS_type==SolverSpecify::BDF2 && SolverSpecify::BDF2_LowerOrder==false)
-    {
-      PetscScalar Tn_BDF2 = -((2-r)/(1-r)*n - 1.0/(r*(1-r))*node_data->n() + (1-r)/r*node_data->n_last())
-                       / (SolverSpecify::dt_last+SolverSpecify::dt) * fvm_node->volume();
-      PetscScalar Tp_BDF2 = -((2-r)/(1-r)*p - 1.0/(r*(1-r))*node_data->p() + (1-r)/r*node_data->p_last())
-                       / (SolverSpecify::dt_last+SolverSpecify::dt) * fvm_node->volume();
-
-      y.push_back( Tn_BDF2 );
-      y.push_back( Tp_BDF2 );
-    }
-    else //first order
-    {
-      PetscScalar Tn_BDF1 = -(n - node_data->n())/SolverSpecify::dt*fvm_node->volume();
-      PetscScalar Tp_BDF1 = -(p - node_data->p())/SolverSpecify::dt*fvm_node->volume();
-      y.push_back( Tn_BDF1 );
-      y.push_back( Tp_BDF1 );
-    }
+    y.push_back( ddm1_time_term(n, node_data->n(), node_data->n_last(), r, fvm_node->volume()) );
+    y.push_back( ddm1_time_term(p, node_data->p(), node_data->p_last(), r, fvm_node->volume()) );
   }
 
 
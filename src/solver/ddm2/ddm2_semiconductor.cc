@@ -25,6 +25,7 @@
 #include "solver_specify.h"
 
 #include "log.h"
+#include "scratch_vector.h"
 #include "jflux2.h"
 
 
@@ -708,7 +709,7 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
     mt->set_ad_num(adtl::AutoDScalar::numdir);
 
     // indicate the column position of the variables in the matrix
-    std::vector<PetscInt> cell_col;
+    ScratchVector<PetscInt> cell_col;
     cell_col.reserve(4*elem->n_nodes());
     for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
     {
@@ -738,9 +739,9 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
       // which are the vector of electric field and current density.
       // here use type AutoDScalar, we should make sure the order of independent variable keeps the
       // same all the time
-      std::vector<AutoDScalar> psi_vertex;
-      std::vector<AutoDScalar> phin_vertex;
-      std::vector<AutoDScalar> phip_vertex;
+      ScratchVector<AutoDScalar> psi_vertex;
+      ScratchVector<AutoDScalar> phin_vertex;
+      ScratchVector<AutoDScalar> phip_vertex;
 
       for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
       {
@@ -792,8 +793,8 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
       if(get_advanced_model()->ESurface && insulator_interface_elem)
       {
         // get all the sides on insulator interface
-        std::vector<unsigned int> sides;
-        std::vector<SimulationRegion *> regions;
+        ScratchVector<unsigned int> sides;
+        ScratchVector<SimulationRegion *> regions;
         elem_on_insulator_interface(elem, sides, regions);
 
         VectorValue<AutoDScalar> E_insul(0.0,0.0,0.0);
@@ -806,7 +807,7 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, SparseMatrix<
         {
           const Elem * elem_neighbor = elem->neighbor(sides[ne]);
 
-          std::vector<AutoDScalar> psi_vertex_neighbor;
+          ScratchVector<AutoDScalar> psi_vertex_neighbor;
           for(unsigned int nd=0; nd<elem_neighbor->n_nodes(); ++nd)
           {
             const FVM_Node * fvm_node_neighbor = elem_neighbor->get_fvm_node(nd);
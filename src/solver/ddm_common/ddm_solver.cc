@@ -24,6 +24,12 @@
 #include <stack>
 #include <deque>
 #include <numeric>
+#include <fstream>
+#include <cstdio>
+#include <ctime>
+#include <csignal>
+#include <sstream>
+#include <algorithm>
 
 
 #include "solver_specify.h"
@@ -32,8 +38,10 @@
 #include "resistance_region.h"
 #include "simulation_system.h"
 #include "field_source.h"
+#include "solution_checkpoint.h"
 #include "ddm_solver.h"
 #include "parallel.h"
+#include "petsc_utils.h"
 #include "MXMLUtil.h"
 
 
@@ -80,6 +88,34 @@ int DDMSolverBase::create_solver()
   // must setup nonlinear contex here!
   setup_nonlinear_data();
 
+  set_solver_tolerances();
+
+  return FVM_FlexNonlinearSolver::create_solver();
+}
+
+
+
+int DDMSolverBase::resume_solver()
+{
+  MESSAGE<< '\n' << "Reuse the solver of last SOLVE card..." << std::endl;
+  RECORD();
+
+  set_nonlinear_solver_type ( SolverSpecify::NS );
+  set_linear_solver_type    ( SolverSpecify::LS );
+  set_preconditioner_type   ( SolverSpecify::PC );
+
+  // dof map, vectors and jacobian pattern are kept, only update snes/ksp/pc
+  resume_nonlinear_data();
+
+  set_solver_tolerances();
+
+  return FVM_FlexNonlinearSolver::resume_solver();
+}
+
+
+
+void DDMSolverBase::set_solver_tolerances()
+{
   //NOTE Tolerances here only be set as a reference
 
   //abstol = 1e-15                  - absolute convergence tolerance
@@ -93,14 +129,21 @@ int DDMSolverBase::create_solver()
 
   // user can do further adjusment from command line
   SNESSetFromOptions (snes);
-
-  return FVM_FlexNonlinearSolver::create_solver();
 }
 
 
 
 void DDMSolverBase::set_extra_matrix_nonzero_pattern()
 {
+  // dof offsets are ready, let bc build the stencil of their nonlocal coupling.
+  // the stencils are declared to the jacobian pattern by build_sparsity_pattern(),
+  // so the first assembly finds their slots preallocated
+  if(_system.get_bcs()!=NULL)
+  {
+    for(unsigned int n=0; n<_system.get_bcs()->n_bcs(); ++n )
+      _system.get_bcs()->get_bc(n)->DDM_build_extra_coupling();
+  }
+
 #if 0
   if(_system.get_bcs()!=NULL)
   {
@@ -132,6 +175,19 @@ void DDMSolverBase::set_extra_matrix_nonzero_pattern()
 }
 
 
+void DDMSolverBase::build_sparsity_pattern(SparsityPattern & pattern) const
+{
+  FVM_FlexNonlinearSolver::build_sparsity_pattern(pattern);
+
+  // nonlocal coupling of bc, i.e. gate tunneling
+  if(_system.get_bcs()!=NULL)
+  {
+    for(unsigned int n=0; n<_system.get_bcs()->n_bcs(); ++n )
+      _system.get_bcs()->get_bc(n)->DDM_extra_coupling(pattern);
+  }
+}
+
+
 int DDMSolverBase::post_solve_process()
 {
   mxml_node_t *eSolution = new_dom_solution_elem();
@@ -206,6 +262,20 @@ int DDMSolverBase::destroy_solver()
 
 
 
+int DDMSolverBase::suspend_solver()
+{
+  // keep nonlinear matrix/vector
+  suspend_nonlinear_data();
+
+#if defined(HAVE_FENV_H)
+  feclearexcept(FE_INVALID);
+#endif
+
+  return FVM_FlexNonlinearSolver::suspend_solver();
+}
+
+
+
 bool DDMSolverBase::heat_sink() const
 {
   bool sink = false;
@@ -266,6 +336,7 @@ void DDMSolverBase::snes_solve()
 #endif
   // do snes solve
   SNESSolve ( snes, PETSC_NULL, x );
+  PetscUtils::SNESCountIterations(snes);
 
   // get the converged reason
   SNESConvergedReason reason;
@@ -283,12 +354,16 @@ void DDMSolverBase::snes_solve()
 #endif
     this->diverged_recovery();
     SNESSolve ( snes, PETSC_NULL, x );
+    PetscUtils::SNESCountIterations(snes);
   }
 
 #if defined(HAVE_FENV_H)
   feclearexcept (FE_ALL_EXCEPT);
 #endif
 
+  // the frozen coefficients only live inside one nonlinear solve
+  SolverSpecify::LaggedCoefficientFrozen = false;
+
   STOP_LOG("snes_solve()", "DDMSolverBase");
 }
 
@@ -1343,6 +1418,238 @@ trace_end:
 }
 
 
+namespace
+{
+  const char   checkpoint_magic[8] = {'G','S','S','C','K','P','T','\0'};
+  const int    checkpoint_version  = 1;
+
+  // set by signal handler, checked at the beginning of each time step
+  volatile sig_atomic_t checkpoint_signal = 0;
+
+  // each processor holds its own part of the solution
+  std::string checkpoint_file_name(const std::string &fname)
+  {
+    if( Genius::n_processors() == 1 ) return fname;
+    std::stringstream ss;
+    ss << fname << ".p" << Genius::processor_id();
+    return ss.str();
+  }
+
+  template <typename T>
+  void checkpoint_write(std::ostream &out, const T &v)
+  { out.write(reinterpret_cast<const char *>(&v), sizeof(T)); }
+
+  template <typename T>
+  void checkpoint_read(std::istream &in, T &v)
+  { in.read(reinterpret_cast<char *>(&v), sizeof(T)); }
+
+  void checkpoint_write_vec(std::ostream &out, Vec v)
+  {
+    PetscInt n;
+    VecGetLocalSize(v, &n);
+    checkpoint_write(out, n);
+
+    PetscScalar * vv;
+    VecGetArray(v, &vv);
+    out.write(reinterpret_cast<const char *>(vv), n*sizeof(PetscScalar));
+    VecRestoreArray(v, &vv);
+  }
+
+  bool checkpoint_read_vec(std::istream &in, Vec v)
+  {
+    PetscInt n, n_local;
+    VecGetLocalSize(v, &n_local);
+    checkpoint_read(in, n);
+    if( !in || n != n_local ) return false;
+
+    PetscScalar * vv;
+    VecGetArray(v, &vv);
+    in.read(reinterpret_cast<char *>(vv), n*sizeof(PetscScalar));
+    VecRestoreArray(v, &vv);
+    return !in.fail();
+  }
+}
+
+extern "C"
+{
+  static void __genius_checkpoint_signal_handler(int sig)
+  {
+    checkpoint_signal = sig;
+  }
+}
+
+
+bool DDMSolverBase::write_transient_checkpoint(const std::string &fname, int autostep_retry, int diverged_retry,
+                                               const std::deque<double> &time_step_success)
+{
+  START_LOG("write_transient_checkpoint()", "DDMSolverBase");
+
+  SolutionCheckpoint checkpoint;
+  checkpoint.save(_system);
+
+  const std::string file = checkpoint_file_name(fname);
+  const std::string tmp_file = file + ".tmp";
+
+  bool ok = true;
+  {
+    std::ofstream out(tmp_file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if( out.good() )
+    {
+      out.write(checkpoint_magic, sizeof(checkpoint_magic));
+      checkpoint_write(out, checkpoint_version);
+      checkpoint_write(out, Genius::n_processors());
+
+      // transient clock and time step controller
+      checkpoint_write(out, SolverSpecify::clock);
+      checkpoint_write(out, SolverSpecify::dt);
+      checkpoint_write(out, SolverSpecify::dt_last);
+      checkpoint_write(out, SolverSpecify::dt_last_last);
+      checkpoint_write(out, SolverSpecify::T_Cycles);
+      checkpoint_write(out, SolverSpecify::BDF2_LowerOrder);
+      checkpoint_write(out, SolverSpecify::TS_type);
+      checkpoint_write(out, autostep_retry);
+      checkpoint_write(out, diverged_retry);
+      unsigned int n_steps = time_step_success.size();
+      checkpoint_write(out, n_steps);
+      for(unsigned int i=0; i<n_steps; ++i)
+        checkpoint_write(out, time_step_success[i]);
+
+      // node/cell data and boundary state
+      checkpoint.write(out);
+
+      // solution history
+      checkpoint_write_vec(out, x);
+      checkpoint_write_vec(out, x_n);
+      checkpoint_write_vec(out, x_n1);
+      checkpoint_write_vec(out, x_n2);
+
+      out.flush();
+      ok = out.good();
+    }
+    else
+      ok = false;
+  }
+
+  // only replace the old checkpoint when all the processors wrote the new one
+  Parallel::min(ok);
+  if( ok )
+  {
+#ifdef WINDOWS
+    std::remove(file.c_str());
+#endif
+    ok = (std::rename(tmp_file.c_str(), file.c_str()) == 0);
+    Parallel::min(ok);
+  }
+  else
+    std::remove(tmp_file.c_str());
+
+  if( ok )
+  {
+    MESSAGE<<"Transient checkpoint at t = "<<SolverSpecify::clock/s*1e12<<" ps written to "<<fname<<".\n\n";
+    RECORD();
+  }
+  else
+  {
+    MESSAGE<<"Warning: failed to write transient checkpoint "<<fname<<".\n\n";
+    RECORD();
+  }
+
+  STOP_LOG("write_transient_checkpoint()", "DDMSolverBase");
+
+  return ok;
+}
+
+
+bool DDMSolverBase::read_transient_checkpoint(const std::string &fname, int &autostep_retry, int &diverged_retry,
+                                              std::deque<double> &time_step_success)
+{
+  START_LOG("read_transient_checkpoint()", "DDMSolverBase");
+
+  const std::string file = checkpoint_file_name(fname);
+  std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+
+  bool ok = in.good();
+
+  char magic[8];
+  int version = 0;
+  unsigned int n_processors = 0;
+  if( ok )
+  {
+    in.read(magic, sizeof(magic));
+    checkpoint_read(in, version);
+    checkpoint_read(in, n_processors);
+    ok = in.good() &&
+         std::equal(magic, magic+sizeof(magic), checkpoint_magic) &&
+         version == checkpoint_version &&
+         n_processors == Genius::n_processors();
+  }
+
+  double clock=0, dt=0, dt_last=0, dt_last_last=0;
+  int T_Cycles=0;
+  bool BDF2_LowerOrder=false;
+  SolverSpecify::TemporalScheme TS_type=SolverSpecify::TS_type;
+  std::deque<double> steps;
+  int autostep=0, diverged=0;
+  SolutionCheckpoint checkpoint;
+
+  if( ok )
+  {
+    checkpoint_read(in, clock);
+    checkpoint_read(in, dt);
+    checkpoint_read(in, dt_last);
+    checkpoint_read(in, dt_last_last);
+    checkpoint_read(in, T_Cycles);
+    checkpoint_read(in, BDF2_LowerOrder);
+    checkpoint_read(in, TS_type);
+    checkpoint_read(in, autostep);
+    checkpoint_read(in, diverged);
+    unsigned int n_steps=0;
+    checkpoint_read(in, n_steps);
+    for(unsigned int i=0; in.good() && i<n_steps; ++i)
+    {
+      double h;
+      checkpoint_read(in, h);
+      steps.push_back(h);
+    }
+    ok = in.good() && TS_type == SolverSpecify::TS_type && checkpoint.read(in);
+  }
+
+  // everything before this point only touched local variables,
+  // give up together when any processor failed
+  Parallel::min(ok);
+  if( ok ) ok = checkpoint.restore(_system);
+
+  if( ok )
+  {
+    ok = checkpoint_read_vec(in, x)    &&
+         checkpoint_read_vec(in, x_n)  &&
+         checkpoint_read_vec(in, x_n1) &&
+         checkpoint_read_vec(in, x_n2);
+    Parallel::min(ok);
+  }
+
+  if( ok )
+  {
+    SolverSpecify::clock           = clock;
+    SolverSpecify::dt              = dt;
+    SolverSpecify::dt_last         = dt_last;
+    SolverSpecify::dt_last_last    = dt_last_last;
+    SolverSpecify::T_Cycles        = T_Cycles;
+    SolverSpecify::BDF2_LowerOrder = BDF2_LowerOrder;
+    autostep_retry    = autostep;
+    diverged_retry    = diverged;
+    time_step_success = steps;
+
+    MESSAGE<<"Transient restart from "<<fname<<" at t = "<<clock/s*1e12<<" ps.\n";
+    RECORD();
+  }
+
+  STOP_LOG("read_transient_checkpoint()", "DDMSolverBase");
+
+  return ok;
+}
+
+
 /*----------------------------------------------------------------------------
  * transient simulation!
  */
@@ -1360,27 +1667,54 @@ int DDMSolverBase::solve_transient()
   // time dependent
   SolverSpecify::TimeDependent = true;
 
-  // if BDF2 scheme is used, we should set SolverSpecify::BDF2_LowerOrder flag to true
-  if ( SolverSpecify::TS_type==SolverSpecify::BDF2 )
-    SolverSpecify::BDF2_LowerOrder = true;
+  // diverged counter
+  int diverged_retry=0;
+
+  // auto time step counter
+  int autostep_retry=0;
+
+  std::deque<double> time_step_success;
 
-  // we have a previous dc solution
-  if(!SolverSpecify::tran_histroy)
+  // continue from a checkpoint written by a previous run
+  bool restart = false;
+  if( !SolverSpecify::restart_file.empty() )
   {
-    _system.get_electrical_source()->update ( SolverSpecify::TStart );
-    for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+    restart = read_transient_checkpoint(SolverSpecify::restart_file, autostep_retry, diverged_retry, time_step_success);
+    if( !restart )
     {
-      BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
-      if(bc && bc->is_electrode())
-        bc->ext_circuit()->tran_op_init();
+      MESSAGE<<"ERROR: failed to restart transient simulation from "<<SolverSpecify::restart_file<<".\n";
+      RECORD();
+      genius_error();
     }
   }
 
-  // transient simulation clock
-  SolverSpecify::clock = SolverSpecify::TStart + SolverSpecify::TStep;
+  if( !restart )
+  {
+    // if BDF2 scheme is used, we should set SolverSpecify::BDF2_LowerOrder flag to true
+    if ( SolverSpecify::TS_type==SolverSpecify::BDF2 )
+      SolverSpecify::BDF2_LowerOrder = true;
 
-  // for the first step, dt equals TStep
-  SolverSpecify::dt = SolverSpecify::TStep;
+    // we have a previous dc solution
+    if(!SolverSpecify::tran_histroy)
+    {
+      _system.get_electrical_source()->update ( SolverSpecify::TStart );
+      for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+      {
+        BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+        if(bc && bc->is_electrode())
+          bc->ext_circuit()->tran_op_init();
+      }
+    }
+
+    // transient simulation clock
+    SolverSpecify::clock = SolverSpecify::TStart + SolverSpecify::TStep;
+
+    // for the first step, dt equals TStep
+    SolverSpecify::dt = SolverSpecify::TStep;
+
+    // time step counter
+    SolverSpecify::T_Cycles=0;
+  }
 
   MESSAGE<<"Transient compute from "<<SolverSpecify::TStart/s*1e12
       <<" ps step "<<SolverSpecify::TStep/s*1e12
@@ -1388,22 +1722,66 @@ int DDMSolverBase::solve_transient()
   <<'\n';
   RECORD();
 
-  // diverged counter
-  int diverged_retry=0;
+  double dt_dynamic_factor = 1.0;
 
-  // auto time step counter
-  int autostep_retry=0;
+  double average_time_step = SolverSpecify::dt;
+  if( !time_step_success.empty() )
+    average_time_step = std::accumulate(time_step_success.begin(), time_step_success.end(), 0.0)/time_step_success.size();
 
-  // time step counter
-  SolverSpecify::T_Cycles=0;
+  // the predicted solution of the restarted step, pre_solve_process should still
+  // fill the scaling vector from the restored data
+  Vec x_restart = PETSC_NULL;
+  if( restart )
+  {
+    VecDuplicate ( x, &x_restart );
+    VecCopy ( x, x_restart );
+  }
 
-  double dt_dynamic_factor = 1.0;
+  // periodic checkpoint, and checkpoint on signal
+  const bool checkpoint = !SolverSpecify::checkpoint_file.empty();
+  time_t checkpoint_time = time(0);
+  void (*sigterm_handler)(int) = SIG_DFL;
+#ifndef WINDOWS
+  void (*sigusr1_handler)(int) = SIG_DFL;
+#endif
+  if( checkpoint )
+  {
+    checkpoint_signal = 0;
+    sigterm_handler = signal(SIGTERM, __genius_checkpoint_signal_handler);
+#ifndef WINDOWS
+    sigusr1_handler = signal(SIGUSR1, __genius_checkpoint_signal_handler);
+#endif
+  }
 
-  std::deque<double> time_step_success;
-  double average_time_step = SolverSpecify::dt;
   // the main loop of transient solver.
   do
   {
+    // the state at the beginning of a time step is complete for restart
+    if( checkpoint && SolverSpecify::T_Cycles > 0 )
+    {
+      int sig = checkpoint_signal;
+      bool timeout = SolverSpecify::checkpoint_interval > 0 &&
+                     difftime(time(0), checkpoint_time) >= SolverSpecify::checkpoint_interval;
+      // all the processors should agree
+      Parallel::max(sig);
+      Parallel::max(timeout);
+
+      if( sig || timeout )
+      {
+        checkpoint_signal = 0;
+        write_transient_checkpoint(SolverSpecify::checkpoint_file, autostep_retry, diverged_retry, time_step_success);
+        checkpoint_time = time(0);
+      }
+
+      if( sig == SIGTERM )
+      {
+        MESSAGE<<"------> Terminated by signal, transient simulation stopped at t = "<<SolverSpecify::clock/s*1e12<<" ps.\n\n\n";
+        RECORD();
+        ierr = 1;
+        break;
+      }
+    }
+
     MESSAGE
     <<"t = "<<SolverSpecify::clock/s*1e12<<" ps, "<< "dt = " << SolverSpecify::dt/s*1e12 <<" ps"<< '\n'
     <<"--------------------------------------------------------------------------------\n";
@@ -1417,6 +1795,13 @@ int DDMSolverBase::solve_transient()
     // call pre_solve_process
     if ( SolverSpecify::T_Cycles == 0 )
       this->pre_solve_process();
+    else if ( x_restart )
+    {
+      this->pre_solve_process();
+      VecCopy ( x_restart, x );
+      VecDestroy ( PetscDestroyObject(x_restart) );
+      x_restart = PETSC_NULL;
+    }
     else
       this->pre_solve_process ( false );
 
@@ -1653,7 +2038,16 @@ int DDMSolverBase::solve_transient()
   }
   while ( SolverSpecify::clock < SolverSpecify::TStop+0.5*SolverSpecify::dt );
 
+  if( checkpoint )
+  {
+    signal(SIGTERM, sigterm_handler);
+#ifndef WINDOWS
+    signal(SIGUSR1, sigusr1_handler);
+#endif
+  }
+
   // free aux vectors
+  if( x_restart ) VecDestroy ( PetscDestroyObject(x_restart) );
   VecDestroy ( PetscDestroyObject(x_n) );
   VecDestroy ( PetscDestroyObject(x_n1) );
   VecDestroy ( PetscDestroyObject(x_n2) );
@@ -1779,11 +2173,14 @@ int DDMSolverBase::snes_solve_pseudo_time_step()
   #include <petsc/private/snesimpl.h>
 #endif
 
-void DDMSolverBase::petsc_snes_convergence_test ( PetscInt its, PetscReal , PetscReal pnorm, PetscReal fnorm, SNESConvergedReason *reason )
+void DDMSolverBase::petsc_snes_convergence_test ( PetscInt its, PetscReal xnorm, PetscReal pnorm, PetscReal fnorm, SNESConvergedReason *reason )
 {
   // update error norm
   this->error_norm();
 
+  // frozen or full coefficients in the next jacobian
+  this->update_lagged_coefficient(its, xnorm, pnorm);
+
   *reason = SNES_CONVERGED_ITERATING;
 
   // the first iteration
@@ -1978,6 +2375,29 @@ void DDMSolverBase::petsc_snes_convergence_test ( PetscInt its, PetscReal , Pets
 
 
 
+/*------------------------------------------------------------------
+ * the first newton iterations of each solve build the jacobian with frozen
+ * mobility and impact ionization coefficients. full derivatives are restored
+ * when the newton update relative to the solution is small or newton takes too many steps, and kept
+ * to the end of the solve. the residual is always exact, so the converged
+ * solution does not change.
+ */
+void DDMSolverBase::update_lagged_coefficient(PetscInt its, PetscReal xnorm, PetscReal pnorm)
+{
+  if( !SolverSpecify::LaggedCoefficient )
+  {
+    SolverSpecify::LaggedCoefficientFrozen = false;
+    return;
+  }
+
+  if( !its )
+    SolverSpecify::LaggedCoefficientFrozen = true;
+  else if( pnorm < SolverSpecify::LaggedCoefficientTol*xnorm || its >= static_cast<PetscInt>(SolverSpecify::MaxIteration/2) )
+    SolverSpecify::LaggedCoefficientFrozen = false;
+}
+
+
+
 /*------------------------------------------------------------------
  * ksp convergence criteria
  */
@@ -27,6 +27,7 @@
 #include "boundary_condition_is.h"
 #include "boundary_condition_collector.h"
 #include "petsc_utils.h"
+#include "sparsity_pattern.h"
 #include "parallel.h"
 
 #define DEBUG
@@ -79,19 +80,17 @@ void InsulatorSemiconductorInterfaceBC::_gate_current()
     // injection end
     SimulationRegion * region = node_it->second.region;
     BoundaryCondition * bc = node_it->second.bc;
-    const Elem * bc_elem = node_it->second.elem;
-    const unsigned int bc_elem_face_index = node_it->second.side;
+    const NearestPoint & nearest_point = node_it->second;
     const Point & point_injection = node_it->second.p;
 
-    AutoPtr<Elem> bc_elem_face = bc_elem->build_side(bc_elem_face_index, false);
     std::vector<PetscScalar> psi_elem;
     std::vector<PetscScalar> Ec_elem;
     std::vector<PetscScalar> Ev_elem;
     std::vector<PetscScalar> qfn_elem;
     std::vector<PetscScalar> qfp_elem;
-    for(unsigned int n=0; n<bc_elem_face->n_nodes(); ++n)
+    for(unsigned int n=0; n<nearest_point.side_nodes.size(); ++n)
     {
-      const Node * node = bc_elem_face->get_node(n); assert(node->on_local());
+      const Node * node = nearest_point.side_nodes[n]; assert(node->on_local());
       const FVM_Node * fvm_node = region->region_fvm_node(node);
       assert(fvm_node->on_local());
       psi_elem.push_back(fvm_node->node_data()->psi());
@@ -100,11 +99,11 @@ void InsulatorSemiconductorInterfaceBC::_gate_current()
       qfn_elem.push_back(fvm_node->node_data()->qFn());
       qfp_elem.push_back(fvm_node->node_data()->qFp());
     }
-    PetscScalar V_gate = bc_elem_face->interpolation(psi_elem, point_injection);
-    PetscScalar Ec_gate = bc_elem_face->interpolation(Ec_elem, point_injection);
-    PetscScalar Ev_gate = bc_elem_face->interpolation(Ev_elem, point_injection);
-    PetscScalar Efn_gate = bc_elem_face->interpolation(qfn_elem, point_injection);
-    PetscScalar Efp_gate = bc_elem_face->interpolation(qfp_elem, point_injection);
+    PetscScalar V_gate = nearest_point.interpolation(psi_elem);
+    PetscScalar Ec_gate = nearest_point.interpolation(Ec_elem);
+    PetscScalar Ev_gate = nearest_point.interpolation(Ev_elem);
+    PetscScalar Efn_gate = nearest_point.interpolation(qfn_elem);
+    PetscScalar Efp_gate = nearest_point.interpolation(qfp_elem);
     // Ec/Ev is meaning less for metal
     /*
     if(region->type() == MetalRegion ||  region->type() == ElectrodeRegion )
@@ -283,41 +282,101 @@ void InsulatorSemiconductorInterfaceBC::_gate_current()
 
 void InsulatorSemiconductorInterfaceBC::DDM_extra_dofs(std::map<FVM_Node *, std::pair<unsigned int, unsigned int> >& dofs) const
 {
+  // count from the coupling table, which only exists with TunnelingSelfConsistently
+  for(unsigned int c=0; c<_gate_coupling.size(); ++c)
+  {
+    const GateCoupling & coupling = _gate_coupling[c];
+    FVM_Node * semiconductor_node = const_cast<FVM_Node *>(coupling.semiconductor_node);
+
+    for(unsigned int n=0; n<coupling.gate_nodes.size(); ++n)
+    {
+      FVM_Node * fvm_node = const_cast<FVM_Node *>(coupling.gate_nodes[n]);
+      if(fvm_node->on_processor())
+        dofs[semiconductor_node].first += coupling.gate_node_dofs;
+      else
+        dofs[semiconductor_node].second += coupling.gate_node_dofs;
+
+      dofs[fvm_node].first += 3;
+    }
+  }
+}
+
+
+
+void InsulatorSemiconductorInterfaceBC::DDM_build_extra_coupling()
+{
+  _gate_coupling.clear();
+
   const SimulationRegion * _r1 = bc_regions().first;
   const SimulationRegion * _r2 = bc_regions().second;
 
   const SemiconductorSimulationRegion * semiconductor_region = dynamic_cast<const SemiconductorSimulationRegion *> ( _r1 );
   const InsulatorSimulationRegion * insulator_region = dynamic_cast<const InsulatorSimulationRegion *> ( _r2 );
 
+  if(!semiconductor_region->advanced_model().TunnelingSelfConsistently) return;
+
+  _gate_coupling.reserve(_node_nearest_point_map.size());
+
   std::multimap<const Node *, NearestPoint>::const_iterator node_it = _node_nearest_point_map.begin();
   for(; node_it != _node_nearest_point_map.end(); ++node_it)
   {
-    // injection begin
-    FVM_Node * semiconductor_node = get_region_fvm_node(node_it->first, semiconductor_region);
-
-    // injection end
-    SimulationRegion * region = node_it->second.region;
-    BoundaryCondition * bc = node_it->second.bc;
-    const Elem * bc_elem = node_it->second.elem;
-    const unsigned int bc_elem_face_index = node_it->second.side;
-    const unsigned int nv = region->type() == SemiconductorRegion ? 3 : 1;
-
-    AutoPtr<Elem> bc_elem_face = bc_elem->build_side(bc_elem_face_index, false);
-    for(unsigned int n=0; n<bc_elem_face->n_nodes(); ++n)
+    const NearestPoint & nearest_point = node_it->second;
+    const SimulationRegion * region = nearest_point.region;
+
+    GateCoupling coupling;
+    coupling.nearest_point = &nearest_point;
+    coupling.semiconductor_node = get_region_fvm_node(node_it->first, semiconductor_region);   assert(coupling.semiconductor_node);
+    coupling.insulator_node = get_region_fvm_node(node_it->first, insulator_region);    assert(coupling.insulator_node);
+    coupling.t = (*(coupling.semiconductor_node->root_node())-nearest_point.p).size();
+    coupling.gate_node_dofs = region->type() == SemiconductorRegion ? 3 : 1;
+
+    const unsigned int global_offset = coupling.semiconductor_node->global_offset();
+    coupling.col_index.push_back(global_offset + 0);
+    coupling.col_index.push_back(global_offset + 1);
+    coupling.col_index.push_back(global_offset + 2);
+    coupling.row_index.push_back(global_offset + 1);
+    coupling.row_index.push_back(global_offset + 2);
+
+    for(unsigned int v=0; v<nearest_point.side_nodes.size(); ++v)
     {
-      Node * node = bc_elem_face->get_node(n); assert(node->on_local());
-      FVM_Node * fvm_node = region->region_fvm_node(node);
-      if(fvm_node->on_processor())
-        dofs[semiconductor_node].first += nv;
-      else
-        dofs[semiconductor_node].second += nv;
+      const Node * node = nearest_point.side_nodes[v]; assert(node->on_local());
+      const FVM_Node * fvm_node = region->region_fvm_node(node);
+      coupling.gate_nodes.push_back(fvm_node);
 
-      dofs[fvm_node].first += 3;
+      const unsigned int global_offset = fvm_node->global_offset();
+      if(region->type() == SemiconductorRegion)
+      {
+        coupling.col_index.push_back(global_offset + 0);
+        coupling.col_index.push_back(global_offset + 1);
+        coupling.col_index.push_back(global_offset + 2);
+        coupling.row_index.push_back(global_offset + 1);
+        coupling.row_index.push_back(global_offset + 2);
+      }
+      else
+      {
+        coupling.col_index.push_back(global_offset);
+        coupling.row_index.push_back(global_offset);
+      }
     }
+
+    _gate_coupling.push_back(coupling);
   }
 }
 
 
+void InsulatorSemiconductorInterfaceBC::DDM_extra_coupling(SparsityPattern &pattern) const
+{
+  // the table is built by DDM_build_extra_coupling() before the pattern is declared,
+  // every stencil slot is then preallocated at the first assembly
+  const SemiconductorSimulationRegion * semiconductor_region = dynamic_cast<const SemiconductorSimulationRegion *> ( bc_regions().first );
+  genius_assert( _gate_coupling.size() ==
+                 (semiconductor_region->advanced_model().TunnelingSelfConsistently ? _node_nearest_point_map.size() : 0) );
+
+  for(unsigned int c=0; c<_gate_coupling.size(); ++c)
+    pattern.add_coupling(_gate_coupling[c].row_index, _gate_coupling[c].col_index);
+}
+
+
 
 #define __F_SELF_CONSISTANCE__
 
@@ -344,26 +403,23 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_function(PetscScalar * x,
   std::vector<PetscScalar> J_VBHT_Buffer;
   std::vector<PetscScalar> J_VBET_Buffer;
 
-  std::multimap<const Node *, NearestPoint>::const_iterator node_it = _node_nearest_point_map.begin();
-  for(; node_it != _node_nearest_point_map.end(); ++node_it)
+  std::vector<PetscScalar> f_values;
+
+  for(unsigned int c=0; c<_gate_coupling.size(); ++c)
   {
+    const GateCoupling & coupling = _gate_coupling[c];
     // injection end
-    SimulationRegion * region = node_it->second.region;
-    BoundaryCondition * bc = node_it->second.bc;
-    const Elem * bc_elem = node_it->second.elem;
-    const unsigned int bc_elem_face_index = node_it->second.side;
-    const Point & point_injection = node_it->second.p;
-    AutoPtr<Elem> bc_elem_face = bc_elem->build_side(bc_elem_face_index, false);
+    const NearestPoint & nearest_point = *coupling.nearest_point;
+    const SimulationRegion * region = nearest_point.region;
 
     std::vector<PetscScalar> psi_elem;
     std::vector<PetscScalar> Ec_elem;
     std::vector<PetscScalar> Ev_elem;
     std::vector<PetscScalar> qfn_elem;
     std::vector<PetscScalar> qfp_elem;
-    for(unsigned int v=0; v<bc_elem_face->n_nodes(); ++v)
+    for(unsigned int v=0; v<coupling.gate_nodes.size(); ++v)
     {
-      const Node * node = bc_elem_face->get_node(v); assert(node->on_local());
-      const FVM_Node * fvm_node = region->region_fvm_node(node);
+      const FVM_Node * fvm_node = coupling.gate_nodes[v];
       const FVM_NodeData * node_data = fvm_node->node_data();
 
       const unsigned int local_offset = fvm_node->local_offset();
@@ -394,17 +450,16 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_function(PetscScalar * x,
         qfp_elem.push_back(-(e*V + node_data->affinity()) );
       }
     }
-    PetscScalar V_gate = bc_elem_face->interpolation(psi_elem, point_injection);
-    PetscScalar Ec_gate = bc_elem_face->interpolation(Ec_elem, point_injection);
-    PetscScalar Ev_gate = bc_elem_face->interpolation(Ev_elem, point_injection);
-    PetscScalar Efn_gate = bc_elem_face->interpolation(qfn_elem, point_injection);
-    PetscScalar Efp_gate = bc_elem_face->interpolation(qfp_elem, point_injection);
+    PetscScalar V_gate = nearest_point.interpolation(psi_elem);
+    PetscScalar Ec_gate = nearest_point.interpolation(Ec_elem);
+    PetscScalar Ev_gate = nearest_point.interpolation(Ev_elem);
+    PetscScalar Efn_gate = nearest_point.interpolation(qfn_elem);
+    PetscScalar Efp_gate = nearest_point.interpolation(qfp_elem);
 
     // fvm_node at semiconductor side
-    const FVM_Node * semiconductor_node = get_region_fvm_node(node_it->first, semiconductor_region);    assert(semiconductor_node);
+    const FVM_Node * semiconductor_node = coupling.semiconductor_node;
     assert(semiconductor_node->on_processor());
     const unsigned int local_offset = semiconductor_node->local_offset();
-    const unsigned int global_offset = semiconductor_node->global_offset();
 
     PetscScalar T_semi = semiconductor_node->node_data()->T();
     PetscScalar Eg_semi = semiconductor_node->node_data()->Eg();
@@ -425,7 +480,7 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_function(PetscScalar * x,
     PetscScalar mh_semi = semiconductor_region->material()->band->EffecHoleMass(T_semi);
 
     // barraier (of conduction band)
-    const FVM_Node * insulator_node = get_region_fvm_node(node_it->first, insulator_region);    assert(insulator_node);
+    const FVM_Node * insulator_node = coupling.insulator_node;
     assert(insulator_node->on_processor());
     PetscScalar Affinity_ins = insulator_node->node_data()->affinity();
     PetscScalar Eg_ins = insulator_node->node_data()->Eg();
@@ -435,7 +490,7 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_function(PetscScalar * x,
     PetscScalar Bv_gate = -e*V_gate - Affinity_ins - Eg_ins;
 
     // the electrical field in insulator
-    double t = (*(semiconductor_node->root_node())-point_injection).size();
+    const double t = coupling.t;
     PetscScalar E_insulator = (V_gate - V_semi)/t;
 
     PetscScalar In_DIR=0.0, Ip_DIR=0.0;
@@ -455,28 +510,27 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_function(PetscScalar * x,
     //std::cout<<"In_DIR " << In_DIR << std::endl;
     //std::cout<<"Ip_DIR " << Ip_DIR << std::endl;
 
-    VecSetValue(f, global_offset+1, -In_DIR, ADD_VALUES);
-    VecSetValue(f, global_offset+2, -Ip_DIR, ADD_VALUES);
+    // values in the order of precomputed rows
+    f_values.clear();
+    f_values.push_back(-In_DIR);
+    f_values.push_back(-Ip_DIR);
 
-    unsigned int n_piece = bc_elem_face->n_nodes();
-    for(unsigned int v=0; v<bc_elem_face->n_nodes(); ++v)
+    unsigned int n_piece = coupling.gate_nodes.size();
+    for(unsigned int v=0; v<coupling.gate_nodes.size(); ++v)
     {
-      const Node * node = bc_elem_face->get_node(v); assert(node->on_local());
-      const FVM_Node * fvm_node = region->region_fvm_node(node);
-
-      const unsigned int global_offset = fvm_node->global_offset();
       if(region->type() == SemiconductorRegion)
       {
-        VecSetValue(f, global_offset+1, In_DIR/n_piece, ADD_VALUES);
-        VecSetValue(f, global_offset+2, Ip_DIR/n_piece, ADD_VALUES);
+        f_values.push_back(In_DIR/n_piece);
+        f_values.push_back(Ip_DIR/n_piece);
       }
       else
       {
         // current in metal region
-        VecSetValue(f, global_offset, (Ip_DIR-In_DIR)/n_piece, ADD_VALUES);
+        f_values.push_back((Ip_DIR-In_DIR)/n_piece);
       }
     }
 
+    VecSetValues(f, coupling.row_index.size(), &coupling.row_index[0], &f_values[0], ADD_VALUES);
   }
 
 
@@ -522,37 +576,28 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_jacobian(PetscScalar * x,
 
   if(!semiconductor_region->advanced_model().TunnelingSelfConsistently) return;
 
-  std::multimap<const Node *, NearestPoint>::const_iterator node_it = _node_nearest_point_map.begin();
-  for(; node_it != _node_nearest_point_map.end(); ++node_it)
+  for(unsigned int c=0; c<_gate_coupling.size(); ++c)
   {
+    const GateCoupling & coupling = _gate_coupling[c];
     // injection end
-    SimulationRegion * region = node_it->second.region;
-    BoundaryCondition * bc = node_it->second.bc;
-    const Elem * bc_elem = node_it->second.elem;
-    const unsigned int bc_elem_face_index = node_it->second.side;
-    const Point & point_injection = node_it->second.p;
-    AutoPtr<Elem> bc_elem_face = bc_elem->build_side(bc_elem_face_index, false);
+    const NearestPoint & nearest_point = *coupling.nearest_point;
+    const SimulationRegion * region = nearest_point.region;
 
-    if(region->type() == SemiconductorRegion)
-      adtl::AutoDScalar::numdir = 3 + 3*bc_elem_face->n_nodes();
-    else
-      adtl::AutoDScalar::numdir = 3 + bc_elem_face->n_nodes();
-
-    std::vector<PetscInt> col_index(adtl::AutoDScalar::numdir);
+    // the stencil is fixed, columns are precomputed
+    adtl::AutoDScalar::numdir = coupling.col_index.size();
+    const PetscInt * col_index = &coupling.col_index[0];
 
     std::vector<AutoDScalar> psi_elem;
     std::vector<AutoDScalar> Ec_elem;
     std::vector<AutoDScalar> Ev_elem;
     std::vector<AutoDScalar> qfn_elem;
     std::vector<AutoDScalar> qfp_elem;
-    for(unsigned int v=0; v<bc_elem_face->n_nodes(); ++v)
+    for(unsigned int v=0; v<coupling.gate_nodes.size(); ++v)
     {
-      const Node * node = bc_elem_face->get_node(v); assert(node->on_local());
-      const FVM_Node * fvm_node = region->region_fvm_node(node);
+      const FVM_Node * fvm_node = coupling.gate_nodes[v];
       const FVM_NodeData * node_data = fvm_node->node_data();
 
       const unsigned int local_offset = fvm_node->local_offset();
-      const unsigned int global_offset = fvm_node->global_offset();
       if(region->type() == SemiconductorRegion)
       {
         AutoDScalar V = x[local_offset+0]; V.setADValue(3 + 3*v +0, 1.0);
@@ -563,10 +608,6 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_jacobian(PetscScalar * x,
         AutoDScalar n = x[local_offset+1]; //n.setADValue(3 + 3*v +1, 1.0);
         AutoDScalar p = x[local_offset+2]; //p.setADValue(3 + 3*v +2, 1.0);
 #endif
-        col_index[3 + 3*v +0] = global_offset + 0;
-        col_index[3 + 3*v +1] = global_offset + 1;
-        col_index[3 + 3*v +2] = global_offset + 2;
-
         psi_elem.push_back(V);
         Ec_elem.push_back(-(e*V + node_data->affinity()) );
         Ev_elem.push_back(-(e*V + node_data->affinity() + node_data->Eg() ));
@@ -576,7 +617,6 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_jacobian(PetscScalar * x,
       else
       {
         AutoDScalar V = x[local_offset];  V.setADValue(3 + v, 1.0);
-        col_index[3 + v] = global_offset;
 
         psi_elem.push_back(V);
         Ec_elem.push_back(-(e*V + node_data->affinity()) );
@@ -586,21 +626,17 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_jacobian(PetscScalar * x,
       }
     }
 
-    AutoDScalar V_gate = bc_elem_face->interpolation(psi_elem, point_injection);
-    AutoDScalar Ec_gate = bc_elem_face->interpolation(Ec_elem, point_injection);
-    AutoDScalar Ev_gate = bc_elem_face->interpolation(Ev_elem, point_injection);
-    AutoDScalar Efn_gate = bc_elem_face->interpolation(qfn_elem, point_injection);
-    AutoDScalar Efp_gate = bc_elem_face->interpolation(qfp_elem, point_injection);
+    AutoDScalar V_gate = nearest_point.interpolation(psi_elem);
+    AutoDScalar Ec_gate = nearest_point.interpolation(Ec_elem);
+    AutoDScalar Ev_gate = nearest_point.interpolation(Ev_elem);
+    AutoDScalar Efn_gate = nearest_point.interpolation(qfn_elem);
+    AutoDScalar Efp_gate = nearest_point.interpolation(qfp_elem);
 
 
     // fvm_node at semiconductor side
-    const FVM_Node * semiconductor_node = get_region_fvm_node(node_it->first, semiconductor_region);    assert(semiconductor_node);
+    const FVM_Node * semiconductor_node = coupling.semiconductor_node;
     assert(semiconductor_node->on_processor());
     const unsigned int local_offset = semiconductor_node->local_offset();
-    const unsigned int global_offset = semiconductor_node->global_offset();
-    col_index[0] = global_offset + 0;
-    col_index[1] = global_offset + 1;
-    col_index[2] = global_offset + 2;
 
     PetscScalar T_semi = semiconductor_node->node_data()->T();
     PetscScalar Eg_semi = semiconductor_node->node_data()->Eg();
@@ -621,7 +657,7 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_jacobian(PetscScalar * x,
     PetscScalar mh_semi = semiconductor_region->material()->band->EffecHoleMass(T_semi);
 
     // barraier (of conduction band)
-    const FVM_Node * insulator_node = get_region_fvm_node(node_it->first, insulator_region);    assert(insulator_node);
+    const FVM_Node * insulator_node = coupling.insulator_node;
     assert(insulator_node->on_processor());
     PetscScalar Affinity_ins = insulator_node->node_data()->affinity();
     PetscScalar Eg_ins = insulator_node->node_data()->Eg();
@@ -633,7 +669,7 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_jacobian(PetscScalar * x,
 
 
     // the electrical field in insulator
-    double t = (*(semiconductor_node->root_node())-point_injection).size();
+    const double t = coupling.t;
     AutoDScalar E_insulator = (V_gate - V_semi)/t;
 
 
@@ -650,33 +686,24 @@ void InsulatorSemiconductorInterfaceBC::_gate_current_jacobian(PetscScalar * x,
     //std::cout<<"In_DIR " << In_DIR << std::endl;
     //std::cout<<"Ip_DIR " << Ip_DIR << std::endl;
 
-    PetscInt fn_index = global_offset + 1;
-    jac->add_row(fn_index, adtl::AutoDScalar::numdir, &col_index[0], (-In_DIR).getADValue());
-
-    PetscInt fp_index = global_offset + 2;
-    jac->add_row(fp_index, adtl::AutoDScalar::numdir, &col_index[0], (-Ip_DIR).getADValue());
+    const PetscInt * row_index = &coupling.row_index[0];
+    const int numdir = adtl::AutoDScalar::numdir;
+    jac->add_row(row_index[0], numdir, col_index, (-In_DIR).getADValue());
+    jac->add_row(row_index[1], numdir, col_index, (-Ip_DIR).getADValue());
 
-    unsigned int n_piece = bc_elem_face->n_nodes();
-    for(unsigned int v=0; v<bc_elem_face->n_nodes(); ++v)
+    unsigned int n_piece = coupling.gate_nodes.size();
+    for(unsigned int v=0; v<coupling.gate_nodes.size(); ++v)
     {
-      const Node * node = bc_elem_face->get_node(v); assert(node->on_local());
-      const FVM_Node * fvm_node = region->region_fvm_node(node);
-
-      const unsigned int global_offset = fvm_node->global_offset();
       if(region->type() == SemiconductorRegion)
       {
-        PetscInt fn_index = global_offset + 1;
-        jac->add_row(fn_index, adtl::AutoDScalar::numdir, &col_index[0], (In_DIR/n_piece).getADValue());
-
-        PetscInt fp_index = global_offset + 2;
-        jac->add_row(fp_index, adtl::AutoDScalar::numdir, &col_index[0], (Ip_DIR/n_piece).getADValue());
+        jac->add_row(row_index[2 + 2*v + 0], numdir, col_index, (In_DIR/n_piece).getADValue());
+        jac->add_row(row_index[2 + 2*v + 1], numdir, col_index, (Ip_DIR/n_piece).getADValue());
       }
       else
       {
         // current in metal region
-        PetscInt f_index = global_offset;
         AutoDScalar I = (Ip_DIR-In_DIR)/n_piece;
-        jac->add_row(f_index, adtl::AutoDScalar::numdir, &col_index[0], I.getADValue());
+        jac->add_row(row_index[2 + v], numdir, col_index, I.getADValue());
       }
     }
 
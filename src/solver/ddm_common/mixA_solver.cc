@@ -1555,11 +1555,14 @@ int MixASolverBase::solve_transient()
 #if PETSC_VERSION_GE(3, 6, 0)
   #include <petsc/private/snesimpl.h>
 #endif
-void MixASolverBase::petsc_snes_convergence_test(PetscInt its, PetscReal , PetscReal pnorm, PetscReal fnorm, SNESConvergedReason *reason)
+void MixASolverBase::petsc_snes_convergence_test(PetscInt its, PetscReal xnorm, PetscReal pnorm, PetscReal fnorm, SNESConvergedReason *reason)
 {
   // update error norm
   this->error_norm();
 
+  // frozen or full coefficients in the next jacobian
+  this->update_lagged_coefficient(its, xnorm, pnorm);
+
   *reason = SNES_CONVERGED_ITERATING;
 
   // the first iteration
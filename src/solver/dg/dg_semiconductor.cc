@@ -27,6 +27,7 @@
 #include "semiconductor_region.h"
 #include "solver_specify.h"
 #include "log.h"
+#include "scratch_vector.h"
 
 #include "jflux1q.h"
 
@@ -811,7 +812,7 @@ void SemiconductorSimulationRegion::DG_Jacobian(PetscScalar * x, SparseMatrix<Pe
     mt->set_ad_num(adtl::AutoDScalar::numdir);
 
     // indicate the column position of the variables in the matrix
-    std::vector<PetscInt> cell_col;
+    ScratchVector<PetscInt> cell_col;
     cell_col.reserve(n_variables*elem->n_nodes());
     for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
     {
@@ -839,9 +840,9 @@ void SemiconductorSimulationRegion::DG_Jacobian(PetscScalar * x, SparseMatrix<Pe
       // which are the vector of electric field and current density.
       // here use type AutoDScalar, we should make sure the order of independent variable keeps the
       // same all the time
-      std::vector<AutoDScalar> psi_vertex;
-      std::vector<AutoDScalar> phin_vertex;
-      std::vector<AutoDScalar> phip_vertex;
+      ScratchVector<AutoDScalar> psi_vertex;
+      ScratchVector<AutoDScalar> phin_vertex;
+      ScratchVector<AutoDScalar> phip_vertex;
 
       for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
       {
@@ -892,8 +893,8 @@ void SemiconductorSimulationRegion::DG_Jacobian(PetscScalar * x, SparseMatrix<Pe
       if(get_advanced_model()->ESurface && insulator_interface_elem)
       {
         // get all the sides on insulator interface
-        std::vector<unsigned int> sides;
-        std::vector<SimulationRegion *> regions;
+        ScratchVector<unsigned int> sides;
+        ScratchVector<SimulationRegion *> regions;
         elem_on_insulator_interface(elem, sides, regions);
 
         VectorValue<AutoDScalar> E_insul(0.0,0.0,0.0);
@@ -906,7 +907,7 @@ void SemiconductorSimulationRegion::DG_Jacobian(PetscScalar * x, SparseMatrix<Pe
         {
           const Elem * elem_neighbor = elem->neighbor(sides[ne]);
 
-          std::vector<AutoDScalar> psi_vertex_neighbor;
+          ScratchVector<AutoDScalar> psi_vertex_neighbor;
           for(unsigned int nd=0; nd<elem_neighbor->n_nodes(); ++nd)
           {
             const FVM_Node * fvm_node_neighbor = elem_neighbor->get_fvm_node(nd);
@@ -1027,7 +1028,7 @@ void SemiconductorSimulationRegion::DG_Jacobian(PetscScalar * x, SparseMatrix<Pe
       const unsigned int n2_local_offset = fvm_n2->local_offset();
 
       // the row position of variables in the matrix
-      std::vector<PetscInt> row;
+      ScratchVector<PetscInt> row;
       for(unsigned int i=0; i<n_variables; ++i) row.push_back(fvm_n1->global_offset()+i);
       for(unsigned int i=0; i<n_variables; ++i) row.push_back(fvm_n2->global_offset()+i);
 
@@ -1306,7 +1307,7 @@ void SemiconductorSimulationRegion::DG_Jacobian(PetscScalar * x, SparseMatrix<Pe
     const FVM_NodeData * node_data = fvm_node->node_data();
     unsigned int local_offset = fvm_node->local_offset();
 
-    std::vector<PetscInt> index;
+    ScratchVector<PetscInt> index;
     for(unsigned int n=0; n<n_variables; n++)
       index.push_back(fvm_node->global_offset()+n);
 
@@ -865,36 +865,102 @@ void DopingAnalytic::set_doping_function_analytic2_poly_mask(const Parser::Card
 }
 
 
+/**
+ * collect the local nodes of region which fall into the box [pmin, pmax] (no box when has_box is false),
+ * and evaluate doping function at these nodes in one batch
+ */
+static void _doping_function_batch(DopingFunction * df, SimulationRegion * region,
+                                   bool has_box, const Point &pmin, const Point &pmax,
+                                   std::vector<FVM_NodeData *> &nodes, std::vector<double> &d)
+{
+  nodes.clear();
+  d.clear();
+
+  std::vector<double> x, y, z;
+  x.reserve(region->n_node());
+  y.reserve(region->n_node());
+  z.reserve(region->n_node());
+  nodes.reserve(region->n_node());
+
+  SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
+  SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
+  for(; node_it!=node_it_end; ++node_it)
+  {
+    FVM_Node * fvm_node = *node_it;
+    FVM_NodeData * node_data = fvm_node->node_data();
+    genius_assert(node_data!=NULL);
+
+    const Node * node = fvm_node->root_node();
+    if( has_box )
+    {
+      if( (*node)(0) < pmin(0) || (*node)(0) > pmax(0) ) continue;
+      if( (*node)(1) < pmin(1) || (*node)(1) > pmax(1) ) continue;
+      if( (*node)(2) < pmin(2) || (*node)(2) > pmax(2) ) continue;
+    }
+
+    nodes.push_back(node_data);
+    x.push_back((*node)(0));
+    y.push_back((*node)(1));
+    z.push_back((*node)(2));
+  }
+
+  if( nodes.empty() ) return;
+
+  d.resize(nodes.size());
+  df->profile_batch(nodes.size(), &x[0], &y[0], &z[0], &d[0]);
+}
+
+
+/**
+ * @return false when region has no overlap with box [pmin, pmax]
+ */
+static bool _region_overlap(SimulationRegion * region, const Point &pmin, const Point &pmax)
+{
+  std::pair<Point, Point> bbox = region->boundingbox();
+  for(unsigned int i=0; i<3; ++i)
+    if( bbox.first(i) > pmax(i) || bbox.second(i) < pmin(i) ) return false;
+  return true;
+}
+
+
 void DopingAnalytic::_doping_function_apply(DopingFunction * df, const std::string &region_app)
 {
+  Point pmin, pmax;
+  bool has_box = df->bound_box(pmin, pmax);
+
+  std::vector<FVM_NodeData *> nodes;
+  std::vector<double> d;
+
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
     if(region->type() != SemiconductorRegion) continue;
     if( !region_app.empty() && region->name()!=region_app) continue;
-        
-    SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
-    SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
-    for(; node_it!=node_it_end; ++node_it)
-    {
-      FVM_Node * fvm_node = *node_it;
-      FVM_NodeData * node_data = fvm_node->node_data();
-      genius_assert(node_data!=NULL);
+    // doping function vanishes in this region
+    if( has_box && !_region_overlap(region, pmin, pmax) ) continue;
 
-      const Node * node = fvm_node->root_node();
-      double d = df->profile((*node)(0),(*node)(1),(*node)(2));
-      double dop_Na = std::abs(d < 0.0 ? d: 0.0);  
-      double dop_Nd = std::abs(d > 0.0 ? d: 0.0);  
+    _doping_function_batch(df, region, has_box, pmin, pmax, nodes, d);
 
-      node_data->Na() += dop_Na;
-      node_data->Nd() += dop_Nd;
-    }  
+    for(unsigned int i=0; i<nodes.size(); ++i)
+    {
+      double dop_Na = std::abs(d[i] < 0.0 ? d[i]: 0.0);
+      double dop_Nd = std::abs(d[i] > 0.0 ? d[i]: 0.0);
+
+      nodes[i]->Na() += dop_Na;
+      nodes[i]->Nd() += dop_Nd;
+    }
   }
 }
 
 
 void DopingAnalytic::_custom_profile_function_apply(const std::string &ion, DopingFunction * df, const std::string &region_app)
 {
+  Point pmin, pmax;
+  bool has_box = df->bound_box(pmin, pmax);
+
+  std::vector<FVM_NodeData *> nodes;
+  std::vector<double> d;
+
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
@@ -903,24 +969,25 @@ void DopingAnalytic::_custom_profile_function_apply(const std::string &ion, Dopi
     SemiconductorSimulationRegion * semiconductor_region = dynamic_cast<SemiconductorSimulationRegion *>(region);
     unsigned int ion_index = region->add_variable(SimulationVariable(ion, SCALAR, POINT_CENTER, "cm^-3", invalid_uint, true, true));
     int ion_type = semiconductor_region ? semiconductor_region->material()->band->IonType(ion) : 0;
-    
+
+    // set the profile to zero, nodes inside the doping box will be overwritten later
     SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
     SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
     for(; node_it!=node_it_end; ++node_it)
-    {
-      FVM_Node * fvm_node = *node_it;
-      FVM_NodeData * node_data = fvm_node->node_data();
-      genius_assert(node_data!=NULL);
+      (*node_it)->node_data()->data<PetscScalar>(ion_index) = 0.0;
 
-      const Node * node = fvm_node->root_node();
-      double d = df->profile((*node)(0),(*node)(1),(*node)(2));
-      
-      node_data->data<PetscScalar>(ion_index) = d;
-      if(ion_type < 0 ) node_data->Na() += d;
-      if(ion_type > 0 ) node_data->Nd() += d;
-    }  
+    if( has_box && !_region_overlap(region, pmin, pmax) ) continue;
+
+    _doping_function_batch(df, region, has_box, pmin, pmax, nodes, d);
+
+    for(unsigned int i=0; i<nodes.size(); ++i)
+    {
+      nodes[i]->data<PetscScalar>(ion_index) = d[i];
+      if(ion_type < 0 ) nodes[i]->Na() += d[i];
+      if(ion_type > 0 ) nodes[i]->Nd() += d[i];
+    }
   }
-  
+
 }
 
 
@@ -9,6 +9,16 @@
 
 using PhysicalUnit::um;
 
+
+//------------------------------------------------------------------
+
+void DopingFunction::profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *d)
+{
+  for(unsigned int i=0; i<n; ++i)
+    d[i] = profile(x[i], y[i], z[i]);
+}
+
+
 //------------------------------------------------------------------
 
 double UniformDopingFunction::profile(double x,double y,double z)
@@ -22,6 +32,28 @@ double UniformDopingFunction::profile(double x,double y,double z)
 }
 
 
+void UniformDopingFunction::profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *d)
+{
+  const double xmin = _xmin-1e-6*um, xmax = _xmax+1e-6*um;
+  const double ymin = _ymin-1e-6*um, ymax = _ymax+1e-6*um;
+  const double zmin = _zmin-1e-6*um, zmax = _zmax+1e-6*um;
+  const double v = _ion*_peak;
+  for(unsigned int i=0; i<n; ++i)
+  {
+    bool in = x[i] >= xmin && x[i] <= xmax && y[i] >= ymin && y[i] <= ymax && z[i] >= zmin && z[i] <= zmax;
+    d[i] = in ? v : 0.0;
+  }
+}
+
+
+bool UniformDopingFunction::bound_box(Point &pmin, Point &pmax) const
+{
+  pmin = Point(_xmin-1e-6*um, _ymin-1e-6*um, _zmin-1e-6*um);
+  pmax = Point(_xmax+1e-6*um, _ymax+1e-6*um, _zmax+1e-6*um);
+  return true;
+}
+
+
 //------------------------------------------------------------------
 
 
@@ -54,63 +86,82 @@ double LinearDopingFunction::profile(double x,double y,double z)
 }
 
 
+bool LinearDopingFunction::bound_box(Point &pmin, Point &pmax) const
+{
+  pmin = Point(_xmin-1e-6*um, _ymin-1e-6*um, _zmin-1e-6*um);
+  pmax = Point(_xmax+1e-6*um, _ymax+1e-6*um, _zmax+1e-6*um);
+  return true;
+}
+
+
 //------------------------------------------------------------------
 
 /**
- * compute doping concentration by point location
+ * the distribution factor along one direction
  */
-double AnalyticDopingFunction::profile(double x, double y, double z)
+inline double AnalyticDopingFunction::_factor(double x, double xmin, double xmax, double xchar, bool xerfc)
 {
-  double dx, dy, dz;
-  if ( _XERFC )
+  if ( xerfc )
 #ifdef WINDOWS
-    dx = (Erfc((x-_xmax)/_XCHAR)-Erfc((x-_xmin)/_XCHAR))/2.0;
+    return (Erfc((x-xmax)/xchar)-Erfc((x-xmin)/xchar))/2.0;
 #else
-    dx = (erfc((x-_xmax)/_XCHAR)-erfc((x-_xmin)/_XCHAR))/2.0;
+    return (erfc((x-xmax)/xchar)-erfc((x-xmin)/xchar))/2.0;
 #endif
-  else
-  {
-    if(x<_xmin)
-      dx = exp(-(x-_xmin)*(x-_xmin)/(_XCHAR*_XCHAR));
-    else if(x>=_xmin&&x<=_xmax)
-      dx = 1.0;
-    else
-      dx = exp(-(x-_xmax)*(x-_xmax)/(_XCHAR*_XCHAR));
-  }
 
-  if ( _YERFC )
-#ifdef WINDOWS
-    dy = (Erfc((y-_ymax)/_YCHAR)-Erfc((y-_ymin)/_YCHAR))/2.0;
-#else
-    dy = (erfc((y-_ymax)/_YCHAR)-erfc((y-_ymin)/_YCHAR))/2.0;
+  // distance to [xmin, xmax], written as select instead of branch.
+  // inside the box the factor is exactly 1, even for zero characteristic length
+  double t = x<xmin ? x-xmin : (x>xmax ? x-xmax : 0.0);
+  return t==0.0 ? 1.0 : exp(-t*t/(xchar*xchar));
+}
+
+
+/**
+ * compute doping concentration by point location
+ */
+double AnalyticDopingFunction::profile(double x, double y, double z)
+{
+  double dx = _factor(x, _xmin, _xmax, _XCHAR, _XERFC);
+  double dy = _factor(y, _ymin, _ymax, _YCHAR, _YERFC);
+  double dz = _factor(z, _zmin, _zmax, _ZCHAR, _ZERFC);
+  return _ion*_peak*dx*dy*dz;
+}
+
+
+/**
+ * compute doping concentration by point location
+ */
+void AnalyticDopingFunction::profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *d)
+{
+  const int N = static_cast<int>(n);
+
+  // x direction, also initialize d
+#ifdef HAVE_OPENMP
+  #pragma omp parallel for
 #endif
-  else
-  {
-    if(y<_ymin)
-      dy = exp(-(y-_ymin)*(y-_ymin)/(_YCHAR*_YCHAR));
-    else if(y>=_ymin&&y<=_ymax)
-      dy = 1.0;
-    else
-      dy = exp(-(y-_ymax)*(y-_ymax)/(_YCHAR*_YCHAR));
-  }
+  for(int i=0; i<N; ++i)
+    d[i] = _ion*_peak*_factor(x[i], _xmin, _xmax, _XCHAR, _XERFC);
 
-  if ( _ZERFC )
-#ifdef WINDOWS
-    dz = (Erfc((z-_zmax)/_ZCHAR)-Erfc((z-_zmin)/_ZCHAR))/2.0;
-#else
-    dz = (erfc((z-_zmax)/_ZCHAR)-erfc((z-_zmin)/_ZCHAR))/2.0;
+  // y direction
+#ifdef HAVE_OPENMP
+  #pragma omp parallel for
 #endif
-  else
-  {
-    if(z<_zmin)
-      dz = exp(-(z-_zmin)*(z-_zmin)/(_ZCHAR*_ZCHAR));
-    else if(z>=_zmin&&z<=_zmax)
-      dz = 1.0;
-    else
-      dz = exp(-(z-_zmax)*(z-_zmax)/(_ZCHAR*_ZCHAR));
-  }
+  for(int i=0; i<N; ++i)
+    d[i] *= _factor(y[i], _ymin, _ymax, _YCHAR, _YERFC);
 
-  return _ion*_peak*dx*dy*dz;
+  // z direction
+#ifdef HAVE_OPENMP
+  #pragma omp parallel for
+#endif
+  for(int i=0; i<N; ++i)
+    d[i] *= _factor(z[i], _zmin, _zmax, _ZCHAR, _ZERFC);
+}
+
+
+bool AnalyticDopingFunction::bound_box(Point &pmin, Point &pmax) const
+{
+  pmin = Point(_xmin-7*_XCHAR, _ymin-7*_YCHAR, _zmin-7*_ZCHAR);
+  pmax = Point(_xmax+7*_XCHAR, _ymax+7*_YCHAR, _zmax+7*_ZCHAR);
+  return true;
 }
 
 
@@ -126,19 +177,63 @@ PolyMaskDopingFunction::PolyMaskDopingFunction(double ion, const std::vector<Poi
     // doping line direction
   double deg = 3.14159265359/180.0;
   _dir = Point( sin(theta*deg)*cos(phi*deg), cos(theta*deg), sin(theta*deg)*sin(phi*deg));
+
+  // doping bounding box, the mask polygon swept along doping line,
+  // extended by the lateral range of doping line
+  const double r1 = _rmin - 5*_char_lateral;
+  const double r2 = _rmax + 5*_char_lateral;
+  const double ext = 10*_char_lateral;
+  _doping_min = Point( 1e30,  1e30,  1e30);
+  _doping_max = Point(-1e30, -1e30, -1e30);
+  for(unsigned int n=0; n<poly.size(); ++n)
+  {
+    Point p1 = poly[n] + _dir*r1;
+    Point p2 = poly[n] + _dir*r2;
+    for(unsigned int d=0; d<3; ++d)
+    {
+      _doping_min(d) = std::min(_doping_min(d), std::min(p1(d), p2(d)) - ext);
+      _doping_max(d) = std::max(_doping_max(d), std::max(p1(d), p2(d)) + ext);
+    }
+  }
 }
 
 
 
 double PolyMaskDopingFunction::profile(double x, double y, double z)
 {
-  Point p(x, y, z); // doping point
   Plane mask_plane = _mask_mesh.plane(); // mask plane
+  return _profile(Point(x, y, z), mask_plane.point(), mask_plane.normal(), prof_func_lnorm());
+}
+
+
+void PolyMaskDopingFunction::profile_batch(unsigned int n, const double *x, const double *y, const double *z, double *d)
+{
+  // evaluate the mask plane only once
+  Plane mask_plane = _mask_mesh.plane();
+  const Point  plane_point = mask_plane.point();
+  const Point  plane_norm = mask_plane.normal();
+  const double A = prof_func_lnorm();
+
+#ifdef HAVE_OPENMP
+  #pragma omp parallel for schedule(dynamic, 64)
+#endif
+  for(int i=0; i<static_cast<int>(n); ++i)
+    d[i] = _profile(Point(x[i], y[i], z[i]), plane_point, plane_norm, A);
+}
+
+
+bool PolyMaskDopingFunction::bound_box(Point &pmin, Point &pmax) const
+{
+  pmin = _doping_min;
+  pmax = _doping_max;
+  return true;
+}
+
+
+double PolyMaskDopingFunction::_profile(const Point &p, const Point &plane_point, const Point &plane_norm, double A) const
+{
   Point point_on_plane;
   {
-    Point  plane_point = mask_plane.point();
-    Point  plane_norm = mask_plane.normal();
-
     double t = (plane_point - p)*plane_norm/(plane_norm*_dir);
     point_on_plane = p + _dir*t;
   }
@@ -147,8 +242,6 @@ double PolyMaskDopingFunction::profile(double x, double y, double z)
   if( r > _rmax + 5*_char_lateral || r < _rmin - 5*_char_lateral ) return 0.0;
 
   double profile = 0.0;
-  const double A = prof_func_lnorm();
-  std::vector<double> vecr, vecl;   // array of range/lateral coordinates
 
   // if point outside the doping box, skip
   typedef std::pair<unsigned int, unsigned int> Idx;
@@ -168,54 +261,31 @@ double PolyMaskDopingFunction::profile(double x, double y, double z)
     double r = (project_p - loc)*_dir;
     double dist = (project_p - p).size();
 
-    vecr.push_back(r);
-    vecl.push_back(dist);
-  }
-
-  std::vector<double> vecfr = prof_func_r(vecr);
-  std::vector<double> vecfl = prof_func_l(vecl);
-
-  for (size_t i=0; i<vecfr.size(); ++i)
-  {
-    profile += A*vecfr[i]*vecfl[i];
+    profile += A*prof_func_r(r)*prof_func_l(dist);
   }
 
   return _ion*profile;
 }
 
 
-std::vector<double> PolyMaskDopingFunction::prof_func_r(const std::vector<double> &rs) const
+double PolyMaskDopingFunction::prof_func_r(double r) const
 {
-  std::vector<double> res;
-  for (std::vector<double>::const_iterator i=rs.begin(); i!=rs.end(); i++)
-  {
-    const double r = *i;
-
-    double dr;
-    if(r<_rmin)
-      dr = exp(-(r-_rmin)*(r-_rmin)/(_char_depth*_char_depth));
-    else if(r<=_rmax)
-      dr = 1.0;
-    else
-      dr = exp(-(r-_rmax)*(r-_rmax)/(_char_depth*_char_depth));
+  double dr;
+  if(r<_rmin)
+    dr = exp(-(r-_rmin)*(r-_rmin)/(_char_depth*_char_depth));
+  else if(r<=_rmax)
+    dr = 1.0;
+  else
+    dr = exp(-(r-_rmax)*(r-_rmax)/(_char_depth*_char_depth));
 
-    res.push_back(_peak*dr);
-  }
-  return res;
+  return _peak*dr;
 }
 
-std::vector<double> PolyMaskDopingFunction::prof_func_l(const std::vector<double> &dists) const
+double PolyMaskDopingFunction::prof_func_l(double dist) const
 {
-  std::vector<double> res;
-  for (std::vector<double>::const_iterator i=dists.begin(); i!=dists.end(); i++)
-  {
-    const double dist = *i;
-    if (dist==0.0)
-      res.push_back(1.0);
-    else
-      res.push_back( exp( -dist*dist/(_char_lateral*_char_lateral) ) );
-  }
-  return res;
+  if (dist==0.0)
+    return 1.0;
+  return exp( -dist*dist/(_char_lateral*_char_lateral) );
 }
 
 double PolyMaskDopingFunction::prof_func_lnorm() const
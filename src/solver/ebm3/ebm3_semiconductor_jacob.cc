@@ -25,6 +25,7 @@
 #include "semiconductor_region.h"
 #include "solver_specify.h"
 #include "log.h"
+#include "scratch_vector.h"
 
 #include "jflux1.h"
 #include "jflux2.h"
@@ -82,7 +83,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
     mt->set_ad_num(adtl::AutoDScalar::numdir);
 
     // indicate the column position of the variables in the matrix
-    std::vector<PetscInt> cell_col;
+    ScratchVector<PetscInt> cell_col;
     for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
     {
       const FVM_Node * fvm_node = elem->get_fvm_node(nd);
@@ -108,9 +109,9 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
       // which are the vector of electric field and current density.
       // here use type AutoDScalar, we should make sure the order of independent variable keeps the
       // same all the time
-      std::vector<AutoDScalar> psi_vertex;
-      std::vector<AutoDScalar> phin_vertex;
-      std::vector<AutoDScalar> phip_vertex;
+      ScratchVector<AutoDScalar> psi_vertex;
+      ScratchVector<AutoDScalar> phin_vertex;
+      ScratchVector<AutoDScalar> phip_vertex;
 
       for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
       {
@@ -162,8 +163,8 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
       if(get_advanced_model()->ESurface && insulator_interface_elem)
       {
         // get all the sides on insulator interface
-        std::vector<unsigned int> sides;
-        std::vector<SimulationRegion *> regions;
+        ScratchVector<unsigned int> sides;
+        ScratchVector<SimulationRegion *> regions;
         elem_on_insulator_interface(elem, sides, regions);
 
         VectorValue<AutoDScalar> E_insul(0.0,0.0,0.0);
@@ -176,7 +177,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
         {
           const Elem * elem_neighbor = elem->neighbor(sides[ne]);
 
-          std::vector<AutoDScalar> psi_vertex_neighbor;
+          ScratchVector<AutoDScalar> psi_vertex_neighbor;
           for(unsigned int nd=0; nd<elem_neighbor->n_nodes(); ++nd)
           {
             const FVM_Node * fvm_node_neighbor = elem_neighbor->get_fvm_node(nd);
@@ -295,7 +296,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
       unsigned int n2_local_offset = fvm_n2->local_offset();
 
       // the row position of variables in the matrix
-      std::vector<PetscInt> row1, row2;
+      ScratchVector<PetscInt> row1, row2;
       for(unsigned int nv=0; nv<n_node_var; ++nv)  row1.push_back( fvm_n1->global_offset()+nv );
       for(unsigned int nv=0; nv<n_node_var; ++nv)  row2.push_back( fvm_n2->global_offset()+nv );
 
@@ -733,7 +734,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, SparseMatrix<
     const FVM_NodeData * node_data = fvm_node->node_data();
 
 
-    std::vector<PetscInt> index;
+    ScratchVector<PetscInt> index;
     for(unsigned int nv=0; nv<n_node_var; ++nv)  index.push_back( fvm_node->global_offset()+nv );
 
     AutoDScalar V = x[fvm_node->local_offset() + node_psi_offset];
@@ -23,6 +23,7 @@
 #include <sstream>
 
 #include "mesh_base.h"
+#include "field_source.h"
 #include "emfem2d/emfem2d.h"
 #include "petsc_type.h"
 #include "fe_type.h"
@@ -133,6 +134,9 @@ int EMFEM2DSolver::solve()
 
   }
 
+  // OptG was written directly, the generation cached by field source is stale
+  _system.get_field_source()->invalidate_generation();
+
   STOP_LOG("EM FEM 2D Linear Solver", "solve");
 #endif
   return 0;
@@ -223,9 +227,10 @@ void EMFEM2DSolver::build_TE_matrix_rhs(double lambda, double power, double phas
   const unsigned int dim = mesh.mesh_dimension();
   genius_assert(dim==2);
 
-  // the integral order used in gauss intergral. default value= 2*fe_order+1
-  Order int_order=SECOND;
+  // the integral order used in gauss intergral. the mass term phi*phi of
+  // the straight sided elements needs 2*fe_order
   FEType fe_type;
+  Order int_order=fe_type.affine_quadrature_order();
 
   VecZeroEntries(x);
   VecZeroEntries(b);
@@ -428,9 +433,10 @@ void EMFEM2DSolver::build_TM_matrix_rhs(double lambda, double power, double phas
   const unsigned int dim = mesh.mesh_dimension();
   genius_assert(dim==2);
 
-  // the integral order used in gauss intergral. default value= 2*fe_order+1
-  Order int_order=SECOND;
+  // the integral order used in gauss intergral. the mass term phi*phi of
+  // the straight sided elements needs 2*fe_order
   FEType fe_type;
+  Order int_order=fe_type.affine_quadrature_order();
 
   VecZeroEntries(x);
   VecZeroEntries(b);
@@ -25,7 +25,9 @@
 
 #include "fvm_flex_nonlinear_solver.h"
 #include "parallel.h"
+#include "petsc_utils.h"
 #include "petsc_matrix.h"
+#include "klu_solver.h"
 
 #ifdef HAVE_SLEPC
 #include "slepceps.h"
@@ -170,9 +172,9 @@ extern "C"
  * constructor, setup context
  */
 FVM_FlexNonlinearSolver::FVM_FlexNonlinearSolver(SimulationSystem & system)
-: FVM_FlexPDESolver(system), jacobian_matrix_first_assemble(false), Jac(0)
+: FVM_FlexPDESolver(system), jacobian_matrix_first_assemble(false), Jac(0), lx_source(PETSC_NULL), lx_source_state(0)
 {
-
+  klu = new KLUSolver;
 }
 
 
@@ -225,6 +227,16 @@ void FVM_FlexNonlinearSolver::setup_nonlinear_data()
   Jac = new PetscMatrix<PetscScalar>(n_global_dofs, n_global_dofs, n_local_dofs, n_local_dofs);
   J = dynamic_cast<PetscMatrix<PetscScalar> *>(Jac)->mat();
 
+  // the first assembly is buffered in the jacobian pattern known from the mesh
+  {
+    START_LOG("build_sparsity_pattern()", "FVM_FlexNonlinearSolver");
+    SparsityPattern pattern(n_global_dofs, n_local_dofs, global_offset);
+    build_sparsity_pattern(pattern);
+    pattern.build();
+    dynamic_cast<PetscMatrix<PetscScalar> *>(Jac)->set_sparsity_pattern(pattern);
+    STOP_LOG("build_sparsity_pattern()", "FVM_FlexNonlinearSolver");
+  }
+
 
   // create petsc nonlinear solver context
   ierr = SNESCreate(PETSC_COMM_WORLD, &snes); genius_assert(!ierr);
@@ -393,11 +405,36 @@ void FVM_FlexNonlinearSolver::destroy_vector(Vec &vec)
 }
 
 
+/*------------------------------------------------------------------
+ * scatter global vector to lx, skip when lx is up to date
+ */
+void FVM_FlexNonlinearSolver::scatter_local_solution(Vec v)
+{
+#if PETSC_VERSION_GE(3,5,0)
+  PetscObjectState state;
+  PetscObjectStateGet((PetscObject)v, &state);
+#else
+  PetscInt state;
+  PetscObjectStateQuery((PetscObject)v, &state);
+#endif
+
+  if( v == lx_source && state == lx_source_state ) return;
+
+  VecScatterBegin(scatter, v, lx, INSERT_VALUES, SCATTER_FORWARD);
+  VecScatterEnd  (scatter, v, lx, INSERT_VALUES, SCATTER_FORWARD);
+
+  lx_source = v;
+  lx_source_state = state;
+}
+
+
 /*------------------------------------------------------------------
  * destroy nonlinear data
  */
 void FVM_FlexNonlinearSolver::clear_nonlinear_data()
 {
+  lx_source = PETSC_NULL;
+
   PetscErrorCode ierr;
   // free everything
   ierr = VecDestroy(PetscDestroyObject(x));                 genius_assert(!ierr);
@@ -412,6 +449,9 @@ void FVM_FlexNonlinearSolver::clear_nonlinear_data()
   ierr = MatDestroy(PetscDestroyObject(J));                 genius_assert(!ierr);
   ierr = SNESDestroy(PetscDestroyObject(snes));             genius_assert(!ierr);
 
+  // free KLU factorization
+  klu->clear();
+
   // clear petsc options
   std::map<std::string, std::string>::const_iterator it = petsc_options.begin();
   for(; it != petsc_options.end(); ++it)
@@ -419,12 +459,41 @@ void FVM_FlexNonlinearSolver::clear_nonlinear_data()
 }
 
 
+/*------------------------------------------------------------------
+ * keep nonlinear data for the next SOLVE card
+ */
+void FVM_FlexNonlinearSolver::suspend_nonlinear_data()
+{
+  // set_petsc_option() skips the options already exist, clear them
+  // so that the next SOLVE card can set them again
+  std::map<std::string, std::string>::const_iterator it = petsc_options.begin();
+  for(; it != petsc_options.end(); ++it)
+    PetscOptionsClearValue(it->first.c_str());
+  petsc_options.clear();
+}
+
+
+/*------------------------------------------------------------------
+ * reuse nonlinear data of last SOLVE card
+ */
+void FVM_FlexNonlinearSolver::resume_nonlinear_data()
+{
+  // the solution vector will be reloaded, do not trust the scattered local copy
+  lx_source = PETSC_NULL;
+
+  set_petsc_nonelinear_solver_type();
+  set_petsc_linear_solver_type ();
+  set_petsc_preconditioner_type();
+}
+
+
 /*------------------------------------------------------------------
  * destructor: destroy context
  */
 FVM_FlexNonlinearSolver::~FVM_FlexNonlinearSolver()
 {
   delete Jac;
+  delete klu;
 }
 
 
@@ -664,6 +733,20 @@ void FVM_FlexNonlinearSolver::set_petsc_linear_solver_type()
       MESSAGE<< "Using CHEBYSHEV linear solver..."<<std::endl;  RECORD();
       ierr = KSPSetType (ksp, "chebyshev");  genius_assert(!ierr); return;
 
+      case SolverSpecify::KLU:
+      if (Genius::n_processors()>1)
+      {
+        MESSAGE<< "Warning:  KLU can not be used in parallel, use BCGS(l) instead!" << std::endl;
+        RECORD();
+        ierr = KSPSetType (ksp, (char*) KSPBCGSL);  genius_assert(!ierr);
+        ierr = PCSetType (pc, (char*) PCASM);       genius_assert(!ierr);
+        return;
+      }
+      MESSAGE<< "Using KLU linear solver..."<<std::endl;  RECORD();
+      ierr = KSPSetType (ksp, (char*) KSPPREONLY); genius_assert(!ierr);
+      ierr = klu->set_pc_shell(pc); genius_assert(!ierr);
+      return;
+
       case SolverSpecify::LU:
       case SolverSpecify::UMFPACK:
       case SolverSpecify::SuperLU:
@@ -840,7 +923,8 @@ void FVM_FlexNonlinearSolver::set_petsc_preconditioner_type()
       _linear_solver_type == SolverSpecify::SuperLU ||
       _linear_solver_type == SolverSpecify::MUMPS   ||
       _linear_solver_type == SolverSpecify::PASTIX  ||
-      _linear_solver_type == SolverSpecify::SuperLU_DIST
+      _linear_solver_type == SolverSpecify::SuperLU_DIST ||
+      _linear_solver_type == SolverSpecify::KLU
      )
   {
     return;
@@ -1157,8 +1241,8 @@ void FVM_FlexNonlinearSolver::snes_solve()
 
   // do snes solve
   SNESSolve ( snes, PETSC_NULL, x );
+  PetscUtils::SNESCountIterations(snes);
 
-  
   STOP_LOG("sens_solve()", "FVM_FlexNonlinearSolver");
 }
 
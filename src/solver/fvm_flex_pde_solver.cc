@@ -20,9 +20,14 @@
 /********************************************************************************/
 
 #include <numeric>
+#include <algorithm>
+
+#include "omp_threads.h"
 
 #include "genius_common.h"
 #include "fvm_flex_pde_solver.h"
+#include "boundary_condition_collector.h"
+#include "sparsity_pattern.h"
 
 #ifdef COGENDA_COMMERCIAL_PRODUCT
   #include "fvm_flex_parallel_dof_map.h"
@@ -45,9 +50,118 @@ void FVM_FlexPDESolver::build_dof_map()
 
 
 
+void FVM_FlexPDESolver::build_sparsity_pattern(SparsityPattern & pattern) const
+{
+  // node dofs couple to the node dofs of their stencil
+  for(unsigned int n=0; n<_system.n_regions(); ++n)
+  {
+    SimulationRegion * region = _system.region(n);
+    const unsigned int region_node_dofs = this->node_dofs( region );
+    const bool elem_based = this->all_neighbor_elements_involved( region );
+
+    SimulationRegion::processor_node_iterator nodes = region->on_processor_nodes_begin();
+    const int n_nodes = static_cast<int>(region->on_processor_nodes_end() - nodes);
+
+#ifdef HAVE_OPENMP
+    const int n_threads = OmpThreads::loop_threads(n_nodes);
+    #pragma omp parallel num_threads(n_threads)
+#endif
+    {
+      SparsityPattern local(n_global_dofs, n_local_dofs, global_offset);
+      std::vector<const FVM_Node *> stencil;
+
+#ifdef HAVE_OPENMP
+      #pragma omp for schedule(static)
+#endif
+      for(int i=0; i<n_nodes; ++i)
+      {
+        const FVM_Node * fvm_node = nodes[i];
+        if( fvm_node->global_offset() == invalid_uint ) continue;
+
+        fvm_node->PDE_node_stencil(stencil, elem_based);
+
+        local.add_rows(fvm_node->global_offset(), region_node_dofs);
+        for(unsigned int k=0; k<stencil.size(); ++k)
+        {
+          if( stencil[k]->global_offset() == invalid_uint ) continue;
+          local.add_cols(stencil[k]->global_offset(), this->node_dofs(_system.region(stencil[k]->subdomain_id())));
+        }
+      }
+
+#ifdef HAVE_OPENMP
+      #pragma omp critical
+#endif
+      pattern.append(local);
+    }
+  }
+
+  if( _system.get_bcs() == NULL ) return;
+
+  // bc dofs couple to the boundary nodes and their stencil, and the boundary nodes to the bc dofs.
+  // inter connect hub couples to the dofs and boundary nodes of all its electrodes.
+  std::vector<const FVM_Node *> stencil;
+  std::vector<const FVM_Node *> bc_stencil;
+  std::vector<std::pair<unsigned int, unsigned int> > bc_blocks;
+  for(unsigned int n=0; n<_system.get_bcs()->n_bcs(); ++n )
+  {
+    const BoundaryCondition * bc = _system.get_bcs()->get_bc(n);
+
+    bc_blocks.clear();
+    if( bc->global_offset() != invalid_uint )
+      bc_blocks.push_back( std::make_pair(bc->global_offset(), this->bc_dofs(bc)) );
 
+    const BoundaryCondition * hub = bc->inter_connect_hub();
+    if( hub && hub != bc && hub->global_offset() != invalid_uint )
+      bc_blocks.push_back( std::make_pair(hub->global_offset(), this->bc_dofs(hub)) );
 
+    std::vector<const BoundaryCondition *> node_bcs(1, bc);
+    if( bc->is_inter_connect_hub() )
+    {
+      node_bcs.assign(bc->inter_connect().begin(), bc->inter_connect().end());
+      for(unsigned int i=0; i<node_bcs.size(); ++i)
+        if( node_bcs[i]->global_offset() != invalid_uint )
+          bc_blocks.push_back( std::make_pair(node_bcs[i]->global_offset(), this->bc_dofs(node_bcs[i])) );
+    }
 
+    if( bc_blocks.empty() ) continue;
 
+    bc_stencil.clear();
+    for(unsigned int i=0; i<node_bcs.size(); ++i)
+    {
+      const BoundaryCondition * node_bc = node_bcs[i];
+      BoundaryCondition::const_node_iterator node_it = node_bc->nodes_begin();
+      for( ; node_it != node_bc->nodes_end(); ++node_it)
+      {
+        BoundaryCondition::const_region_node_iterator rnode_it = node_bc->region_node_begin(*node_it);
+        for( ; rnode_it != node_bc->region_node_end(*node_it); ++rnode_it)
+        {
+          const SimulationRegion * region = (*rnode_it).second.first;
+          const FVM_Node * fvm_node = (*rnode_it).second.second;
+          if( !fvm_node->on_processor() || fvm_node->global_offset() == invalid_uint ) continue;
 
+          fvm_node->PDE_node_stencil(stencil, this->all_neighbor_elements_involved(region));
+          bc_stencil.insert(bc_stencil.end(), stencil.begin(), stencil.end());
 
+          if( node_bc != bc ) continue;
+          pattern.add_rows(fvm_node->global_offset(), this->node_dofs(region));
+          for(unsigned int b=0; b<bc_blocks.size(); ++b)
+            pattern.add_cols(bc_blocks[b].first, bc_blocks[b].second);
+        }
+      }
+    }
+
+    if( bc->global_offset() == invalid_uint ) continue;
+
+    std::sort(bc_stencil.begin(), bc_stencil.end());
+    bc_stencil.erase(std::unique(bc_stencil.begin(), bc_stencil.end()), bc_stencil.end());
+
+    pattern.add_rows(bc->global_offset(), this->bc_dofs(bc));
+    for(unsigned int b=0; b<bc_blocks.size(); ++b)
+      pattern.add_cols(bc_blocks[b].first, bc_blocks[b].second);
+    for(unsigned int k=0; k<bc_stencil.size(); ++k)
+    {
+      if( bc_stencil[k]->global_offset() == invalid_uint ) continue;
+      pattern.add_cols(bc_stencil[k]->global_offset(), this->node_dofs(_system.region(bc_stencil[k]->subdomain_id())));
+    }
+  }
+}
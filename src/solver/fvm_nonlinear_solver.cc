@@ -25,6 +25,7 @@
 
 #include "fvm_nonlinear_solver.h"
 #include "parallel.h"
+#include "petsc_utils.h"
 
 #ifdef HAVE_SLEPC
 #include "slepceps.h"
@@ -1202,7 +1203,7 @@ void FVM_NonlinearSolver::snes_solve()
 
   // do snes solve
   SNESSolve ( snes, PETSC_NULL, x );
-
+  PetscUtils::SNESCountIterations(snes);
 
   STOP_LOG("sens_solve()", "FVM_NonlinearSolver");
 }
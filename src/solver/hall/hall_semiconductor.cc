@@ -27,6 +27,7 @@
 #include "solver_specify.h"
 #include "hall/hall.h"
 #include "log.h"
+#include "scratch_vector.h"
 
 #include "jflux1.h"
 
@@ -774,7 +775,7 @@ void SemiconductorSimulationRegion::HALL_Jacobian(const VectorValue<PetscScalar>
     mt->set_ad_num(adtl::AutoDScalar::numdir);
 
     // indicate the column position of the variables in the matrix
-    std::vector<PetscInt> cell_col;
+    ScratchVector<PetscInt> cell_col;
     for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
     {
       const FVM_Node * fvm_node = elem->get_fvm_node(nd);
@@ -787,14 +788,14 @@ void SemiconductorSimulationRegion::HALL_Jacobian(const VectorValue<PetscScalar>
     // which are the vector of electric field and current density.
     // here use type AutoDScalar, we should make sure the order of independent variable keeps the
     // same all the time
-    std::vector<AutoDScalar> psi_vertex;
-    std::vector<AutoDScalar> phin_vertex;
-    std::vector<AutoDScalar> phip_vertex;
+    ScratchVector<AutoDScalar> psi_vertex;
+    ScratchVector<AutoDScalar> phin_vertex;
+    ScratchVector<AutoDScalar> phip_vertex;
 
-    std::vector<AutoDScalar> mun_edge; //store all the edge mun
-    std::vector<AutoDScalar> mup_edge; //store all the edge mup
-    std::vector<AutoDScalar> Vp_edge; //store all the edge Jp/p
-    std::vector<AutoDScalar> Vn_edge; //store all the edge Jn/n
+    ScratchVector<AutoDScalar> mun_edge; //store all the edge mun
+    ScratchVector<AutoDScalar> mup_edge; //store all the edge mup
+    ScratchVector<AutoDScalar> Vp_edge; //store all the edge Jp/p
+    ScratchVector<AutoDScalar> Vn_edge; //store all the edge Jn/n
 
     // E field parallel to current flow
     AutoDScalar Epn=0;
@@ -852,8 +853,8 @@ void SemiconductorSimulationRegion::HALL_Jacobian(const VectorValue<PetscScalar>
       if(get_advanced_model()->ESurface && insulator_interface_elem)
       {
         // get all the sides on insulator interface
-        std::vector<unsigned int> sides;
-        std::vector<SimulationRegion *> regions;
+        ScratchVector<unsigned int> sides;
+        ScratchVector<SimulationRegion *> regions;
         elem_on_insulator_interface(elem, sides, regions);
 
         VectorValue<AutoDScalar> E_insul(0.0,0.0,0.0);
@@ -866,7 +867,7 @@ void SemiconductorSimulationRegion::HALL_Jacobian(const VectorValue<PetscScalar>
         {
           const Elem * elem_neighbor = elem->neighbor(sides[ne]);
 
-          std::vector<AutoDScalar> psi_vertex_neighbor;
+          ScratchVector<AutoDScalar> psi_vertex_neighbor;
           for(unsigned int nd=0; nd<elem_neighbor->n_nodes(); ++nd)
           {
             const FVM_Node * fvm_node_neighbor = elem_neighbor->get_fvm_node(nd);
@@ -988,7 +989,7 @@ void SemiconductorSimulationRegion::HALL_Jacobian(const VectorValue<PetscScalar>
       unsigned int n2_local_offset = fvm_n2->local_offset();
 
       // the row position of variables in the matrix
-      std::vector<PetscInt> row;
+      ScratchVector<PetscInt> row;
       for(unsigned int i=0; i<3; ++i) row.push_back( fvm_n1->global_offset()+i );
       for(unsigned int i=0; i<3; ++i) row.push_back( fvm_n2->global_offset()+i );
 
@@ -1267,7 +1268,7 @@ void SemiconductorSimulationRegion::HALL_Jacobian(const VectorValue<PetscScalar>
       unsigned int n2_local_offset = fvm_n2->local_offset();
 
       // the row position of variables in the matrix
-      std::vector<PetscInt> row;
+      ScratchVector<PetscInt> row;
       for(unsigned int i=0; i<3; ++i) row.push_back( fvm_n1->global_offset()+i );
       for(unsigned int i=0; i<3; ++i) row.push_back( fvm_n2->global_offset()+i );
 
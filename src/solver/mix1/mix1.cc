@@ -760,26 +760,17 @@ void Mix1Solver::build_petsc_sens_residual(Vec x, Vec r)
   // flag for indicate ADD_VALUES operator.
   InsertMode add_value_flag = NOT_SET_VALUES;
 
-  // evaluate governing equations of DDML1 in all the regions
+  // evaluate governing equations of DDML1 in all the regions,
+  // together with time derivative if necessary
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
-    region->DDM1_Function(lxx, r, add_value_flag);
+    if(SolverSpecify::TimeDependent == true)
+      region->DDM1_Function_Time_Dependent(lxx, r, add_value_flag);
+    else
+      region->DDM1_Function(lxx, r, add_value_flag);
   }
 
-#if defined(HAVE_FENV_H) && defined(DEBUG)
-  genius_assert( !fetestexcept(FE_INVALID) );
-#endif
-
-  // evaluate time derivative if necessary
-  if(SolverSpecify::TimeDependent == true)
-    for(unsigned int n=0; n<_system.n_regions(); n++)
-    {
-      SimulationRegion * region = _system.region(n);
-      region->DDM1_Time_Dependent_Function(lxx, r, add_value_flag);
-    }
-
-
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
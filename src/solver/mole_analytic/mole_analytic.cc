@@ -78,14 +78,54 @@ int MoleAnalytic::solve()
     //we only process semiconductor region
     if( region->type() != SemiconductorRegion ) continue;
 
+    std::vector<FVM_NodeData *> nodes;
+    std::vector<double> x, y, z;
+    nodes.reserve(region->n_node());
+    x.reserve(region->n_node());
+    y.reserve(region->n_node());
+    z.reserve(region->n_node());
+
     SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
     SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
     for(; node_it!=node_it_end; ++node_it)
     {
       FVM_Node * fvm_node = *node_it;
-      FVM_NodeData * node_data = fvm_node->node_data();
-      node_data->mole_x() = this->mole_x( region->name(), fvm_node->root_node() );
-      node_data->mole_y() = this->mole_y( region->name(), fvm_node->root_node() );
+      const Node * node = fvm_node->root_node();
+      nodes.push_back(fvm_node->node_data());
+      x.push_back((*node)(0));
+      y.push_back((*node)(1));
+      z.push_back((*node)(2));
+    }
+    if( nodes.empty() ) continue;
+
+    // analytic mole functions of this region, evaluated for all the nodes at once
+    std::vector<double> mole_x(nodes.size(), 0.0);
+    std::vector<double> mole_y(nodes.size(), 0.0);
+    std::vector<double> m(nodes.size());
+    for(size_t i=0; i<_mole_funs.size(); i++)
+    {
+      if(_mole_funs[i]->region() != region->name()) continue;
+      if(!_mole_funs[i]->mole_x() && !_mole_funs[i]->mole_y()) continue;
+
+      _mole_funs[i]->profile_batch(nodes.size(), &x[0], &y[0], &z[0], &m[0]);
+
+      std::vector<double> & mole = _mole_funs[i]->mole_x() ? mole_x : mole_y;
+      for(unsigned int k=0; k<nodes.size(); ++k)
+        mole[k] += m[k];
+    }
+
+    // then add mole profile file
+    node_it = region->on_local_nodes_begin();
+    for(unsigned int k=0; node_it!=node_it_end; ++node_it, ++k)
+    {
+      const Node * node = (*node_it)->root_node();
+      if( !_mole_data.empty() )
+      {
+        mole_x[k] += this->mole_x_data( node );
+        mole_y[k] += this->mole_y_data( node );
+      }
+      nodes[k]->mole_x() = mole_x[k];
+      nodes[k]->mole_y() = mole_y[k];
     }
   }
 
@@ -405,20 +445,11 @@ void MoleAnalytic::set_mole_function_linear(const Parser::Card & c)
 
 
 
-double MoleAnalytic::mole_x(const std::string & region, const Node * node)
+double MoleAnalytic::mole_x_data(const Node * node)
 {
   double mole = 0.0;
 
-  // use the first Mole profile that specified an X composition
-  for(size_t i=0; i<_mole_funs.size(); i++)
-  {
-    if(_mole_funs[i]->region() != region) continue;
-
-    if(_mole_funs[i]->mole_x())
-      mole +=  _mole_funs[i]->profile((*node)(0),(*node)(1),(*node)(2));
-  }
-
-  // then check mole profile file
+  // check mole profile file
   for(size_t i=0; i<_mole_data.size(); i++)
   {
     int axes = _mole_int_type[i];
@@ -478,19 +509,11 @@ double MoleAnalytic::mole_x(const std::string & region, const Node * node)
 
 
 
-double MoleAnalytic::mole_y(const std::string & region, const Node * node)
+double MoleAnalytic::mole_y_data(const Node * node)
 {
   double mole = 0.0;
 
-  for(size_t i=0; i<_mole_funs.size(); i++)
-  {
-    if(_mole_funs[i]->region() != region) continue;
-
-    if(_mole_funs[i]->mole_y())
-      mole +=  _mole_funs[i]->profile((*node)(0),(*node)(1),(*node)(2));
-  }
-
-  // then check mole profile file
+  // check mole profile file
   for(size_t i=0; i<_mole_data.size(); i++)
   {
     int axes = _mole_int_type[i];
@@ -0,0 +1,314 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include "omp_threads.h"
+
+#include "post_solve_reduction.h"
+#include "simulation_system.h"
+#include "simulation_region.h"
+#include "fvm_node_info.h"
+#include "fvm_node_data.h"
+#include "fvm_cell_data.h"
+#include "elem.h"
+#include "parallel.h"
+#include "perf_log.h"
+
+
+namespace
+{
+  /**
+   * @return true when (v, id) is a better MAX/MIN result than (v0, id0),
+   * tie is broken by the smaller id so the result does not depend on the sweep order
+   */
+  inline bool better(PostSolveReduction::Operation op, Real v, unsigned int id, Real v0, unsigned int id0)
+  {
+    if( id0 == invalid_uint ) return true;
+    if( op == PostSolveReduction::MAX ? v > v0 : v < v0 ) return true;
+    return v == v0 && id < id0;
+  }
+}
+
+
+
+unsigned int PostSolveReduction::add(Operation op, const std::string & variable, DataLocation location,
+                                     const std::string & region, const Point & lower, const Point & upper)
+{
+  genius_assert( location == POINT_CENTER || location == CELL_CENTER );
+
+  Reduction reduction;
+  reduction.op = op;
+  reduction.variable = variable;
+  reduction.data_location = location;
+  reduction.region = region;
+  reduction.box = lower.x() < upper.x() || lower.y() < upper.y() || lower.z() < upper.z();
+  reduction.lower = lower;
+  reduction.upper = upper;
+  reduction.value = 0.0;
+  reduction.id = invalid_uint;
+  reduction.count = 0;
+
+  _reductions.push_back(reduction);
+  return _reductions.size() - 1;
+}
+
+
+
+void PostSolveReduction::Partial::init(const std::vector<Reduction> & reductions)
+{
+  value.assign(reductions.size(), 0.0);
+  id.assign(reductions.size(), invalid_uint);
+  count.assign(reductions.size(), 0);
+}
+
+
+
+void PostSolveReduction::Partial::merge(const std::vector<Reduction> & reductions, const Partial & other)
+{
+  for(unsigned int k=0; k<reductions.size(); ++k)
+  {
+    count[k] += other.count[k];
+    switch( reductions[k].op )
+    {
+      case MAX :
+      case MIN :
+        if( other.id[k] != invalid_uint && better(reductions[k].op, other.value[k], other.id[k], value[k], id[k]) )
+        {
+          value[k] = other.value[k];
+          id[k] = other.id[k];
+        }
+        break;
+      case SUM :
+      case INTEGRAL :
+        value[k] += other.value[k];
+        break;
+    }
+  }
+}
+
+
+
+void PostSolveReduction::_build_entities(const SimulationSystem & system)
+{
+  bool changed = _nodes.size() != system.n_regions();
+  for(unsigned int r=0; r<system.n_regions() && !changed; ++r)
+  {
+    const SimulationRegion * region = system.region(r);
+    if( _nodes[r].region != region || _nodes[r].n_total != region->n_node() ) changed = true;
+    if( _cells[r].region != region || _cells[r].n_total != region->n_cell() ) changed = true;
+  }
+  if( !changed ) return;
+
+  _nodes.clear();
+  _cells.clear();
+  _nodes.resize(system.n_regions());
+  _cells.resize(system.n_regions());
+
+  for(unsigned int r=0; r<system.n_regions(); ++r)
+  {
+    const SimulationRegion * region = system.region(r);
+
+    Entities & nodes = _nodes[r];
+    nodes.region = region;
+    nodes.n_total = region->n_node();
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      const FVM_Node * fvm_node = *it;
+      nodes.offset.push_back( fvm_node->node_data()->offset() );
+      nodes.volume.push_back( fvm_node->volume() );
+      nodes.id.push_back( fvm_node->root_node()->id() );
+      nodes.position.push_back( *fvm_node->root_node() );
+    }
+
+    Entities & cells = _cells[r];
+    cells.region = region;
+    cells.n_total = region->n_cell();
+    for(unsigned int e=0; e<region->n_cell(); ++e)
+    {
+      const Elem * elem = region->get_region_elem(e);
+      if( elem->processor_id() != Genius::processor_id() ) continue;
+      cells.offset.push_back( region->get_region_elem_data(e)->offset() );
+      cells.volume.push_back( elem->volume() );
+      cells.id.push_back( elem->id() );
+      cells.position.push_back( elem->centroid() );
+    }
+  }
+}
+
+
+
+void PostSolveReduction::_sweep(const Entities & entities, unsigned int begin, unsigned int end,
+                                const std::vector<Source> & sources, Partial & partial) const
+{
+  for(unsigned int i=begin; i<end; ++i)
+  {
+    const unsigned int offset = entities.offset[i];
+    const Point & p = entities.position[i];
+
+    for(unsigned int s=0; s<sources.size(); ++s)
+    {
+      const unsigned int k = sources[s].reduction;
+      const Reduction & reduction = _reductions[k];
+
+      if( reduction.box &&
+          !( p.x() >= reduction.lower.x() && p.x() <= reduction.upper.x() &&
+             p.y() >= reduction.lower.y() && p.y() <= reduction.upper.y() &&
+             p.z() >= reduction.lower.z() && p.z() <= reduction.upper.z() ) ) continue;
+
+      const Real x = sources[s].scalar ? sources[s].scalar[offset] : sources[s].vector[offset].size();
+
+      partial.count[k]++;
+      switch( reduction.op )
+      {
+        case MAX :
+        case MIN :
+          if( better(reduction.op, x, entities.id[i], partial.value[k], partial.id[k]) )
+          {
+            partial.value[k] = x;
+            partial.id[k] = entities.id[i];
+          }
+          break;
+        case SUM :
+          partial.value[k] += x;
+          break;
+        case INTEGRAL :
+          partial.value[k] += x*entities.volume[i];
+          break;
+      }
+    }
+  }
+}
+
+
+
+void PostSolveReduction::evaluate(const SimulationSystem & system)
+{
+  if( _reductions.empty() ) return;
+
+  START_LOG("evaluate()", "PostSolveReduction");
+
+  _build_entities(system);
+
+  Partial total;
+  total.init(_reductions);
+
+  for(unsigned int r=0; r<system.n_regions(); ++r)
+  {
+    const SimulationRegion * region = system.region(r);
+
+    for(unsigned int l=0; l<2; ++l)
+    {
+      const DataLocation location = l ? CELL_CENTER : POINT_CENTER;
+      const DataStorage & storage = l ? region->cell_data_storage() : region->node_data_storage();
+      const Entities & entities = l ? _cells[r] : _nodes[r];
+
+      // the data blocks of the reductions on this region
+      std::vector<Source> sources;
+      for(unsigned int k=0; k<_reductions.size(); ++k)
+      {
+        const Reduction & reduction = _reductions[k];
+        if( reduction.data_location != location ) continue;
+        if( !reduction.region.empty() && reduction.region != region->name() ) continue;
+
+        SimulationVariable variable;
+        if( !region->get_variable(reduction.variable, location, variable) || !variable.variable_valid ) continue;
+
+        Source source;
+        source.reduction = k;
+        source.scalar = 0;
+        source.vector = 0;
+        if( variable.variable_data_type == SCALAR ) source.scalar = storage.scalar_block(variable.variable_index);
+        if( variable.variable_data_type == VECTOR ) source.vector = storage.vector_block(variable.variable_index);
+        if( source.scalar || source.vector )
+          sources.push_back(source);
+      }
+      if( sources.empty() ) continue;
+
+      const unsigned int n = entities.offset.size();
+
+      // split the sweep among threads, each one with its own partial result
+      const int n_threads = OmpThreads::loop_threads(n);
+      std::vector<Partial> partials(n_threads);
+      for(int t=0; t<n_threads; ++t)
+        partials[t].init(_reductions);
+
+#ifdef HAVE_OPENMP
+      #pragma omp parallel num_threads(n_threads)
+#endif
+      {
+#ifdef HAVE_OPENMP
+        const unsigned int tid = omp_get_thread_num();
+        const unsigned int nt  = omp_get_num_threads();
+#else
+        const unsigned int tid = 0;
+        const unsigned int nt  = 1;
+#endif
+        _sweep(entities, n*tid/nt, n*(tid+1)/nt, sources, partials[tid]);
+      }
+
+      for(int t=0; t<n_threads; ++t)
+        total.merge(_reductions, partials[t]);
+    }
+  }
+
+  // combine the processors
+  const unsigned int n_reductions = _reductions.size();
+
+  std::vector<unsigned int> count = total.count;
+  Parallel::sum(count);
+
+  std::vector<Real> sum = total.value;
+  Parallel::sum(sum);
+
+  std::vector<Real> extreme_value = total.value;
+  std::vector<unsigned int> extreme_id = total.id;
+  Parallel::allgather(extreme_value);
+  Parallel::allgather(extreme_id);
+
+  for(unsigned int k=0; k<n_reductions; ++k)
+  {
+    Reduction & reduction = _reductions[k];
+    reduction.count = count[k];
+    reduction.value = 0.0;
+    reduction.id = invalid_uint;
+
+    if( reduction.op == SUM || reduction.op == INTEGRAL )
+    {
+      reduction.value = sum[k];
+      continue;
+    }
+
+    for(unsigned int p=0; p<extreme_id.size()/n_reductions; ++p)
+    {
+      const Real v = extreme_value[p*n_reductions+k];
+      const unsigned int id = extreme_id[p*n_reductions+k];
+      if( id != invalid_uint && better(reduction.op, v, id, reduction.value, reduction.id) )
+      {
+        reduction.value = v;
+        reduction.id = id;
+      }
+    }
+  }
+
+  STOP_LOG("evaluate()", "PostSolveReduction");
+}
@@ -167,6 +167,8 @@ int RayTraceSolver::solve()
     RECORD();
   }
 
+  // OptG was written directly, the generation cached by field source is stale
+  _system.get_field_source()->invalidate_generation();
 
   statistic();
 
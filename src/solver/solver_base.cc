@@ -45,6 +45,22 @@ int SolverBase::destroy_solver()
   return 0;
 }
 
+int SolverBase::suspend_solver()
+{
+  // the hooks belong to the SOLVE card, delete them with their reductions
+  hook_list()->on_close();
+  _reduction.clear();
+
+  return 0;
+}
+
+int SolverBase::resume_solver()
+{
+  // call hook function on_init
+  hook_list()->on_init();
+  return 0;
+}
+
 
 
 int SolverBase::pre_solve_process(bool /*load_solution*/)
@@ -57,9 +73,15 @@ int SolverBase::pre_solve_process(bool /*load_solution*/)
 
 int SolverBase::post_solve_process()
 {
+  // evaluate the reductions registered by hooks in one sweep
+  _reduction.evaluate(_system);
+
   // call (user defined) hook function hook_post_solve_process
   hook_list()->post_solve();
 
+  // record time, counters and memory usage of this step
+  perflog.mark_step(SolverSpecify::label, SolverSpecify::clock/PhysicalUnit::s);
+
   return 0;
 }
 
@@ -65,6 +65,11 @@ namespace SolverSpecify
    */
   std::string      out_prefix;
 
+  /**
+   * label of the particle event solved by an ensemble transient, empty otherwise
+   */
+  std::string      event_label;
+
   /**
    * the append model for output file
    */
@@ -90,6 +95,26 @@ namespace SolverSpecify
    */
   int     NSLagJacobian;
 
+  /**
+   * freeze the mobility and impact ionization coefficients in the DDML1 jacobian
+   */
+  bool    LaggedCoefficient;
+
+  /**
+   * relative newton update below which the frozen coefficients are released
+   */
+  double  LaggedCoefficientTol;
+
+  /**
+   * true while the jacobian uses frozen coefficients
+   */
+  bool    LaggedCoefficientFrozen;
+
+  /**
+   * keep the solver alive between SOLVE cards of the same solver type
+   */
+  bool    ReuseSolver;
+
   /**
    * linear solver scheme: LU, BCGS, GMRES ...
    */
@@ -400,6 +425,21 @@ namespace SolverSpecify
    */
   bool      tran_histroy;
 
+  /**
+   * file of transient checkpoint, empty for no checkpoint
+   */
+  std::string      checkpoint_file;
+
+  /**
+   * wall clock interval (in second) between transient checkpoints, 0 for only on signal
+   */
+  double    checkpoint_interval;
+
+  /**
+   * continue the transient from this checkpoint file, empty for a new transient
+   */
+  std::string      restart_file;
+
   /**
    * current time
    */
@@ -714,6 +754,10 @@ namespace SolverSpecify
     NSLagPCLU         = 1;
     NSLagJacobian     = 1;
 #endif
+    LaggedCoefficient       = false;
+    LaggedCoefficientTol    = 1e-3;
+    LaggedCoefficientFrozen = false;
+    ReuseSolver             = true;
 
     out_append        = false;
 
@@ -765,6 +809,9 @@ namespace SolverSpecify
     UIC                       = false;
     tran_op                   = true;
     tran_histroy              = false;
+    checkpoint_file           = "";
+    checkpoint_interval       = 0.0;
+    restart_file              = "";
     AutoStep                  = true;
     RejectStep                = true;
     Predict                   = true;
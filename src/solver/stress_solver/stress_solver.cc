@@ -22,12 +22,19 @@
 //  $Id: poisson.cc,v 1.36 2008/07/09 07:53:36 gdiso Exp $
 
 
+#include <map>
+#include <cmath>
+#include <algorithm>
+
+#include "omp_threads.h"
+
 #include "elem.h"
 #include "mesh_base.h"
 #include "stress_solver/stress_solver.h"
 #include "solver_specify.h"
 #include "fe_type.h"
 #include "fe_base.h"
+#include "fe.h"
 #include "quadrature_gauss.h"
 #include "tensor_value.h"
 
@@ -94,354 +101,461 @@ int StressSolver::destroy_solver()
   // clear linear contex
   clear_linear_data();
 
+  _affine_elems.clear();
+  _affine_color_begin.clear();
+  _general_elems.clear();
+  _general_elem_nodes.clear();
+  _node_offset.clear();
+  _node_load.clear();
+
   return 0;
 }
 
 
 
-void StressSolver::build_matrix(Mat A, Mat )
+namespace
 {
-  // the integral order used in gauss intergral. default value= 2*fe_order+1
-  Order int_order=FIFTH;
+  /**
+   * the stiff matrix. a general stiff matrix named C of 3D is a 6x6 symmetry matrx
+   * so it has 21 independent parameter. in some special case the independent parameter number will be reduce.
+   * note that in 2D case, plane stress and plane strain are two deferent case.
+   * this should be function of material. for convinent, we take a sample parameter here,
+   * you should re_value it for your own use.
+   */
+  void stress_material(double C[6][6])
+  {
+    for(unsigned int i=0; i<6; ++i)
+      for(unsigned int j=0; j<6; ++j)
+        C[i][j] = 0.0;
+    C[0][0]=C[1][1]=C[2][2]=1.e9;
+    C[3][3]=C[4][4]=C[5][5]=1.e8;
+  }
+
+  /**
+   * fill the strain-displacement matrix B with the shape function gradients
+   * 2D and 1D are regard as reduced 3D problem, 6 is the dim of stress.
+   */
+  inline void stress_B(unsigned int n_node, const Real *gx, const Real *gy, const Real *gz, double B[6][81])
+  {
+    for(unsigned int i=0;i<n_node;i++)
+    {
+      B[0][i*3+0]=gx[i];
+      B[1][i*3+1]=gy[i];
+      B[2][i*3+2]=gz[i];
+
+      B[3][i*3+0]=gy[i];
+      B[3][i*3+1]=gx[i];
+
+      B[4][i*3+1]=gz[i];
+      B[4][i*3+2]=gy[i];
+
+      B[5][i*3+0]=gz[i];
+      B[5][i*3+2]=gx[i];
+    }
+  }
+
+  /**
+   * K += w*B'CB, CB is a scratch of size 6*n_node2
+   */
+  inline void stress_BtCB(unsigned int n_node2, const double C[6][6], const double B[6][81], double w, double *CB, double *K)
+  {
+    for(unsigned int ii=0;ii<6;ii++)
+      for(unsigned int jj=0;jj<n_node2;jj++)
+      {
+        double v=0.0;
+        for(unsigned int kk=0;kk<6;kk++)
+          v+=C[ii][kk]*B[kk][jj];
+        CB[ii*n_node2+jj]=w*v;
+      }
+
+    for(unsigned int ii=0;ii<n_node2;ii++)
+      for(unsigned int jj=0;jj<n_node2;jj++)
+      {
+        double v=0.0;
+        for(unsigned int kk=0;kk<6;kk++)
+          v+=B[kk][ii]*CB[kk*n_node2+jj];
+        K[ii*n_node2+jj]+=v;
+      }
+  }
+
+  /**
+   * reference data of a linear simplex element type: the constant
+   * shape function gradients and the quadrature weighted shape functions
+   */
+  struct SimplexReference
+  {
+    unsigned int n_nodes;
+    Real dphi[4][3];
+    Real phi_w[4];
+  };
+
+  bool is_linear_simplex(const ElemType t)
+  {
+    switch(t)
+    {
+      case EDGE2 :
+      case EDGE2_FVM :
+      case TRI3 :
+      case TRI3_FVM :
+      case TET4 :
+      case TET4_FVM : return true;
+      default : return false;
+    }
+  }
+
+  template <unsigned int Dim>
+  void build_simplex_reference(const ElemType t, const Order o, SimplexReference &ref)
+  {
+    QGauss qrule(Dim, o);
+    qrule.init(t);
+    const std::vector<Point> & qp = qrule.get_points();
+    const std::vector<Real>  & qw = qrule.get_weights();
+
+    ref.n_nodes = FE<Dim,LAGRANGE>::n_shape_functions(t, FIRST);
+    genius_assert(ref.n_nodes <= 4);
+    for(unsigned int i=0; i<ref.n_nodes; ++i)
+    {
+      for(unsigned int d=0; d<3; ++d)
+        ref.dphi[i][d] = d<Dim ? FE<Dim,LAGRANGE>::shape_deriv(t, FIRST, i, d, Point()) : 0.0;
+      ref.phi_w[i] = 0.0;
+      for(unsigned int q=0; q<qp.size(); ++q)
+        ref.phi_w[i] += qw[q]*FE<Dim,LAGRANGE>::shape(t, FIRST, i, qp[q]);
+    }
+  }
+}
 
-  const MeshBase& mesh = _system.mesh();
 
+
+void StressSolver::_build_elem_cache()
+{
+  START_LOG("_build_elem_cache()", "StressSolver");
+
+  _affine_elems.clear();
+  _affine_color_begin.clear();
+  _general_elems.clear();
+  _general_elem_nodes.clear();
+  _node_offset.clear();
+
+  const MeshBase& mesh = _system.mesh();
   const unsigned int dim = mesh.mesh_dimension();
 
+  // phi is linear, the load term phi*f needs order 2*p, the stiff term of linear simplex is constant
   FEType fe_type;
+  const Order int_order = fe_type.affine_quadrature_order();
+
+  std::map<ElemType, SimplexReference> references;
+
+  // the fvm nodes used by local elements, each region has its own displacement
+  std::map<const FVM_Node *, unsigned int> node_index;
 
-  AutoPtr<FEBase> fe (FEBase::build(dim, fe_type));
-
-  // Gauss quadrature rule for numerical integration.
-  QGauss qrule (dim, int_order);
-
-  // Tell the finite element object to use our quadrature rule.
-  fe->attach_quadrature_rule (&qrule);
-
-  // Declare a special finite element object for boundary integration.
-  AutoPtr<FEBase> fe_face (FEBase::build(dim, fe_type));
-
-  // Boundary integration requires one quadraure rule,
-  // with dimensionality one less than the dimensionality
-  // of the element.
-  QGauss qface(dim-1, int_order);
-
-  // Tell the finite element object to use our
-  // quadrature rule.
-  fe_face->attach_quadrature_rule (&qface);
-
-  // Here we define some references to cell-specific data that
-  // will be used to assemble the linear system.
-  //
-  // The element Jacobian * quadrature weight at each integration point.
-  const std::vector<Real>& JxW = fe->get_JxW();
-
-  // The physical XY locations of the quadrature points on the element.
-  // These might be useful for evaluating spatially varying material
-  // properties at the quadrature points.
-  const std::vector<Point>& q_point = fe->get_xyz();
-
-  // The element shape functions evaluated at the quadrature points.
-  const std::vector<std::vector<Real> >& phi = fe->get_phi();
-
-  // The element shape function gradients evaluated at the quadrature
-  // points.
-  //const std::vector<std::vector<RealGradient> >& dphi = fe->get_dphi();
-  const std::vector<std::vector<Real> >& dphidx       = fe->get_dphidx();
-  const std::vector<std::vector<Real> >& dphidy       = fe->get_dphidy();
-  const std::vector<std::vector<Real> >& dphidz       = fe->get_dphidz();
-
-  // Define data structures to contain the element matrix
-  // and right-hand-side vector contribution.  Following
-  // basic finite element terminology we will denote these
-  // "Ke" and "Fe".  These datatypes are templated on
-  //  Number, which allows the same code to work for real
-  // or complex numbers.
-  //DenseMatrix<Number> Ke;
-  //DenseVector<Number> Fe;
-
-
-  // This vector will hold the degree of freedom indices for
-  // the element.  These define where in the global system
-  // the element degrees of freedom get mapped.
-  //std::vector<unsigned int> dof_indices;
-
-  // Now we will loop over all the elements in the mesh.
-  // We will compute the element matrix and right-hand-side
-  // contribution.
-  //
-  // Element iterators are a nice way to iterate through
-  // all the elements, or all the elements that have some property.
-  // There are many types of element iterators, but here we will
-  // use the most basic type, the  const_elem_iterator.  The iterator
-  //  el will iterate from the first to the last element.  The
-  // iterator  end_el tells us when to stop.  It is smart to make
-  // this one  const so that we don't accidentally mess it up!
-  //   const_elem_iterator           el (mesh.elements_begin());
-  //   const const_elem_iterator end_el (mesh.elements_end());
-
-  //for(unsigned int n=0; n<_system.n_regions(); ++n)
-  //{
-  //	SimulationRegion * region = _system.region(n);
-  //}
+  // colors already taken by the elements around each node
+  std::vector< std::vector<unsigned int> > node_colors;
+  std::vector<unsigned int> elem_color;
+  unsigned int n_colors = 0;
 
   MeshBase::const_element_iterator       el     = mesh.elements_begin();
   const MeshBase::const_element_iterator end_el = mesh.elements_end();
-
-  //this should be function of node. for convinent, we take parameter as const in every element
-  // you should re_value it for your own use.
-  //VectorValue<double> E;      //yang's modul
-  //TensorValue<double> G;   //shear modul
-  //TensorValue<double> nu;  //possion ratio
-
-  //the stiff matrix. a general stiff matrix named C of 3D is a 6x6 symmetry matrx
-  // so it has 21 independent parameter. in some special case the independent parameter number will be reduce.
-  // note that in 2D case, plane stress and plane strain are two deferent case.
-  double C[6][6]={0.};
-
-  //std::cout<<"k="<<k<<std::endl;
-  // Loop over the elements.  Note that  ++el is preferred to
-  // el++ since the latter requires an unnecessary temporary
-  // object.
   for ( ; el != end_el ; ++el)
   {
-    //material initialization for every element, now only a sample is taken
-    C[0][0]=C[1][1]=C[2][2]=1.e9;
-    C[3][3]=C[4][4]=C[5][5]=1.e8;
-
-    // Store a pointer to the element we are currently
-    // working on.  This allows for nicer syntax later.
     const Elem* elem = *el;
+    if( !elem->on_processor() ) continue;
 
-    //matrix K and F are matrix of Ax=b in every element Kx=F, its size are changed with node in element,
-    // so initialize it in every element.
-    unsigned int n_node=elem->n_nodes();
-    unsigned int dim=3;   // 3 is 3D, 2D and 1D are regard as reduced 3D problem.
-    unsigned int dim_stress=6; //6 is the dim of stress. stress is 3x3 symmetry matrix and has 6 independent element.
-
-    unsigned int n_node2=n_node*dim;
+    const SimulationRegion * region = _system.region(elem->subdomain_id());
+    unsigned int nodes[27];
+    genius_assert(elem->n_nodes() <= 27);
+    for(unsigned int i=0; i<elem->n_nodes(); ++i)
+    {
+      const FVM_Node * fvm_node = region->region_fvm_node(elem->get_node(i));
+      genius_assert(fvm_node != NULL);
+      std::map<const FVM_Node *, unsigned int>::iterator nit = node_index.find(fvm_node);
+      if( nit == node_index.end() )
+      {
+        nit = node_index.insert(std::make_pair(fvm_node, static_cast<unsigned int>(_node_offset.size()))).first;
+        _node_offset.push_back(fvm_node->global_offset());
+        node_colors.push_back(std::vector<unsigned int>());
+      }
+      nodes[i] = nit->second;
+    }
 
-    double* K  =new double[n_node2*n_node2];   //K=B'CB
-    double* F  =new double[n_node2];
-    double* CB =new double[dim_stress*n_node2]; //a matrix=C*B
+    if( elem->dim() != dim || elem->p_level() || !is_linear_simplex(elem->type()) )
+    {
+      _general_elems.push_back(elem);
+      _general_elem_nodes.insert(_general_elem_nodes.end(), nodes, nodes+elem->n_nodes());
+      continue;
+    }
 
-    for(unsigned int ii=0;ii<n_node2*n_node2;++ii)
+    std::map<ElemType, SimplexReference>::iterator it = references.find(elem->type());
+    if( it == references.end() )
     {
-      K[ii]=0.;
+      SimplexReference ref;
+      switch(dim)
+      {
+        case 1: build_simplex_reference<1>(elem->type(), int_order, ref); break;
+        case 2: build_simplex_reference<2>(elem->type(), int_order, ref); break;
+        case 3: build_simplex_reference<3>(elem->type(), int_order, ref); break;
+        default: genius_error();
+      }
+      it = references.insert(std::make_pair(elem->type(), ref)).first;
     }
+    const SimplexReference & ref = it->second;
 
-    for(unsigned int ii=0;ii<n_node2;++ii)
+    // jacobian of the affine map J[a][b] = dx_a/dxi_b, unused dims are kept as identity
+    Real J[3][3] = { {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0} };
+    for(unsigned int a=0; a<dim; ++a)
+      for(unsigned int b=0; b<dim; ++b)
+      {
+        J[a][b] = 0.0;
+        for(unsigned int i=0; i<ref.n_nodes; ++i)
+          J[a][b] += elem->point(i)(a)*ref.dphi[i][b];
+      }
+
+    const Real det = J[0][0]*(J[1][1]*J[2][2] - J[1][2]*J[2][1])
+                   - J[0][1]*(J[1][0]*J[2][2] - J[1][2]*J[2][0])
+                   + J[0][2]*(J[1][0]*J[2][1] - J[1][1]*J[2][0]);
+    genius_assert(det != 0.0);
+
+    Real inv[3][3];
+    inv[0][0] =  (J[1][1]*J[2][2] - J[1][2]*J[2][1])/det;
+    inv[0][1] = -(J[0][1]*J[2][2] - J[0][2]*J[2][1])/det;
+    inv[0][2] =  (J[0][1]*J[1][2] - J[0][2]*J[1][1])/det;
+    inv[1][0] = -(J[1][0]*J[2][2] - J[1][2]*J[2][0])/det;
+    inv[1][1] =  (J[0][0]*J[2][2] - J[0][2]*J[2][0])/det;
+    inv[1][2] = -(J[0][0]*J[1][2] - J[0][2]*J[1][0])/det;
+    inv[2][0] =  (J[1][0]*J[2][1] - J[1][1]*J[2][0])/det;
+    inv[2][1] = -(J[0][0]*J[2][1] - J[0][1]*J[2][0])/det;
+    inv[2][2] =  (J[0][0]*J[1][1] - J[0][1]*J[1][0])/det;
+
+    AffineElem ae;
+    ae.elem = elem;
+    ae.n_nodes = ref.n_nodes;
+    for(unsigned int i=0; i<ref.n_nodes; ++i)
     {
-      F[ii]=0.;
+      // dphi/dx_a = sum_b dphi/dxi_b * dxi_b/dx_a
+      for(unsigned int a=0; a<3; ++a)
+      {
+        ae.dphi[i][a] = 0.0;
+        for(unsigned int b=0; b<dim; ++b)
+          ae.dphi[i][a] += ref.dphi[i][b]*inv[b][a];
+      }
+      ae.phi_JxW[i] = std::abs(det)*ref.phi_w[i];
+      ae.node[i] = nodes[i];
     }
 
+    // greedy coloring: the first color not taken by any node of this element
+    std::vector<bool> taken(n_colors, false);
+    for(unsigned int i=0; i<ae.n_nodes; ++i)
+      for(unsigned int c=0; c<node_colors[ae.node[i]].size(); ++c)
+        taken[node_colors[ae.node[i]][c]] = true;
+    unsigned int color = std::find(taken.begin(), taken.end(), false) - taken.begin();
+    if( color == n_colors ) n_colors++;
+    for(unsigned int i=0; i<ae.n_nodes; ++i)
+      node_colors[ae.node[i]].push_back(color);
+
+    _affine_elems.push_back(ae);
+    elem_color.push_back(color);
+  }
+
+  // sort the affine elements by color, keep the mesh order inside a color
+  _affine_color_begin.assign(n_colors+1, 0);
+  for(unsigned int n=0; n<elem_color.size(); ++n)
+    _affine_color_begin[elem_color[n]+1]++;
+  for(unsigned int c=0; c<n_colors; ++c)
+    _affine_color_begin[c+1] += _affine_color_begin[c];
 
-    // Get the degree of freedom indices for the
-    // current element.  These define where in the global
-    // matrix and right-hand-side this element will
-    // contribute to.
-    //	dof_map.dof_indices (elem, dof_indices);
+  std::vector<AffineElem> colored(_affine_elems.size());
+  std::vector<unsigned int> pos(_affine_color_begin.begin(), _affine_color_begin.end()-1);
+  for(unsigned int n=0; n<_affine_elems.size(); ++n)
+    colored[pos[elem_color[n]]++] = _affine_elems[n];
+  _affine_elems.swap(colored);
 
-    // Compute the element-specific data for the current
-    // element.  This involves computing the location of the
-    // quadrature points (q_point) and the shape functions
-    // (phi, dphi) for the current element.
-    fe->reinit (elem);
+  _node_load.assign(3*_node_offset.size(), 0.0);
 
-    double B[6][81]={0.}; //81=27*3, and 27 is the max n_node in an element.
+  STOP_LOG("_build_elem_cache()", "StressSolver");
+}
 
 
-    // Zero the element matrix and right-hand side before
-    // summing them.  We use the resize member here because
-    // the number of degrees of freedom might have changed from
-    // the last element.  Note that this will be the case if the
-    // element type is different (i.e. the last element was a
-    // triangle, now we are on a quadrilateral).
 
-    // The  DenseMatrix::resize() and the  DenseVector::resize()
-    // members will automatically zero out the matrix  and vector.
-    //	Ke.resize (dof_indices.size(),
-    //			dof_indices.size());
+void StressSolver::build_matrix(Mat A, Mat )
+{
+  START_LOG("build_matrix()", "StressSolver");
 
-    //	Fe.resize (dof_indices.size());
+  if( _affine_elems.empty() && _general_elems.empty() )
+    _build_elem_cache();
 
-    // Now loop over the quadrature points.  This handles
-    // the numeric integration.
+  MatZeroEntries(A);
+  std::fill(_node_load.begin(), _node_load.end(), 0.0);
 
-    for (unsigned int qp=0; qp<qrule.n_points(); qp++)
+  // material initialization, now only a sample is taken
+  double C[6][6];
+  stress_material(C);
+
+  // the body force, also a sample
+  const double f[3]={1.e3,0.,0.};
+
+  // 3 is 3D, 2D and 1D are regard as reduced 3D problem.
+  const unsigned int dim=3;
+
+  // linear simplex elements. B is constant, so K=V*B'CB and F is the
+  // cached integral of phi. elements of one color share no node, so the threads
+  // add F to _node_load without conflict. K of the color is kept in Kc and
+  // inserted into A by this thread, PETSc is not thread safe.
+  unsigned int max_color_size = 0;
+  for(unsigned int c=0; c+1<_affine_color_begin.size(); ++c)
+    max_color_size = std::max(max_color_size, _affine_color_begin[c+1]-_affine_color_begin[c]);
+  std::vector<PetscScalar> Kc(max_color_size*12*12);
+
+  for(unsigned int c=0; c+1<_affine_color_begin.size(); ++c)
+  {
+    const int begin = static_cast<int>(_affine_color_begin[c]);
+    const int end   = static_cast<int>(_affine_color_begin[c+1]);
+
+    // one element costs about 10 fvm node updates
+#ifdef HAVE_OPENMP
+    const int n_threads = OmpThreads::loop_threads(end-begin, 10);
+    #pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+    for(int n=begin; n<end; ++n)
     {
+      const AffineElem & ae = _affine_elems[n];
+      const unsigned int n_node2 = ae.n_nodes*dim;
+
+      double * K = &Kc[(n-begin)*12*12];
+      double CB[6*12];
+      double B[6][81];
 
-      // Now we will build the element matrix.  This involves
-      // a double loop to integrate the test funcions (i) against
-      // the trial functions (j).
-      for (unsigned int i=0; i<phi.size(); i++)
+      Real gx[4], gy[4], gz[4];
+      Real V = 0.0;
+      for(unsigned int i=0; i<ae.n_nodes; ++i)
       {
-        for (unsigned int j=0; j<phi.size(); j++)
-        {
-          //	Ke(i,j) += JxW[qp]*(dphi[i][qp]*dphi[j][qp]);
-        }
+        gx[i] = ae.dphi[i][0];
+        gy[i] = ae.dphi[i][1];
+        gz[i] = ae.dphi[i][2];
+        V += ae.phi_JxW[i];
       }
 
-      for(unsigned int i=0;i<phi.size();i++)
-      {
-        B[0][i*3+0]=dphidx[i][qp];  //vd0[0][i];
+      for(unsigned int ii=0;ii<6;ii++)
+        for(unsigned int jj=0;jj<n_node2;jj++)
+          B[ii][jj]=0.;
+      stress_B(ae.n_nodes, gx, gy, gz, B);
 
-        B[1][i*3+1]=dphidy[i][qp];  //vd0[1][i];
+      for(unsigned int ii=0;ii<n_node2*n_node2;++ii)
+        K[ii]=0.;
+      stress_BtCB(n_node2, C, B, V, CB, K);
 
-        B[2][i*3+2]=dphidz[i][qp];  //vd0[2][i];
+      for (unsigned int ii=0; ii<ae.n_nodes; ii++)
+        for(unsigned int jj=0; jj<dim; jj++)
+          _node_load[ae.node[ii]*dim+jj] += ae.phi_JxW[ii]*f[jj];
+    }
 
-        B[3][i*3+0]=dphidy[i][qp];  //vd0[1][i];
-        B[3][i*3+1]=dphidx[i][qp];  //vd0[0][i];
+    for(int n=begin; n<end; ++n)
+    {
+      const AffineElem & ae = _affine_elems[n];
+      const unsigned int n_node2 = ae.n_nodes*dim;
 
-        B[4][i*3+1]=dphidz[i][qp];  //vd0[2][i];
-        B[4][i*3+2]=dphidy[i][qp];  //vd0[1][i];
+      PetscInt dofs[12];
+      for (unsigned int ii=0; ii<ae.n_nodes; ii++)
+        for(unsigned int jj=0; jj<dim; jj++)
+          dofs[ii*dim+jj] = _node_offset[ae.node[ii]] + jj;
 
-        B[5][i*3+0]=dphidz[i][qp];  //vd0[2][i];
-        B[5][i*3+2]=dphidx[i][qp];  //vd0[0][i];
-      }
+      MatSetValues(A, n_node2, dofs, n_node2, dofs, &Kc[(n-begin)*12*12], ADD_VALUES);
+    }
+  }
 
-      for(unsigned int ii=0;ii<dim_stress;ii++)
-      {
+
+  // the other elements with FE reinit. the integral order used in gauss intergral is 2*fe_order+1
+  if( !_general_elems.empty() )
+  {
+    const MeshBase& mesh = _system.mesh();
+
+    FEType fe_type;
+
+    AutoPtr<FEBase> fe (FEBase::build(mesh.mesh_dimension(), fe_type));
+
+    // Gauss quadrature rule for numerical integration.
+    QGauss qrule (mesh.mesh_dimension(), fe_type.default_quadrature_order());
+
+    // Tell the finite element object to use our quadrature rule.
+    fe->attach_quadrature_rule (&qrule);
+
+    // The element Jacobian * quadrature weight at each integration point.
+    const std::vector<Real>& JxW = fe->get_JxW();
+
+    // The element shape functions and their gradients evaluated at the quadrature points.
+    const std::vector<std::vector<Real> >& phi = fe->get_phi();
+    const std::vector<std::vector<Real> >& dphidx       = fe->get_dphidx();
+    const std::vector<std::vector<Real> >& dphidy       = fe->get_dphidy();
+    const std::vector<std::vector<Real> >& dphidz       = fe->get_dphidz();
+
+    //matrix K and F are matrix of Ax=b in every element Kx=F, 81=27*3, and 27 is the max n_node in an element.
+    std::vector<PetscScalar> K(81*81), CB(6*81);
+    std::vector<PetscInt> dofs(81);
+    double B[6][81];
+    Real gx[27], gy[27], gz[27];
+
+    const unsigned int * nodes = _general_elem_nodes.empty() ? NULL : &_general_elem_nodes[0];
+    for(unsigned int n=0; n<_general_elems.size(); ++n)
+    {
+      const Elem* elem = _general_elems[n];
+
+      unsigned int n_node=elem->n_nodes();
+      unsigned int n_node2=n_node*dim;
+
+      std::fill(K.begin(), K.begin()+n_node2*n_node2, 0.0);
+
+      for(unsigned int ii=0;ii<6;ii++)
         for(unsigned int jj=0;jj<n_node2;jj++)
-        {
-          CB[ii*n_node2+jj]=0.0;
-          for(unsigned int kk=0;kk<dim_stress;kk++)
-          {
-            CB[ii*n_node2+jj]+=C[ii][kk]*B[kk][jj];
-          }
-        }
-      }
+          B[ii][jj]=0.;
+
+      fe->reinit (elem);
 
-      for(unsigned int ii=0;ii<n_node2;ii++)
+      for (unsigned int qp=0; qp<qrule.n_points(); qp++)
       {
-        for(unsigned int jj=0;jj<n_node2;jj++)
+        for(unsigned int i=0;i<phi.size();i++)
         {
-          for(unsigned int kk=0;kk<dim_stress;kk++)
-          {
-            K[ii*n_node2+jj]+=B[kk][ii]*CB[kk*n_node2+jj]*JxW[qp];
-          }
-          //	cout<<element_k[ii]<<endl;
+          gx[i] = dphidx[i][qp];
+          gy[i] = dphidy[i][qp];
+          gz[i] = dphidz[i][qp];
         }
+        stress_B(phi.size(), gx, gy, gz, B);
+
+        stress_BtCB(n_node2, C, B, JxW[qp], &CB[0], &K[0]);
+
+        for (unsigned int ii=0; ii<n_node; ii++)
+          for(unsigned int jj=0; jj<dim; jj++)
+            _node_load[nodes[ii]*dim+jj] += JxW[qp]*f[jj]*phi[ii][qp];
       }
 
-      double f[3]={1.e3,0.,0.};
       for (unsigned int ii=0; ii<n_node; ii++)
-      {
         for(unsigned int jj=0; jj<dim; jj++)
-        {
-          F[ii*dim+jj] += JxW[qp]*f[jj]*phi[ii][qp];
-        }
-      }
-    }
+          dofs[ii*dim+jj] = _node_offset[nodes[ii]] + jj;
 
-    // We have now reached the end of the RHS summation,
-    // and the end of quadrature point loop, so
-    // the interior element integration has
-    // been completed.  However, we have not yet addressed
-    // boundary conditions.  For this example we will only
-    // consider simple Dirichlet boundary conditions.
-    //
-    // There are several ways Dirichlet boundary conditions
-    // can be imposed.  A simple approach, which works for
-    // interpolary bases like the standard Lagrange polynomials,
-    // is to assign function values to the
-    // degrees of freedom living on the domain boundary. This
-    // works well for interpolary bases, but is more difficult
-    // when non-interpolary (e.g Legendre or Hierarchic) bases
-    // are used.
-    //
-    // Dirichlet boundary conditions can also be imposed with a
-    // "penalty" method.  In this case essentially the L2 projection
-    // of the boundary values are added to the matrix. The
-    // projection is multiplied by some large factor so that, in
-    // floating point arithmetic, the existing (smaller) entries
-    // in the matrix and right-hand-side are effectively ignored.
-    //
-    // This amounts to adding a term of the form (in latex notation)
-    //
-    // \frac{1}{\epsilon} \int_{\delta \Omega} \phi_i \phi_j = \frac{1}{\epsilon} \int_{\delta \Omega} u \phi_i
-    //
-    // where
-    //
-    // \frac{1}{\epsilon} is the penalty parameter, defined such that \epsilon << 1
-    /*
-    {
-
-    	// The following loop is over the sides of the element.
-    	// If the element has no neighbor on a side then that
-    	// side MUST live on a boundary of the domain.
-    	for (unsigned int side=0; side<elem->n_sides(); side++)
-    	{
-    		if (elem->neighbor(side) == NULL)
-    		{
-    			// The value of the shape functions at the quadrature
-    			// points.
-    			const std::vector<std::vector<Real> >&  phi_face = fe_face->get_phi();
-
-    			// The Jacobian * Quadrature Weight at the quadrature
-    			// points on the face.
-    			const std::vector<Real>& JxW_face = fe_face->get_JxW();
-
-    			// The XYZ locations (in physical space) of the
-    			// quadrature points on the face.  This is where
-    			// we will interpolate the boundary value function.
-    			const std::vector<Point >& qface_point = fe_face->get_xyz();
-
-    			// Compute the shape function values on the element
-    			// face.
-    			fe_face->reinit(elem, side);
-
-    			// Loop over the face quadrature points for integration.
-    			for (unsigned int qp=0; qp<qface.n_points(); qp++)
-    			{
-
-    				// The location on the boundary of the current
-    				// face quadrature point.
-    				const Real xf = qface_point[qp](0);
-    				const Real yf = qface_point[qp](1);
-
-    				// The penalty value.  \frac{1}{\epsilon}
-    				// in the discussion above.
-    				const Real penalty = 1.e10;
-
-    				// The boundary value.
-    				const Real value = 20.;//exact_solution(xf, yf);
-
-    				// Matrix contribution of the L2 projection.
-    				for (unsigned int i=0; i<phi_face.size(); i++)
-    				for (unsigned int j=0; j<phi_face.size(); j++)
-    				Ke(i,j) += JxW_face[qp]*penalty*phi_face[i][qp]*phi_face[j][qp];
-
-    				// Right-hand-side contribution of the L2
-    				// projection.
-    				for (unsigned int i=0; i<phi_face.size(); i++)
-    				Fe(i) += JxW_face[qp]*penalty*value*phi_face[i][qp];
-    			}
-    		}
-    	}
-    }/*/
-
-    // We have now finished the quadrature point loop,
-    // and have therefore applied all the boundary conditions.
-    //
-    // The element matrix and right-hand-side are now built
-    // for this element.  Add them to the global matrix and
-    // right-hand-side vector.  The  SparseMatrix::add_matrix()
-    // and  NumericVector::add_vector() members do this for us.
-    //	system.matrix->add_matrix (Ke, dof_indices);
-    //	system.rhs->add_vector    (Fe, dof_indices);
-
-    delete []K;
-    delete []F;
-    delete []CB;
+      MatSetValues(A, n_node2, &dofs[0], n_node2, &dofs[0], &K[0], ADD_VALUES);
 
+      nodes += n_node;
+    }
   }
 
-  // All done!
+  MatAssemblyBegin(A, MAT_FINAL_ASSEMBLY);
+  MatAssemblyEnd(A, MAT_FINAL_ASSEMBLY);
+
+  STOP_LOG("build_matrix()", "StressSolver");
 }
 
 void StressSolver::build_rhs(Vec b)
 {
-  //std::cout<<"here b"<<std::endl;
+  // the load vector is integrated together with the stiff matrix in build_matrix()
+  VecZeroEntries(b);
+
+  std::vector<PetscInt> dofs;
+  dofs.reserve(_node_load.size());
+  for(unsigned int i=0; i<_node_offset.size(); ++i)
+    for(unsigned int j=0; j<3; ++j)
+      dofs.push_back(_node_offset[i] + j);
+
+  if( !dofs.empty() )
+    VecSetValues(b, dofs.size(), &dofs[0], &_node_load[0], ADD_VALUES);
+
+  VecAssemblyBegin(b);
+  VecAssemblyEnd(b);
 }
 
@@ -23,6 +23,7 @@
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 
 #include "genius_common.h"
@@ -41,7 +42,7 @@ using  PhysicalUnit::s;
 
 
 FieldSource::FieldSource(SimulationSystem & system, Parser::InputParser & decks)
-  :_system(system), _decks(decks), _applied_to_system(false), current_waveform(0)
+  :_system(system), _decks(decks), _applied_to_system(false), _generation_valid(false), current_waveform(0)
 {
 
   // check if any waveform defined
@@ -273,36 +274,47 @@ void FieldSource::update(double time, bool force_update_source)
 
   if( _applied_to_system == false ) this->update_source();
 
+  // the spatial profile of each source is fixed, OptG and PatG only change with the time scale.
+  // rebuild them when any scale differs from the last update
+  std::vector<double> scale;
+  scale.reserve(_particle_sources.size() + _light_sources.size());
+  for(unsigned int n=0; n<_particle_sources.size(); ++n)
+    scale.push_back(_particle_sources[n]->carrier_generation_step(time));
+  for(unsigned int n=0; n<_light_sources.size(); ++n)
+    scale.push_back(_light_sources[n]->carrier_generation_step(time));
 
-  // clear old particle and optical generation
-  for(unsigned int n=0; n<_system.n_regions(); n++)
+  if( !_generation_valid || scale != _generation_scale )
   {
-    SimulationRegion * region = _system.region(n);
+    // clear old particle and optical generation
+    for(unsigned int n=0; n<_system.n_regions(); n++)
     {
-      SimulationRegion::processor_node_iterator it = region->on_local_nodes_begin();
-      SimulationRegion::processor_node_iterator it_end = region->on_local_nodes_end();
-      for(; it!=it_end; ++it)
+      SimulationRegion * region = _system.region(n);
       {
-        FVM_Node * fvm_node = (*it);
-        FVM_NodeData * fvm_node_data = fvm_node->node_data();
-        fvm_node_data->PatG() = 0.0;
-        fvm_node_data->OptG() = 0.0;
+        SimulationRegion::processor_node_iterator it = region->on_local_nodes_begin();
+        SimulationRegion::processor_node_iterator it_end = region->on_local_nodes_end();
+        for(; it!=it_end; ++it)
+        {
+          FVM_Node * fvm_node = (*it);
+          FVM_NodeData * fvm_node_data = fvm_node->node_data();
+          fvm_node_data->PatG() = 0.0;
+          fvm_node_data->OptG() = 0.0;
+        }
       }
     }
-  }
 
-  // let particle source update the PatG
-  std::vector<Particle_Source *>::iterator pit = _particle_sources.begin();
-  for(; pit!=_particle_sources.end(); ++pit)
-  {
-    (*pit)->carrier_generation(time);
-  }
+    // let particle source update the PatG
+    for(unsigned int n=0; n<_particle_sources.size(); ++n)
+      _particle_sources[n]->carrier_generation(time);
 
-  // let light source update the OptG
-  std::vector<Light_Source *>::iterator lit = _light_sources.begin();
-  for(; lit!=_light_sources.end(); ++lit)
-    (*lit)->carrier_generation(time);
+    // let light source update the OptG
+    for(unsigned int n=0; n<_light_sources.size(); ++n)
+      _light_sources[n]->carrier_generation(time);
 
+    _generation_scale = scale;
+    _generation_valid = true;
+  }
+
+  // Field_G is always rebuilt, hooks may add their own generation to it
 
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
@@ -371,10 +383,58 @@ void FieldSource::update_source()
 #endif
 
   _applied_to_system = true;
+  _generation_valid = false;
 }
 
 
 
+void FieldSource::clear_mesh_data()
+{
+  for(unsigned int n=0; n<_particle_sources.size(); ++n)
+    _particle_sources[n]->clear_mesh_data();
+
+  for(unsigned int n=0; n<_light_sources.size(); ++n)
+    _light_sources[n]->clear_mesh_data();
+
+  _applied_to_system = false;
+  _generation_valid = false;
+}
+
+
+unsigned int FieldSource::n_particle_events() const
+{
+  unsigned int n_events = _particle_sources.empty() ? 0 : 1;
+  for(unsigned int n=0; n<_particle_sources.size(); ++n)
+    n_events = std::max(n_events, _particle_sources[n]->n_events());
+  return n_events;
+}
+
+
+std::string FieldSource::particle_event_label(unsigned int e) const
+{
+  for(unsigned int n=0; n<_particle_sources.size(); ++n)
+    if( e < _particle_sources[n]->n_events() && !_particle_sources[n]->event_label(e).empty() )
+      return _particle_sources[n]->event_label(e);
+
+  std::stringstream ss;
+  ss << "event" << e;
+  return ss.str();
+}
+
+
+void FieldSource::select_particle_event(unsigned int e)
+{
+  for(unsigned int n=0; n<_particle_sources.size(); ++n)
+    if( _particle_sources[n]->n_events() > 1 )
+    {
+      genius_assert( e < _particle_sources[n]->n_events() );
+      _particle_sources[n]->select_event(e);
+    }
+
+  this->update_source();
+}
+
+
 double FieldSource::limit_dt(double time, double dt, double dt_min) const
 {
   std::vector<Particle_Source *>::const_iterator pit = _particle_sources.begin();
@@ -0,0 +1,90 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include "genius_common.h"
+#include "generation_profile.h"
+#include "simulation_system.h"
+#include "simulation_region.h"
+#include "fvm_node_info.h"
+#include "fvm_node_data.h"
+
+
+double & GenerationProfile::operator[] (const FVM_Node *fvm_node)
+{
+  _dummy = 0.0;
+
+  if( !fvm_node->on_processor() ) return _dummy;
+
+  const unsigned int r = fvm_node->subdomain_id();
+  SimulationRegion * region = _system.region(r);
+  if( region->type() != SemiconductorRegion ) return _dummy;
+
+  if( _profile.size() < _system.n_regions() )
+    _profile.resize(_system.n_regions());
+
+  // size the profile as node data storage, ghost entries stay zero
+  std::vector<double> & profile = _profile[r];
+  const unsigned int size = region->node_data_storage().size();
+  if( profile.size() != size )
+    profile.resize(size, 0.0);
+
+  return profile[fvm_node->node_data()->offset()];
+}
+
+
+double GenerationProfile::operator[] (const FVM_Node *fvm_node) const
+{
+  const unsigned int r = fvm_node->subdomain_id();
+  if( r >= _profile.size() ) return 0.0;
+
+  const unsigned int offset = fvm_node->node_data()->offset();
+  if( offset >= _profile[r].size() ) return 0.0;
+
+  return _profile[r][offset];
+}
+
+
+void GenerationProfile::clear()
+{
+  _profile.clear();
+}
+
+
+void GenerationProfile::apply(unsigned int v, double scale) const
+{
+  for(unsigned int r=0; r<_profile.size(); ++r)
+  {
+    const std::vector<double> & profile = _profile[r];
+    if( profile.empty() ) continue;
+
+    DataStorage & storage = _system.region(r)->node_data_storage();
+    // region node data must not change after the profile was built,
+    // field source clears the profile on mesh change
+    genius_assert( storage.size() == profile.size() );
+
+    PetscScalar * g = storage.scalar_block(v);
+    const double * p = &profile[0];
+    const unsigned int n = profile.size();
+    for(unsigned int i=0; i<n; ++i)
+      g[i] += scale*p[i];
+  }
+}
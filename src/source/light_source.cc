@@ -26,6 +26,7 @@
 #include "simulation_system.h"
 #include "simulation_region.h"
 #include "semiconductor_region.h"
+#include "fvm_node_data_semiconductor.h"
 #include "interpolation_2d_csa.h"
 #include "interpolation_2d_nn.h"
 //#include "interpolation_3d_qshep.h"
@@ -48,6 +49,12 @@ using PhysicalUnit::h;
 
 
 void Light_Source::carrier_generation(double t)
+{
+  _fvm_node_particle_deposit.apply(FVM_Semiconductor_NodeData::_OptG_, carrier_generation_step(t));
+}
+
+
+double Light_Source::carrier_generation_step(double t)
 {
   double optical_gen_waveform = 1.0;
   if(SolverSpecify::TimeDependent)
@@ -57,23 +64,7 @@ void Light_Source::carrier_generation(double t)
     else if(_waveform)
       optical_gen_waveform = 0.5*(_waveform->waveform(t) + _waveform->waveform(t-SolverSpecify::dt));
   }
-
-  for(unsigned int n=0; n<_system.n_regions(); n++)
-  {
-    SimulationRegion * region = _system.region(n);
-
-    if( region->type() != SemiconductorRegion ) continue;
-
-    SimulationRegion::processor_node_iterator it = region->on_processor_nodes_begin();
-    SimulationRegion::processor_node_iterator it_end = region->on_processor_nodes_end();
-    for(; it!=it_end; ++it)
-    {
-      FVM_Node * fvm_node = (*it);
-      FVM_NodeData * node_data = fvm_node->node_data();
-
-      node_data->OptG() += _fvm_node_particle_deposit[fvm_node]*optical_gen_waveform;
-    }
-  }
+  return optical_gen_waveform;
 }
 
 double Light_Source::limit_dt(double time, double dt, double dt_min) const
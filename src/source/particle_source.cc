@@ -28,6 +28,7 @@
 #include "simulation_system.h"
 #include "simulation_region.h"
 #include "semiconductor_region.h"
+#include "fvm_node_data_semiconductor.h"
 #include "insulator_region.h"
 #include "interpolation_2d_csa.h"
 //#include "interpolation_3d_qshep.h"
@@ -54,24 +55,13 @@ using PhysicalUnit::g;
 
 void Particle_Source::carrier_generation(double t)
 {
-  double ct = 0.5*(carrier_generation_t(t+0.5*SolverSpecify::dt) + carrier_generation_t(t-0.5*SolverSpecify::dt));
-
-  for(unsigned int n=0; n<_system.n_regions(); n++)
-  {
-    SimulationRegion * region = _system.region(n);
-
-    if( region->type() != SemiconductorRegion ) continue;
+  _fvm_node_particle_deposit.apply(FVM_Semiconductor_NodeData::_PatG_, carrier_generation_step(t));
+}
 
-    SimulationRegion::processor_node_iterator it = region->on_processor_nodes_begin();
-    SimulationRegion::processor_node_iterator it_end = region->on_processor_nodes_end();
-    for(; it!=it_end; ++it)
-    {
-      FVM_Node * fvm_node = (*it);
-      FVM_NodeData * node_data = fvm_node->node_data();
 
-      node_data->PatG() += _fvm_node_particle_deposit[fvm_node]*ct;
-    }
-  }
+double Particle_Source::carrier_generation_step(double t) const
+{
+  return 0.5*(carrier_generation_t(t+0.5*SolverSpecify::dt) + carrier_generation_t(t-0.5*SolverSpecify::dt));
 }
 
 
@@ -494,7 +484,33 @@ Particle_Source_Track::Particle_Source_Track(SimulationSystem &system, const Par
   if(!hdf5_file.empty())
     _read_particle_profile_track_hdf5(hdf5_file, event_path, c.get_real("lateral.char", 0.1));
 #endif
+
+  // without event lines, all the tracks make up a single event
+  if( _event_begin.empty() )
+  {
+    _event_begin.push_back(0);
+    _event_labels.push_back(std::string());
+  }
+  _event_begin.push_back(_tracks.size());
+  _event = 0;
+
   MESSAGE<<"ok\n"<<std::endl; RECORD();
+  if( n_events() > 1 )
+  {
+    MESSAGE<<"  "<<n_events()<<" particle events found.\n"<<std::endl; RECORD();
+  }
+}
+
+
+Particle_Source_Track::~Particle_Source_Track()
+{}
+
+
+
+void Particle_Source_Track::clear_mesh_data()
+{
+  Particle_Source::clear_mesh_data();
+  _nn_locator.reset();
 }
 
 
@@ -502,6 +518,9 @@ Particle_Source_Track::Particle_Source_Track(SimulationSystem &system, const Par
 void Particle_Source_Track::_read_particle_profile_track_evt(const std::string & filename, Real lateral_char)
 {
   std::vector<double> meta_data;
+  // a line "event <label>" starts a new event, tracks before it belong to an unnamed event
+  std::vector<unsigned int> event_begin;
+  std::string event_labels;
   if(Genius::processor_id()==0)
   {
     std::ifstream in(filename.c_str());
@@ -523,6 +542,20 @@ void Particle_Source_Track::_read_particle_profile_track_evt(const std::string &
       ss >> particle;
       if(particle.empty()) continue;
 
+      if(particle == "event")
+      {
+        if( event_begin.empty() && !meta_data.empty() )
+        {
+          event_begin.push_back(0);
+          event_labels += '\n';
+        }
+        std::string label;
+        ss >> label;
+        event_begin.push_back(meta_data.size()/8);
+        event_labels += label + '\n';
+        continue;
+      }
+
       double p1[3], p2[3], energy, sigma=lateral_char;
       ss >>  p1[0] >> p1[1] >> p1[2] >> p2[0] >> p2[1] >> p2[2] >> energy;
       if(!ss.eof()) { ss >> sigma;}
@@ -549,6 +582,20 @@ void Particle_Source_Track::_read_particle_profile_track_evt(const std::string &
   }
 
   Parallel::broadcast(meta_data);
+  Parallel::broadcast(event_begin);
+  Parallel::broadcast(event_labels);
+
+  {
+    std::stringstream ss(event_labels);
+    for(unsigned int e=0; e<event_begin.size(); ++e)
+    {
+      std::string label;
+      std::getline(ss, label);
+      _event_begin.push_back(_tracks.size() + event_begin[e]);
+      _event_labels.push_back(label);
+    }
+  }
+
   for(unsigned int n=0; n<meta_data.size()/8; ++n)
   {
     track_t track;
@@ -684,11 +731,20 @@ void Particle_Source_Track::update_source()
   std::vector<double> region_energy(_system.n_regions(), 0.0);
   double total_energy=0.0;
 
-  AutoPtr<NearestNodeLocator> nn_locator( new NearestNodeLocator(_system.mesh()) );
+  // the locator only depends on mesh, keep it for later events,
+  // clear_mesh_data() drops it when the mesh changes
+  if( !_nn_locator.get() )
+    _nn_locator.reset( new NearestNodeLocator(_system.mesh()) );
+  NearestNodeLocator * nn_locator = _nn_locator.get();
 
-  for(unsigned int t=0; t<_tracks.size(); ++t)
+  // deposit of previous event
+  _fvm_node_particle_deposit.clear();
+
+  const unsigned int t_begin = _event_begin[_event];
+  const unsigned int t_end   = _event_begin[_event+1];
+  for(unsigned int t=t_begin; t<t_end; ++t)
   {
-    if( t%(1+_tracks.size()/20) ==0 )
+    if( (t-t_begin)%(1+(t_end-t_begin)/20) ==0 )
     {
       MESSAGE<< ".";
       RECORD();
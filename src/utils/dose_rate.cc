@@ -19,7 +19,9 @@
 /*                                                                              */
 /********************************************************************************/
 #include <numeric>
+#include <algorithm>
 
+#include "omp_threads.h"
 
 #include "dose_rate.h"
 #include "simulation_system.h"
@@ -66,6 +68,7 @@ DoseRate::DoseRate(const SimulationSystem & system )
   _octree = new OcTree(low, high, root_data, 3);
   _octree->refine();
 
+  this->_build_leaves();
 }
 
 
@@ -78,85 +81,138 @@ DoseRate::~DoseRate()
 
 void DoseRate::refine()
 {
+  this->_store_leaf_energy();
   _octree->refine();
+  this->_build_leaves();
 }
 
 
 
-void DoseRate::energy_deposite(const Point &p1, const Point &p2, double e)
+void DoseRate::_build_leaves()
+{
+  _linear_octree.build(*_octree);
+
+  std::vector<OcTreeDataDoseRate *> tree_leaf_data;
+  OcTree::tree_leaf_iterator leaf_it = _octree->begin_leaf();
+  for ( ; leaf_it != _octree->end_leaf(); ++leaf_it )
+    tree_leaf_data.push_back( dynamic_cast<OcTreeDataDoseRate *>(leaf_it->data()) );
+
+  const unsigned int n_leaves = _linear_octree.n_leaves();
+  _leaf_data.resize(n_leaves);
+  _leaf_energy.resize(n_leaves);
+  _leaf_density.resize(n_leaves);
+  _leaf_volume.resize(n_leaves);
+  for(unsigned int n=0; n<n_leaves; ++n)
+  {
+    OcTreeDataDoseRate * dose_rate = tree_leaf_data[_linear_octree.tree_leaf(n)];
+    _leaf_data[n]    = dose_rate;
+    _leaf_energy[n]  = dose_rate->electron_energy;
+    _leaf_density[n] = dose_rate->weighted_density;
+    _leaf_volume[n]  = _linear_octree.volume(n);
+  }
+}
+
+
+
+void DoseRate::_store_leaf_energy()
+{
+  for(unsigned int n=0; n<_leaf_data.size(); ++n)
+    _leaf_data[n]->electron_energy = _leaf_energy[n];
+}
+
+
+
+void DoseRate::_deposite(const Point &p1, const Point &p2, double e, double * energy,
+                         std::vector<std::pair<unsigned int, Real> > & hits) const
 {
   const double length = (p2-p1).size();
   if(length == 0.0) return;
 
-  std::vector<std::pair<OcTreeNode, double> > result;
-  _octree->intersect(p1, p2, result);
+  hits.clear();
+  _linear_octree.intersect(p1, p2, hits);
 
-  for(unsigned int n=0; n<result.size(); ++n)
-  {
-    const OcTreeNode & node = result[n].first;
-    const double l = result[n].second;
+  const double e_per_length = e/length;
+  for(unsigned int n=0; n<hits.size(); ++n)
+    energy[hits[n].first] += e_per_length*hits[n].second;
+}
 
-    OcTreeDataDoseRate * dose_rate = dynamic_cast<OcTreeDataDoseRate *>(node.data());
-    dose_rate->electron_energy += e*l/length;
-  }
+
+
+void DoseRate::energy_deposite(const Point &p1, const Point &p2, double e)
+{
+  std::vector<std::pair<unsigned int, Real> > hits;
+  _deposite(p1, p2, e, &_leaf_energy[0], hits);
 }
 
 
 
-void DoseRate::sync_energy_deposite()
+void DoseRate::energy_deposite(const std::vector<Point> &p1, const std::vector<Point> &p2, const std::vector<double> &e)
 {
-  std::vector<double> energy;
-  OcTree::tree_leaf_iterator leaf_it = _octree->begin_leaf();
-  for ( ; leaf_it != _octree->end_leaf(); ++leaf_it )
-  {
-    OcTreeDataDoseRate * dose_rate = dynamic_cast<OcTreeDataDoseRate *>(leaf_it->data());
-    energy.push_back(dose_rate->electron_energy);
-  }
-  Parallel::sum(energy);
+  genius_assert(p1.size() == p2.size() && p1.size() == e.size());
+  const int n_tracks = static_cast<int>(p1.size());
+
+  // a track walks many cells, weight it as ten node updates
+  const int n_threads = OmpThreads::loop_threads(n_tracks, 10);
+
+  // master thread deposites to _leaf_energy, the others to their own accumulator
+  if( static_cast<int>(_thread_energy.size()) < n_threads-1 )
+    _thread_energy.resize(n_threads-1);
+  for(int t=0; t<n_threads-1; ++t)
+    _thread_energy[t].assign(_leaf_energy.size(), 0.0);
 
-  leaf_it = _octree->begin_leaf();
-  for (unsigned int n=0 ; leaf_it != _octree->end_leaf(); ++leaf_it, ++n )
+#ifdef HAVE_OPENMP
+  #pragma omp parallel num_threads(n_threads)
+#endif
   {
-    OcTreeDataDoseRate * dose_rate = dynamic_cast<OcTreeDataDoseRate *>(leaf_it->data());
-    dose_rate->electron_energy = energy[n];
+#ifdef HAVE_OPENMP
+    const int tid = omp_get_thread_num();
+#else
+    const int tid = 0;
+#endif
+    double * energy = tid ? &_thread_energy[tid-1][0] : &_leaf_energy[0];
+    std::vector<std::pair<unsigned int, Real> > hits;
+
+#ifdef HAVE_OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for(int n=0; n<n_tracks; ++n)
+      _deposite(p1[n], p2[n], e[n], energy, hits);
   }
+
+  for(int t=0; t<n_threads-1; ++t)
+    for(unsigned int n=0; n<_leaf_energy.size(); ++n)
+      _leaf_energy[n] += _thread_energy[t][n];
+}
+
+
+
+void DoseRate::sync_energy_deposite()
+{
+  Parallel::sum(_leaf_energy);
 }
 
 
 
 void DoseRate::clear_energy_deposite()
 {
-  OcTree::tree_leaf_iterator leaf_it = _octree->begin_leaf();
-  for ( ; leaf_it != _octree->end_leaf(); ++leaf_it )
-  {
-    OcTreeDataDoseRate * dose_rate = dynamic_cast<OcTreeDataDoseRate *>(leaf_it->data());
-    dose_rate->electron_energy = 0.0;
-  }
+  std::fill(_leaf_energy.begin(), _leaf_energy.end(), 0.0);
 }
 
 
 double DoseRate::total_energy() const
 {
-  double energy = 0.0;
-  OcTree::tree_leaf_iterator leaf_it = _octree->begin_leaf();
-  for ( ; leaf_it != _octree->end_leaf(); ++leaf_it )
-  {
-    OcTreeDataDoseRate * dose_rate = dynamic_cast<OcTreeDataDoseRate *>(leaf_it->data());
-    energy += dose_rate->electron_energy;
-  }
-  return energy;
+  return std::accumulate(_leaf_energy.begin(), _leaf_energy.end(), 0.0);
 }
 
 
 
 double DoseRate::energy_deposite_density(const Point & p) const
 {
-  OcTree::tree_iterator_base it = _octree->find_leaf_has_point(p);
-  double volume = it->volume();
+  const unsigned int n = _linear_octree.locate(p);
+  if( n == invalid_uint ) return 0.0;
 
-  OcTreeDataDoseRate * dose_rate = dynamic_cast<OcTreeDataDoseRate *>(it->data());
-  if(dose_rate->weighted_density > 0.0)
-    return dose_rate->electron_energy/volume/dose_rate->weighted_density;
+  if(_leaf_density[n] > 0.0)
+    return _leaf_energy[n]/_leaf_volume[n]/_leaf_density[n];
   return 0.0;
 }
 
@@ -177,6 +233,8 @@ void DoseRate::export_vtk(const std::string &file)
   sync_energy_deposite();
   */
 
+  this->_store_leaf_energy();
+
   if(Genius::processor_id() == 0)
     _octree->export_vtk(file);
 }
@@ -186,21 +244,16 @@ void DoseRate::export_vtk(const std::string &file)
 
 void DoseRate::particle_endpoint(const Point &p)
 {
-  OcTree::tree_iterator_base it = _octree->find_leaf_has_point(p);
-  if( it.node==0 ) return;
-  OcTreeDataDoseRate * dose_rate = dynamic_cast<OcTreeDataDoseRate *>(it->data());
-  dose_rate->electron_endpoint.push_back(p);
+  const unsigned int n = _linear_octree.locate(p);
+  if( n == invalid_uint ) return;
+  _leaf_data[n]->electron_endpoint.push_back(p);
 }
 
 
 void DoseRate::clear_particle_endpoint()
 {
-  OcTree::tree_leaf_iterator leaf_it = _octree->begin_leaf();
-  for ( ; leaf_it != _octree->end_leaf(); ++leaf_it )
-  {
-    OcTreeDataDoseRate * dose_rate = dynamic_cast<OcTreeDataDoseRate *>(leaf_it->data());
-    dose_rate->electron_endpoint.clear();
-  }
+  for(unsigned int n=0; n<_leaf_data.size(); ++n)
+    _leaf_data[n]->electron_endpoint.clear();
 }
 
 
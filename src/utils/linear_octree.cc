@@ -0,0 +1,283 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "genius_env.h"
+#include "linear_octree.h"
+#include "octree.h"
+
+
+namespace
+{
+  typedef unsigned long long code_type;
+
+  /**
+   * insert two zero bits between each of the lower 21 bits of v
+   */
+  inline code_type morton_spread(unsigned int v)
+  {
+    code_type x = v & 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffffULL;
+    x = (x | x << 16) & 0x1f0000ff0000ffULL;
+    x = (x | x << 8)  & 0x100f00f00f00f00fULL;
+    x = (x | x << 4)  & 0x10c30c30c30c30c3ULL;
+    x = (x | x << 2)  & 0x1249249249249249ULL;
+    return x;
+  }
+
+  /**
+   * inverse of morton_spread
+   */
+  inline unsigned int morton_compact(code_type x)
+  {
+    x &= 0x1249249249249249ULL;
+    x = (x ^ (x >> 2))  & 0x10c30c30c30c30c3ULL;
+    x = (x ^ (x >> 4))  & 0x100f00f00f00f00fULL;
+    x = (x ^ (x >> 8))  & 0x1f0000ff0000ffULL;
+    x = (x ^ (x >> 16)) & 0x1f00000000ffffULL;
+    x = (x ^ (x >> 32)) & 0x1fffffULL;
+    return static_cast<unsigned int>(x);
+  }
+
+  /**
+   * grid cell index of grid coordinate x, clamped to [lo, hi]
+   */
+  inline unsigned int grid_cell(Real x, unsigned int lo, unsigned int hi)
+  {
+    const Real i = std::floor(x);
+    if( i <= static_cast<Real>(lo) ) return lo;
+    if( i >= static_cast<Real>(hi) ) return hi;
+    return static_cast<unsigned int>(i);
+  }
+}
+
+
+
+LinearOcTree::code_type LinearOcTree::_encode(const unsigned int * ijk)
+{
+  return morton_spread(ijk[0]) | (morton_spread(ijk[1]) << 1) | (morton_spread(ijk[2]) << 2);
+}
+
+
+void LinearOcTree::_decode(code_type code, unsigned int * ijk)
+{
+  ijk[0] = morton_compact(code);
+  ijk[1] = morton_compact(code >> 1);
+  ijk[2] = morton_compact(code >> 2);
+}
+
+
+
+void LinearOcTree::clear()
+{
+  _code.clear();
+  _level.clear();
+  _tree_leaf.clear();
+}
+
+
+
+void LinearOcTree::build(const OcTree & octree)
+{
+  this->clear();
+
+  const OcTreeLocation low_corner(OcTreeLocation::L_Left, OcTreeLocation::L_Bottom, OcTreeLocation::L_Back);
+  const OcTreeLocation high_corner(OcTreeLocation::L_Right, OcTreeLocation::L_Top, OcTreeLocation::L_Front);
+
+  // root box
+  OcTree::tree_iterator_base root = octree.begin();
+  const Point & low  = *root->get_point(low_corner);
+  const Point & high = *root->get_point(high_corner);
+  const Real n_cells = static_cast<Real>(1u << max_level);
+  _low = low;
+  for(unsigned int a=0; a<3; ++a)
+  {
+    _size[a]  = high(a) - low(a);
+    _scale[a] = n_cells/_size[a];
+  }
+
+  // code and level of each leaf, the leaf corner is always on the grid
+  std::vector< std::pair<code_type, unsigned int> > leaves;
+  std::vector<unsigned char> level;
+  OcTree::tree_leaf_iterator leaf_it = octree.begin_leaf();
+  for (unsigned int n=0; leaf_it != octree.end_leaf(); ++leaf_it, ++n )
+  {
+    const Point & p = *leaf_it->get_point(low_corner);
+    unsigned int ijk[3];
+    for(unsigned int a=0; a<3; ++a)
+      ijk[a] = static_cast<unsigned int>(std::floor((p(a) - _low(a))*_scale[a] + 0.5));
+
+    const Real cells = leaf_it->x_size()*_scale[0];
+    const int l = static_cast<int>(max_level) - static_cast<int>(std::floor(std::log(cells)/std::log(2.0) + 0.5));
+    genius_assert( l >= 0 && l <= static_cast<int>(max_level) );
+
+    leaves.push_back( std::make_pair(_encode(ijk), n) );
+    level.push_back( static_cast<unsigned char>(l) );
+  }
+
+  std::sort(leaves.begin(), leaves.end());
+
+  _code.reserve(leaves.size());
+  _level.reserve(leaves.size());
+  _tree_leaf.reserve(leaves.size());
+  for(unsigned int n=0; n<leaves.size(); ++n)
+  {
+    _code.push_back(leaves[n].first);
+    _level.push_back(level[leaves[n].second]);
+    _tree_leaf.push_back(leaves[n].second);
+  }
+}
+
+
+
+Real LinearOcTree::volume(unsigned int n) const
+{
+  return std::ldexp(_size[0]*_size[1]*_size[2], -3*static_cast<int>(_level[n]));
+}
+
+
+
+unsigned int LinearOcTree::_find(const unsigned int * ijk) const
+{
+  // leaves in Morton order, each one covers a continuous range of codes starting from its own code
+  const code_type code = _encode(ijk);
+  std::vector<code_type>::const_iterator it = std::upper_bound(_code.begin(), _code.end(), code);
+  return static_cast<unsigned int>(it - _code.begin()) - 1;
+}
+
+
+
+unsigned int LinearOcTree::locate(const Point & p) const
+{
+  if( _code.empty() ) return invalid_uint;
+
+  const unsigned int N = 1u << max_level;
+  unsigned int ijk[3];
+  for(unsigned int a=0; a<3; ++a)
+  {
+    const Real x = (p(a) - _low(a))*_scale[a];
+    if( x < 0.0 || x > static_cast<Real>(N) ) return invalid_uint;
+    ijk[a] = grid_cell(x, 0, N-1);
+  }
+  return _find(ijk);
+}
+
+
+
+void LinearOcTree::intersect(const Point & p1, const Point & p2, std::vector<std::pair<unsigned int, Real> > & result) const
+{
+  if( _code.empty() ) return;
+
+  const Real length = (p2-p1).size();
+  if( length == 0.0 ) return;
+  const Point dir = (p2-p1)/length;
+
+  const unsigned int N = 1u << max_level;
+  const Real inf = std::numeric_limits<Real>::infinity();
+
+  // the segment in grid coordinate is o + g*t, t is the length along the segment.
+  // clip t to the root box
+  Real o[3], g[3];
+  Real t_begin = 0.0, t_end = length;
+  for(unsigned int a=0; a<3; ++a)
+  {
+    o[a] = (p1(a) - _low(a))*_scale[a];
+    g[a] = dir(a)*_scale[a];
+    if( g[a] != 0.0 )
+    {
+      Real ta = -o[a]/g[a];
+      Real tb = (static_cast<Real>(N) - o[a])/g[a];
+      if( ta > tb ) std::swap(ta, tb);
+      t_begin = std::max(t_begin, ta);
+      t_end   = std::min(t_end, tb);
+    }
+    else if( o[a] < 0.0 || o[a] > static_cast<Real>(N) )
+      return;
+  }
+  if( t_begin >= t_end ) return;
+
+  // the grid cell at the begin of the segment, a point on a cell face
+  // belongs to the cell the segment goes into
+  unsigned int ijk[3];
+  for(unsigned int a=0; a<3; ++a)
+  {
+    const Real x = o[a] + g[a]*t_begin;
+    if( g[a] < 0.0 && x == std::floor(x) )
+      ijk[a] = grid_cell(x - 1.0, 0, N-1);
+    else
+      ijk[a] = grid_cell(x, 0, N-1);
+  }
+
+  Real t = t_begin;
+  unsigned int leaf = _find(ijk);
+  while( true )
+  {
+    unsigned int lo[3];
+    _decode(_code[leaf], lo);
+    const unsigned int s = 1u << (max_level - _level[leaf]);
+
+    // exit the leaf at the nearest face
+    Real t_exit[3];
+    Real t_next = inf;
+    for(unsigned int a=0; a<3; ++a)
+    {
+      if( g[a] > 0.0 )      t_exit[a] = (static_cast<Real>(lo[a] + s) - o[a])/g[a];
+      else if( g[a] < 0.0 ) t_exit[a] = (static_cast<Real>(lo[a]) - o[a])/g[a];
+      else                  t_exit[a] = inf;
+      t_next = std::min(t_next, t_exit[a]);
+    }
+
+    if( t_next >= t_end )
+    {
+      if( t_end > t ) result.push_back( std::make_pair(leaf, t_end - t) );
+      return;
+    }
+    if( t_next > t ) result.push_back( std::make_pair(leaf, t_next - t) );
+
+    // grid cell just outside the exit face, step over all the faces hit at t_next
+    // (edge and corner crossing). the other directions stay inside this leaf
+    for(unsigned int a=0; a<3; ++a)
+    {
+      if( t_exit[a] <= t_next )
+      {
+        if( g[a] > 0.0 )
+        {
+          if( lo[a] + s >= N ) return;
+          ijk[a] = lo[a] + s;
+        }
+        else
+        {
+          if( lo[a] == 0 ) return;
+          ijk[a] = lo[a] - 1;
+        }
+      }
+      else
+        ijk[a] = grid_cell(o[a] + g[a]*t_next, lo[a], lo[a] + s - 1);
+    }
+
+    t = std::max(t, t_next);
+    leaf = _find(ijk);
+  }
+}
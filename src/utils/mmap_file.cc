@@ -0,0 +1,103 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <fstream>
+
+#include "genius_common.h"
+#include "mmap_file.h"
+
+#ifndef WINDOWS
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+
+MMapFile::MMapFile()
+  : _data(0), _size(0), _mapped(false)
+{}
+
+
+MMapFile::~MMapFile()
+{
+  close();
+}
+
+
+bool MMapFile::open(const std::string & filename)
+{
+  close();
+
+#ifndef WINDOWS
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if( fd < 0 ) return false;
+
+  struct stat st;
+  if( fstat(fd, &st) == 0 && st.st_size > 0 )
+  {
+    void * p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if( p != MAP_FAILED )
+    {
+      // the importers scan the file from begin to end
+      madvise(p, st.st_size, MADV_SEQUENTIAL);
+      _data = static_cast<const char *>(p);
+      _size = st.st_size;
+      _mapped = true;
+    }
+  }
+  ::close(fd);
+
+  if( _mapped ) return true;
+#endif
+
+  // fall back to read the whole file
+  std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+  if( !in.good() ) return false;
+
+  in.seekg(0, std::ios::end);
+  std::streamoff length = in.tellg();
+  in.seekg(0, std::ios::beg);
+
+  // keep one extra '\0' so an empty file still has valid _data
+  _buffer.resize(static_cast<size_t>(length) + 1, '\0');
+  in.read(&_buffer[0], length);
+
+  _data = &_buffer[0];
+  _size = static_cast<size_t>(length);
+  return true;
+}
+
+
+void MMapFile::close()
+{
+#ifndef WINDOWS
+  if( _mapped )
+    munmap(const_cast<char *>(_data), _size);
+#endif
+
+  _data = 0;
+  _size = 0;
+  _mapped = false;
+  std::vector<char>().swap(_buffer);
+}
@@ -27,6 +27,7 @@
 #include "surface_locator_base.h"
 #include "surface_locator_list.h"
 #include "surface_locator_sphere.h"
+#include "surface_locator_bvh.h"
 
 
 
@@ -50,6 +51,12 @@ AutoPtr<SurfaceLocatorBase> SurfaceLocatorBase::build (const SurfaceLocatorType
         return ap;
       }
 
+      case SurfaceLocator_BVH:
+      {
+        AutoPtr<SurfaceLocatorBase> ap(new SurfaceLocatorBVH(mesh, subdomain));
+        return ap;
+      }
+
       default:
       {
         std::cerr << "ERROR: Bad SurfaceLocatorType = " << t << std::endl;
@@ -79,6 +86,12 @@ AutoPtr<SurfaceLocatorBase> SurfaceLocatorBase::build (const SurfaceLocatorType
       return ap;
     }
 
+    case SurfaceLocator_BVH:
+    {
+      AutoPtr<SurfaceLocatorBase> ap(new SurfaceLocatorBVH(mesh, boundary));
+      return ap;
+    }
+
     default:
     {
       std::cerr << "ERROR: Bad SurfaceLocatorType = " << t << std::endl;
@@ -91,3 +104,14 @@ AutoPtr<SurfaceLocatorBase> SurfaceLocatorBase::build (const SurfaceLocatorType
   return ap;
 }
 
+
+
+void SurfaceLocatorBase::locate (const std::vector<Point> & points, std::vector<std::pair<const Elem*, unsigned int> > & elems,
+                                 std::vector<Point> & project_points, Real dist) const
+{
+  elems.resize(points.size());
+  project_points.resize(points.size());
+  for(unsigned int n=0; n<points.size(); ++n)
+    elems[n] = (*this)(points[n], project_points[n], dist);
+}
+
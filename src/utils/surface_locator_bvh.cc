@@ -0,0 +1,279 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+// C++ includes
+#include <algorithm>
+
+// Local Includes
+#include "mesh_base.h"
+#include "boundary_info.h"
+#include "elem.h"
+#include "surface_locator_bvh.h"
+
+
+namespace
+{
+  /**
+   * order element index by the center coordinate in given axis
+   */
+  struct CenterLess
+  {
+    CenterLess(const std::vector<Point> & c, unsigned int axis) : center(c), k(axis) {}
+    bool operator() (unsigned int a, unsigned int b) const
+    { return center[a](k) < center[b](k); }
+    const std::vector<Point> & center;
+    unsigned int k;
+  };
+}
+
+
+
+//------------------------------------------------------------------
+// SurfaceLocator methods
+SurfaceLocatorBVH::SurfaceLocatorBVH (const MeshBase& mesh, const unsigned int subdomain) :
+    SurfaceLocatorBase (mesh, subdomain)
+{
+  this->init();
+}
+
+
+SurfaceLocatorBVH::SurfaceLocatorBVH (const MeshBase& mesh, const short int boundary) :
+    SurfaceLocatorBase (mesh, boundary)
+{
+  this->init();
+}
+
+
+SurfaceLocatorBVH::~SurfaceLocatorBVH ()
+{
+  this->clear ();
+}
+
+
+
+void SurfaceLocatorBVH::clear ()
+{
+  for(unsigned int n=0; n<_leaf_elems.size(); ++n)
+    delete _leaf_elems[n];
+  _leaf_elems.clear();
+  _leaf_volume_elems.clear();
+  _bvh_nodes.clear();
+}
+
+
+
+void SurfaceLocatorBVH::init()
+{
+  std::vector<unsigned int>       elems;
+  std::vector<unsigned short int> sides;
+  std::vector<short int>          bds;
+  _mesh.boundary_info->build_active_side_list (elems, sides, bds);
+
+  std::vector<const Elem *> surface_elems;
+  std::vector<std::pair<const Elem *, unsigned int> > volume_elems;
+  std::vector<Point> elem_min, elem_max, elem_center;
+
+  for(unsigned int n=0; n<elems.size(); ++n)
+  {
+    const Elem * elem = _mesh.elem(elems[n]);
+    if(subdomain_locator() && elem->subdomain_id() != _subdomain) continue;
+    if(boundary_locator() && bds[n] != _boundary) continue;
+
+    const Elem * surface_elem = elem->build_side(sides[n], false).release();
+    surface_elems.push_back(surface_elem);
+    volume_elems.push_back(std::make_pair(elem, static_cast<unsigned int>(sides[n])));
+
+    Point min(1.e30,   1.e30,  1.e30);
+    Point max(-1.e30, -1.e30, -1.e30);
+    for (unsigned int v=0; v<surface_elem->n_nodes(); v++)
+      for (unsigned int i=0; i<3; i++)
+      {
+        min(i) = std::min(min(i), surface_elem->point(v)(i));
+        max(i) = std::max(max(i), surface_elem->point(v)(i));
+      }
+    elem_min.push_back(min);
+    elem_max.push_back(max);
+    elem_center.push_back((min+max)*0.5);
+  }
+
+  // ready for take-off, an empty tree returns no hit
+  this->_initialized = true;
+  if( surface_elems.empty() ) return;
+
+  std::vector<unsigned int> order(surface_elems.size());
+  for(unsigned int n=0; n<order.size(); ++n)
+    order[n] = n;
+
+  _bvh_nodes.reserve(2*surface_elems.size()/_leaf_size + 1);
+  _build(0, order.size(), order, elem_min, elem_max, elem_center);
+
+  // store surface elements in leaf order, elements in the same leaf are adjacent in memory
+  _leaf_elems.resize(order.size());
+  _leaf_volume_elems.resize(order.size());
+  for(unsigned int n=0; n<order.size(); ++n)
+  {
+    _leaf_elems[n] = surface_elems[order[n]];
+    _leaf_volume_elems[n] = volume_elems[order[n]];
+  }
+}
+
+
+
+unsigned int SurfaceLocatorBVH::_build(unsigned int begin, unsigned int end, std::vector<unsigned int> & order,
+                                       const std::vector<Point> & elem_min, const std::vector<Point> & elem_max,
+                                       const std::vector<Point> & elem_center)
+{
+  unsigned int index = _bvh_nodes.size();
+  _bvh_nodes.push_back(BVHNode());
+
+  Point min(1.e30,   1.e30,  1.e30);
+  Point max(-1.e30, -1.e30, -1.e30);
+  Point cmin(1.e30,   1.e30,  1.e30);
+  Point cmax(-1.e30, -1.e30, -1.e30);
+  for(unsigned int n=begin; n<end; ++n)
+    for (unsigned int i=0; i<3; i++)
+    {
+      min(i) = std::min(min(i), elem_min[order[n]](i));
+      max(i) = std::max(max(i), elem_max[order[n]](i));
+      cmin(i) = std::min(cmin(i), elem_center[order[n]](i));
+      cmax(i) = std::max(cmax(i), elem_center[order[n]](i));
+    }
+
+  {
+    BVHNode & node = _bvh_nodes[index];
+    node.min = min;
+    node.max = max;
+    node.begin = begin;
+    node.end = end;
+    node.right = invalid_uint;
+    node.leaf = (end - begin <= _leaf_size);
+  }
+  if( end - begin <= _leaf_size ) return index;
+
+  // split at the median of element center along the longest axis
+  unsigned int axis = 0;
+  for (unsigned int i=1; i<3; i++)
+    if( cmax(i) - cmin(i) > cmax(axis) - cmin(axis) ) axis = i;
+
+  unsigned int mid = (begin + end)/2;
+  std::nth_element(order.begin()+begin, order.begin()+mid, order.begin()+end, CenterLess(elem_center, axis));
+
+  // left child is always index+1
+  _build(begin, mid, order, elem_min, elem_max, elem_center);
+  unsigned int right = _build(mid, end, order, elem_min, elem_max, elem_center);
+  // _bvh_nodes may be reallocated, access by index
+  _bvh_nodes[index].right = right;
+
+  return index;
+}
+
+
+
+Real SurfaceLocatorBVH::_dist_sq(const Point &p, const Point &min, const Point &max)
+{
+  Real d = 0.0;
+  for (unsigned int i=0; i<3; i++)
+  {
+    if( p(i) < min(i) ) d += (min(i)-p(i))*(min(i)-p(i));
+    else if( p(i) > max(i) ) d += (p(i)-max(i))*(p(i)-max(i));
+  }
+  return d;
+}
+
+
+
+std::pair<const Elem*, unsigned int> SurfaceLocatorBVH::operator() (const Point& p, Point & project_point, const Real dist) const
+{
+  int nearest_elem = -1;
+  Point nearest_point;
+  Real  voting_dist = dist;
+
+  if( _bvh_nodes.empty() ) return std::make_pair((const Elem*)0, invalid_uint);
+
+  // tree depth is about log2(n/_leaf_size), a small stack is enough
+  std::vector<unsigned int> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+
+  while( !stack.empty() )
+  {
+    const BVHNode & node = _bvh_nodes[stack.back()];
+    const unsigned int index = stack.back();
+    stack.pop_back();
+
+    if( _dist_sq(p, node.min, node.max) > voting_dist*voting_dist ) continue;
+
+    if( node.leaf )
+    {
+      for(unsigned int n=node.begin; n<node.end; ++n)
+      {
+        Real d;
+        Point np = _leaf_elems[n]->nearest_point(p, &d);
+        if( d <= voting_dist )
+        {
+          nearest_elem = n;
+          nearest_point = np;
+          voting_dist = d;
+        }
+      }
+      continue;
+    }
+
+    // visit the nearer child first, it is pushed last
+    const unsigned int left = index+1;
+    const unsigned int right = node.right;
+    Real dl = _dist_sq(p, _bvh_nodes[left].min, _bvh_nodes[left].max);
+    Real dr = _dist_sq(p, _bvh_nodes[right].min, _bvh_nodes[right].max);
+    if( dl < dr )
+    {
+      stack.push_back(right);
+      stack.push_back(left);
+    }
+    else
+    {
+      stack.push_back(left);
+      stack.push_back(right);
+    }
+  }
+
+  if( nearest_elem < 0 ) return std::make_pair((const Elem*)0, invalid_uint);
+
+  project_point = nearest_point;
+  return _leaf_volume_elems[nearest_elem];
+}
+
+
+
+void SurfaceLocatorBVH::locate (const std::vector<Point> & points, std::vector<std::pair<const Elem*, unsigned int> > & elems,
+                                std::vector<Point> & project_points, Real dist) const
+{
+  elems.resize(points.size());
+  project_points.resize(points.size());
+
+#ifdef HAVE_OPENMP
+  #pragma omp parallel for schedule(dynamic, 16)
+#endif
+  for(int n=0; n<static_cast<int>(points.size()); ++n)
+    elems[n] = (*this)(points[n], project_points[n], dist);
+}
+
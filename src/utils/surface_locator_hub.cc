@@ -63,6 +63,16 @@ std::pair<const Elem*, unsigned int> SurfaceLocatorHub::operator() (const Point&
 }
 
 
+void SurfaceLocatorHub::locate (const std::vector<Point> & points, const unsigned int subdomain,
+                                std::vector<std::pair<const Elem*, unsigned int> > & elems, std::vector<Point> & project_points, const Real dist)
+{
+  const SurfaceLocatorBase * & subdomain_surface_locator = _subdomain_surface_locators[subdomain];
+  if( subdomain_surface_locator == NULL )
+    subdomain_surface_locator = SurfaceLocatorBase::build(_type, _mesh, subdomain).release();
+  subdomain_surface_locator->locate(points, elems, project_points, dist);
+}
+
+
 std::pair<const Elem*, unsigned int> SurfaceLocatorHub::operator() (const Point& p, const short int boundary, Point & project_point, const Real dist)
 {
   if( _boundary_surface_locators.find(boundary) == _boundary_surface_locators.end() )
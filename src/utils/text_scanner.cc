@@ -0,0 +1,153 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cstdlib>
+#include <string>
+
+#include "text_scanner.h"
+
+
+namespace
+{
+  // powers of ten which are exact in double
+  const double exact_pow10[] =
+  {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  /**
+   * slow path, copy the token and let strtod do it
+   */
+  bool parse_real_strtod(const char * b, const char * e, double & v)
+  {
+    std::string buf(b, e);
+    for(unsigned int c=0; c<buf.size(); ++c)
+      if( buf[c] == 'd' || buf[c] == 'D' ) buf[c] = 'e';
+
+    char * stop;
+    v = strtod(buf.c_str(), &stop);
+    return stop != buf.c_str() && *stop == '\0';
+  }
+}
+
+
+
+bool TextScanner::get(long & v)
+{
+  const char * b, * e;
+  if( !token(b, e) ) return false;
+  return parse_integer(b, e, v);
+}
+
+
+bool TextScanner::get(double & v)
+{
+  const char * b, * e;
+  if( !token(b, e) ) return false;
+  return parse_real(b, e, v);
+}
+
+
+const char * TextScanner::find_line(const char * s) const
+{
+  const size_t n = std::strlen(s);
+  const char * p = _p;
+  while( p < _end )
+  {
+    if( static_cast<size_t>(_end - p) >= n && !std::strncmp(p, s, n) )
+      return p;
+    p = static_cast<const char *>(std::memchr(p, '\n', _end - p));
+    if( !p ) break;
+    ++p;
+  }
+  return _end;
+}
+
+
+bool TextScanner::parse_integer(const char * b, const char * e, long & v)
+{
+  const char * p = b;
+  bool negative = false;
+  if( p < e && (*p == '-' || *p == '+') ) negative = (*p++ == '-');
+  if( p == e ) return false;
+
+  long r = 0;
+  for( ; p < e; ++p )
+  {
+    unsigned int d = static_cast<unsigned int>(*p - '0');
+    if( d > 9 ) return false;
+    r = r*10 + d;
+  }
+  v = negative ? -r : r;
+  return true;
+}
+
+
+bool TextScanner::parse_real(const char * b, const char * e, double & v)
+{
+  const char * p = b;
+  bool negative = false;
+  if( p < e && (*p == '-' || *p == '+') ) negative = (*p++ == '-');
+
+  // mantissa as integer, at most 19 significant digits
+  unsigned long long mantissa = 0;
+  int n_digits = 0;
+  int exp10 = 0;
+  bool has_digit = false;
+
+  for( ; p < e && static_cast<unsigned int>(*p - '0') <= 9; ++p )
+  {
+    has_digit = true;
+    if( n_digits < 19 ) { mantissa = mantissa*10 + (*p - '0'); if(mantissa) n_digits++; }
+    else exp10++;
+  }
+  if( p < e && *p == '.' )
+  {
+    for( ++p; p < e && static_cast<unsigned int>(*p - '0') <= 9; ++p )
+    {
+      has_digit = true;
+      if( n_digits < 19 ) { mantissa = mantissa*10 + (*p - '0'); if(mantissa) n_digits++; exp10--; }
+    }
+  }
+  if( !has_digit ) return parse_real_strtod(b, e, v); // inf, nan ...
+
+  if( p < e && (*p == 'e' || *p == 'E' || *p == 'd' || *p == 'D') )
+  {
+    long ex;
+    if( !parse_integer(p+1, e, ex) ) return false;
+    exp10 += static_cast<int>(ex);
+    p = e;
+  }
+  if( p != e ) return false;
+
+  // exact when both mantissa and power of ten are exact doubles
+  if( mantissa < (1ULL<<53) && exp10 >= -22 && exp10 <= 22 )
+  {
+    double r = static_cast<double>(mantissa);
+    r = exp10 < 0 ? r/exact_pow10[-exp10] : r*exact_pow10[exp10];
+    v = negative ? -r : r;
+    return true;
+  }
+
+  return parse_real_strtod(b, e, v);
+}